@@ -0,0 +1,134 @@
+/*
+ * Measures how fast the updates of a device reach its listeners (see Device::onTrigger()).
+ *
+ * A producer thread takes the role of the realtime thread of a DummyDevice. Every round, it sends
+ * a burst of progress updates and sensor updates, which ends with the state changes PRINTING and
+ * OK. The listener measures the time from the start of the burst to the state change OK, which is
+ * dispatched after all updates of the burst. The producer waits for it, before the next round.
+ *
+ * usage: bench_device_events [rounds] [updates per burst]
+ */
+#include <devices/dummy/DummyDevice.hh>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+
+using bench_clock = std::chrono::steady_clock;
+
+class BenchDevice : public DummyDevice {
+    public:
+        BenchDevice()
+            : DummyDevice("bench")
+        {}
+
+        void burst(size_t updates)
+        {
+            for (size_t i = 0; i < updates; ++i) {
+                if (0 == i % 8) {
+                    update_sensor_readings();
+                } else {
+                    update_progress(i % 100, updates - i);
+                }
+            }
+            set_state(State::PRINTING);
+            set_state(State::OK);
+        }
+};
+
+class BenchListener : public Device::Listener {
+    public:
+        BenchListener()
+            : m_calls(0),
+              m_done(false)
+        {}
+
+        void on_state_change(Device &device, Device::State new_state) override
+        {
+            m_calls++;
+            if (Device::State::OK != new_state) {
+                return;
+            }
+            const std::lock_guard<std::mutex> guard(m_mutex);
+            m_end = bench_clock::now();
+            m_done = true;
+            m_cv.notify_one();
+        }
+
+        void on_build_progress_change(Device &device, unsigned percentage, unsigned remaining_time) override
+        {
+            m_calls++;
+        }
+
+        void on_sensor_update(Device &device) override
+        {
+            m_calls++;
+        }
+
+        /**
+         * Waits for the state change OK and returns its time.
+         */
+        bench_clock::time_point wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_done; });
+            m_done = false;
+            return m_end;
+        }
+
+        std::atomic<size_t> m_calls;
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_done;
+        bench_clock::time_point m_end;
+};
+
+int main(int argc, char **argv)
+{
+    const size_t rounds = (1 < argc) ? (std::strtoul(argv[1], nullptr, 0)) : (20000);
+    const size_t updates = (2 < argc) ? (std::strtoul(argv[2], nullptr, 0)) : (16);
+
+    BenchDevice device;
+    BenchListener listener;
+    device.register_listener(&listener);
+    // the state change OK of the constructor
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    listener.m_calls = 0;
+
+    std::vector<double> latencies;
+    latencies.reserve(rounds);
+    const bench_clock::time_point bench_start = bench_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        const bench_clock::time_point start = bench_clock::now();
+        device.burst(updates);
+        latencies.push_back(std::chrono::duration<double, std::micro>(listener.wait() - start).count());
+    }
+    const double seconds = std::chrono::duration<double>(bench_clock::now() - bench_start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))];
+    };
+    const size_t events = rounds * (updates + 2);
+    std::cout << "rounds: " << rounds << ", events per round: " << updates + 2 << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "events/s:            " << events / seconds << "\n";
+    std::cout << "listener calls:      " << listener.m_calls << " (" << 100.0 * listener.m_calls / events << "% of the events)\n";
+    std::cout << "burst latency [us]:  p50 " << percentile(0.5)
+              << ", p90 " << percentile(0.9)
+              << ", p99 " << percentile(0.99)
+              << ", max " << latencies.back() << "\n";
+    std::cout.flush();
+    // skip the destructors of the device and the event loop
+    _exit(0);
+}
@@ -0,0 +1,104 @@
+/*
+ * Measures the latency from new input on an fd to the write of the answer in the read callback
+ * for the libevent based EventLoop and the epoll based RealtimeEventLoop. This is the path of an
+ * "ok" of the printer to the next command.
+ *
+ * A client thread writes a byte into a pipe, the read callback of the loop reads it and writes a
+ * byte into a second pipe, on which the client waits. The client waits a bit between the rounds,
+ * so every round includes the wakeup of the idle loop.
+ *
+ * usage: bench_event_loop [rounds] [realtime (0|1)]
+ */
+#include <EventLoop.hh>
+#include <RealtimeEventLoop.hh>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <cstdlib>
+#include <stdexcept>
+#include <unistd.h>
+
+using bench_clock = std::chrono::steady_clock;
+
+static int g_answer_fd = -1;
+
+static bool on_read(int fd, void *arg)
+{
+    char buf[64];
+    while (0 < read(fd, buf, sizeof(buf))) {
+        if (1 != write(g_answer_fd, buf, 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Loop>
+static std::vector<double> measure(Loop &loop, size_t rounds)
+{
+    int request[2];
+    int answer[2];
+    if (pipe(request) || pipe(answer)) {
+        throw std::runtime_error("Could not create pipes.");
+    }
+    g_answer_fd = answer[1];
+    loop.register_read_cb(request[0], on_read, nullptr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::vector<double> latencies;
+    latencies.reserve(rounds);
+    for (size_t i = 0; i < rounds; ++i) {
+        char c = 'x';
+        const bench_clock::time_point start = bench_clock::now();
+        if (1 != write(request[1], &c, 1) || 1 != read(answer[0], &c, 1)) {
+            throw std::runtime_error("Could not send a request.");
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(bench_clock::now() - start).count());
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    loop.unregister_read_cb(request[0]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    close(request[1]);
+    close(answer[0]);
+    return latencies;
+}
+
+static void report(const char *name, std::vector<double> latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))];
+    };
+    std::cout << std::setw(20) << name
+              << std::setw(10) << percentile(0.5)
+              << std::setw(10) << percentile(0.9)
+              << std::setw(10) << percentile(0.99)
+              << std::setw(10) << percentile(0.999)
+              << std::setw(10) << latencies.back() << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    const size_t rounds = (1 < argc) ? (std::strtoul(argv[1], nullptr, 0)) : (20000);
+    const bool realtime = (2 < argc) && ('1' == argv[2][0]);
+
+    std::cout << "rounds: " << rounds << ", realtime: " << ((realtime) ? ("yes") : ("no")) << "\n";
+    std::cout << std::setw(20) << "latency [us]"
+              << std::setw(10) << "p50"
+              << std::setw(10) << "p90"
+              << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9"
+              << std::setw(10) << "max" << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    report("EventLoop", measure(EventLoop::get_event_loop(), rounds));
+    RealtimeEventLoop *realtime_loop = new RealtimeEventLoop((realtime) ? (std::optional<uint32_t>(50)) : (std::nullopt), std::nullopt, false);
+    report("RealtimeEventLoop", measure(*realtime_loop, rounds));
+    std::cout.flush();
+    // skip the destructors of the event loops
+    _exit(0);
+}
@@ -0,0 +1,285 @@
+/*
+ * Measures how many commands per second PrusaDevice sends to a printer depending on the
+ * configured print window (print_window_commands / print_window_bytes).
+ *
+ * The printer is emulated on a pseudo terminal. The emulator acknowledges every command after
+ * a fixed link latency (USB round trip and command parsing). Additionally, the firmware needs
+ * a fixed time to process each command, i.e. to put it into the motion planner.
+ *
+ * usage: bench_print_window [commands] [latency in us] [processing time in us]
+ */
+#include <devices/prusa/PrusaDevice.hh>
+#include <Config.hh>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using bench_clock = std::chrono::steady_clock;
+
+class PrinterEmulator {
+    public:
+        PrinterEmulator(std::chrono::microseconds latency, std::chrono::microseconds processing)
+            : m_latency(latency),
+              m_processing(processing),
+              m_stop(false),
+              m_received(0),
+              m_acknowledged(0),
+              m_max_in_flight(0),
+              m_reads(0)
+        {
+            m_master = posix_openpt(O_RDWR | O_NOCTTY);
+            if (0 > m_master || 0 != grantpt(m_master) || 0 != unlockpt(m_master)) {
+                throw std::runtime_error("Could not create pseudo terminal.");
+            }
+            m_slave = ptsname(m_master);
+        }
+
+        ~PrinterEmulator()
+        {
+            stop();
+            close(m_master);
+        }
+
+        const std::string &slave() const
+        {
+            return m_slave;
+        }
+
+        void start()
+        {
+            m_thread = std::thread([this]() { run(); });
+        }
+
+        void stop()
+        {
+            m_stop = true;
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+        }
+
+        void reset_stats()
+        {
+            m_max_in_flight = 0;
+            m_reads = 0;
+        }
+
+        /**
+         * Returns the number of reads, which returned data. Since the writes of the device are
+         * not merged by the pseudo terminal, this is the number of write syscalls of the device.
+         */
+        size_t reads() const
+        {
+            return m_reads;
+        }
+
+        size_t max_in_flight() const
+        {
+            return m_max_in_flight;
+        }
+
+    private:
+        void reply(const char *line)
+        {
+            size_t len = std::strlen(line);
+            while (len) {
+                ssize_t n = write(m_master, line, len);
+                if (0 > n) {
+                    if (EAGAIN == errno || EINTR == errno) {
+                        continue;
+                    }
+                    return;
+                }
+                line += n;
+                len -= n;
+            }
+        }
+
+        void run()
+        {
+            // the device waits for this line before it sends any command
+            reply("LCD status changed\n");
+
+            std::string buf;
+            std::deque<bench_clock::time_point> pending;
+            bench_clock::time_point last_processed = bench_clock::now();
+            while (!m_stop) {
+                int timeout = 10;
+                if (!pending.empty()) {
+                    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(pending.front() - bench_clock::now());
+                    timeout = std::max<int>(0, std::min<int>(timeout, wait.count()));
+                }
+                struct pollfd pfd = { m_master, POLLIN, 0 };
+                if (0 < poll(&pfd, 1, timeout) && (pfd.revents & POLLIN)) {
+                    char tmp[4096];
+                    ssize_t n = read(m_master, tmp, sizeof(tmp));
+                    if (0 < n) {
+                        buf.append(tmp, n);
+                        m_reads++;
+                    }
+                }
+
+                std::string::size_type eol;
+                while (std::string::npos != (eol = buf.find('\n'))) {
+                    const std::string line = buf.substr(0, eol);
+                    buf.erase(0, eol + 1);
+                    if ("M115" == line) {
+                        reply("Cap:AUTOREPORT_TEMP:1\nok\n");
+                        continue;
+                    }
+                    const bench_clock::time_point now = bench_clock::now();
+                    last_processed = std::max(now + m_latency, last_processed + m_processing);
+                    pending.push_back(last_processed);
+                    m_received++;
+                    m_max_in_flight = std::max(m_max_in_flight.load(), m_received - m_acknowledged);
+                }
+
+                const bench_clock::time_point now = bench_clock::now();
+                while (!pending.empty() && pending.front() <= now) {
+                    pending.pop_front();
+                    m_acknowledged++;
+                    reply("ok\n");
+                }
+            }
+        }
+
+    private:
+        const std::chrono::microseconds m_latency;
+        const std::chrono::microseconds m_processing;
+        int m_master;
+        std::string m_slave;
+        std::thread m_thread;
+        std::atomic<bool> m_stop;
+        size_t m_received;
+        size_t m_acknowledged;
+        std::atomic<size_t> m_max_in_flight;
+        std::atomic<size_t> m_reads;
+};
+
+
+/*
+ * Creates a configuration with the given print window.
+ */
+static std::unique_ptr<Config> create_config(uint32_t window_commands, uint32_t window_bytes)
+{
+    char conf_path[] = "/tmp/bench_print_window_XXXXXX";
+    int fd = mkstemp(conf_path);
+    if (0 > fd) {
+        throw std::runtime_error("Could not create configuration file.");
+    }
+    close(fd);
+    {
+        std::ofstream conf_file(conf_path);
+        conf_file << "use_realtime_scheduler = false\n";
+        conf_file << "print_window_commands = " << window_commands << "\n";
+        conf_file << "print_window_bytes = " << window_bytes << "\n";
+        conf_file << "checkpoint_interval = 0\n";
+    }
+    char arg0[] = "bench_print_window";
+    char arg1[] = "-c";
+    char *argv[] = { arg0, arg1, conf_path, nullptr };
+    std::unique_ptr<Config> conf(new Config(3, argv));
+    unlink(conf_path);
+    return conf;
+}
+
+
+/*
+ * Waits until the device is in the given state. Returns false on timeout.
+ */
+static bool wait_for_state(const Device &dev, Device::State state, std::chrono::seconds timeout)
+{
+    const bench_clock::time_point end = bench_clock::now() + timeout;
+    while (dev.state() != state) {
+        if (bench_clock::now() > end) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    const size_t commands = (1 < argc) ? std::strtoul(argv[1], nullptr, 0) : 5000;
+    const std::chrono::microseconds latency((2 < argc) ? std::strtoul(argv[2], nullptr, 0) : 2000);
+    const std::chrono::microseconds processing((3 < argc) ? std::strtoul(argv[3], nullptr, 0) : 250);
+
+    // short segments like the ones of a curve or gyroid infill
+    std::stringstream gcode;
+    for (size_t i = 0; i < commands; ++i) {
+        gcode << "G1 X" << (100 + i % 50) << ".123 Y" << (100 + i % 37) << ".456 E0.01234\n";
+    }
+
+    const struct {
+        uint32_t commands;
+        uint32_t bytes;
+    } windows[] = {
+        { 1, 0 }, { 2, 0 }, { 4, 0 }, { 8, 0 }, { 16, 0 },
+        // the RX buffer of the Prusa firmware has 128 bytes
+        { 32, 127 },
+    };
+
+    std::cout << "commands: " << commands
+              << ", latency: " << latency.count() << " us"
+              << ", processing time: " << processing.count() << " us\n";
+    std::cout << std::setw(16) << "window commands"
+              << std::setw(14) << "window bytes"
+              << std::setw(14) << "in flight"
+              << std::setw(16) << "commands/s"
+              << std::setw(14) << "writes/cmd" << "\n";
+
+    // The devices are not destroyed, since the event loop may still reference them. The process
+    // is terminated without calling any destructors.
+    std::vector<std::unique_ptr<Config>> confs;
+    std::vector<std::unique_ptr<PrinterEmulator>> emulators;
+    std::vector<std::unique_ptr<PrusaDevice>> devices;
+    for (const auto &window: windows) {
+        confs.push_back(create_config(window.commands, window.bytes));
+        emulators.emplace_back(new PrinterEmulator(latency, processing));
+        PrinterEmulator &emu = *emulators.back();
+        devices.emplace_back(new PrusaDevice(emu.slave(), "bench", *confs.back()));
+        PrusaDevice &dev = *devices.back();
+        emu.start();
+
+        if (!wait_for_state(dev, Device::State::OK, std::chrono::seconds(5))) {
+            std::cerr << "Device did not get ready, state: " << Device::state_to_str(dev.state()) << "\n";
+            _exit(1);
+        }
+        emu.reset_stats();
+
+        const bench_clock::time_point start = bench_clock::now();
+        if (Device::PrintResult::OK != dev.print(gcode.str())) {
+            std::cerr << "Failed to start print.\n";
+            _exit(1);
+        }
+        if (!wait_for_state(dev, Device::State::OK, std::chrono::seconds(600))) {
+            std::cerr << "Print did not finish.\n";
+            _exit(1);
+        }
+        const std::chrono::duration<double> duration = bench_clock::now() - start;
+        emu.stop();
+
+        std::cout << std::setw(16) << window.commands
+                  << std::setw(14) << window.bytes
+                  << std::setw(14) << emu.max_in_flight()
+                  << std::setw(16) << std::fixed << std::setprecision(1) << commands / duration.count()
+                  << std::setw(14) << std::setprecision(2) << double(emu.reads()) / commands << "\n";
+    }
+    std::cout.flush();
+    _exit(0);
+}
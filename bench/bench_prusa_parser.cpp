@@ -0,0 +1,157 @@
+/*
+ * Compares the PrusaParser with the std::regex based parsing, which was used by PrusaDevice before.
+ * The input is captured output of a Prusa MK3S while printing.
+ *
+ * usage: bench_prusa_parser [iterations]
+ */
+#include <devices/prusa/PrusaParser.hh>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <regex>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using bench_clock = std::chrono::steady_clock;
+
+static const char *captured_lines[] = {
+    "T:214.8 /215.0 B:60.1 /60.0 T0:214.8 /215.0 @:43 B@:21 P:35.2 A:31.4",
+    "ok",
+    "X:118.23 Y:97.54 Z:0.20 E:0.00 Count X: 118.23 Y:97.54 Z:0.20 E:0.00",
+    "ok",
+    "E0:7200 RPM PRN1:4512 RPM E0@:255 PRN1@:178",
+    "ok",
+    "NORMAL MODE: Percent done: 12; print time remaining in mins: 21; Change in mins: -1",
+    "SILENT MODE: Percent done: 12; print time remaining in mins: 23; Change in mins: -1",
+    "ok",
+    "echo:busy: processing",
+    "T:215.1 /215.0 B:59.9 /60.0 T0:215.1 /215.0 @:41 B@:25 P:35.2 A:31.5",
+    "ok",
+    "ok",
+};
+
+#define __TEMP_REGEX "((T[[:digit:]]*)|(B[[:digit:]]*)|(B@)|@|P|A):[[:digit:]]+(\\.[[:digit:]]+)?( /[[:digit:]]+\\.[[:digit:]])?[[:space:]]*"
+static const std::regex temp_regex(__TEMP_REGEX);
+static const std::regex full_temp_regex("(" __TEMP_REGEX ")+");
+#define __POS_REGEX "(([XYZE]:[[:space:]]?[[:digit:]]+(\\.[[:digit:]]+))|Count)[[:space:]]?"
+static const std::regex pos_regex(__POS_REGEX);
+static const std::regex full_pos_regex("(" __POS_REGEX "){9}");
+#define __FAN_REGEX "((E)|(PRN))[[:digit:]]@?:[[:digit:]]+( RPM)?[[:space:]]?"
+static const std::regex fan_regex(__FAN_REGEX);
+static const std::regex full_fan_regex("(" __FAN_REGEX ")+");
+static const std::regex progress_regex("^NORMAL MODE: Percent done: ([[:digit:]]+); print time remaining in mins: ([[:digit:]]+);.*$");
+
+
+/*
+ * Parses the line like the former implementation of PrusaDevice and returns the sum of all values.
+ */
+static double parse_regex(const std::string &line)
+{
+    double sum = 0;
+    std::smatch m;
+    if (std::regex_match(line, full_temp_regex)) {
+        auto begin = line.begin();
+        while (std::regex_search(begin, line.end(), m, temp_regex)) {
+            begin = begin + m.position() + m[0].length();
+            std::string::size_type colon_pos = m[0].str().find(':');
+            std::string::size_type slash_pos = m[0].str().find('/', colon_pos);
+            std::string type = m[0].str().substr(0, colon_pos);
+            sum += std::stod(m[0].str().substr(colon_pos+1));
+            if (std::string::npos != slash_pos) {
+                sum += std::stod(m[0].str().substr(slash_pos+1));
+            }
+        }
+    } else if (std::regex_match(line, full_pos_regex)) {
+        auto begin = line.begin();
+        while (std::regex_search(begin, line.end(), m, pos_regex)) {
+            begin = begin + m.position() + m[0].length();
+            if ("Count " == m[0]) {
+                break;
+            }
+            std::string::size_type colon_pos = m[0].str().find(':');
+            std::string name = m[0].str().substr(0, colon_pos);
+            sum += std::stod(m[0].str().substr(colon_pos+1));
+        }
+    } else if (std::regex_match(line, full_fan_regex)) {
+        auto begin = line.begin();
+        while (std::regex_search(begin, line.end(), m, fan_regex)) {
+            begin = begin + m.position() + m[0].length();
+            std::string::size_type colon_pos = m[0].str().find(':');
+            std::string name = m[0].str().substr(0, colon_pos);
+            sum += std::stod(m[0].str().substr(colon_pos+1));
+        }
+    } else if (std::regex_match(line, m, progress_regex)) {
+        sum += std::atoi(m[1].str().c_str());
+        sum += std::atoi(m[2].str().c_str());
+    }
+    return sum;
+}
+
+
+/*
+ * Parses the line with the PrusaParser and returns the sum of all values.
+ */
+static double parse_tokenizer(std::string_view line)
+{
+    double sum = 0;
+    PrusaParser::Result result;
+    PrusaParser::parse(line, result);
+    if (PrusaParser::LineType::OTHER == result.type) {
+        unsigned percentage;
+        unsigned remaining;
+        if (PrusaParser::parse_progress(line, percentage, remaining)) {
+            sum += percentage;
+            sum += remaining;
+        }
+        return sum;
+    }
+    for (size_t i = 0; i < result.count; ++i) {
+        sum += result.readings[i].current_value;
+        if (result.readings[i].set_point) {
+            sum += *result.readings[i].set_point;
+        }
+    }
+    return sum;
+}
+
+
+template<typename F>
+static double run(const std::vector<std::string> &lines, size_t iterations, F parse, double &checksum)
+{
+    checksum = 0;
+    const bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        for (const std::string &line: lines) {
+            checksum += parse(line);
+        }
+    }
+    const std::chrono::duration<double, std::nano> duration = bench_clock::now() - start;
+    return duration.count() / (iterations * lines.size());
+}
+
+
+int main(int argc, char **argv)
+{
+    const size_t iterations = (1 < argc) ? std::strtoul(argv[1], nullptr, 0) : 2000;
+    const std::vector<std::string> lines(std::begin(captured_lines), std::end(captured_lines));
+
+    for (const std::string &line: lines) {
+        if (parse_regex(line) != parse_tokenizer(line)) {
+            std::cerr << "Parsers differ on line: '" << line << "'\n";
+            return 1;
+        }
+    }
+
+    double checksum_regex;
+    double checksum_tokenizer;
+    const double ns_regex = run(lines, iterations, parse_regex, checksum_regex);
+    const double ns_tokenizer = run(lines, iterations, parse_tokenizer, checksum_tokenizer);
+
+    std::cout << "lines: " << lines.size() * iterations << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "std::regex:  " << std::setw(10) << ns_regex << " ns/line (checksum " << checksum_regex << ")\n";
+    std::cout << "PrusaParser: " << std::setw(10) << ns_tokenizer << " ns/line (checksum " << checksum_tokenizer << ")\n";
+    std::cout << "speedup:     " << std::setw(10) << ns_regex / ns_tokenizer << "x\n";
+    return 0;
+}
@@ -4,7 +4,9 @@
 #include <iomanip>
 #include <fstream>
 #include <regex>
+#include <vector>
 #include <sys/random.h>
+#include <sched.h>
 
 const struct option long_options_config[] = {
     { "config",            required_argument, 0, 'c' },
@@ -83,6 +85,12 @@ void Config::set_default()
         }
     }
     m_aliases_file = "/var/lib/gcoded/aliases";
+    m_upload_dir = "/var/tmp";
+    m_job_cache_dir = "/var/cache/gcoded/jobs";
+    m_job_cache_size = uint64_t(1024) * 1024 * 1024;
+    m_print_request_size = uint64_t(64) * 1024 * 1024;
+    m_checkpoint_dir = "/var/lib/gcoded/checkpoints";
+    m_job_queue_file = "/var/lib/gcoded/queue";
 
     m_mqtt_broker = "localhost";
     m_mqtt_port = 1883;
@@ -98,6 +106,10 @@ void Config::set_default()
     m_mqtt_keyfile = std::nullopt;
     m_mqtt_tls_insecure = false;
     m_use_realtime_scheduler = true;
+    m_realtime_threads = 1;
+    // the middle of the SCHED_FIFO priorities (1 to 99)
+    m_realtime_priority = 50;
+    m_lock_memory = false;
     m_load_dummy = false;
     m_print_help = false;
     m_verbose = false;
@@ -206,9 +218,20 @@ void Config::load_config()
     }
     uint32_t line_counter = 0;
 
-    std::regex var_name_regex("[[:alpha:]][[:alnum:]_]*");
+    // device settings can be restricted to one device: var_name[device_name]
+    std::regex var_name_regex("[[:alpha:]][[:alnum:]_]*(\\[[^\\][:space:]]+\\])?");
     std::regex var_value_regex("([^[:space:]\"]+)|(\"(([^\"])|(\\\\\"))*\")");
 
+    // the device specific settings are applied after the whole file is parsed, so they
+    // override the general settings independent of the order in the file.
+    struct device_setting {
+        std::string device_name;
+        std::string var_name;
+        std::string var_value;
+        uint32_t line_counter;
+    };
+    std::vector<device_setting> device_settings;
+
     while (!conf_file.eof()) {
         line_counter++;
 
@@ -286,7 +309,18 @@ void Config::load_config()
             var_value = var_value.substr(1,var_value.length()-2);
         }
 
-        if ("mqtt_broker" == var_name) {
+        std::string::size_type pos_bracket = var_name.find('[');
+        if (std::string::npos != pos_bracket) {
+            device_settings.push_back({var_name.substr(pos_bracket + 1, var_name.length() - pos_bracket - 2),
+                                       var_name.substr(0, pos_bracket),
+                                       var_value,
+                                       line_counter});
+            continue;
+        }
+
+        if (parse_device_setting(m_device_config, var_name, var_value, line_counter)) {
+            continue;
+        } else if ("mqtt_broker" == var_name) {
             m_mqtt_broker = var_value;
         } else if ("mqtt_port" == var_name) {
             std::optional<uint16_t> value = parse_mqtt_port_value(var_value);
@@ -346,7 +380,47 @@ void Config::load_config()
             m_mqtt_certfile = var_value;
         } else if ("mqtt_keyfile" == var_name) {
             m_mqtt_keyfile = var_value;
-        } else if ("use_realtime_scheduler") {
+        } else if ("upload_dir" == var_name) {
+            m_upload_dir = var_value;
+        } else if ("job_cache_dir" == var_name) {
+            m_job_cache_dir = var_value;
+        } else if ("job_cache_size" == var_name) {
+            // the size is configured in MiB
+            std::optional<uint32_t> value = parse_uint32_value(var_value);
+            if (!value) {
+                std::string err = "Parsing error in '";
+                err += *m_conf_file;
+                err += "' on line ";
+                err += std::to_string(line_counter);
+                err += ": invalid value '";
+                err += var_value;
+                err += "' for variable '";
+                err += var_name;
+                err += "'";
+                throw std::runtime_error(err);
+            }
+            m_job_cache_size = uint64_t(*value) * 1024 * 1024;
+        } else if ("print_request_size" == var_name) {
+            // the size is configured in MiB
+            std::optional<uint32_t> value = parse_uint32_value(var_value);
+            if (!value) {
+                std::string err = "Parsing error in '";
+                err += *m_conf_file;
+                err += "' on line ";
+                err += std::to_string(line_counter);
+                err += ": invalid value '";
+                err += var_value;
+                err += "' for variable '";
+                err += var_name;
+                err += "'";
+                throw std::runtime_error(err);
+            }
+            m_print_request_size = uint64_t(*value) * 1024 * 1024;
+        } else if ("checkpoint_dir" == var_name) {
+            m_checkpoint_dir = var_value;
+        } else if ("job_queue_file" == var_name) {
+            m_job_queue_file = var_value;
+        } else if ("use_realtime_scheduler" == var_name) {
             if (var_value != "true" && var_value != "false") {
                 std::string err = "Parsing error in '";
                 err += *m_conf_file;
@@ -360,6 +434,65 @@ void Config::load_config()
                 throw std::runtime_error(err);
             }
             m_use_realtime_scheduler = var_value == "true";
+        } else if ("realtime_threads" == var_name) {
+            std::optional<uint32_t> value = ("per_device" == var_value) ? (0) : (parse_uint32_value(var_value));
+            if (!value || (0 == *value && "per_device" != var_value)) {
+                std::string err = "Parsing error in '";
+                err += *m_conf_file;
+                err += "' on line ";
+                err += std::to_string(line_counter);
+                err += ": invalid value '";
+                err += var_value;
+                err += "' for variable '";
+                err += var_name;
+                err += "'. Allowed values are 'per_device' or a number larger than 0.";
+                throw std::runtime_error(err);
+            }
+            m_realtime_threads = *value;
+        } else if ("realtime_priority" == var_name) {
+            std::optional<uint32_t> value = parse_uint32_value(var_value);
+            if (!value || 1 > *value || 99 < *value) {
+                std::string err = "Parsing error in '";
+                err += *m_conf_file;
+                err += "' on line ";
+                err += std::to_string(line_counter);
+                err += ": invalid value '";
+                err += var_value;
+                err += "' for variable '";
+                err += var_name;
+                err += "'. Allowed values are 1 to 99.";
+                throw std::runtime_error(err);
+            }
+            m_realtime_priority = *value;
+        } else if ("realtime_cpus" == var_name) {
+            std::optional<std::vector<uint32_t>> value = parse_cpu_list(var_value);
+            if (!value) {
+                std::string err = "Parsing error in '";
+                err += *m_conf_file;
+                err += "' on line ";
+                err += std::to_string(line_counter);
+                err += ": invalid value '";
+                err += var_value;
+                err += "' for variable '";
+                err += var_name;
+                err += "'. Expected a comma separated list of CPU numbers.";
+                throw std::runtime_error(err);
+            }
+            m_realtime_cpus = *value;
+        } else if ("lock_memory" == var_name) {
+            if (var_value != "true" && var_value != "false") {
+                std::string err = "Parsing error in '";
+                err += *m_conf_file;
+                err += "' on line ";
+                err += std::to_string(line_counter);
+                err += ": invalid value '";
+                err += var_value;
+                err += "' for variable '";
+                err += var_name;
+                err += "'. Allowed values are 'true' or 'false'.";
+                throw std::runtime_error(err);
+            }
+            m_lock_memory = var_value == "true";
         } else {
             std::string err = "Parsing error in '";
             err += *m_conf_file;
@@ -371,6 +504,122 @@ void Config::load_config()
             throw std::runtime_error(err);
         }
     }
+
+    for (const auto &setting: device_settings) {
+        auto inserted = m_device_configs.emplace(setting.device_name, m_device_config);
+        if (!parse_device_setting(inserted.first->second, setting.var_name, setting.var_value, setting.line_counter)) {
+            std::string err = "Parsing error in '";
+            err += *m_conf_file;
+            err += "' on line ";
+            err += std::to_string(setting.line_counter);
+            err += ": Variable '";
+            err += setting.var_name;
+            err += "' can't be set for a single device.";
+            throw std::runtime_error(err);
+        }
+    }
+
+    check_device_config(m_device_config, "");
+    for (const auto &dev_conf: m_device_configs) {
+        check_device_config(dev_conf.second, dev_conf.first);
+    }
+}
+
+
+/*
+ * check_device_config()
+ */
+void Config::check_device_config(const DeviceConfig &dev_conf, const std::string &device_name) const
+{
+    // without a timeout, the driver waits for VMIN bytes, but an acknowledgement ("ok\n") has only 3 bytes
+    if (0 == dev_conf.serial_vtime && 3 < dev_conf.serial_vmin) {
+        std::string err = "Invalid configuration in '";
+        err += *m_conf_file;
+        err += "': serial_vmin";
+        if (!device_name.empty()) {
+            err += "[" + device_name + "]";
+        }
+        err += " = " + std::to_string(dev_conf.serial_vmin);
+        err += " must not be larger than 3, if serial_vtime is 0. Otherwise the acknowledgements of the printer are not received.";
+        throw std::runtime_error(err);
+    }
+}
+
+
+/*
+ * parse_device_setting()
+ */
+bool Config::parse_device_setting(DeviceConfig &dev_conf,
+                                  const std::string &var_name,
+                                  const std::string &var_value,
+                                  uint32_t line_counter) const
+{
+    bool *bool_setting = nullptr;
+    if ("serial_checksums" == var_name) {
+        bool_setting = &dev_conf.serial_checksums;
+    } else if ("serial_low_latency" == var_name) {
+        bool_setting = &dev_conf.serial_low_latency;
+    }
+    if (bool_setting) {
+        if (var_value != "true" && var_value != "false") {
+            std::string err = "Parsing error in '";
+            err += *m_conf_file;
+            err += "' on line ";
+            err += std::to_string(line_counter);
+            err += ": invalid value '";
+            err += var_value;
+            err += "' for variable '";
+            err += var_name;
+            err += "'. Allowed values are 'true' or 'false'.";
+            throw std::runtime_error(err);
+        }
+        *bool_setting = var_value == "true";
+        return true;
+    }
+
+    uint32_t *setting = nullptr;
+    uint32_t min_value = 0;
+    uint32_t max_value = UINT32_MAX;
+    if ("print_window_commands" == var_name) {
+        setting = &dev_conf.print_window_commands;
+        // at least one command has to be on the way, otherwise the print never proceeds
+        min_value = 1;
+        // the send queue of the device allocates a slot for every command of the window
+        max_value = 4096;
+    } else if ("print_window_bytes" == var_name) {
+        setting = &dev_conf.print_window_bytes;
+    } else if ("baud_rate" == var_name) {
+        setting = &dev_conf.baud_rate;
+        min_value = 1;
+    } else if ("serial_vmin" == var_name) {
+        setting = &dev_conf.serial_vmin;
+        max_value = 255;
+    } else if ("serial_vtime" == var_name) {
+        setting = &dev_conf.serial_vtime;
+        max_value = 255;
+    } else if ("serial_latency_test" == var_name) {
+        setting = &dev_conf.serial_latency_test;
+    } else if ("checkpoint_interval" == var_name) {
+        setting = &dev_conf.checkpoint_interval;
+    } else {
+        return false;
+    }
+
+    std::optional<uint32_t> value = parse_uint32_value(var_value);
+    if (!value || min_value > *value || max_value < *value) {
+        std::string err = "Parsing error in '";
+        err += *m_conf_file;
+        err += "' on line ";
+        err += std::to_string(line_counter);
+        err += ": invalid value '";
+        err += var_value;
+        err += "' for variable '";
+        err += var_name;
+        err += "'";
+        throw std::runtime_error(err);
+    }
+    *setting = *value;
+    return true;
 }
 
 
@@ -490,6 +739,55 @@ std::optional<uint32_t> Config::parse_mqtt_connect_retries_value(const std::stri
 }
 
 
+/*
+ * parse_uint32_value()
+ */
+std::optional<uint32_t> Config::parse_uint32_value(const std::string &value) const
+{
+    size_t end;
+    int64_t number;
+    try {
+        number = std::stoll(value, &end, 0);
+    } catch (const std::logic_error &e) {
+        return std::nullopt;
+    }
+    if (value.length() != end) {
+        return std::nullopt;
+    }
+    if (0 > number) {
+        return std::nullopt;
+    }
+    if (std::numeric_limits<uint32_t>::max() < number) {
+        return std::nullopt;
+    }
+
+    return number;
+}
+
+
+/*
+ * parse_cpu_list()
+ */
+std::optional<std::vector<uint32_t>> Config::parse_cpu_list(const std::string &value) const
+{
+    std::vector<uint32_t> cpus;
+    std::string::size_type begin = 0;
+    while (true) {
+        const std::string::size_type end = value.find(',', begin);
+        std::optional<uint32_t> cpu = parse_uint32_value(value.substr(begin, end - begin));
+        if (!cpu || CPU_SETSIZE <= *cpu) {
+            return std::nullopt;
+        }
+        cpus.push_back(*cpu);
+        if (std::string::npos == end) {
+            break;
+        }
+        begin = end + 1;
+    }
+    return cpus;
+}
+
+
 /*
  * parse_mqtt_psk()
  */
@@ -590,7 +888,49 @@ std::ostream& operator<<(std::ostream& out, const Config &conf)
         out << "<none>\n";
     }
     out << "mqtt_tls_insecure: " << ((conf.mqtt_tls_insecure())?("true"):("false")) << "\n";
+    out << "upload_dir: " << conf.upload_dir() << "\n";
+    out << "job_cache_dir: " << conf.job_cache_dir() << "\n";
+    out << "job_cache_size: " << conf.job_cache_size() / (1024 * 1024) << "\n";
+    out << "print_request_size: " << conf.print_request_size() / (1024 * 1024) << "\n";
+    out << "checkpoint_dir: " << conf.checkpoint_dir() << "\n";
+    out << "job_queue_file: " << conf.job_queue_file() << "\n";
     out << "use_realtime_scheduler: " << ((conf.use_realtime_scheduler())?("true"):("false")) << "\n";
+    out << "realtime_threads: ";
+    if (conf.realtime_threads()) {
+        out << conf.realtime_threads() << "\n";
+    } else {
+        out << "per_device\n";
+    }
+    out << "realtime_priority: " << conf.realtime_priority() << "\n";
+    out << "realtime_cpus: ";
+    if (conf.realtime_cpus().empty()) {
+        out << "<none>";
+    }
+    for (size_t i = 0; i < conf.realtime_cpus().size(); ++i) {
+        out << ((i) ? (",") : ("")) << conf.realtime_cpus()[i];
+    }
+    out << "\n";
+    out << "lock_memory: " << ((conf.lock_memory())?("true"):("false")) << "\n";
+    out << "print_window_commands: " << conf.default_device_config().print_window_commands << "\n";
+    out << "print_window_bytes: " << conf.default_device_config().print_window_bytes << "\n";
+    out << "serial_checksums: " << ((conf.default_device_config().serial_checksums)?("true"):("false")) << "\n";
+    out << "baud_rate: " << conf.default_device_config().baud_rate << "\n";
+    out << "serial_low_latency: " << ((conf.default_device_config().serial_low_latency)?("true"):("false")) << "\n";
+    out << "serial_vmin: " << conf.default_device_config().serial_vmin << "\n";
+    out << "serial_vtime: " << conf.default_device_config().serial_vtime << "\n";
+    out << "serial_latency_test: " << conf.default_device_config().serial_latency_test << "\n";
+    out << "checkpoint_interval: " << conf.default_device_config().checkpoint_interval << "\n";
+    for (const auto &dev_conf: conf.device_configs()) {
+        out << "print_window_commands[" << dev_conf.first << "]: " << dev_conf.second.print_window_commands << "\n";
+        out << "print_window_bytes[" << dev_conf.first << "]: " << dev_conf.second.print_window_bytes << "\n";
+        out << "serial_checksums[" << dev_conf.first << "]: " << ((dev_conf.second.serial_checksums)?("true"):("false")) << "\n";
+        out << "baud_rate[" << dev_conf.first << "]: " << dev_conf.second.baud_rate << "\n";
+        out << "serial_low_latency[" << dev_conf.first << "]: " << ((dev_conf.second.serial_low_latency)?("true"):("false")) << "\n";
+        out << "serial_vmin[" << dev_conf.first << "]: " << dev_conf.second.serial_vmin << "\n";
+        out << "serial_vtime[" << dev_conf.first << "]: " << dev_conf.second.serial_vtime << "\n";
+        out << "serial_latency_test[" << dev_conf.first << "]: " << dev_conf.second.serial_latency_test << "\n";
+        out << "checkpoint_interval[" << dev_conf.first << "]: " << dev_conf.second.checkpoint_interval << "\n";
+    }
     out << "load_dummy: " << ((conf.load_dummy())?("true"):("false")) << "\n";
     out << "verbose: " << ((conf.verbose())?("true"):("false")) << "\n";
     return out;
@@ -3,10 +3,55 @@
 
 #include <optional>
 #include <filesystem>
+#include <map>
+#include <vector>
 #include "MQTTConfig.hh"
 
 class Config : public MQTTConfig {
     public:
+        /**
+         * Settings which can be set for each device individually.
+         * In the configuration file, a setting applies to all devices. If the variable name is
+         * followed by a device name in brackets (e.g. "print_window_commands[prusa-CZPX1234] = 4"),
+         * then the setting applies only to this device and overrides the general setting.
+         */
+        struct DeviceConfig {
+            // Maximum number of commands which are sent to the device without being acknowledged
+            // (1 to 4096).
+            uint32_t print_window_commands;
+            // Maximum number of bytes (including the line breaks) which are sent to the device
+            // without being acknowledged. Zero means no limit.
+            uint32_t print_window_bytes;
+            // Prefixes the commands of a print with line numbers and appends checksums, so the
+            // firmware detects corrupted commands and requests them again.
+            bool serial_checksums;
+            // Baud rate of the serial interface.
+            uint32_t baud_rate;
+            // Sets the low latency flag of the serial driver.
+            bool serial_low_latency;
+            // VMIN and VTIME (in tenths of a second) of the serial interface, see termios(3).
+            uint32_t serial_vmin;
+            uint32_t serial_vtime;
+            // Number of commands used to measure the round trip time after connecting to the
+            // device. Zero disables the measurement.
+            uint32_t serial_latency_test;
+            // Number of acknowledged commands of a print job between two checkpoints, which allow
+            // to resume the print (see PrintCheckpoint). Zero disables the checkpoints.
+            uint32_t checkpoint_interval;
+
+            DeviceConfig()
+                : print_window_commands(2),
+                  print_window_bytes(0),
+                  serial_checksums(false),
+                  baud_rate(115200),
+                  serial_low_latency(false),
+                  serial_vmin(1),
+                  serial_vtime(0),
+                  serial_latency_test(0),
+                  checkpoint_interval(100)
+            {}
+        };
+
         Config() = delete;
         Config(int argc, char **argv);
         virtual ~Config() {};
@@ -35,6 +80,56 @@ class Config : public MQTTConfig {
         }
 
 
+        /**
+         * returns the directory, where uploaded print jobs are stored until they are printed.
+         */
+        const std::filesystem::path &upload_dir() const {
+            return m_upload_dir;
+        }
+
+
+        /**
+         * returns the directory of the job cache (see JobCache).
+         */
+        const std::filesystem::path &job_cache_dir() const {
+            return m_job_cache_dir;
+        }
+
+
+        /**
+         * returns the maximum size of the job cache in bytes. If zero, the job cache is disabled.
+         */
+        uint64_t job_cache_size() const {
+            return m_job_cache_size;
+        }
+
+
+        /**
+         * returns the maximum size in bytes of the G-code of a print request after its
+         * decompression (see MsgPrint). Larger jobs have to be uploaded (see JobUpload).
+         */
+        uint64_t print_request_size() const {
+            return m_print_request_size;
+        }
+
+
+        /**
+         * returns the directory, where the checkpoints of the print jobs are stored (see
+         * PrintCheckpoint).
+         */
+        const std::filesystem::path &checkpoint_dir() const {
+            return m_checkpoint_dir;
+        }
+
+
+        /**
+         * returns the filename of the database of the job queues (see JobQueue).
+         */
+        const std::filesystem::path &job_queue_file() const {
+            return m_job_queue_file;
+        }
+
+
         /**
          * returns the client ID used for MQTT.
          * This id is a 128bit random number.
@@ -189,6 +284,79 @@ class Config : public MQTTConfig {
         }
 
 
+        /**
+         * Returns the number of threads, which handle the I/O of the devices (see
+         * RealtimeEventLoop). The devices are distributed over these threads. Zero means one
+         * thread per device.
+         */
+        uint32_t realtime_threads() const
+        {
+            return m_realtime_threads;
+        }
+
+
+        /**
+         * Returns the SCHED_FIFO priority of the threads, which handle the I/O of the devices.
+         */
+        uint32_t realtime_priority() const
+        {
+            return m_realtime_priority;
+        }
+
+
+        /**
+         * Returns the CPUs, to which the threads for the I/O of the devices are pinned. The n-th
+         * thread is pinned to the CPU (n modulo the number of CPUs). If empty, the threads are not
+         * pinned.
+         */
+        const std::vector<uint32_t> &realtime_cpus() const
+        {
+            return m_realtime_cpus;
+        }
+
+
+        /**
+         * If true, the memory of the daemon is locked into RAM at the start, and the stacks of the
+         * threads for the device I/O are pre-faulted and locked. This avoids page faults while
+         * printing.
+         */
+        bool lock_memory() const
+        {
+            return m_lock_memory;
+        }
+
+
+        /**
+         * Returns the settings for the device with the given name.
+         */
+        const DeviceConfig &device_config(const std::string &device_name) const
+        {
+            auto conf = m_device_configs.find(device_name);
+            if (m_device_configs.end() != conf) {
+                return conf->second;
+            }
+            return m_device_config;
+        }
+
+
+        /**
+         * Returns the settings which apply to all devices without own settings.
+         */
+        const DeviceConfig &default_device_config() const
+        {
+            return m_device_config;
+        }
+
+
+        /**
+         * Returns the settings of all devices with own settings.
+         */
+        const std::map<std::string, DeviceConfig> &device_configs() const
+        {
+            return m_device_configs;
+        }
+
+
         /**
          * returns true if dummy devices shall be loaded
          */
@@ -261,12 +429,35 @@ class Config : public MQTTConfig {
         std::optional<uint16_t> parse_mqtt_port_value(const std::string &value) const;
         std::optional<uint32_t> parse_mqtt_connect_retries_value(const std::string &value) const;
         std::optional<std::pair<std::string, std::string>> parse_mqtt_psk(const std::string &value) const;
+        std::optional<uint32_t> parse_uint32_value(const std::string &value) const;
+        std::optional<std::vector<uint32_t>> parse_cpu_list(const std::string &value) const;
+
+        /**
+         * Sets a device setting in dev_conf. Returns false, if var_name is not a device setting.
+         * Throws an exception, if the value is invalid.
+         */
+        bool parse_device_setting(DeviceConfig &dev_conf,
+                                  const std::string &var_name,
+                                  const std::string &var_value,
+                                  uint32_t line_counter) const;
+
+        /**
+         * Checks the combination of the device settings, after the settings of single devices are
+         * merged with the defaults. Throws an exception, if they don't work together.
+         */
+        void check_device_config(const DeviceConfig &dev_conf, const std::string &device_name) const;
 
 
     private:
         std::optional<std::filesystem::path> m_conf_file;
         std::optional<std::filesystem::path> m_id_file;
         std::filesystem::path m_aliases_file;
+        std::filesystem::path m_upload_dir;
+        std::filesystem::path m_job_cache_dir;
+        uint64_t m_job_cache_size;
+        uint64_t m_print_request_size;
+        std::filesystem::path m_checkpoint_dir;
+        std::filesystem::path m_job_queue_file;
         std::string m_mqtt_client_id;
         std::string m_mqtt_broker;
         uint16_t m_mqtt_port;
@@ -282,6 +473,12 @@ class Config : public MQTTConfig {
         std::optional<std::string> m_mqtt_keyfile;
         bool m_mqtt_tls_insecure;
         bool m_use_realtime_scheduler;
+        uint32_t m_realtime_threads;
+        uint32_t m_realtime_priority;
+        std::vector<uint32_t> m_realtime_cpus;
+        bool m_lock_memory;
+        DeviceConfig m_device_config;
+        std::map<std::string, DeviceConfig> m_device_configs;
         bool m_load_dummy;
         bool m_print_help;
         bool m_verbose;
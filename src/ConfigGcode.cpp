@@ -13,12 +13,13 @@ const struct option long_options_config[] = {
     { "mqtt-connect-retries", required_argument, 0, 't' },
     { "mqtt-tls-insecure",    no_argument,       0, 0 },
     { "real-names",           no_argument,       0, 'r' },
+    { "arc-tolerance",        required_argument, 0, 'a' },
     { "verbose",              no_argument,       0, 'v' },
     { "help",                 no_argument,       0, 'h' },
     { 0, 0, 0, 0 }
 };
 
-const char short_options_config[] = "-c:b:p:e:t:rvh";
+const char short_options_config[] = "-c:b:p:e:t:ra:vh";
 
 const char usage_message[] = "gcode [OPTIONS] [COMMAND]\n";
 const char help_message[] =
@@ -33,12 +34,19 @@ const char help_message[] =
 "    --mqtt-tls-insecure         Do not validate domain name in the MQTT broker certificate.\n"
 "                                This should be used only for testing. Allows Man-in-the-middle attacks.\n"
 "-r, --real-names                Do not use aliases for device and provider. Use real names.\n"
+"-a, --arc-tolerance=mm          Replace runs of G1 moves on a circle by G2/G3 arcs before a gcode\n"
+"                                file is sent or converted. The arcs deviate at most by mm from the\n"
+"                                original path (e.g. 0.01).\n"
 "-v, --verbose                   Enable debug output.\n"
 "-h, --help                      Print help message and configuration.\n"
 "\n"
 "COMMANDS: (get further details with \"-h\": e.g. \"gcode list -h\")\n"
 "list         Lists all currently known devices which can process gcode.\n"
 "send         Sends a gcode file to an device.\n"
+"resume       Resumes an interrupted print.\n"
+"queue        Manage the job queues of the devices.\n"
+"dispatch     Distributes gcode files to the least loaded devices.\n"
+"convert      Converts a gcode file between the text and the binary format.\n"
 "alias        Manage aliases.\n"
 "sr           Show sensor readings.\n";
 
@@ -62,8 +70,67 @@ const char send_help_message[] =
 "             The hint accepts '*' as a wildcard and tries to match device names.\n"
 "             If you want to match all devices of one provider, than you have to provide a\n"
 "             hint like 'providername/*'.\n"
+"             If a hint matches for more than one device, you will be prompt whether you are sure.\n"
+"With -a/--arc-tolerance, arcs are fitted into the gcode before it is sent.\n";
+
+const char resume_usage_message[] = "gcode [OPTIONS] resume [DEVICE_HINT]\n";
+const char resume_help_message[] =
+"Resumes a print, which was interrupted by a lost connection to the device (i.e. a USB glitch or\n"
+"a power loss of the printer).\n"
+"While printing, the daemon stores a checkpoint of the print. The print is resumed with the\n"
+"first command, which was not acknowledged by the device. Before, the device is heated up,\n"
+"the nozzle is lifted and only the X and Y axes are homed, so the nozzle doesn't hit the print.\n"
+"Make sure, that the printed part didn't move and that the Z axis didn't move after the\n"
+"interruption. The job has to be in the job cache of the daemon.\n"
+"DEVICE_HINT  A hint to which device shall resume its print.\n"
+"             If no hint is given, than all known devices resume their prints.\n"
+"             The hint accepts '*' as a wildcard and tries to match device names.\n"
 "             If a hint matches for more than one device, you will be prompt whether you are sure.\n";
 
+const char queue_usage_message[] = "gcode [OPTIONS] queue ACTION\n";
+const char queue_help_message[] =
+"Manage the job queues of the devices.\n"
+"Every device has a job queue, which is kept by the daemon, also over restarts. As soon as a\n"
+"device is idle, it starts the next job of its queue. While a device prints, the next job is\n"
+"already loaded and analyzed, so it starts without delay. Make sure, that the printed part is\n"
+"removed by the end of each job (i.e. on a belt printer), since the next job starts immediately.\n"
+"The job queues need the job cache of the daemon.\n"
+"ACTIONS: \n"
+"add            Queue a gcode file. It expects the arguments: GCODE_FILE [DEVICE_HINT]\n"
+"               DEVICE_HINT works like for the send command.\n"
+"list           List the queued jobs. It expects the optional argument: [DEVICE_HINT]\n"
+"               Every job is shown with its position, its JOB_ID and the beginning of its hash.\n"
+"move           Move a queued job. It expects the arguments: DEVICE_HINT JOB_ID POSITION\n"
+"               DEVICE_HINT has to match exactly one device. POSITION 0 is the next job.\n"
+"cancel         Remove a job from the queue. It expects the arguments: DEVICE_HINT JOB_ID\n"
+"               DEVICE_HINT has to match exactly one device.\n"
+"With -a/--arc-tolerance, arcs are fitted into the gcode before it is queued.\n";
+
+const char dispatch_usage_message[] = "gcode [OPTIONS] dispatch DEVICE_HINT GCODE_FILE...\n";
+const char dispatch_help_message[] =
+"Distributes gcode files to the least loaded devices, until all files are printed or queued.\n"
+"Every file is put into the job queue of the least loaded device: idle devices first, then the\n"
+"printing device with the shortest remaining time. A device gets the next file, as soon as it has\n"
+"no queued job, so it starts the next print right after the current one. Devices without job\n"
+"queue (i.e. the daemon has no job cache) only get a file, while they are idle.\n"
+"The command waits for free devices as long as necessary.\n"
+"DEVICE_HINT  A hint to the compatible devices, i.e. all printers of the same model.\n"
+"             The hint accepts '*' as a wildcard and tries to match device names.\n"
+"             You are not prompted, if the hint matches more than one device.\n"
+"GCODE_FILE   Gcode files, which are dispatched in the given order.\n"
+"With -a/--arc-tolerance, arcs are fitted into the gcode before it is sent.\n";
+
+const char convert_usage_message[] = "gcode [OPTIONS] convert INPUT_FILE OUTPUT_FILE\n";
+const char convert_help_message[] =
+"Converts a gcode file between the text and the binary format.\n"
+"A text file is converted to the binary format and a binary file is converted to text.\n"
+"The binary format is about half the size of the text. Comments are removed in both cases.\n"
+"Binary files can be sent like text files and are expanded to text by the daemon, just before\n"
+"a command is sent to the printer.\n"
+"INPUT_FILE   Gcode file to convert.\n"
+"OUTPUT_FILE  File to write. An existing file is overwritten.\n"
+"With -a/--arc-tolerance, arcs are fitted into the gcode before it is converted.\n";
+
 const char alias_usage_message[] = "gcode [OPTIONS] alias ACTION\n";
 const char alias_help_message[] =
 "Manage aliases.\n"
@@ -110,6 +177,14 @@ const char *ConfigGcode::usage() const
             return list_usage_message;
         } else if ("send" == *m_command) {
             return send_usage_message;
+        } else if ("resume" == *m_command) {
+            return resume_usage_message;
+        } else if ("queue" == *m_command) {
+            return queue_usage_message;
+        } else if ("dispatch" == *m_command) {
+            return dispatch_usage_message;
+        } else if ("convert" == *m_command) {
+            return convert_usage_message;
         } else if ("alias" == *m_command) {
             return alias_usage_message;
         } else if ("sr" == *m_command) {
@@ -132,6 +207,14 @@ const char *ConfigGcode::help() const
             return list_help_message;
         } else if ("send" == *m_command) {
             return send_help_message;
+        } else if ("resume" == *m_command) {
+            return resume_help_message;
+        } else if ("queue" == *m_command) {
+            return queue_help_message;
+        } else if ("dispatch" == *m_command) {
+            return dispatch_help_message;
+        } else if ("convert" == *m_command) {
+            return convert_help_message;
         } else if ("alias" == *m_command) {
             return alias_help_message;
         } else if ("sr" == *m_command) {
@@ -172,6 +255,7 @@ void ConfigGcode::set_default()
     m_print_help = false;
     m_verbose = false;
     m_resolve_aliases = true;
+    m_arc_tolerance.reset();
 }
 
 
@@ -220,7 +304,8 @@ void ConfigGcode::load_config()
     }
     uint32_t line_counter = 0;
 
-    std::regex var_name_regex("[[:alpha:]][[:alnum:]_]*");
+    // device settings of gcoded can be restricted to one device: var_name[device_name]
+    std::regex var_name_regex("[[:alpha:]][[:alnum:]_]*(\\[[^\\][:space:]]+\\])?");
     std::regex var_value_regex("([^[:space:]\"]+)|(\"(([^\"])|(\\\\\"))*\")");
 
     while (!conf_file.eof()) {
@@ -435,6 +520,16 @@ void ConfigGcode::parse_args(int argc, char **argv)
             case 'r':
                 m_resolve_aliases = false;
                 break;
+            case 'a':
+                {
+                    std::optional<double> tolerance = parse_arc_tolerance_value(optarg);
+                    if (!tolerance) {
+                        std::string err = "Invalid argument for option -a/--arc-tolerance";
+                        throw std::runtime_error(err);
+                    }
+                    m_arc_tolerance = *tolerance;
+                }
+                break;
             case 'h':
                 m_print_help = true;
                 break;
@@ -510,6 +605,29 @@ std::optional<uint32_t> ConfigGcode::parse_mqtt_connect_retries_value(const std:
 }
 
 
+/*
+ * parse_arc_tolerance_value()
+ */
+std::optional<double> ConfigGcode::parse_arc_tolerance_value(const std::string &value) const
+{
+    size_t end;
+    double tolerance;
+    try {
+        tolerance = std::stod(value, &end);
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+    if (value.length() != end) {
+        return std::nullopt;
+    }
+    if (!(0.0 < tolerance)) {
+        return std::nullopt;
+    }
+
+    return tolerance;
+}
+
+
 
 /*
  * parse_mqtt_psk()
@@ -605,6 +723,12 @@ std::ostream& operator<<(std::ostream& out, const ConfigGcode &conf)
     }
     out << "mqtt_tls_insecure: " << ((conf.mqtt_tls_insecure())?("true"):("false")) << "\n";
     out << "resolve_aliases: " << ((conf.resolve_aliases())?("true"):("false")) << "\n";
+    out << "arc_tolerance: ";
+    if (conf.arc_tolerance()) {
+        out << *conf.arc_tolerance() << "\n";
+    } else {
+        out << "<none>\n";
+    }
     out << "verbose: " << ((conf.verbose())?("true"):("false")) << "\n";
     return out;
 }
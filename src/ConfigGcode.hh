@@ -197,6 +197,14 @@ class ConfigGcode : public MQTTConfig {
             return m_resolve_aliases;
         }
 
+        /**
+         * Returns the tolerance in mm for fitting arcs into a gcode file (see ArcFitter).
+         * No arcs are fitted, if it is not set.
+         */
+        const std::optional<double> &arc_tolerance() const {
+            return m_arc_tolerance;
+        }
+
     private:
         /**
          * sets the default configuration, which is compiled into the program.
@@ -227,6 +235,7 @@ class ConfigGcode : public MQTTConfig {
 
         std::optional<uint16_t> parse_mqtt_port_value(const std::string &value) const;
         std::optional<uint32_t> parse_mqtt_connect_retries_value(const std::string &value) const;
+        std::optional<double> parse_arc_tolerance_value(const std::string &value) const;
         std::optional<std::pair<std::string, std::string>> parse_mqtt_psk(const std::string &value) const;
 
 
@@ -252,6 +261,7 @@ class ConfigGcode : public MQTTConfig {
         std::optional<std::string> m_command;
         std::vector<std::string> m_command_args;
         bool m_resolve_aliases;
+        std::optional<double> m_arc_tolerance;
 };
 
 std::ostream& operator<<(std::ostream& out, const ConfigGcode &conf);
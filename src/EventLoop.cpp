@@ -26,14 +26,23 @@ struct UserCBHelperStruct {
     std::shared_ptr<EventLoop::UserEvent> user_event;
 };
 
+/*
+ * The helpers are freed by the finalizers of their events, i.e. after a running callback returned.
+ * Therefore, a callback may unregister itself and still use its helper. An event_del() of a
+ * finalized event does nothing.
+ */
+template<typename Helper>
+void free_helper(struct event *ev, void *arg) {
+    delete static_cast<Helper *>(arg);
+}
+
+
 void read_callback(evutil_socket_t fd, short what, void *arg) {
     ReadCBHelperStruct *helper = static_cast<ReadCBHelperStruct *>(arg);
-    if (what & (EV_READ | EV_TIMEOUT)) {
-        if (helper->onRead(fd, helper->arg)) {
-            struct timeval timeout;
-            timeout.tv_sec = 1;
-            timeout.tv_usec = 0;
-            event_add(helper->event, &timeout);
+    if (what & EV_READ) {
+        // the event is persistent, so it only has to be removed
+        if (!helper->onRead(fd, helper->arg)) {
+            event_del(helper->event);
         }
     } else {
         throw std::runtime_error("Unknown event in callback()\n");
@@ -43,12 +52,15 @@ void read_callback(evutil_socket_t fd, short what, void *arg) {
 
 void write_callback(evutil_socket_t fd, short what, void *arg) {
     WriteCBHelperStruct *helper = static_cast<WriteCBHelperStruct *>(arg);
-    if (what & (EV_WRITE | EV_TIMEOUT)) {
+    if (what & EV_WRITE) {
+        // An fd is writable almost always. Therefore, the event is only pending, while the
+        // callback has something to write. trigger_write_cb() activates it without being pending.
         if (helper->onWrite(fd, helper->arg)) {
-            struct timeval timeout;
-            timeout.tv_sec = 1;
-            timeout.tv_usec = 0;
-            event_add(helper->event, &timeout);
+            if (!event_pending(helper->event, EV_WRITE, NULL)) {
+                event_add(helper->event, NULL);
+            }
+        } else {
+            event_del(helper->event);
         }
     } else {
         throw std::runtime_error("Unknown event in callback()\n");
@@ -58,12 +70,10 @@ void write_callback(evutil_socket_t fd, short what, void *arg) {
 
 void user_callback(evutil_socket_t fd, short what, void *arg) {
     UserCBHelperStruct *helper = static_cast<UserCBHelperStruct *>(arg);
+    // only a timer is pending, a user event is just activated by UserEvent::trigger()
     if (helper->listener &&
-        helper->listener->onTrigger()) {
-        struct timeval timeout;
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
-        event_add(helper->event, &timeout);
+        !helper->listener->onTrigger()) {
+        event_del(helper->event);
     }
 }
 
@@ -71,7 +81,7 @@ void user_callback(evutil_socket_t fd, short what, void *arg) {
 /*
  * constructor()
  */
-EventLoop::EventLoop(bool realtime)
+EventLoop::EventLoop()
 {
     const std::lock_guard<std::recursive_mutex> guard(m_mutex);
     evthread_use_pthreads();
@@ -83,30 +93,6 @@ EventLoop::EventLoop(bool realtime)
     m_worker = std::thread([this]() {
             event_base_loop(m_eb, EVLOOP_NO_EXIT_ON_EMPTY);
     });
-
-    if (realtime) {
-        sched_param sch;
-        int policy;
-        int max = sched_get_priority_max(SCHED_FIFO);
-        if (-1 == max) {
-            std::string error = "Failed to get max schedule priority for SCHED_FIFO: ";
-            error += std::strerror(errno);
-            throw std::runtime_error(error);
-        }
-        int min = sched_get_priority_min(SCHED_FIFO);
-        if (-1 == min) {
-            std::string error = "Failed to get mn schedule priority for SCHED_FIFO: ";
-            error += std::strerror(errno);
-            throw std::runtime_error(error);
-        }
-        pthread_getschedparam(m_worker.native_handle(), &policy, &sch);
-        sch.sched_priority = (min + max) / 2;
-        if (pthread_setschedparam(m_worker.native_handle(), SCHED_FIFO, &sch)) {
-            std::string error = "Failed to setschedparam: ";
-            error += std::strerror(errno);
-            throw std::runtime_error(error);
-        }
-    }
 }
 
 
@@ -157,22 +143,13 @@ EventLoop::~EventLoop()
 void EventLoop::register_read_cb(int fd, bool (*onRead)(int fd, void *arg), void *arg)
 {
     const std::lock_guard<std::recursive_mutex> guard(m_mutex);
-    ReadCBHelperStruct *helper;
-    if (m_read_events.end() != m_read_events.find(fd)) {
-        event_get_assignment(m_read_events[fd], NULL, NULL, NULL, NULL, (void **)&helper);
-        event_free(helper->event);
-        helper->event = m_read_events[fd] = event_new(m_eb, fd, EV_READ, read_callback, helper);
-    } else {
-        helper = new ReadCBHelperStruct();
-        helper->event = m_read_events[fd] = event_new(m_eb, fd, EV_READ, read_callback, helper);
-    }
+    unregister_read_cb(fd);
+    ReadCBHelperStruct *helper = new ReadCBHelperStruct();
+    helper->event = m_read_events[fd] = event_new(m_eb, fd, EV_READ | EV_PERSIST, read_callback, helper);
     helper->arg = arg;
     helper->onRead = onRead;
     evutil_make_socket_nonblocking(fd);
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
-    event_add(helper->event, &timeout);
+    event_add(helper->event, NULL);
 }
 
 
@@ -182,22 +159,14 @@ void EventLoop::register_read_cb(int fd, bool (*onRead)(int fd, void *arg), void
 void EventLoop::register_write_cb(int fd, bool (*onWrite)(int fd, void *arg), void *arg)
 {
     const std::lock_guard<std::recursive_mutex> guard(m_mutex);
-    WriteCBHelperStruct *helper;
-    if (m_write_events.end() != m_write_events.find(fd)) {
-        event_get_assignment(m_write_events[fd], NULL, NULL, NULL, NULL, (void **)&helper);
-        event_free(helper->event);
-        helper->event = m_write_events[fd] = event_new(m_eb, fd, EV_WRITE, write_callback, helper);
-    } else {
-        helper = new WriteCBHelperStruct();
-        helper->event = m_write_events[fd] = event_new(m_eb, fd, EV_WRITE, write_callback, helper);
-    }
+    unregister_write_cb(fd);
+    WriteCBHelperStruct *helper = new WriteCBHelperStruct();
+    helper->event = m_write_events[fd] = event_new(m_eb, fd, EV_WRITE | EV_PERSIST, write_callback, helper);
     helper->arg = arg;
     helper->onWrite = onWrite;
     evutil_make_socket_nonblocking(fd);
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
-    event_add(helper->event, &timeout);
+    // the callback is called once and removes the event, if it has nothing to write
+    event_add(helper->event, NULL);
 }
 
 
@@ -209,6 +178,7 @@ void EventLoop::unregister_read_cb(int fd)
     const std::lock_guard<std::recursive_mutex> guard(m_mutex);
     auto fd_entry = m_read_events.find(fd);
     if (fd_entry != m_read_events.end()) {
+        event_free_finalize(0, fd_entry->second, free_helper<ReadCBHelperStruct>);
         m_read_events.erase(fd_entry);
     }
 }
@@ -222,6 +192,7 @@ void EventLoop::unregister_write_cb(int fd)
     const std::lock_guard<std::recursive_mutex> guard(m_mutex);
     auto fd_entry = m_write_events.find(fd);
     if (fd_entry != m_write_events.end()) {
+        event_free_finalize(0, fd_entry->second, free_helper<WriteCBHelperStruct>);
         m_write_events.erase(fd_entry);
     }
 }
@@ -239,9 +210,26 @@ std::shared_ptr<EventLoop::UserEvent> EventLoop::create_user_event(UserListener
     helper->listener = listener;
     helper->user_event = std::make_shared<UserEvent>(helper->event, this);
     m_user_events.push_back(helper->event);
+
+    return helper->user_event;
+}
+
+
+/*
+ * create_timer()
+ */
+std::shared_ptr<EventLoop::UserEvent> EventLoop::create_timer(UserListener *listener, std::chrono::milliseconds interval)
+{
+    const std::lock_guard<std::recursive_mutex> guard(m_mutex);
+    UserCBHelperStruct *helper;
+    helper = new UserCBHelperStruct();
+    helper->event = event_new(m_eb, -1, EV_PERSIST, user_callback, helper);
+    helper->listener = listener;
+    helper->user_event = std::make_shared<UserEvent>(helper->event, this);
+    m_user_events.push_back(helper->event);
     struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
+    timeout.tv_sec = interval.count() / 1000;
+    timeout.tv_usec = (interval.count() % 1000) * 1000;
     event_add(helper->event, &timeout);
 
     return helper->user_event;
@@ -249,7 +237,7 @@ std::shared_ptr<EventLoop::UserEvent> EventLoop::create_user_event(UserListener
 
 
 /*
- *
+ * unregister_user_event()
  */
 void EventLoop::unregister_user_event(struct event *ev)
 {
@@ -258,11 +246,11 @@ void EventLoop::unregister_user_event(struct event *ev)
     if (m_user_events.end() != event) {
         UserCBHelperStruct *helper;
         event_get_assignment(*event, NULL, NULL, NULL, NULL, (void **)&helper);
+        // waits for the listener, unless it disables its own event
         event_del_block(helper->event);
         helper->user_event = nullptr;
         helper->listener = nullptr;
-        event_free(helper->event);
-        delete helper;
+        event_free_finalize(0, helper->event, free_helper<UserCBHelperStruct>);
         auto new_end = std::remove(m_user_events.begin(), m_user_events.end(), ev);
         m_user_events.erase(new_end, m_user_events.end());
     }
@@ -8,6 +8,7 @@
 #include <memory>
 #include <mutex>
 #include <cstring>
+#include <chrono>
 
 class EventLoop {
     public:
@@ -64,48 +65,67 @@ class EventLoop {
 
         class UserListener {
             public:
+                /**
+                 * Called on the thread of the event loop after UserEvent::trigger() or after the
+                 * interval of a timer. A timer is stopped, if false is returned.
+                 */
                 virtual bool onTrigger(void) = 0;
                 virtual ~UserListener() {};
         };
 
     public:
-        EventLoop() = delete;
         EventLoop(const EventLoop &) = delete;
         EventLoop(EventLoop &&) = delete;
         EventLoop &operator=(const EventLoop &) = delete;
 
         /**
-         * Returns an instance of the event loop whit an thread, which is executed by
-         * a realtime scheduler. If the parameter realtime is set to false, the function
-         * returns an event loop without a realtiem thread.
+         * Returns the event loop for everything, which is not device I/O (see RealtimeEventLoop).
          */
-        static EventLoop &get_realtime_event_loop(bool realtime = true)
-        {
-            if (!realtime) {
-                return get_event_loop();
-            }
-            static EventLoop el(true);
-            return el;
-        }
-
         static EventLoop &get_event_loop()
         {
-            static EventLoop el(false);
+            static EventLoop el;
             return el;
         }
 
+        /**
+         * Registers a callback, which is called whenever the fd is readable, until it returns
+         * false. There are no timeouts, the callback is only called for real events or after
+         * trigger_read_cb().
+         */
         void register_read_cb(int fd, bool (*onRead)(int fd, void *arg), void *arg);
+
+        /**
+         * Registers a callback, which is called once and then whenever the fd is writable, until
+         * it returns false (i.e. nothing is left to write). Afterwards, trigger_write_cb() calls
+         * it again.
+         */
         void register_write_cb(int fd, bool (*onWrite)(int fd, void *arg), void *arg);
+
+        /**
+         * Unregisters the callbacks of the fd. These calls don't wait for a running callback, so
+         * they can be called from inside of the callback.
+         */
         void unregister_read_cb(int fd);
         void unregister_write_cb(int fd);
 
+        /**
+         * Creates an event, which calls the listener only after UserEvent::trigger().
+         */
         std::shared_ptr<UserEvent> create_user_event(UserListener *listener);
 
+        /**
+         * Creates a timer, which calls the listener every interval, until the listener returns
+         * false or the timer is disabled. UserEvent::trigger() calls the listener immediately
+         * in addition. Use it only for work, which is really periodic, since every timer wakes up
+         * the event loop.
+         */
+        std::shared_ptr<UserEvent> create_timer(UserListener *listener, std::chrono::milliseconds interval);
+
         void trigger_read_cb(int fd);
         void trigger_write_cb(int fd);
 
     private:
-        EventLoop(bool realtime = false);
+        EventLoop();
         ~EventLoop();
 
         void unregister_user_event(struct event *ev);
@@ -7,6 +7,14 @@
 #include "mqtt_messages/MsgAliases.hh"
 #include "mqtt_messages/MsgAliasesSet.hh"
 #include "mqtt_messages/MsgAliasesSetProvider.hh"
+#include "mqtt_messages/MsgUploadBegin.hh"
+#include "mqtt_messages/MsgUploadChunk.hh"
+#include "mqtt_messages/MsgUploadCommit.hh"
+#include "mqtt_messages/MsgUploadCredit.hh"
+#include "mqtt_messages/MsgJobQueue.hh"
+#include "mqtt_messages/MsgJobQueueRequest.hh"
+#include "job/PrintCheckpoint.hh"
+#include <algorithm>
 
 /*
  * Interface()
@@ -14,15 +22,39 @@
 Interface::Interface(const Config &conf, Aliases &aliases)
     : m_conf(conf),
       m_mqtt(conf),
-      m_aliases(aliases)
+      m_aliases(aliases),
+      m_queues_pending(false)
 {
     //std::cout << "Interface::" << __func__ << "\n";
+    if (0 < m_conf.job_cache_size()) {
+        // The queued jobs are kept in the job cache. The queue is loaded first, so the queued
+        // jobs are pinned before the cache removes any job.
+        std::vector<Sha256::Digest> queued_jobs;
+        try {
+            m_job_queue = std::make_unique<JobQueue>(m_conf.job_queue_file());
+            queued_jobs = m_job_queue->all_jobs();
+        } catch (const std::exception &e) {
+            m_job_queue = nullptr;
+            std::cerr << "Warning: Job queues disabled: " << e.what() << "\n";
+        }
+        try {
+            m_job_cache = std::make_unique<JobCache>(m_conf.job_cache_dir(), m_conf.job_cache_size(), queued_jobs);
+        } catch (const std::exception &e) {
+            m_job_queue = nullptr;
+            std::cerr << "Warning: Job cache disabled: " << e.what() << "\n";
+        }
+    }
+    m_queue_event = EventLoop::get_event_loop().create_user_event(this);
     {
         const std::lock_guard<std::mutex> guard(m_mutex);
         m_mqtt.register_listener(this);
         std::string topic_print_request = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/+/print_request";
+        std::string topic_upload = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/+/upload";
+        std::string topic_queue_request = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/+/queue_request";
         std::string topic_alias_set = m_conf.mqtt_prefix() + "/aliases/" + m_conf.mqtt_client_id() + "/set";
         m_mqtt.subscribe(topic_print_request);
+        m_mqtt.subscribe(topic_upload);
+        m_mqtt.subscribe(topic_queue_request);
         m_mqtt.subscribe(topic_alias_set);
         m_mqtt.start();
     }
@@ -36,6 +68,10 @@ Interface::Interface(const Config &conf, Aliases &aliases)
  */
 Interface::~Interface()
 {
+    if (m_queue_event) {
+        m_queue_event->disable();
+    }
+    m_queue_event = nullptr;
     const std::lock_guard<std::mutex> guard(m_mutex);
     Detector::get(m_conf).unregister_on_new_device(this);
     Detector::get(m_conf).for_each_device([this](const std::shared_ptr<Device> &dev) {
@@ -59,6 +95,14 @@ void Interface::on_new_device(const std::shared_ptr<Device> &dev)
         dev->register_listener(this);
     }
     on_state_change(*dev, dev->state());
+    if (m_job_queue) {
+        const std::lock_guard<std::mutex> guard(m_job_mutex);
+        try {
+            publish_queue(dev->name());
+        } catch (const std::exception &e) {
+            std::cerr << "Could not publish the job queue of " << dev->name() << ": " << e.what() << "\n";
+        }
+    }
 }
 
 
@@ -73,11 +117,14 @@ void Interface::on_state_change(Device &dev, enum Device::State new_state)
     msg_state.encode(buf);
     if (Device::State::DISCONNECTED == new_state) {
         std::string topic_pp = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/" + dev.name() + "/print_progress";
+        std::string topic_queue = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/" + dev.name() + "/queue";
         m_mqtt.publish_retained(topic.c_str(), NULL, 0);
         m_mqtt.publish_retained(topic_pp.c_str(), NULL, 0);
+        m_mqtt.publish_retained(topic_queue.c_str(), NULL, 0);
         const std::lock_guard<std::mutex> guard(m_mutex);
         m_retain_topics.erase(topic);
         m_retain_topics.erase(topic_pp);
+        m_retain_topics.erase(topic_queue);
         m_mqtt.publish(topic, buf);
     } else {
         m_mqtt.publish_retained(topic, buf);
@@ -88,6 +135,11 @@ void Interface::on_state_change(Device &dev, enum Device::State new_state)
         const std::lock_guard<std::mutex> guard(m_mutex);
         dev.unregister_listener(this);
     }
+    // an idle device starts its next queued job, a printing device prepares it. This runs with
+    // the device locked, so the job is started later by onTrigger().
+    if (Device::State::OK == new_state || Device::State::PRINTING == new_state) {
+        schedule_queues();
+    }
 }
 
 /*
@@ -97,6 +149,8 @@ void Interface::on_message(const char *topic, const char *payload, size_t payloa
 {
     const std::string print_prefix = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/";
     const std::string print_postfix = "/print_request";
+    const std::string upload_postfix = "/upload";
+    const std::string queue_postfix = "/queue_request";
     const std::string alias_topic = m_conf.mqtt_prefix() + "/aliases/" + m_conf.mqtt_client_id() + "/set";
 
     if (alias_topic == topic) {
@@ -130,6 +184,7 @@ void Interface::on_message(const char *topic, const char *payload, size_t payloa
 
         const std::vector<char> msg_buf(payload, payload + payload_len);
         MsgPrint print_msg;
+        print_msg.set_max_gcode_size(m_conf.print_request_size());
         try {
             print_msg.decode(msg_buf);
         } catch (const std::exception &e) {
@@ -137,20 +192,46 @@ void Interface::on_message(const char *topic, const char *payload, size_t payloa
             return;
         }
 
-        Device::PrintResult result = Device::PrintResult::NET_ERR_NO_DEVICE;
-        Detector &detector = Detector::get(m_conf);
-        // TODO: Implemente and use something like find_device(...)
-        detector.for_each_device([&](const std::shared_ptr<Device> &dev) {
-                if (dev->name() == device) {
-                    result = dev->print(print_msg.gcode());
-                }
-        });
+        if (print_msg.job_hash()) {
+            on_cached_print(device, print_msg);
+            return;
+        }
+        if (print_msg.resume()) {
+            on_resume(device, print_msg);
+            return;
+        }
+
+        // the job is parsed once and shared by all targets
+        const request_code code{ print_msg.request_code_part1(), print_msg.request_code_part2() };
+        print_results results = make_results(device, code, print_msg.targets(), Device::PrintResult::NET_ERR_NO_DEVICE);
+        std::shared_ptr<const GcodeJob> job;
+        try {
+            job = GcodeJob::from_string(print_msg.gcode());
+        } catch (const std::exception &e) {
+            std::cerr << "Invalid G-code: " << e.what() << "\n";
+        }
+        print_job(results, job);
+        send_print_responses(results);
+    } else if (   0 == print_prefix.compare(0, print_prefix.size(), topic, print_prefix.size())
+               && std::strlen(topic) > print_prefix.size() + upload_postfix.size()
+               && 0 == upload_postfix.compare(0, upload_postfix.size(), topic + std::strlen(topic) - upload_postfix.size())) {
 
-        MsgPrintResponse response_msg(print_msg, result);
-        std::vector<char> response_buf;
-        response_msg.encode(response_buf);
-        std::string response_topic = print_prefix + device + "/print_response";
-        m_mqtt.publish(response_topic, response_buf);
+        const char *first = topic + print_prefix.size();
+        const char *last = topic + std::strlen(topic) - upload_postfix.size();
+        const std::string device(first, last);
+
+        const std::vector<char> msg_buf(payload, payload + payload_len);
+        on_upload_message(device, msg_buf);
+    } else if (   0 == print_prefix.compare(0, print_prefix.size(), topic, print_prefix.size())
+               && std::strlen(topic) > print_prefix.size() + queue_postfix.size()
+               && 0 == queue_postfix.compare(0, queue_postfix.size(), topic + std::strlen(topic) - queue_postfix.size())) {
+
+        const char *first = topic + print_prefix.size();
+        const char *last = topic + std::strlen(topic) - queue_postfix.size();
+        const std::string device(first, last);
+
+        const std::vector<char> msg_buf(payload, payload + payload_len);
+        on_queue_request(device, msg_buf);
     } else {
         std::cerr << "Got message on unknown topic: " << topic << "\n";
     }
@@ -178,12 +259,10 @@ void Interface::on_build_progress_change(Device &device, unsigned percentage, un
 void Interface::on_sensor_update(Device &device) 
 {
     std::string topic = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/" + device.name() + "/sensor_readings";
-    MsgSensorReadings sr;
+    SensorTable::Snapshot snapshot;
     std::vector<char> buf;
-    for (const auto &value: device.sensor_readings()) {
-        sr.add_sensor_reading(value.first, value.second);
-    }
-    sr.encode(buf);
+    device.sensor_readings(snapshot);
+    MsgSensorReadings::encode(snapshot, buf);
     m_mqtt.publish_retained(topic, buf);
     const std::lock_guard<std::mutex> guard(m_mutex);
     m_retain_topics.insert(topic);
@@ -214,3 +293,625 @@ void Interface::on_alias_change()
     const std::lock_guard<std::mutex> guard(m_mutex);
     m_retain_topics.insert(topic);
 }
+
+
+/*
+ * on_upload_message()
+ */
+void Interface::on_upload_message(const std::string &device, const std::vector<char> &msg_buf)
+{
+    MsgType type;
+    try {
+        type.decode(msg_buf);
+    } catch (const std::exception &e) {
+        std::cerr << "Could not decode upload message: " << e.what() << "\n";
+        return;
+    }
+
+    try {
+        switch (type.type()) {
+            case MsgType::Type::UPLOAD_BEGIN:
+                {
+                    MsgUploadBegin begin_msg;
+                    begin_msg.decode(msg_buf);
+                    const request_code code{ begin_msg.request_code_part1(), begin_msg.request_code_part2() };
+
+                    // a repeated begin of a finished upload has lost the response
+                    if (resend_results(code)) {
+                        return;
+                    }
+
+                    // drop uploads of clients, which went away
+                    const auto now = std::chrono::steady_clock::now();
+                    for (auto iter = m_uploads.begin(); iter != m_uploads.end();) {
+                        if (now - iter->second->last_activity() > UPLOAD_TIMEOUT) {
+                            iter = m_uploads.erase(iter);
+                        } else {
+                            iter++;
+                        }
+                    }
+
+                    auto upload = m_uploads.find(code);
+                    if (m_uploads.end() == upload) {
+                        // an unknown compression of a newer client is declined, the client
+                        // falls back to uncompressed chunks
+                        const Compression::Type compression = (Compression::is_valid(begin_msg.compression()))
+                                                              ? (static_cast<Compression::Type>(begin_msg.compression()))
+                                                              : (Compression::Type::NONE);
+                        std::unique_ptr<JobUpload> new_upload;
+                        try {
+                            new_upload = std::make_unique<JobUpload>(m_conf.upload_dir(),
+                                                                     begin_msg.total_size(),
+                                                                     begin_msg.job_hash(),
+                                                                     compression);
+                        } catch (const std::exception &e) {
+                            std::cerr << "Could not start upload: " << e.what() << "\n";
+                            send_print_response(device, code, Device::PrintResult::NET_ERR_UPLOAD);
+                            return;
+                        }
+                        upload = m_uploads.emplace(code, std::move(new_upload)).first;
+                    }
+                    send_upload_credit(device, code, *upload->second);
+                }
+                break;
+
+            case MsgType::Type::UPLOAD_CHUNK:
+                {
+                    MsgUploadChunk chunk_msg;
+                    chunk_msg.decode(msg_buf);
+                    const request_code code{ chunk_msg.request_code_part1(), chunk_msg.request_code_part2() };
+                    auto upload = m_uploads.find(code);
+                    if (m_uploads.end() == upload) {
+                        return;
+                    }
+                    JobUpload &job_upload = *upload->second;
+                    if (job_upload.append(chunk_msg.sequence(), chunk_msg.data(), chunk_msg.compression())) {
+                        // the credit is extended every half window, so the client never waits
+                        // for a credit as long as no chunk is lost
+                        if (0 == job_upload.next_sequence() % (UPLOAD_WINDOW / 2)) {
+                            send_upload_credit(device, code, job_upload);
+                        }
+                    } else if (chunk_msg.sequence() > job_upload.next_sequence()) {
+                        // a chunk got lost, the client has to go back to the next expected one
+                        send_upload_credit(device, code, job_upload);
+                    }
+                }
+                break;
+
+            case MsgType::Type::UPLOAD_COMMIT:
+                {
+                    MsgUploadCommit commit_msg;
+                    commit_msg.decode(msg_buf);
+                    const request_code code{ commit_msg.request_code_part1(), commit_msg.request_code_part2() };
+                    auto upload = m_uploads.find(code);
+                    if (m_uploads.end() == upload) {
+                        if (!resend_results(code)) {
+                            send_print_responses(make_results(device, code, commit_msg.targets(), Device::PrintResult::NET_ERR_UPLOAD));
+                        }
+                        return;
+                    }
+                    if (!upload->second->complete(commit_msg.chunk_count(), commit_msg.total_size())) {
+                        send_upload_credit(device, code, *upload->second);
+                        return;
+                    }
+
+                    print_results results = make_results(device, code, commit_msg.targets(), Device::PrintResult::NET_ERR_NO_DEVICE);
+                    const JobUpload &job_upload = *upload->second;
+                    const std::optional<Sha256::Digest> job_hash = job_upload.job_hash();
+                    if (job_hash && *job_hash != job_upload.content_hash()) {
+                        std::cerr << "Uploaded job does not match its hash " << Sha256::to_hex(*job_hash) << ".\n";
+                        results = make_results(device, code, commit_msg.targets(), Device::PrintResult::NET_ERR_UPLOAD);
+                    } else {
+                        std::string file_path = job_upload.file_path();
+                        bool cached = false;
+                        if (job_hash && m_job_cache) {
+                            const std::lock_guard<std::mutex> guard(m_job_mutex);
+                            try {
+                                const auto cached_path = m_job_cache->insert(*job_hash, file_path);
+                                if (cached_path) {
+                                    file_path = cached_path->string();
+                                    cached = true;
+                                }
+                            } catch (const std::exception &e) {
+                                std::cerr << "Warning: " << e.what() << "\n";
+                            }
+                        }
+                        auto queued = std::find(m_queued_uploads.begin(), m_queued_uploads.end(), code);
+                        if (m_queued_uploads.end() == queued) {
+                            print_job(results, load_job(file_path));
+                        } else if (cached) {
+                            m_queued_uploads.erase(queued);
+                            enqueue_job(results, *job_hash);
+                        } else {
+                            // the queue references the job in the job cache
+                            m_queued_uploads.erase(queued);
+                            std::cerr << "The uploaded job " << Sha256::to_hex(*job_hash) << " could not be cached for the job queue.\n";
+                            for (auto &result: results) {
+                                result.result = Device::PrintResult::NET_ERR_NO_QUEUE;
+                            }
+                        }
+                    }
+                    m_uploads.erase(upload);
+                    finish_print(code, results);
+                }
+                break;
+
+            default:
+                std::cerr << "Got unexpected message of type " << type.type() << " for upload.\n";
+                break;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Upload failed: " << e.what() << "\n";
+    }
+}
+
+
+/*
+ * on_cached_print()
+ */
+void Interface::on_cached_print(const std::string &device, const MsgPrint &print_msg)
+{
+    const request_code code{ print_msg.request_code_part1(), print_msg.request_code_part2() };
+    // a repeated request has lost the response
+    if (resend_results(code)) {
+        return;
+    }
+
+    if (print_msg.enqueue() && !m_job_queue) {
+        finish_print(code, make_results(device, code, print_msg.targets(), Device::PrintResult::NET_ERR_NO_QUEUE));
+        return;
+    }
+
+    std::optional<std::filesystem::path> job_path;
+    if (m_job_cache) {
+        const std::lock_guard<std::mutex> guard(m_job_mutex);
+        job_path = m_job_cache->lookup(*print_msg.job_hash());
+    }
+    if (!job_path) {
+        // the client uploads the job with the same request code, the commit of the upload
+        // queues the job
+        if (print_msg.enqueue() && m_queued_uploads.end() == std::find(m_queued_uploads.begin(), m_queued_uploads.end(), code)) {
+            m_queued_uploads.push_back(code);
+            if (MAX_FINISHED_PRINTS < m_queued_uploads.size()) {
+                m_queued_uploads.pop_front();
+            }
+        }
+        send_print_response(device, code, Device::PrintResult::NET_ERR_NOT_CACHED);
+        return;
+    }
+
+    print_results results = make_results(device, code, print_msg.targets(), Device::PrintResult::NET_ERR_NO_DEVICE);
+    if (print_msg.enqueue()) {
+        enqueue_job(results, *print_msg.job_hash());
+    } else {
+        print_job(results, load_job(job_path->string()));
+    }
+    finish_print(code, results);
+}
+
+
+/*
+ * on_resume()
+ */
+void Interface::on_resume(const std::string &device, const MsgPrint &print_msg)
+{
+    const request_code code{ print_msg.request_code_part1(), print_msg.request_code_part2() };
+    // a repeated request has lost the response
+    if (resend_results(code)) {
+        return;
+    }
+
+    print_results results = make_results(device, code, PrintTargets(), Device::PrintResult::NET_ERR_NO_DEVICE);
+    const std::optional<PrintCheckpoint> checkpoint = PrintCheckpoint::load(PrintCheckpoint::path(m_conf.checkpoint_dir(), device));
+    if (!checkpoint) {
+        results.front().result = Device::PrintResult::ERR_NO_CHECKPOINT;
+        finish_print(code, results);
+        return;
+    }
+
+    std::optional<std::filesystem::path> job_path;
+    if (m_job_cache) {
+        const std::lock_guard<std::mutex> guard(m_job_mutex);
+        job_path = m_job_cache->lookup(checkpoint->job_hash);
+    }
+    std::shared_ptr<const GcodeJob> job;
+    if (job_path) {
+        job = load_job(job_path->string());
+    } else {
+        std::cerr << "The job " << Sha256::to_hex(checkpoint->job_hash) << " of the checkpoint of " << device << " is not cached.\n";
+    }
+    if (!job) {
+        results.front().result = Device::PrintResult::ERR_INVALID_JOB;
+        finish_print(code, results);
+        return;
+    }
+
+    Detector::get(m_conf).for_each_device([&](const std::shared_ptr<Device> &dev) {
+            if (dev->name() == device) {
+                results.front().result = dev->resume_job(job, *checkpoint);
+            }
+    });
+    finish_print(code, results);
+}
+
+
+/*
+ * on_queue_request()
+ */
+void Interface::on_queue_request(const std::string &device, const std::vector<char> &msg_buf)
+{
+    MsgJobQueueRequest request_msg;
+    try {
+        request_msg.decode(msg_buf);
+    } catch (const std::exception &e) {
+        std::cerr << "Could not decode job queue request: " << e.what() << "\n";
+        return;
+    }
+    if (!m_job_queue) {
+        return;
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard(m_job_mutex);
+        try {
+            bool found = false;
+            if (MsgJobQueueRequest::Action::MOVE == request_msg.action()) {
+                found = m_job_queue->move(device, request_msg.job_id(), request_msg.position());
+            } else {
+                for (const auto &entry: m_job_queue->jobs(device)) {
+                    if (entry.id == request_msg.job_id()) {
+                        found = m_job_queue->remove(device, entry.id);
+                        m_job_cache->unpin(entry.job_hash);
+                        break;
+                    }
+                }
+            }
+            if (!found) {
+                std::cerr << "The job " << request_msg.job_id() << " is not queued for " << device << ".\n";
+            }
+            // the client waits for the queue in any case
+            publish_queue(device);
+        } catch (const std::exception &e) {
+            std::cerr << "Job queue request failed: " << e.what() << "\n";
+            return;
+        }
+    }
+    // the next job may have changed
+    schedule_queues();
+}
+
+
+/*
+ * send_upload_credit()
+ */
+void Interface::send_upload_credit(const std::string &device, const request_code &code, const JobUpload &upload)
+{
+    MsgUploadCredit credit_msg(code.first,
+                               code.second,
+                               upload.next_sequence(),
+                               upload.next_sequence() + UPLOAD_WINDOW,
+                               upload.compression());
+    std::vector<char> buf;
+    credit_msg.encode(buf);
+    const std::string topic = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/" + device + "/upload_credit";
+    m_mqtt.publish(topic, buf);
+}
+
+
+/*
+ * send_print_response()
+ */
+void Interface::send_print_response(const std::string &device, const request_code &code, Device::PrintResult result)
+{
+    MsgPrintResponse response_msg(code.first, code.second, result);
+    std::vector<char> buf;
+    response_msg.encode(buf);
+    const std::string topic = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/" + device + "/print_response";
+    m_mqtt.publish(topic, buf);
+}
+
+
+/*
+ * send_print_responses()
+ */
+void Interface::send_print_responses(const print_results &results)
+{
+    for (const auto &result: results) {
+        send_print_response(result.device, result.code, result.result);
+    }
+}
+
+
+/*
+ * make_results()
+ */
+Interface::print_results Interface::make_results(const std::string &device,
+                                                 const request_code &code,
+                                                 const PrintTargets &targets,
+                                                 Device::PrintResult result)
+{
+    print_results results;
+    results.reserve(1 + targets.size());
+    results.push_back({ device, code, result });
+    for (const auto &target: targets.targets()) {
+        results.push_back({ target.device, { target.request_code_part1, target.request_code_part2 }, result });
+    }
+    return results;
+}
+
+
+/*
+ * print_job()
+ */
+void Interface::print_job(print_results &results, const std::shared_ptr<const GcodeJob> &job)
+{
+    if (!job) {
+        for (auto &result: results) {
+            result.result = Device::PrintResult::ERR_INVALID_JOB;
+        }
+        return;
+    }
+    Detector::get(m_conf).for_each_device([&](const std::shared_ptr<Device> &dev) {
+            for (auto &result: results) {
+                if (dev->name() == result.device) {
+                    result.result = dev->print_job(job);
+                }
+            }
+    });
+}
+
+
+/*
+ * enqueue_job()
+ */
+void Interface::enqueue_job(print_results &results, const Sha256::Digest &job_hash)
+{
+    std::set<std::string> devices;
+    Detector::get(m_conf).for_each_device([&devices](const std::shared_ptr<Device> &dev) {
+            devices.insert(dev->name());
+    });
+
+    {
+        const std::lock_guard<std::mutex> guard(m_job_mutex);
+        for (auto &result: results) {
+            if (0 == devices.count(result.device)) {
+                result.result = Device::PrintResult::NET_ERR_NO_DEVICE;
+                continue;
+            }
+            try {
+                m_job_queue->enqueue(result.device, job_hash);
+                m_job_cache->pin(job_hash);
+                result.result = Device::PrintResult::OK;
+                publish_queue(result.device);
+            } catch (const std::exception &e) {
+                std::cerr << "Could not queue the job for " << result.device << ": " << e.what() << "\n";
+                result.result = Device::PrintResult::NET_ERR_NO_QUEUE;
+            }
+        }
+    }
+    // an idle device starts the job immediately
+    schedule_queues();
+}
+
+
+/*
+ * publish_queue()
+ */
+void Interface::publish_queue(const std::string &device)
+{
+    MsgJobQueue queue_msg;
+    for (const auto &entry: m_job_queue->jobs(device)) {
+        queue_msg.add_job(entry.id, entry.job_hash);
+    }
+    std::vector<char> buf;
+    queue_msg.encode(buf);
+    const std::string topic = m_conf.mqtt_prefix() + "/clients/" + m_conf.mqtt_client_id() + "/" + device + "/queue";
+    m_mqtt.publish_retained(topic, buf);
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    m_retain_topics.insert(topic);
+}
+
+
+/*
+ * schedule_queues()
+ */
+void Interface::schedule_queues()
+{
+    if (!m_job_queue) {
+        return;
+    }
+    m_queues_pending = true;
+    if (m_queue_event) {
+        m_queue_event->trigger();
+    }
+}
+
+
+/*
+ * onTrigger()
+ */
+bool Interface::onTrigger()
+{
+    // several triggers may be coalesced into one call, or one call may find nothing to do
+    if (!m_queues_pending.exchange(false)) {
+        return true;
+    }
+
+    // the jobs are loaded without blocking the detector
+    std::vector<std::shared_ptr<Device>> devices;
+    Detector::get(m_conf).for_each_device([&devices](const std::shared_ptr<Device> &dev) {
+            devices.push_back(dev);
+    });
+    for (const auto &dev: devices) {
+        try {
+            start_queued_job(*dev);
+            prepare_queued_job(*dev);
+        } catch (const std::exception &e) {
+            std::cerr << "Job queue of " << dev->name() << " failed: " << e.what() << "\n";
+        }
+    }
+
+    // the prepared jobs of vanished devices are released
+    const std::lock_guard<std::mutex> guard(m_job_mutex);
+    for (auto iter = m_prepared_jobs.begin(); iter != m_prepared_jobs.end();) {
+        const bool known = devices.end() != std::find_if(devices.begin(), devices.end(), [&iter](const std::shared_ptr<Device> &dev) {
+                return dev->name() == iter->first;
+        });
+        if (known) {
+            iter++;
+        } else {
+            iter = m_prepared_jobs.erase(iter);
+        }
+    }
+    return true;
+}
+
+
+/*
+ * start_queued_job()
+ */
+void Interface::start_queued_job(Device &dev)
+{
+    while (Device::State::OK == dev.state()) {
+        JobQueue::Entry next;
+        struct prepared_job prepared;
+        std::optional<std::filesystem::path> job_path;
+        {
+            const std::lock_guard<std::mutex> guard(m_job_mutex);
+            const std::vector<JobQueue::Entry> jobs = m_job_queue->jobs(dev.name());
+            if (jobs.empty()) {
+                return;
+            }
+            next = jobs.front();
+            auto iter = m_prepared_jobs.find(dev.name());
+            if (m_prepared_jobs.end() != iter && next.id == iter->second.id) {
+                prepared = iter->second;
+            } else {
+                job_path = m_job_cache->lookup(next.job_hash);
+            }
+        }
+
+        // the job wasn't prepared, i.e. the device was idle when the job was queued. As in
+        // prepare_queued_job(), the hash is computed before m_job_mutex is locked, so the device
+        // doesn't compute it while the uploads and the queues are blocked.
+        if (!prepared.job && job_path) {
+            prepared.job = load_job(job_path->string());
+            if (prepared.job) {
+                prepared.analysis = GcodeAnalysis::analyze(*prepared.job);
+                prepared.job->content_hash();
+            }
+        }
+
+        const std::lock_guard<std::mutex> guard(m_job_mutex);
+        // the job may have been moved or cancelled meanwhile
+        const std::vector<JobQueue::Entry> jobs = m_job_queue->jobs(dev.name());
+        if (jobs.empty() || jobs.front().id != next.id) {
+            continue;
+        }
+        Device::PrintResult result = Device::PrintResult::ERR_INVALID_JOB;
+        if (prepared.job) {
+            result = dev.print_analyzed_job(prepared.job, prepared.analysis);
+        }
+        if (Device::PrintResult::ERR_INVALID_STATE == result || Device::PrintResult::ERR_PRINTING == result) {
+            // the device got busy, the job is started with the next state change
+            return;
+        }
+        m_prepared_jobs.erase(dev.name());
+        if (Device::PrintResult::OK != result) {
+            // a broken job must not block the queue
+            std::cerr << "Dropped the queued job " << Sha256::to_hex(next.job_hash) << " of " << dev.name()
+                      << ": " << Device::printres_to_str(result) << "\n";
+        }
+        m_job_queue->remove(dev.name(), next.id);
+        m_job_cache->unpin(next.job_hash);
+        publish_queue(dev.name());
+        if (Device::PrintResult::OK == result) {
+            return;
+        }
+    }
+}
+
+
+/*
+ * prepare_queued_job()
+ */
+void Interface::prepare_queued_job(Device &dev)
+{
+    JobQueue::Entry next;
+    std::optional<std::filesystem::path> job_path;
+    {
+        const std::lock_guard<std::mutex> guard(m_job_mutex);
+        const std::vector<JobQueue::Entry> jobs = m_job_queue->jobs(dev.name());
+        auto iter = m_prepared_jobs.find(dev.name());
+        if (jobs.empty() || Device::State::PRINTING != dev.state()) {
+            if (m_prepared_jobs.end() != iter) {
+                m_prepared_jobs.erase(iter);
+            }
+            return;
+        }
+        next = jobs.front();
+        if (m_prepared_jobs.end() != iter && next.id == iter->second.id) {
+            return;
+        }
+        job_path = m_job_cache->lookup(next.job_hash);
+    }
+    if (!job_path) {
+        return;
+    }
+
+    // the file is mapped and indexed, the analysis and the hash are computed, while the
+    // device prints the previous job
+    struct prepared_job prepared;
+    prepared.id = next.id;
+    prepared.job = load_job(job_path->string());
+    if (!prepared.job) {
+        return;
+    }
+    prepared.analysis = GcodeAnalysis::analyze(*prepared.job);
+    prepared.job->content_hash();
+
+    const std::lock_guard<std::mutex> guard(m_job_mutex);
+    m_prepared_jobs[dev.name()] = prepared;
+}
+
+
+/*
+ * load_job()
+ */
+std::shared_ptr<const GcodeJob> Interface::load_job(const std::string &file_path)
+{
+    try {
+        return GcodeJob::from_file(file_path);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to load G-code file: " << e.what() << "\n";
+        return nullptr;
+    }
+}
+
+
+/*
+ * finish_print()
+ */
+void Interface::finish_print(const request_code &code, const print_results &results)
+{
+    m_finished_prints.emplace_back(code, results);
+    if (MAX_FINISHED_PRINTS < m_finished_prints.size()) {
+        m_finished_prints.pop_front();
+    }
+    send_print_responses(results);
+}
+
+
+/*
+ * resend_results()
+ */
+bool Interface::resend_results(const request_code &code)
+{
+    for (const auto &finished: m_finished_prints) {
+        if (code == finished.first) {
+            send_print_responses(finished.second);
+            return true;
+        }
+    }
+    return false;
+}
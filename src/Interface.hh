@@ -5,9 +5,25 @@
 #include "MQTT.hh"
 #include "devices/Detector.hh"
 #include "Aliases.hh"
+#include "job/JobUpload.hh"
+#include "job/JobCache.hh"
+#include "job/JobQueue.hh"
+#include "job/GcodeAnalysis.hh"
+#include "EventLoop.hh"
+#include "mqtt_messages/MsgPrint.hh"
+#include "job/GcodeJob.hh"
 #include <mutex>
+#include <map>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <atomic>
 
-class Interface : public Detector::Listener, public Device::Listener, public MQTT::Listener, public Aliases::Listener {
+class Interface : public Detector::Listener,
+                  public Device::Listener,
+                  public MQTT::Listener,
+                  public Aliases::Listener,
+                  public EventLoop::UserListener {
     public:
         Interface() = delete;
         Interface(const Interface &) = delete;
@@ -22,13 +38,141 @@ class Interface : public Detector::Listener, public Device::Listener, public MQT
         virtual void on_sensor_update(Device &device) override;
         virtual void on_message(const char *topic, const char *payload, size_t payload_len) override;
         virtual void on_alias_change() override;
+
+        /**
+         * Starts the next queued job of every idle device and prepares the next queued job of
+         * every printing device (see JobQueue). It runs on the normal event loop, after
+         * schedule_queues() was called.
+         */
+        virtual bool onTrigger() override;
     
+    private:
+        typedef std::pair<uint64_t, uint64_t> request_code;
+
+        /**
+         * Handles the messages of a chunked upload (MsgUploadBegin, MsgUploadChunk and
+         * MsgUploadCommit) for the given device.
+         */
+        void on_upload_message(const std::string &device, const std::vector<char> &msg_buf);
+        /**
+         * Prints the job referenced by the hash of the MsgPrint from the job cache or answers
+         * with Device::PrintResult::NET_ERR_NOT_CACHED.
+         */
+        void on_cached_print(const std::string &device, const MsgPrint &print_msg);
+        /**
+         * Resumes the interrupted print of the device from its checkpoint (see PrintCheckpoint).
+         * The job of the checkpoint has to be in the job cache.
+         */
+        void on_resume(const std::string &device, const MsgPrint &print_msg);
+        /**
+         * Moves or cancels a queued job of the device (see MsgJobQueueRequest).
+         */
+        void on_queue_request(const std::string &device, const std::vector<char> &msg_buf);
+        void send_upload_credit(const std::string &device, const request_code &code, const JobUpload &upload);
+        void send_print_response(const std::string &device, const request_code &code, Device::PrintResult result);
+
+        // the result of a print request for one of its target devices
+        struct target_result {
+            std::string device;
+            request_code code;
+            Device::PrintResult result;
+        };
+        typedef std::vector<struct target_result> print_results;
+
+        void send_print_responses(const print_results &results);
+
+        /**
+         * Returns the results for the device of a request and all further targets, initialized
+         * with the given result.
+         */
+        static print_results make_results(const std::string &device,
+                                          const request_code &code,
+                                          const PrintTargets &targets,
+                                          Device::PrintResult result);
+
+        /**
+         * Prints the job on all devices of results and stores the results. All devices share the
+         * same job. If job is nullptr, all results are set to ERR_INVALID_JOB.
+         */
+        void print_job(print_results &results, const std::shared_ptr<const GcodeJob> &job);
+
+        /**
+         * Appends the job with the given hash to the job queues of all devices of results and
+         * stores the results. The job has to be in the job cache.
+         */
+        void enqueue_job(print_results &results, const Sha256::Digest &job_hash);
+
+        /**
+         * Publishes the job queue of the device (see MsgJobQueue). m_job_mutex has to be locked.
+         */
+        void publish_queue(const std::string &device);
+
+        /**
+         * Lets onTrigger() process the job queues.
+         */
+        void schedule_queues();
+
+        /**
+         * Starts the next job of the queue of the device, if the device is idle. A job, which
+         * can't be printed, is dropped from the queue.
+         */
+        void start_queued_job(Device &dev);
+
+        /**
+         * Loads and analyzes the next job of the queue of the device, while the device prints,
+         * so start_queued_job() doesn't have to do it.
+         */
+        void prepare_queued_job(Device &dev);
+
+        /**
+         * Loads a job from a file. Returns nullptr, if the job can't be loaded.
+         */
+        static std::shared_ptr<const GcodeJob> load_job(const std::string &file_path);
+
+        /**
+         * Keeps the results of a finished print request to answer repeated requests and sends them.
+         */
+        void finish_print(const request_code &code, const print_results &results);
+
+        /**
+         * Sends the results again, if the request with the given code is already finished.
+         */
+        bool resend_results(const request_code &code);
+
+        // number of chunks, which a client may send ahead of the last stored chunk
+        static constexpr uint32_t UPLOAD_WINDOW = 8;
+        // uploads without a new chunk are dropped after this time
+        static constexpr std::chrono::seconds UPLOAD_TIMEOUT{60};
+        // the results of the last uploads and cached prints are kept to answer repeated requests
+        static constexpr size_t MAX_FINISHED_PRINTS = 16;
+
     private:
         std::mutex m_mutex;
         const Config &m_conf;
         Aliases &m_aliases;
         MQTT m_mqtt;
         std::set<std::string> m_retain_topics;
+        // the uploads are only accessed by the MQTT thread (see on_message())
+        std::map<request_code, std::unique_ptr<JobUpload>> m_uploads;
+        std::deque<std::pair<request_code, print_results>> m_finished_prints;
+        // guards the job cache, the job queue and the prepared jobs, which are used by the MQTT
+        // thread and the normal event loop
+        std::mutex m_job_mutex;
+        // nullptr, if the job cache is disabled
+        std::unique_ptr<JobCache> m_job_cache;
+        // nullptr, if the job cache is disabled or the queue database can't be opened
+        std::unique_ptr<JobQueue> m_job_queue;
+        // the loaded and analyzed next job of the queue of a printing device
+        struct prepared_job {
+            uint64_t id;
+            std::shared_ptr<const GcodeJob> job;
+            std::shared_ptr<const GcodeAnalysis> analysis;
+        };
+        std::map<std::string, struct prepared_job> m_prepared_jobs;
+        // request codes of uploads, which are queued instead of printed after the commit
+        std::deque<request_code> m_queued_uploads;
+        std::atomic_bool m_queues_pending;
+        std::shared_ptr<EventLoop::UserEvent> m_queue_event;
 };
 
 #endif
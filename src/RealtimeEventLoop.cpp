@@ -0,0 +1,502 @@
+#include "RealtimeEventLoop.hh"
+#include "Config.hh"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+// the epoll data of the eventfd, the data of an fd contains its generation in the upper half
+static constexpr uint64_t WAKEUP_DATA = UINT64_MAX;
+
+
+/*
+ * for_device()
+ */
+RealtimeEventLoop &RealtimeEventLoop::for_device(const Config &conf, const std::string &device)
+{
+    static std::mutex mutex;
+    static std::vector<std::unique_ptr<RealtimeEventLoop>> loops;
+    static std::map<std::string, size_t> devices;
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    auto known = devices.find(device);
+    if (devices.end() != known) {
+        return *loops[known->second];
+    }
+
+    size_t index;
+    if (0 == conf.realtime_threads() || loops.size() < conf.realtime_threads()) {
+        index = loops.size();
+        std::optional<uint32_t> priority;
+        if (conf.use_realtime_scheduler()) {
+            priority = conf.realtime_priority();
+        }
+        std::optional<uint32_t> cpu;
+        if (!conf.realtime_cpus().empty()) {
+            cpu = conf.realtime_cpus()[index % conf.realtime_cpus().size()];
+        }
+        loops.push_back(std::make_unique<RealtimeEventLoop>(priority, cpu, conf.lock_memory()));
+    } else {
+        std::vector<size_t> device_counts(loops.size(), 0);
+        for (const auto &dev: devices) {
+            device_counts[dev.second]++;
+        }
+        index = std::min_element(device_counts.begin(), device_counts.end()) - device_counts.begin();
+    }
+    devices[device] = index;
+    return *loops[index];
+}
+
+
+/*
+ * RealtimeEventLoop()
+ */
+RealtimeEventLoop::RealtimeEventLoop(std::optional<uint32_t> priority, std::optional<uint32_t> cpu, bool lock_stack)
+    : m_running(true),
+      m_wakeup_pending(false),
+      m_commands_pending(false)
+{
+    for (size_t i = 0; i < PENDING_WORDS; ++i) {
+        m_read_pending[i] = 0;
+        m_write_pending[i] = 0;
+    }
+
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (0 > m_epoll_fd) {
+        throw std::runtime_error(std::string("Could not create an epoll instance: ") + std::strerror(errno));
+    }
+    m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (0 > m_wakeup_fd) {
+        close(m_epoll_fd);
+        throw std::runtime_error(std::string("Could not create an eventfd: ") + std::strerror(errno));
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKEUP_DATA;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wakeup_fd, &ev)) {
+        close(m_wakeup_fd);
+        close(m_epoll_fd);
+        throw std::runtime_error(std::string("Could not add the eventfd to epoll: ") + std::strerror(errno));
+    }
+
+    m_worker = std::thread([this, lock_stack]() {
+            if (lock_stack) {
+                prefault_stack();
+            }
+            run();
+    });
+
+    // the loop is stopped, if its thread can't be set up, since nobody can destroy it
+    try {
+        if (cpu) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(*cpu, &cpus);
+            const int ret = pthread_setaffinity_np(m_worker.native_handle(), sizeof(cpus), &cpus);
+            if (ret) {
+                std::string error = "Failed to pin the realtime thread to CPU " + std::to_string(*cpu) + ": ";
+                error += std::strerror(ret);
+                throw std::runtime_error(error);
+            }
+        }
+
+        if (priority) {
+            sched_param sch;
+            int policy;
+            int max = sched_get_priority_max(SCHED_FIFO);
+            if (-1 == max) {
+                std::string error = "Failed to get max schedule priority for SCHED_FIFO: ";
+                error += std::strerror(errno);
+                throw std::runtime_error(error);
+            }
+            int min = sched_get_priority_min(SCHED_FIFO);
+            if (-1 == min) {
+                std::string error = "Failed to get mn schedule priority for SCHED_FIFO: ";
+                error += std::strerror(errno);
+                throw std::runtime_error(error);
+            }
+            pthread_getschedparam(m_worker.native_handle(), &policy, &sch);
+            sch.sched_priority = std::clamp(int(*priority), min, max);
+            if (pthread_setschedparam(m_worker.native_handle(), SCHED_FIFO, &sch)) {
+                std::string error = "Failed to setschedparam: ";
+                error += std::strerror(errno);
+                throw std::runtime_error(error);
+            }
+        }
+    } catch (...) {
+        m_running = false;
+        wake_up();
+        m_worker.join();
+        close(m_wakeup_fd);
+        close(m_epoll_fd);
+        throw;
+    }
+}
+
+
+/*
+ * ~RealtimeEventLoop()
+ */
+RealtimeEventLoop::~RealtimeEventLoop()
+{
+    m_running = false;
+    wake_up();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    close(m_wakeup_fd);
+    close(m_epoll_fd);
+}
+
+
+/*
+ * register_read_cb()
+ */
+void RealtimeEventLoop::register_read_cb(int fd, Callback onRead, void *arg)
+{
+    if (0 > fd || MAX_FDS <= fd) {
+        throw std::runtime_error("RealtimeEventLoop::register_read_cb(): fd " + std::to_string(fd) + " is out of range.");
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    submit({ CommandType::REGISTER_READ, fd, onRead, arg });
+}
+
+
+/*
+ * register_write_cb()
+ */
+void RealtimeEventLoop::register_write_cb(int fd, Callback onWrite, void *arg)
+{
+    if (0 > fd || MAX_FDS <= fd) {
+        throw std::runtime_error("RealtimeEventLoop::register_write_cb(): fd " + std::to_string(fd) + " is out of range.");
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    submit({ CommandType::REGISTER_WRITE, fd, onWrite, arg });
+    // the callback is called once, like a new edge
+    trigger_write_cb(fd);
+}
+
+
+/*
+ * unregister_read_cb()
+ */
+void RealtimeEventLoop::unregister_read_cb(int fd)
+{
+    if (0 > fd || MAX_FDS <= fd) {
+        return;
+    }
+    submit({ CommandType::UNREGISTER_READ, fd, nullptr, nullptr });
+}
+
+
+/*
+ * unregister_write_cb()
+ */
+void RealtimeEventLoop::unregister_write_cb(int fd)
+{
+    if (0 > fd || MAX_FDS <= fd) {
+        return;
+    }
+    submit({ CommandType::UNREGISTER_WRITE, fd, nullptr, nullptr });
+}
+
+
+/*
+ * trigger_read_cb()
+ */
+void RealtimeEventLoop::trigger_read_cb(int fd)
+{
+    if (0 > fd || MAX_FDS <= fd) {
+        return;
+    }
+    trigger(m_read_pending, fd);
+}
+
+
+/*
+ * trigger_write_cb()
+ */
+void RealtimeEventLoop::trigger_write_cb(int fd)
+{
+    if (0 > fd || MAX_FDS <= fd) {
+        return;
+    }
+    trigger(m_write_pending, fd);
+}
+
+
+/*
+ * trigger()
+ */
+void RealtimeEventLoop::trigger(std::atomic<uint64_t> *pending, int fd)
+{
+    pending[fd / 64].fetch_or(uint64_t(1) << (fd % 64));
+    // the loop checks the triggers before it waits again
+    if (std::this_thread::get_id() != m_worker.get_id()) {
+        wake_up();
+    }
+}
+
+
+/*
+ * wake_up()
+ */
+void RealtimeEventLoop::wake_up()
+{
+    // several wake ups are merged into one write
+    if (!m_wakeup_pending.exchange(true)) {
+        const uint64_t value = 1;
+        if (sizeof(value) != write(m_wakeup_fd, &value, sizeof(value))) {
+            std::cerr << "RealtimeEventLoop::wake_up(): write() failed: " << std::strerror(errno) << "\n";
+        }
+    }
+}
+
+
+/*
+ * prefault_stack()
+ */
+__attribute__((noinline)) void RealtimeEventLoop::prefault_stack()
+{
+    // the frames of run() and the callbacks are placed in the same area of the stack
+    volatile char stack[STACK_PREFAULT];
+    for (size_t i = 0; i < STACK_PREFAULT; i += 256) {
+        stack[i] = 0;
+    }
+    if (mlock(const_cast<char *>(stack), STACK_PREFAULT)) {
+        std::cerr << "Warning: Could not lock the stack of a realtime thread: " << std::strerror(errno) << "\n";
+    }
+}
+
+
+/*
+ * submit()
+ */
+void RealtimeEventLoop::submit(const Command &command)
+{
+    if (std::this_thread::get_id() == m_worker.get_id()) {
+        execute(command);
+        return;
+    }
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        m_commands.push_back(command);
+    }
+    m_commands_pending = true;
+    wake_up();
+}
+
+
+/*
+ * run()
+ */
+void RealtimeEventLoop::run()
+{
+    struct epoll_event events[MAX_EVENTS];
+    while (m_running) {
+        // a callback may have triggered another callback, which is called without waiting
+        const int n = epoll_wait(m_epoll_fd, events, MAX_EVENTS, (has_triggers()) ? (0) : (-1));
+        if (0 > n) {
+            if (EINTR == errno) {
+                continue;
+            }
+            std::cerr << "RealtimeEventLoop::run(): epoll_wait() failed: " << std::strerror(errno) << "\n";
+            return;
+        }
+
+        // the commands are executed first, so an event of an fd, which is unregistered and
+        // registered again, is not given to the old callback
+        if (m_commands_pending.exchange(false)) {
+            run_commands();
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (WAKEUP_DATA == events[i].data.u64) {
+                uint64_t value;
+                if (sizeof(value) == read(m_wakeup_fd, &value, sizeof(value))) {
+                    m_wakeup_pending = false;
+                }
+                continue;
+            }
+            const int fd = events[i].data.u64 & 0xffffffff;
+            const uint32_t generation = events[i].data.u64 >> 32;
+            const Slot &slot = m_slots[fd];
+            if (!slot.in_epoll || generation != slot.generation) {
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                call_read(fd);
+            }
+            if (events[i].events & (EPOLLOUT | EPOLLERR) && m_slots[fd].write_wanted) {
+                call_write(fd);
+            }
+        }
+
+        // the commands of the wake up are executed before its triggers
+        if (m_commands_pending.exchange(false)) {
+            run_commands();
+        }
+        run_triggers();
+    }
+}
+
+
+/*
+ * run_commands()
+ */
+void RealtimeEventLoop::run_commands()
+{
+    // the vector keeps its capacity, so commands allocate only, if many are submitted at once
+    static thread_local std::vector<Command> commands;
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        commands.swap(m_commands);
+    }
+    for (const Command &command: commands) {
+        execute(command);
+    }
+    commands.clear();
+}
+
+
+/*
+ * execute()
+ */
+void RealtimeEventLoop::execute(const Command &command)
+{
+    Slot &slot = m_slots[command.fd];
+    switch (command.type) {
+        case CommandType::REGISTER_READ:
+            slot.on_read = command.callback;
+            slot.read_arg = command.arg;
+            break;
+        case CommandType::REGISTER_WRITE:
+            slot.on_write = command.callback;
+            slot.write_arg = command.arg;
+            slot.write_wanted = false;
+            break;
+        case CommandType::UNREGISTER_READ:
+            slot.on_read = nullptr;
+            slot.read_arg = nullptr;
+            break;
+        case CommandType::UNREGISTER_WRITE:
+            slot.on_write = nullptr;
+            slot.write_arg = nullptr;
+            slot.write_wanted = false;
+            break;
+    }
+    update_epoll(command.fd);
+}
+
+
+/*
+ * update_epoll()
+ */
+void RealtimeEventLoop::update_epoll(int fd)
+{
+    Slot &slot = m_slots[fd];
+    const bool needed = slot.on_read || slot.on_write;
+    if (needed == slot.in_epoll) {
+        return;
+    }
+    if (needed) {
+        slot.generation++;
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.u64 = (uint64_t(slot.generation) << 32) | uint32_t(fd);
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+            std::cerr << "RealtimeEventLoop: Could not add fd " << fd << " to epoll: " << std::strerror(errno) << "\n";
+            return;
+        }
+        slot.in_epoll = true;
+    } else {
+        // the fd may already be closed, which removed it from epoll
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        slot.in_epoll = false;
+    }
+}
+
+
+/*
+ * has_triggers()
+ */
+bool RealtimeEventLoop::has_triggers() const
+{
+    for (size_t i = 0; i < PENDING_WORDS; ++i) {
+        if (m_read_pending[i].load(std::memory_order_relaxed) || m_write_pending[i].load(std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*
+ * run_triggers()
+ */
+void RealtimeEventLoop::run_triggers()
+{
+    for (size_t i = 0; i < PENDING_WORDS; ++i) {
+        if (!m_read_pending[i].load(std::memory_order_relaxed) && !m_write_pending[i].load(std::memory_order_relaxed)) {
+            continue;
+        }
+        uint64_t reads = m_read_pending[i].exchange(0);
+        while (reads) {
+            const int bit = __builtin_ctzll(reads);
+            reads &= reads - 1;
+            call_read(i * 64 + bit);
+        }
+        uint64_t writes = m_write_pending[i].exchange(0);
+        while (writes) {
+            const int bit = __builtin_ctzll(writes);
+            writes &= writes - 1;
+            call_write(i * 64 + bit);
+        }
+    }
+}
+
+
+/*
+ * call_read()
+ */
+void RealtimeEventLoop::call_read(int fd)
+{
+    Slot &slot = m_slots[fd];
+    if (!slot.on_read) {
+        return;
+    }
+    const Callback on_read = slot.on_read;
+    if (!on_read(fd, slot.read_arg) && on_read == slot.on_read) {
+        // the callback did not register a new one, so it is removed
+        execute({ CommandType::UNREGISTER_READ, fd, nullptr, nullptr });
+    }
+}
+
+
+/*
+ * call_write()
+ */
+void RealtimeEventLoop::call_write(int fd)
+{
+    Slot &slot = m_slots[fd];
+    if (!slot.on_write) {
+        return;
+    }
+    // if the callback unregistered itself, the slot is left as it is
+    const Callback on_write = slot.on_write;
+    const bool wanted = on_write(fd, slot.write_arg);
+    if (on_write == slot.on_write) {
+        slot.write_wanted = wanted;
+    }
+}
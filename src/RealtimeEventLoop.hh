@@ -0,0 +1,164 @@
+#ifndef __REALTIME_EVENTLOOP_HH__
+#define __REALTIME_EVENTLOOP_HH__
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <optional>
+#include <string>
+#include <cstdint>
+
+class Config;
+
+/**
+ * Minimal event loop for the I/O of the devices, which runs on a realtime thread.
+ *
+ * It is built directly on epoll and eventfd instead of libevent. Every fd has a preallocated slot
+ * (the fd is the index), which is only accessed by the thread of the loop. Registrations are
+ * passed to this thread as commands and triggers are set in lock free bitmaps, so dispatching
+ * an event takes no locks and allocates no memory.
+ *
+ * The fds are registered edge triggered for reading and writing with one epoll_ctl() each.
+ * Therefore:
+ * - a read callback has to read, until read() returns EAGAIN,
+ * - a write callback is called on an edge, only if it returned true the last time (i.e. it
+ *   could not write everything). trigger_write_cb() has to be used, to write new data.
+ *
+ * The interface is the same as the one of EventLoop for fds.
+ *
+ * Every loop has its own thread. Depending on the configuration, all devices share one loop, the
+ * devices are distributed over several loops or every device gets its own loop (see
+ * for_device()).
+ */
+class RealtimeEventLoop {
+    public:
+        typedef bool (*Callback)(int fd, void *arg);
+
+        // fds up to this value can be registered
+        static constexpr int MAX_FDS = 1024;
+
+        RealtimeEventLoop(const RealtimeEventLoop &) = delete;
+        RealtimeEventLoop(RealtimeEventLoop &&) = delete;
+        RealtimeEventLoop &operator=(const RealtimeEventLoop &) = delete;
+
+        /**
+         * Returns the loop of the device. The loops are created on demand according to
+         * Config::realtime_threads(), Config::realtime_priority(), Config::realtime_cpus() and
+         * Config::lock_memory(). A device keeps its loop, if it is connected again. With several
+         * shared loops, a new device gets the loop with the fewest devices.
+         */
+        static RealtimeEventLoop &for_device(const Config &conf, const std::string &device);
+
+        /**
+         * Starts the thread of the loop. If a priority is given, the thread is executed by the
+         * realtime scheduler (SCHED_FIFO) with this priority. If a CPU is given, the thread is
+         * pinned to it. If lock_stack is true, the stack of the thread is pre-faulted and locked
+         * into RAM. Throws an std::runtime_error, if the priority or the CPU can't be set.
+         */
+        RealtimeEventLoop(std::optional<uint32_t> priority, std::optional<uint32_t> cpu, bool lock_stack);
+        ~RealtimeEventLoop();
+
+        /**
+         * Registers a callback, which is called whenever new data is readable, until it returns
+         * false. The fd is set to non blocking. Throws an std::runtime_error, if the fd is
+         * larger than MAX_FDS.
+         */
+        void register_read_cb(int fd, Callback onRead, void *arg);
+
+        /**
+         * Registers a callback, which is called once and then whenever the fd gets writable
+         * again, as long as it returns true. The fd is set to non blocking. Throws an
+         * std::runtime_error, if the fd is larger than MAX_FDS.
+         */
+        void register_write_cb(int fd, Callback onWrite, void *arg);
+
+        /**
+         * Unregisters the callbacks of the fd. These calls don't wait for the loop, so a
+         * callback may still be running. They can be called from inside of a callback.
+         */
+        void unregister_read_cb(int fd);
+        void unregister_write_cb(int fd);
+
+        /**
+         * Calls the callback of the fd on the thread of the loop. A trigger from the thread of
+         * the loop needs no system call.
+         */
+        void trigger_read_cb(int fd);
+        void trigger_write_cb(int fd);
+
+    private:
+        enum class CommandType {
+            REGISTER_READ,
+            REGISTER_WRITE,
+            UNREGISTER_READ,
+            UNREGISTER_WRITE
+        };
+
+        struct Command {
+            CommandType type;
+            int fd;
+            Callback callback;
+            void *arg;
+        };
+
+        struct Slot {
+            Callback on_read = nullptr;
+            void *read_arg = nullptr;
+            Callback on_write = nullptr;
+            void *write_arg = nullptr;
+            // the write callback could not write everything and waits for the next edge
+            bool write_wanted = false;
+            bool in_epoll = false;
+            // increased, whenever the fd is added to epoll, so events of a removed fd are ignored
+            uint32_t generation = 0;
+        };
+
+        void run();
+
+        /**
+         * Touches STACK_PREFAULT bytes of the stack of the calling thread and locks them, so the
+         * callbacks cause no page faults on the stack.
+         */
+        static void prefault_stack();
+
+        /**
+         * Executes the command directly on the thread of the loop or passes it to this thread.
+         */
+        void submit(const Command &command);
+        void execute(const Command &command);
+        void run_commands();
+        void run_triggers();
+        bool has_triggers() const;
+        void call_read(int fd);
+        void call_write(int fd);
+
+        /**
+         * Adds the fd to epoll, if it has a callback or removes it, if it has none.
+         */
+        void update_epoll(int fd);
+
+        void trigger(std::atomic<uint64_t> *pending, int fd);
+        void wake_up();
+
+        static constexpr size_t PENDING_WORDS = MAX_FDS / 64;
+        static constexpr int MAX_EVENTS = 16;
+        static constexpr size_t STACK_PREFAULT = 128 * 1024;
+
+    private:
+        int m_epoll_fd;
+        int m_wakeup_fd;
+        std::atomic<bool> m_running;
+        // set, while the eventfd is written and not yet read by the loop
+        std::atomic<bool> m_wakeup_pending;
+        std::atomic<bool> m_commands_pending;
+        // only guards m_commands, it is never locked while dispatching events
+        std::mutex m_mutex;
+        std::vector<Command> m_commands;
+        Slot m_slots[MAX_FDS];
+        std::atomic<uint64_t> m_read_pending[PENDING_WORDS];
+        std::atomic<uint64_t> m_write_pending[PENDING_WORDS];
+        std::thread m_worker;
+};
+
+#endif
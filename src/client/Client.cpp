@@ -1,6 +1,10 @@
 #include <iostream>
 #include <cstring>
 #include <functional>
+#include <list>
+#include <deque>
+#include <set>
+#include <sys/random.h>
 #include "Client.hh"
 #include "mqtt_messages/MsgDeviceState.hh"
 #include "mqtt_messages/MsgPrint.hh"
@@ -10,6 +14,11 @@
 #include "mqtt_messages/MsgAliases.hh"
 #include "mqtt_messages/MsgAliasesSet.hh"
 #include "mqtt_messages/MsgAliasesSetProvider.hh"
+#include "mqtt_messages/MsgUploadBegin.hh"
+#include "mqtt_messages/MsgUploadChunk.hh"
+#include "mqtt_messages/MsgUploadCommit.hh"
+#include "mqtt_messages/MsgUploadCredit.hh"
+#include "mqtt_messages/MsgJobQueueRequest.hh"
 
 /*
  * Client()
@@ -102,13 +111,17 @@ Client::Client(const ConfigGcode &conf)
 
     std::string state_topic = conf.mqtt_prefix() + "/clients/+/+/state";
     std::string print_topic = conf.mqtt_prefix() + "/clients/+/+/print_response";
+    std::string upload_credit_topic = conf.mqtt_prefix() + "/clients/+/+/upload_credit";
     std::string print_progress_topic = conf.mqtt_prefix() + "/clients/+/+/print_progress";
     std::string sensor_readings_topic = conf.mqtt_prefix() + "/clients/+/+/sensor_readings";
+    std::string queue_topic = conf.mqtt_prefix() + "/clients/+/+/queue";
     std::string aliases_topic = conf.mqtt_prefix() + "/aliases/+";
     m_mqtt.subscribe(state_topic);
     m_mqtt.subscribe(print_topic);
+    m_mqtt.subscribe(upload_credit_topic);
     m_mqtt.subscribe(print_progress_topic);
     m_mqtt.subscribe(sensor_readings_topic);
+    m_mqtt.subscribe(queue_topic);
     m_mqtt.subscribe(aliases_topic);
 
     m_mqtt.start();
@@ -128,6 +141,48 @@ Client::Client(const ConfigGcode &conf)
                         iter++;
                     }
                 }
+                for (auto iter = m_uploads.begin(); iter != m_uploads.end();) {
+                    struct upload_helper &upload = iter->second;
+                    if (now <= upload.timeout) {
+                        iter++;
+                    } else if (UPLOAD_RETRIES <= upload.retries) {
+                        for (const auto &pending: upload.pending) {
+                            upload.callback(*pending.second, Device::PrintResult::NET_ERR_TIMEOUT);
+                            m_upload_targets.erase(pending.first);
+                        }
+                        iter = m_uploads.erase(iter);
+                    } else {
+                        // A begin for a running upload only requests a new credit, which tells
+                        // the upload state of the daemon. A lost commit is just sent again.
+                        std::vector<char> payload;
+                        if (!upload.uploading) {
+                            MsgPrint print(iter->first.first, iter->first.second, upload.job->content_hash());
+                            print.set_targets(upload.targets);
+                            print.set_enqueue(upload.enqueue);
+                            print.encode(payload);
+                            m_mqtt.publish(upload.print_topic, payload);
+                            upload.retries++;
+                            upload.timeout = now + UPLOAD_TIMEOUT;
+                            iter++;
+                            continue;
+                        }
+                        if (upload.committed) {
+                            MsgUploadCommit commit(iter->first.first, iter->first.second, upload.chunk_lines.size() - 1, upload.total_size);
+                            commit.set_targets(upload.targets);
+                            commit.encode(payload);
+                        } else {
+                            MsgUploadBegin begin(iter->first.first, iter->first.second, upload.total_size, UPLOAD_CHUNK_SIZE);
+                            begin.set_job_hash(upload.job->content_hash());
+                            begin.set_compression(UPLOAD_COMPRESSION);
+                            begin.encode(payload);
+                        }
+                        m_mqtt.publish(upload.topic, payload);
+                        upload.rewound_to.reset();
+                        upload.retries++;
+                        upload.timeout = now + UPLOAD_TIMEOUT;
+                        iter++;
+                    }
+                }
             }
         }
     });
@@ -159,8 +214,10 @@ void Client::on_message(const char *topic, const char *payload, size_t payload_l
     const std::string alias_prefix = m_conf.mqtt_prefix() + "/aliases/";
     const std::string state_postfix = "/state";
     const std::string print_postfix = "/print_response";
+    const std::string upload_credit_postfix = "/upload_credit";
     const std::string print_progress_postfix = "/print_progress";
     const std::string sensor_readings_postfix = "/sensor_readings";
+    const std::string queue_postfix = "/queue";
 
     if (0 == prefix.compare(0, prefix.size(), topic, prefix.size())) {
         if (   0 <= std::strlen(topic) - state_postfix.size()
@@ -255,12 +312,112 @@ void Client::on_message(const char *topic, const char *payload, size_t payload_l
             const std::lock_guard<std::mutex> guard(m_mutex);
             auto iter = m_print_callbacks.find(key);
             if (m_print_callbacks.end() == iter) {
+                // the response may belong to a further target of an upload
+                auto target_iter = m_upload_targets.find(key);
+                auto upload_iter = m_uploads.find((m_upload_targets.end() == target_iter) ? key : target_iter->second);
+                if (m_uploads.end() == upload_iter) {
+                    return;
+                }
+                struct upload_helper &upload = upload_iter->second;
+                if (Device::PrintResult::NET_ERR_NOT_CACHED == msg_response.print_result()) {
+                    // a repeated answer to the cache request, while the job is already uploaded
+                    if (upload.uploading || upload_iter->first != key) {
+                        return;
+                    }
+                    upload.uploading = true;
+                    upload.timeout = std::chrono::steady_clock::now() + UPLOAD_TIMEOUT;
+                    upload.retries = 0;
+                    MsgUploadBegin begin(key.first, key.second, upload.total_size, UPLOAD_CHUNK_SIZE);
+                    begin.set_job_hash(upload.job->content_hash());
+                    begin.set_compression(UPLOAD_COMPRESSION);
+                    std::vector<char> payload;
+                    begin.encode(payload);
+                    m_mqtt.publish(upload.topic, payload);
+                    return;
+                }
+                // all responses are sent again, if a request is repeated
+                auto pending = upload.pending.find(key);
+                if (upload.pending.end() == pending) {
+                    return;
+                }
+                upload.callback(*pending->second, msg_response.print_result());
+                upload.pending.erase(pending);
+                m_upload_targets.erase(key);
+                if (upload.pending.empty()) {
+                    m_uploads.erase(upload_iter);
+                }
                 return;
             }
             iter->second.callback(*iter->second.device, msg_response.print_result());
             m_print_callbacks.erase(iter);
             return;
 
+        } else if (   std::strlen(topic) >= queue_postfix.size()
+                   && 0 == queue_postfix.compare(0, queue_postfix.size(), topic + std::strlen(topic) - queue_postfix.size())) {
+            const char *first = topic + prefix.size();
+            const char *last = topic + std::strlen(topic) - queue_postfix.size();
+            const char *pos = std::find(first, last, '/');
+            if (pos >= last) {
+                std::cerr << "Unexpected topic format: " << topic << "\n";
+                return;
+            }
+            const std::pair<std::string, std::string> key(std::string(first, pos), std::string(pos + 1, last));
+
+            const std::lock_guard<std::mutex> guard(m_mutex);
+            // the retained queue is deleted, if the device vanishes
+            if (0 == payload_len) {
+                m_job_queues.erase(key);
+                return;
+            }
+            const std::vector<char> msg_buf(payload, payload + payload_len);
+            MsgJobQueue msg_queue;
+            try {
+                msg_queue.decode(msg_buf);
+            } catch (const std::exception &e) {
+                std::cerr << "Invalid job queue: " << e.what() << "\n";
+                return;
+            }
+            m_job_queues[key] = msg_queue.jobs();
+            return;
+
+        } else if (   0 <= std::strlen(topic) - upload_credit_postfix.size()
+                   && 0 == upload_credit_postfix.compare(0, upload_credit_postfix.size(), topic + std::strlen(topic) - upload_credit_postfix.size())) {
+            const std::vector<char> msg_buf(payload, payload + payload_len);
+            MsgUploadCredit msg_credit;
+            try {
+                msg_credit.decode(msg_buf);
+            } catch (const std::exception &e) {
+                std::cerr << "Invalid upload credit: " << e.what() << "\n";
+                return;
+            }
+
+            std::pair<uint64_t, uint64_t> key{ msg_credit.request_code_part1(), msg_credit.request_code_part2() };
+            const std::lock_guard<std::mutex> guard(m_mutex);
+            auto iter = m_uploads.find(key);
+            if (m_uploads.end() == iter) {
+                return;
+            }
+            struct upload_helper &upload = iter->second;
+            upload.acknowledged = msg_credit.acknowledged();
+            upload.credit = std::max(upload.credit, msg_credit.credit());
+            upload.compression = msg_credit.compression();
+            m_provider_compression[upload.device->provider] = upload.compression;
+            // The daemon is missing a chunk (i.e. it was lost), so go back to the first missing
+            // chunk. Further credits with the same acknowledgement are caused by the chunks in
+            // flight and must not trigger another go back.
+            if (   upload.acknowledged < upload.next_sequence
+                && (!upload.rewound_to || *upload.rewound_to != upload.acknowledged)) {
+                upload.next_sequence = upload.acknowledged;
+                upload.rewound_to = upload.acknowledged;
+                upload.committed = false;
+            } else if (upload.acknowledged >= upload.next_sequence) {
+                upload.rewound_to.reset();
+            }
+            upload.timeout = std::chrono::steady_clock::now() + UPLOAD_TIMEOUT;
+            upload.retries = 0;
+            send_chunks(key, upload);
+            return;
+
         } else if (   0 <= std::strlen(topic) - print_progress_postfix.size()
                    && 0 == print_progress_postfix.compare(0, print_progress_postfix.size(), topic + std::strlen(topic) - print_progress_postfix.size())) {
             const char *first = topic + prefix.size();
@@ -715,7 +872,15 @@ void Client::print(const Client::DeviceInfo &dev, const std::string &gcode, std:
         return;
     }
 
-    MsgPrint print(gcode);
+    Compression::Type compression = Compression::Type::NONE;
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        auto iter = m_provider_compression.find(dev.provider);
+        if (m_provider_compression.end() != iter) {
+            compression = iter->second;
+        }
+    }
+    MsgPrint print(gcode, compression);
     std::pair<uint64_t, uint64_t> key{ print.request_code_part1(), print.request_code_part2() };
     // TODO: Make the timeout configurable!
     struct print_callback_helper value(std::chrono::steady_clock::now() + 1s, callback, dev);
@@ -730,6 +895,338 @@ void Client::print(const Client::DeviceInfo &dev, const std::string &gcode, std:
 }
 
 
+/*
+ * resume()
+ */
+void Client::resume(const Client::DeviceInfo &dev, std::function<void(const DeviceInfo &dev, Device::PrintResult)> callback)
+{
+    if (dev.state != Device::State::OK) {
+        callback(dev, Device::PrintResult::ERR_INVALID_STATE);
+        return;
+    }
+
+    MsgPrint print;
+    print.set_resume(true);
+    std::pair<uint64_t, uint64_t> key{ print.request_code_part1(), print.request_code_part2() };
+    struct print_callback_helper value(std::chrono::steady_clock::now() + RESUME_TIMEOUT, callback, dev);
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        m_print_callbacks.emplace(std::pair(key, value));
+    }
+    std::vector<char> payload;
+    print.encode(payload);
+    std::string topic = m_conf.mqtt_prefix() + "/clients/" + dev.provider + "/" + dev.name + "/print_request";
+    m_mqtt.publish(topic, payload);
+}
+
+
+/*
+ * print_job()
+ */
+void Client::print_job(const std::vector<DeviceInfo> &devices,
+                       const std::shared_ptr<const GcodeJob> &job,
+                       std::function<void(const DeviceInfo &, Device::PrintResult)> callback,
+                       bool enqueue)
+{
+    // the job is requested and uploaded only once for all devices of a provider
+    std::map<std::string, std::vector<const DeviceInfo *>> providers;
+    for (const auto &dev: devices) {
+        // a busy device prints a queued job later
+        if (dev.state != Device::State::OK && !enqueue) {
+            callback(dev, Device::PrintResult::ERR_INVALID_STATE);
+            continue;
+        }
+        providers[dev.provider].push_back(&dev);
+    }
+    if (providers.empty()) {
+        return;
+    }
+
+    // the uploaded job contains no comments and blank lines
+    const uint64_t total_size = job->serialized_size();
+
+    for (const auto &provider: providers) {
+        const DeviceInfo &dev = *provider.second.front();
+        // the hash is calculated only once for a job, even if it is printed on many devices
+        MsgPrint print(job->content_hash());
+        std::pair<uint64_t, uint64_t> key{ print.request_code_part1(), print.request_code_part2() };
+
+        struct upload_helper upload;
+        upload.timeout = std::chrono::steady_clock::now() + UPLOAD_TIMEOUT;
+        upload.callback = callback;
+        upload.device = &dev;
+        upload.pending[key] = &dev;
+        // every further device gets its own request code, so its response can be assigned
+        for (size_t i = 1; i < provider.second.size(); ++i) {
+            const DeviceInfo *target = provider.second[i];
+            std::pair<uint64_t, uint64_t> target_code;
+            constexpr size_t len = sizeof(uint64_t);
+            if (   len != getrandom(&target_code.first, len, 0)
+                || len != getrandom(&target_code.second, len, 0)) {
+                throw std::runtime_error("Could not get random number from OS for a print target!");
+            }
+            upload.targets.add(target_code.first, target_code.second, target->name);
+            upload.pending[target_code] = target;
+        }
+        upload.job = job;
+        upload.print_topic = m_conf.mqtt_prefix() + "/clients/" + dev.provider + "/" + dev.name + "/print_request";
+        upload.topic = m_conf.mqtt_prefix() + "/clients/" + dev.provider + "/" + dev.name + "/upload";
+        upload.uploading = false;
+        upload.total_size = total_size;
+        upload.chunk_lines.push_back(0);
+        upload.next_sequence = 0;
+        upload.acknowledged = 0;
+        // nothing is sent before the daemon grants the first credit
+        upload.credit = 0;
+        upload.committed = false;
+        upload.retries = 0;
+        upload.compression = Compression::Type::NONE;
+        upload.enqueue = enqueue;
+
+        print.set_targets(upload.targets);
+        print.set_enqueue(enqueue);
+        std::vector<char> payload;
+        print.encode(payload);
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        for (const auto &pending: upload.pending) {
+            if (pending.first != key) {
+                m_upload_targets[pending.first] = key;
+            }
+        }
+        m_uploads.emplace(key, std::move(upload));
+        m_mqtt.publish(m_uploads.at(key).print_topic, payload);
+    }
+}
+
+
+/*
+ * dispatch()
+ */
+void Client::dispatch(const std::vector<std::shared_ptr<const GcodeJob>> &jobs,
+                      const std::string &hint,
+                      std::function<void(size_t, const DeviceInfo &, Device::PrintResult)> callback)
+{
+    struct assignment {
+        size_t job;
+        // print_job() keeps a pointer to the device until it calls the callback
+        std::vector<DeviceInfo> devices;
+    };
+    // the results are reported by the MQTT thread while m_mutex is locked, therefore they are
+    // only collected there and handled here
+    std::mutex results_mutex;
+    std::vector<std::pair<const struct assignment *, Device::PrintResult>> results;
+    std::list<struct assignment> assignments;
+
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        pending.push_back(i);
+    }
+    std::vector<unsigned> attempts(jobs.size(), 0);
+    std::set<std::pair<std::string, std::string>> in_flight;
+    std::set<std::pair<std::string, std::string>> without_queue;
+    std::map<std::pair<std::string, std::string>, std::chrono::steady_clock::time_point> settling;
+    size_t done = 0;
+
+    while (done < jobs.size()) {
+        std::vector<std::pair<const struct assignment *, Device::PrintResult>> finished;
+        {
+            const std::lock_guard<std::mutex> guard(results_mutex);
+            finished.swap(results);
+        }
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto &result: finished) {
+            const struct assignment &assignment = *result.first;
+            const DeviceInfo &dev = assignment.devices.front();
+            const std::pair<std::string, std::string> key{ dev.provider, dev.name };
+            in_flight.erase(key);
+            settling[key] = now + DISPATCH_SETTLE_TIME;
+            if (Device::PrintResult::NET_ERR_NO_QUEUE == result.second) {
+                // the job is not counted as refused, the device just gets jobs only while it is idle
+                without_queue.insert(key);
+                pending.push_front(assignment.job);
+                settling.erase(key);
+            } else if (   Device::PrintResult::ERR_INVALID_STATE == result.second
+                       || Device::PrintResult::ERR_PRINTING == result.second) {
+                // another client was faster, the job goes to the next free device
+                pending.push_front(assignment.job);
+            } else if (   Device::PrintResult::OK == result.second
+                       || Device::PrintResult::ERR_INVALID_JOB == result.second
+                       || DISPATCH_RETRIES <= ++attempts[assignment.job]) {
+                callback(assignment.job, dev, result.second);
+                ++done;
+            } else {
+                pending.push_front(assignment.job);
+            }
+        }
+
+        const DeviceInfo *best = nullptr;
+        std::unique_ptr<std::vector<DeviceInfo>> devices;
+        if (!pending.empty()) {
+            devices = this->devices(hint);
+            for (const auto &dev: *devices) {
+                const std::pair<std::string, std::string> key{ dev.provider, dev.name };
+                if (in_flight.count(key)) {
+                    continue;
+                }
+                auto settle = settling.find(key);
+                if (settling.end() != settle) {
+                    if (now < settle->second) {
+                        continue;
+                    }
+                    settling.erase(settle);
+                }
+                const bool idle = Device::State::OK == dev.state;
+                if (   (!idle && Device::State::PRINTING != dev.state)
+                    || (!idle && without_queue.count(key))
+                    || !job_queue(dev).empty()) {
+                    continue;
+                }
+                if (!best) {
+                    best = &dev;
+                    continue;
+                }
+                const bool best_idle = Device::State::OK == best->state;
+                if (best_idle) {
+                    continue;
+                }
+                if (   idle
+                    || dev.print_remaining_time < best->print_remaining_time
+                    || (   dev.print_remaining_time == best->print_remaining_time
+                        && dev.print_percentage > best->print_percentage)) {
+                    best = &dev;
+                }
+            }
+        }
+
+        if (!best) {
+            std::this_thread::sleep_for(DISPATCH_POLL_INTERVAL);
+            continue;
+        }
+
+        // the next job is assigned at once, since more devices may be free
+        const std::pair<std::string, std::string> key{ best->provider, best->name };
+        in_flight.insert(key);
+        assignments.push_back({ pending.front(), { *best } });
+        pending.pop_front();
+        const struct assignment *assignment = &assignments.back();
+        print_job(assignment->devices,
+                  jobs[assignment->job],
+                  [&results_mutex, &results, assignment](const DeviceInfo &, Device::PrintResult result) {
+                      const std::lock_guard<std::mutex> guard(results_mutex);
+                      results.emplace_back(assignment, result);
+                  },
+                  !without_queue.count(key));
+    }
+}
+
+
+/*
+ * job_queue()
+ */
+std::vector<MsgJobQueue::Job> Client::job_queue(const DeviceInfo &dev)
+{
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    auto iter = m_job_queues.find({ dev.provider, dev.name });
+    if (m_job_queues.end() == iter) {
+        return std::vector<MsgJobQueue::Job>();
+    }
+    return iter->second;
+}
+
+
+/*
+ * move_job()
+ */
+void Client::move_job(const DeviceInfo &dev, uint64_t job_id, uint32_t position)
+{
+    MsgJobQueueRequest request(MsgJobQueueRequest::Action::MOVE, job_id, position);
+    std::vector<char> payload;
+    request.encode(payload);
+    const std::string topic = m_conf.mqtt_prefix() + "/clients/" + dev.provider + "/" + dev.name + "/queue_request";
+    m_mqtt.publish(topic, payload);
+}
+
+
+/*
+ * cancel_job()
+ */
+void Client::cancel_job(const DeviceInfo &dev, uint64_t job_id)
+{
+    MsgJobQueueRequest request(MsgJobQueueRequest::Action::CANCEL, job_id);
+    std::vector<char> payload;
+    request.encode(payload);
+    const std::string topic = m_conf.mqtt_prefix() + "/clients/" + dev.provider + "/" + dev.name + "/queue_request";
+    m_mqtt.publish(topic, payload);
+}
+
+
+/*
+ * send_chunks()
+ */
+void Client::send_chunks(const std::pair<uint64_t, uint64_t> &key, struct upload_helper &upload)
+{
+    std::vector<char> payload;
+    const size_t job_lines = upload.job->size();
+    while (upload.next_sequence < upload.credit) {
+        // all chunks are built and the last one was sent
+        if (   upload.next_sequence + 1 == upload.chunk_lines.size()
+            && job_lines == upload.chunk_lines.back()) {
+            break;
+        }
+        const std::string_view data = build_chunk(upload, upload.next_sequence);
+        MsgUploadChunk chunk(key.first, key.second, upload.next_sequence, data, upload.compression);
+        chunk.encode(payload);
+        m_mqtt.publish(upload.topic, payload);
+        upload.next_sequence++;
+    }
+
+    if (   !upload.committed
+        && upload.next_sequence + 1 == upload.chunk_lines.size()
+        && job_lines == upload.chunk_lines.back()) {
+        MsgUploadCommit commit(key.first, key.second, upload.next_sequence, upload.total_size);
+        commit.set_targets(upload.targets);
+        commit.encode(payload);
+        m_mqtt.publish(upload.topic, payload);
+        upload.committed = true;
+    }
+}
+
+
+/*
+ * build_chunk()
+ */
+std::string_view Client::build_chunk(struct upload_helper &upload, uint32_t sequence)
+{
+    upload.chunk.clear();
+    if (0 == sequence) {
+        upload.chunk += upload.job->serialized_header();
+    }
+    const size_t job_lines = upload.job->size();
+    size_t line = upload.chunk_lines[sequence];
+    // a chunk contains at least one line, even if it is larger than the chunk size
+    while (line < job_lines) {
+        if (!upload.chunk.empty() && upload.chunk.size() + upload.job->serialized_size(line) > UPLOAD_CHUNK_SIZE) {
+            break;
+        }
+        upload.job->serialize(line, upload.chunk);
+        line++;
+    }
+
+    if (sequence + 1 == upload.chunk_lines.size()) {
+        upload.chunk_lines.push_back(line);
+    }
+
+    if (Compression::Type::NONE == upload.compression) {
+        return upload.chunk;
+    }
+    // every chunk is a stream of its own, so it can be built again after a go back
+    upload.compressed_chunk.clear();
+    m_deflater.add(upload.chunk, upload.compressed_chunk);
+    m_deflater.finish(upload.compressed_chunk);
+    return upload.compressed_chunk;
+}
+
+
 /*
  * get_provider_aliases()
  */
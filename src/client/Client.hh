@@ -9,6 +9,10 @@
 #include "../devices/Device.hh"
 #include "../ConfigGcode.hh"
 #include "../MQTT.hh"
+#include "../job/GcodeJob.hh"
+#include "../job/Compression.hh"
+#include "../mqtt_messages/PrintTargets.hh"
+#include "../mqtt_messages/MsgJobQueue.hh"
 
 class Client : public MQTT::Listener {
     public:
@@ -37,9 +41,75 @@ class Client : public MQTT::Listener {
         // TODO: Documentation
         std::unique_ptr<std::vector<DeviceInfo>> devices(const std::string &hint = "*");
         std::unique_ptr<std::vector<DeviceInfo>> devices(const std::string &hint, bool resolve_aliases);
-        // TODO: Documentation
+        /**
+         * Sends the G-code within the print request. The G-code is compressed only, if the daemon
+         * of the provider already confirmed the compression for an upload (see MsgUploadCredit),
+         * otherwise it is sent uncompressed.
+         */
         void print(const DeviceInfo &dev, const std::string &gcode, std::function<void(const DeviceInfo &, Device::PrintResult)> callback);
 
+        /**
+         * Prints the job on all devices. The devices are grouped by their provider and the job
+         * is sent only once to each provider, which prints it on all of its devices (see
+         * PrintTargets). At first, the job is requested by its hash from the job cache of the
+         * daemon (see MsgPrint). Only if the daemon doesn't have the job, it is uploaded in chunks
+         * (see MsgUploadBegin). The chunks are built from the job on demand and compressed, if the
+         * daemon supports it, therefore only one chunk is held in memory independent of the size
+         * of the job. The callback is called once for every device with its result. The devices
+         * have to be valid until then.
+         *
+         * If enqueue is set, the job is appended to the job queues of the devices instead (see
+         * JobQueue) and the devices don't have to be idle. The result OK tells, that the job is
+         * queued.
+         */
+        void print_job(const std::vector<DeviceInfo> &devices,
+                       const std::shared_ptr<const GcodeJob> &job,
+                       std::function<void(const DeviceInfo &, Device::PrintResult)> callback,
+                       bool enqueue = false);
+
+        /**
+         * Resumes the interrupted print of the device from the checkpoint, which the daemon stored
+         * while printing (see PrintCheckpoint). The job of the checkpoint has to be in the job
+         * cache of the daemon. The callback is called with the result.
+         */
+        void resume(const DeviceInfo &dev, std::function<void(const DeviceInfo &, Device::PrintResult)> callback);
+
+        /**
+         * Dispatches a batch of jobs to the devices, which match the hint. The hint selects the
+         * compatible devices, i.e. all printers of the same model. Every job is assigned to the
+         * least loaded device: idle devices first, then the printing device, which finishes first
+         * (see DeviceInfo::print_remaining_time). The job is put into the job queue of the device,
+         * so the device starts it right after the current print (see print_job()). A device gets
+         * only one queued job at a time, therefore the remaining jobs go to the devices, which get
+         * free first. Devices without job queue only get jobs, while they are idle.
+         *
+         * The callback is called once for every job with its index in jobs and the device, which
+         * accepted it. A job, which is refused DISPATCH_RETRIES times (i.e. upload failures), is
+         * given up with the last result. The call blocks, until all jobs are assigned or given up.
+         * It waits for devices as long as necessary.
+         */
+        void dispatch(const std::vector<std::shared_ptr<const GcodeJob>> &jobs,
+                      const std::string &hint,
+                      std::function<void(size_t, const DeviceInfo &, Device::PrintResult)> callback);
+
+        /**
+         * Returns the job queue of the device as last published by the daemon, the next job
+         * first.
+         */
+        std::vector<MsgJobQueue::Job> job_queue(const DeviceInfo &dev);
+
+        /**
+         * Moves the queued job with the given id to the position in the queue of the device (0 is
+         * the next job). The daemon publishes the changed queue, an unknown id is ignored.
+         */
+        void move_job(const DeviceInfo &dev, uint64_t job_id, uint32_t position);
+
+        /**
+         * Removes the queued job with the given id from the queue of the device. The daemon
+         * publishes the changed queue, an unknown id is ignored.
+         */
+        void cancel_job(const DeviceInfo &dev, uint64_t job_id);
+
         /**
          * Returns a map of all provider aliases. Thereby, the map key is the provider original name
          * and the map value is the alias name.
@@ -84,6 +154,35 @@ class Client : public MQTT::Listener {
          */
         std::pair<std::string, std::string> convert_hint(const std::string &hint) const;
 
+        struct upload_helper;
+
+        /**
+         * Sends all chunks of the upload, which are allowed by the credit of the daemon, and
+         * commits the upload after the last chunk. m_mutex has to be locked.
+         */
+        void send_chunks(const std::pair<uint64_t, uint64_t> &key, struct upload_helper &upload);
+
+        /**
+         * Builds the chunk with the given sequence number and returns its data, compressed with
+         * upload.compression. The data is valid until the next call. m_mutex has to be locked.
+         */
+        std::string_view build_chunk(struct upload_helper &upload, uint32_t sequence);
+
+        // compression offered to the daemon for uploads
+        static constexpr Compression::Type UPLOAD_COMPRESSION = Compression::Type::DEFLATE;
+        // maximum size of the uncompressed data of a chunk
+        static constexpr uint32_t UPLOAD_CHUNK_SIZE = 64 * 1024;
+        // time to wait for a credit or response of the daemon, before the upload is resumed
+        static constexpr std::chrono::seconds UPLOAD_TIMEOUT{2};
+        static constexpr unsigned UPLOAD_RETRIES = 5;
+        // the daemon loads and checks the whole job, before it answers a resume request
+        static constexpr std::chrono::seconds RESUME_TIMEOUT{30};
+        // a device is not refilled for this time after it accepted a job or refused it, since its
+        // new state and job queue are published asynchronously
+        static constexpr std::chrono::seconds DISPATCH_SETTLE_TIME{10};
+        static constexpr std::chrono::milliseconds DISPATCH_POLL_INTERVAL{100};
+        static constexpr unsigned DISPATCH_RETRIES = 5;
+
     private:
         const ConfigGcode &m_conf;
         MQTT m_mqtt;
@@ -107,6 +206,49 @@ class Client : public MQTT::Listener {
             {}
         };
         std::map<std::pair<uint64_t, uint64_t>, struct print_callback_helper> m_print_callbacks;
+
+        struct upload_helper {
+            std::chrono::time_point<std::chrono::steady_clock> timeout;
+            std::function<void(const DeviceInfo, Device::PrintResult)> callback;
+            // the device, which receives the upload
+            const DeviceInfo *device;
+            // further devices of the same provider, which print the job
+            PrintTargets targets;
+            // all devices without a response by their request code
+            std::map<std::pair<uint64_t, uint64_t>, const DeviceInfo *> pending;
+            std::shared_ptr<const GcodeJob> job;
+            // topics of the print requests and the upload messages of the device
+            std::string print_topic;
+            std::string topic;
+            // false, as long as the daemon is asked for the job in its job cache
+            bool uploading;
+            uint64_t total_size;
+            // first line of each chunk, the last entry is the end of the last built chunk
+            std::vector<size_t> chunk_lines;
+            uint32_t next_sequence;
+            uint32_t acknowledged;
+            uint32_t credit;
+            // the sequence number of the last go back, repeated requests for it are ignored
+            std::optional<uint32_t> rewound_to;
+            bool committed;
+            unsigned retries;
+            // compression of the chunks, as confirmed by the daemon
+            Compression::Type compression;
+            // the job is queued instead of printed
+            bool enqueue;
+            // buffers of the current chunk, which are reused for all chunks
+            std::string chunk;
+            std::string compressed_chunk;
+        };
+        std::map<std::pair<uint64_t, uint64_t>, struct upload_helper> m_uploads;
+        // request code of a further target -> key of its upload in m_uploads
+        std::map<std::pair<uint64_t, uint64_t>, std::pair<uint64_t, uint64_t>> m_upload_targets;
+        // compressor for the chunks of all uploads, it is reset after every chunk
+        Compression::Deflater m_deflater;
+        // provider -> compression confirmed by its daemon in an upload credit
+        std::map<std::string, Compression::Type> m_provider_compression;
+        // (provider, device) -> published job queue
+        std::map<std::pair<std::string, std::string>, std::vector<MsgJobQueue::Job>> m_job_queues;
 };
 
 #endif
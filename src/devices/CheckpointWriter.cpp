@@ -0,0 +1,167 @@
+#include "CheckpointWriter.hh"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+
+/*
+ * CheckpointWriter()
+ */
+CheckpointWriter::CheckpointWriter(const std::filesystem::path &file)
+    : m_file(file),
+      m_fd(-1),
+      m_sequence(0),
+      m_active(false),
+      m_pending(Pending::NONE)
+{
+    m_event = EventLoop::get_event_loop().create_user_event(this);
+}
+
+
+/*
+ * ~CheckpointWriter()
+ */
+CheckpointWriter::~CheckpointWriter()
+{
+    if (m_event) {
+        m_event->disable();
+    }
+    m_event = nullptr;
+    sync();
+    if (0 <= m_fd) {
+        close(m_fd);
+    }
+}
+
+
+/*
+ * begin()
+ */
+void CheckpointWriter::begin(const Sha256::Digest &job_hash, uint64_t line)
+{
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        m_checkpoint.job_hash = job_hash;
+        m_checkpoint.line = line;
+        m_active = true;
+    }
+    flush();
+}
+
+
+/*
+ * set_line()
+ */
+void CheckpointWriter::set_line(uint64_t line)
+{
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    m_checkpoint.line = line;
+}
+
+
+/*
+ * set_position()
+ */
+void CheckpointWriter::set_position(const float (&position)[4])
+{
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    memcpy(m_checkpoint.position, position, sizeof(m_checkpoint.position));
+    m_checkpoint.has_position = true;
+}
+
+
+/*
+ * set_temperatures()
+ */
+void CheckpointWriter::set_temperatures(float extruder, float bed)
+{
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    m_checkpoint.temp_extruder = extruder;
+    m_checkpoint.temp_bed = bed;
+}
+
+
+/*
+ * flush()
+ */
+void CheckpointWriter::flush()
+{
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        if (!m_active) {
+            return;
+        }
+        m_pending = Pending::WRITE;
+    }
+    if (m_event) {
+        m_event->trigger();
+    }
+}
+
+
+/*
+ * finish()
+ */
+void CheckpointWriter::finish()
+{
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        m_active = false;
+        m_pending = Pending::REMOVE;
+    }
+    if (m_event) {
+        m_event->trigger();
+    }
+}
+
+
+/*
+ * sync()
+ */
+void CheckpointWriter::sync()
+{
+    const std::lock_guard<std::mutex> file_guard(m_file_mutex);
+    PrintCheckpoint checkpoint;
+    Pending pending;
+    {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        pending = m_pending;
+        checkpoint = m_checkpoint;
+        m_pending = Pending::NONE;
+    }
+
+    try {
+        if (Pending::WRITE == pending) {
+            if (0 > m_fd) {
+                // a checkpoint of an earlier run of the daemon may have a higher sequence number
+                std::filesystem::create_directories(m_file.parent_path());
+                m_fd = open(m_file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (0 > m_fd) {
+                    throw std::runtime_error(std::string("Could not open ") + m_file.string() + ": " + strerror(errno));
+                }
+            }
+            checkpoint.store(m_fd, ++m_sequence);
+        } else if (Pending::REMOVE == pending) {
+            if (0 <= m_fd) {
+                close(m_fd);
+                m_fd = -1;
+            }
+            std::filesystem::remove(m_file);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Warning: " << e.what() << "\n";
+        // the checkpoints of this job are given up, instead of failing with every flush
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        m_active = false;
+    }
+}
+
+
+/*
+ * onTrigger()
+ */
+bool CheckpointWriter::onTrigger()
+{
+    sync();
+    return true;
+}
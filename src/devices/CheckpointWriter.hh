@@ -0,0 +1,89 @@
+#ifndef __CHECKPOINT_WRITER_HH__
+#define __CHECKPOINT_WRITER_HH__
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "../EventLoop.hh"
+#include "../job/PrintCheckpoint.hh"
+
+/**
+ * Keeps the checkpoint of the current print job of a device in its checkpoint file (see
+ * PrintCheckpoint).
+ *
+ * The device updates the checkpoint with every acknowledged command, which only copies the
+ * values. The file is written by flush() and finish() on the normal event loop, so the realtime
+ * thread is never blocked by the disk. If the writing is slower than the flushes, the flushes
+ * are merged and only the latest checkpoint is written. The class doesn't allocate memory after
+ * the first checkpoint is written.
+ *
+ * All methods are thread safe.
+ */
+class CheckpointWriter : public EventLoop::UserListener {
+    public:
+        CheckpointWriter(const CheckpointWriter &) = delete;
+        CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+        explicit CheckpointWriter(const std::filesystem::path &file);
+
+        /**
+         * Disables the event and writes a pending checkpoint on the calling thread.
+         */
+        ~CheckpointWriter();
+
+        /**
+         * Starts the checkpoints of a new print job, which begins with the given line. The
+         * position and the temperatures of the previous job are kept, since they are still
+         * valid. The checkpoint is written immediately.
+         */
+        void begin(const Sha256::Digest &job_hash, uint64_t line);
+
+        /**
+         * Sets the number of acknowledged lines of the job.
+         */
+        void set_line(uint64_t line);
+
+        void set_position(const float (&position)[4]);
+        void set_temperatures(float extruder, float bed);
+
+        /**
+         * Writes the current checkpoint, if a job is started.
+         */
+        void flush();
+
+        /**
+         * Removes the checkpoint file, since the print job is finished. Further updates are
+         * ignored until the next job begins.
+         */
+        void finish();
+
+        /**
+         * Writes or removes the checkpoint file on the calling thread, if flush() or finish()
+         * was called since the last call.
+         */
+        void sync();
+
+        bool onTrigger() override;
+
+    private:
+        enum class Pending {
+            NONE,
+            WRITE,
+            REMOVE
+        };
+
+        const std::filesystem::path m_file;
+        // serializes the file operations of sync()
+        std::mutex m_file_mutex;
+        int m_fd;
+        uint64_t m_sequence;
+
+        std::mutex m_mutex;
+        PrintCheckpoint m_checkpoint;
+        bool m_active;
+        Pending m_pending;
+        std::shared_ptr<EventLoop::UserEvent> m_event;
+};
+
+#endif
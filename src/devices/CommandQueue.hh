@@ -0,0 +1,307 @@
+#ifndef __COMMAND_QUEUE_HH__
+#define __COMMAND_QUEUE_HH__
+
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed-capacity ring of commands, which are sent to a device.
+ *
+ * A command passes three stages: It is pushed into the queue, written to the device and finally
+ * acknowledged by the device (pop()). The slots are allocated once by the constructor. Lines of a
+ * print job are not copied, the slot only points to them. Other commands are copied into a small
+ * buffer within the slot. Instead of a callback, each command carries an action, which tells the
+ * device what to do with the output and the acknowledgement of the command.
+ *
+ * A command can be framed by a short prefix and suffix (i.e. a line number and a checksum). The
+ * suffix contains the new line. Acknowledged commands are retained in the ring until their slot
+ * is reused, so a resend request for them can be told apart from an unknown line number.
+ *
+ * The queue is not thread safe.
+ */
+template<typename Action>
+class CommandQueue {
+    public:
+        // maximum length of a copied command
+        static constexpr size_t INLINE_SIZE = 96;
+        static constexpr size_t MAX_PREFIX = 16;
+        static constexpr size_t MAX_SUFFIX = 8;
+
+        struct Slot {
+            // the command without the new line
+            std::string_view line;
+            // number of written bytes including prefix and suffix
+            size_t sent;
+            Action action;
+            // line number of a framed command
+            uint32_t number;
+            uint8_t prefix_len;
+            uint8_t suffix_len;
+            char prefix[MAX_PREFIX];
+            char suffix[MAX_SUFFIX];
+            char buffer[INLINE_SIZE];
+
+            /**
+             * Returns the number of bytes of the framed command.
+             */
+            size_t size() const
+            {
+                return prefix_len + line.size() + suffix_len;
+            }
+        };
+
+        CommandQueue(const CommandQueue &) = delete;
+        CommandQueue(CommandQueue &&) = delete;
+        CommandQueue &operator=(const CommandQueue &) = delete;
+
+        /**
+         * Creates a queue with at least the given capacity. The capacity is rounded up to a power of two.
+         */
+        explicit CommandQueue(size_t capacity)
+            : m_head(0),
+              m_write(0),
+              m_tail(0),
+              m_bytes(0)
+        {
+            size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            m_slots.resize(size);
+            m_mask = size - 1;
+        }
+
+        size_t capacity() const
+        {
+            return m_slots.size();
+        }
+
+        /**
+         * Returns the number of commands, which are pushed but not acknowledged yet.
+         */
+        size_t size() const
+        {
+            return m_tail - m_head;
+        }
+
+        bool empty() const
+        {
+            return m_tail == m_head;
+        }
+
+        bool full() const
+        {
+            return size() == capacity();
+        }
+
+        /**
+         * Returns the number of bytes (including the new lines) of all commands in the queue.
+         */
+        size_t bytes() const
+        {
+            return m_bytes;
+        }
+
+        /**
+         * Pushes a command, which is not copied. The memory of the line has to stay valid, until
+         * the command is popped or the queue is cleared.
+         * Returns false, if the queue is full.
+         */
+        bool push_view(std::string_view line, Action action)
+        {
+            if (full()) {
+                return false;
+            }
+            Slot &slot = m_slots[m_tail & m_mask];
+            slot.line = line;
+            slot.sent = 0;
+            slot.action = action;
+            slot.number = 0;
+            slot.prefix_len = 0;
+            slot.suffix[0] = '\n';
+            slot.suffix_len = 1;
+            m_bytes += slot.size();
+            m_tail++;
+            return true;
+        }
+
+        /**
+         * Copies the command into the queue.
+         * Returns false, if the queue is full or the command is longer than INLINE_SIZE.
+         */
+        bool push_copy(std::string_view line, Action action)
+        {
+            if (full() || INLINE_SIZE < line.size()) {
+                return false;
+            }
+            Slot &slot = m_slots[m_tail & m_mask];
+            std::memcpy(slot.buffer, line.data(), line.size());
+            return push_view(std::string_view(slot.buffer, line.size()), action);
+        }
+
+        /**
+         * Frames the last pushed command. The suffix has to contain the new line. This is only
+         * allowed, as long as no byte of the command is written.
+         * Returns false, if the prefix or the suffix is too long.
+         */
+        bool frame_last(uint32_t number, std::string_view prefix, std::string_view suffix)
+        {
+            if (empty() || MAX_PREFIX < prefix.size() || MAX_SUFFIX < suffix.size()) {
+                return false;
+            }
+            Slot &slot = m_slots[(m_tail - 1) & m_mask];
+            m_bytes -= slot.size();
+            slot.number = number;
+            std::memcpy(slot.prefix, prefix.data(), prefix.size());
+            slot.prefix_len = prefix.size();
+            std::memcpy(slot.suffix, suffix.data(), suffix.size());
+            slot.suffix_len = suffix.size();
+            m_bytes += slot.size();
+            return true;
+        }
+
+        /**
+         * Returns true, if there are commands which are not completely written yet.
+         */
+        bool has_unwritten() const
+        {
+            return m_write != m_tail;
+        }
+
+        /**
+         * Returns the number of commands, which are not completely written yet.
+         */
+        size_t unwritten_count() const
+        {
+            return m_tail - m_write;
+        }
+
+        /**
+         * Returns the oldest command, which is not completely written yet. With an index, the
+         * following unwritten commands are accessible (index < unwritten_count()).
+         */
+        Slot &unwritten(size_t index = 0)
+        {
+            return m_slots[(m_write + index) & m_mask];
+        }
+
+        /**
+         * Marks the command returned by unwritten() as written.
+         */
+        void mark_written()
+        {
+            m_write++;
+        }
+
+        /**
+         * Assigns the given number of written bytes to the unwritten commands in their order.
+         * Completely written commands are marked as written. The bytes of a partial write are
+         * stored in Slot::sent of the first unwritten command.
+         */
+        void advance_written(size_t bytes)
+        {
+            while (bytes && has_unwritten()) {
+                Slot &curr = unwritten();
+                const size_t remaining = curr.size() - curr.sent;
+                if (bytes < remaining) {
+                    curr.sent += bytes;
+                    return;
+                }
+                curr.sent += remaining;
+                bytes -= remaining;
+                mark_written();
+            }
+        }
+
+        /**
+         * Returns true, if there are written commands, which are not acknowledged yet.
+         */
+        bool has_written() const
+        {
+            return m_head != m_write;
+        }
+
+        /**
+         * Returns the oldest written command, which is not acknowledged yet.
+         */
+        const Slot &front() const
+        {
+            return m_slots[m_head & m_mask];
+        }
+
+        /**
+         * Removes the command returned by front(), since it is acknowledged.
+         */
+        void pop()
+        {
+            m_bytes -= front().size();
+            m_head++;
+        }
+
+        /**
+         * Returns the position of the last pushed command with the given line number or -1, if
+         * it isn't retained anymore. Acknowledged commands are retained, until their slot is reused.
+         */
+        int64_t find_number(uint32_t number) const
+        {
+            const size_t oldest = (m_tail > capacity()) ? (m_tail - capacity()) : 0;
+            for (size_t pos = m_tail; pos > oldest; --pos) {
+                const Slot &slot = m_slots[(pos - 1) & m_mask];
+                if (slot.prefix_len && number == slot.number) {
+                    return pos - 1;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Returns the position of the oldest unwritten command. All commands before it are written.
+         */
+        size_t write_position() const
+        {
+            return m_write;
+        }
+
+        /**
+         * Marks all commands starting at the given position (see find_number()) as unwritten, so
+         * they are sent again. Only written commands, which are not acknowledged yet, can be
+         * rewound. An acknowledged command was already executed by the device.
+         * Returns false and changes nothing, if the command at the position is acknowledged.
+         */
+        bool rewind(size_t position)
+        {
+            if (position < m_head || position > m_tail) {
+                return false;
+            }
+            for (size_t pos = position; pos < m_tail; ++pos) {
+                m_slots[pos & m_mask].sent = 0;
+            }
+            m_write = position;
+            return true;
+        }
+
+        /**
+         * Drops all commands.
+         */
+        void clear()
+        {
+            m_head = 0;
+            m_write = 0;
+            m_tail = 0;
+            m_bytes = 0;
+        }
+
+    private:
+        std::vector<Slot> m_slots;
+        size_t m_mask;
+        // indices are only incremented and masked on access: head <= write <= tail
+        size_t m_head;
+        size_t m_write;
+        size_t m_tail;
+        size_t m_bytes;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Device.hh"
+#include <iostream>
 
 
 /*
@@ -35,33 +36,53 @@ bool Device::onTrigger(void)
     const std::lock_guard<std::mutex> guard(m_mutex);
     bool ret = true;
 
-    if (!m_state_list.empty()) {
-        enum State new_state = m_state_list.front();
-        m_state_list.pop_front();
-        for (auto const &list: m_listeners) {
-            list->on_state_change(*this, new_state);
+    // cleared before the events are taken, so a new event triggers the user event again
+    m_trigger_pending.store(false, std::memory_order_seq_cst);
+
+    // All pending events are dispatched in one pass. Consecutive progress and sensor updates are
+    // merged into the last one, the state changes are dispatched in order. At most one ring of
+    // events is taken, so a device, which produces events continuously, can't block the loop.
+    std::optional<Event> progress;
+    bool sensors = false;
+    auto flush = [this, &progress, &sensors]() {
+        if (progress) {
+            dispatch_event(*progress);
+            progress.reset();
         }
-    } else if (m_progress_update) {
-        for (auto const &list: m_listeners) {
-            list->on_build_progress_change(*this, m_progress_update->first, m_progress_update->second);
+        if (sensors) {
+            Event event;
+            event.type = Event::Type::SENSORS;
+            dispatch_event(event);
+            sensors = false;
         }
-        m_progress_update.reset();
-    } else if (m_sensor_reading_update) {
-        for (auto const &list: m_listeners) {
-            list->on_sensor_update(*this);
+    };
+    Event event;
+    for (size_t i = 0; i < m_events.capacity() && m_events.try_pop(event); ++i) {
+        switch (event.type) {
+            case Event::Type::STATE:
+                flush();
+                dispatch_event(event);
+                break;
+            case Event::Type::PROGRESS:
+                progress = event;
+                break;
+            case Event::Type::SENSORS:
+                sensors = true;
+                break;
         }
-        m_sensor_reading_update = false;
+    }
+    flush();
+    if (m_events.empty() && m_events_lost.exchange(false)) {
+        dispatch_lost_events();
     }
 
-    if (!m_state_list.empty() || m_progress_update) {
-        if (m_user_event) {
+    // the event is not called periodically, so every pending update needs another trigger
+    if (!m_events.empty() || m_events_lost.load()) {
+        if (!m_trigger_pending.exchange(true)) {
             m_user_event->trigger();
         }
     } else if (!is_valid()) {
-        if (m_user_event) {
-            m_user_event->disable();
-        }
-        m_user_event = nullptr;
+        m_user_event->disable();
         ret = false;
     }
     clean_up_listeners();
@@ -75,28 +96,28 @@ bool Device::onTrigger(void)
  */
 void Device::set_state(enum Device::State new_state)
 {
-    const std::lock_guard<std::mutex> guard(m_mutex);
-    if (new_state == m_state){
-        return;
-    }
-
-    if (m_state == State::SHUTDOWN) {
-        std::string err = "Invalid state change on device '";
-        err += name();
-        err += "': You are not allowed to change the state of a device which is in SHUTDOWN.";
-        throw std::runtime_error(err);
-    }
+    State old_state = m_state.load(std::memory_order_acquire);
+    do {
+        if (new_state == old_state) {
+            return;
+        }
 
-    m_state = new_state;
+        if (old_state == State::SHUTDOWN) {
+            std::string err = "Invalid state change on device '";
+            err += name();
+            err += "': You are not allowed to change the state of a device which is in SHUTDOWN.";
+            throw std::runtime_error(err);
+        }
+    } while (!m_state.compare_exchange_weak(old_state, new_state, std::memory_order_acq_rel));
 
-    m_state_list.push_back(new_state);
     // We do not call directly the listeners for state changes, since the device which calls
     // this function might run on a realtime thread and we don't want to execute the listners
     // on a real time thread. Therefore we inform a normal thread that there was a state change
     // which calls the listeners.
-    if (m_user_event) {
-        m_user_event->trigger();
-    }
+    Event event;
+    event.type = Event::Type::STATE;
+    event.state = new_state;
+    push_event(event);
 }
 
 
@@ -105,15 +126,12 @@ void Device::set_state(enum Device::State new_state)
  */
 void Device::update_progress(unsigned percentage, unsigned remaining_time)
 {
-    const std::lock_guard<std::mutex> guard(m_mutex);
-    m_progress_update = std::pair<unsigned, unsigned>(percentage, remaining_time);
-    // We do not call directly the listeners for progress updates, since the device which calls
-    // this function might run on a realtime thread and we don't want to execute the listners
-    // on a real time thread. Therefore we inform a normal thread that there was a progress update
-    // which calls the listeners.
-    if (m_user_event) {
-        m_user_event->trigger();
-    }
+    m_last_progress.store((uint64_t(percentage) << 32) | remaining_time, std::memory_order_relaxed);
+    Event event;
+    event.type = Event::Type::PROGRESS;
+    event.percentage = percentage;
+    event.remaining_time = remaining_time;
+    push_event(event);
 }
 
 
@@ -122,18 +140,81 @@ void Device::update_progress(unsigned percentage, unsigned remaining_time)
  */
 void Device::update_sensor_readings()
 {
-    const std::lock_guard<std::mutex> guard(m_mutex);
-    m_sensor_reading_update = true;
-    // We do not call directly the listeners, since the device which calls
-    // this function might run on a realtime thread and we don't want to execute the listners
-    // on a real time thread. Therefore we inform a normal thread that there was a progress update
-    // which calls the listeners.
-    if (m_user_event) {
+    Event event;
+    event.type = Event::Type::SENSORS;
+    push_event(event);
+}
+
+
+/*
+ * push_event()
+ */
+void Device::push_event(const Event &event)
+{
+    const size_t reserve = (Event::Type::STATE == event.type) ? (0) : (STATE_RESERVE);
+    if (!m_events.try_push(event, reserve)) {
+        // the listener thread is behind, it catches up with the current state (see dispatch_lost_events())
+        m_events_lost.store(true);
+    }
+    if (!m_trigger_pending.exchange(true, std::memory_order_seq_cst)) {
         m_user_event->trigger();
     }
 }
 
 
+/*
+ * dispatch_event()
+ */
+void Device::dispatch_event(const Event &event)
+{
+    switch (event.type) {
+        case Event::Type::STATE:
+            m_delivered_state = event.state;
+            for (auto const &list: m_listeners) {
+                list->on_state_change(*this, event.state);
+            }
+            break;
+        case Event::Type::PROGRESS:
+            for (auto const &list: m_listeners) {
+                list->on_build_progress_change(*this, event.percentage, event.remaining_time);
+            }
+            break;
+        case Event::Type::SENSORS:
+            for (auto const &list: m_listeners) {
+                list->on_sensor_update(*this);
+            }
+            break;
+    }
+}
+
+
+/*
+ * dispatch_lost_events()
+ */
+void Device::dispatch_lost_events()
+{
+    const State state = m_state.load(std::memory_order_acquire);
+    if (state != m_delivered_state) {
+        std::cerr << "WARNING: Dropped state changes of device '" << name() << "', since its listeners are too slow.\n";
+        Event event;
+        event.type = Event::Type::STATE;
+        event.state = state;
+        dispatch_event(event);
+    }
+    const uint64_t progress = m_last_progress.load(std::memory_order_relaxed);
+    if (NO_PROGRESS != progress) {
+        Event event;
+        event.type = Event::Type::PROGRESS;
+        event.percentage = progress >> 32;
+        event.remaining_time = progress & UINT32_MAX;
+        dispatch_event(event);
+    }
+    Event event;
+    event.type = Event::Type::SENSORS;
+    dispatch_event(event);
+}
+
+
 /*
  * try_clean_up_listeners()
  */
@@ -155,6 +236,9 @@ void Device::try_clean_up_listeners()
             }
         }
         m_mutex.unlock();
+    } else {
+        // the listeners are cleaned up by the next call of onTrigger()
+        m_user_event->trigger();
     }
 }
 
@@ -8,9 +8,16 @@
 #include <queue>
 #include <stdexcept>
 #include <mutex>
+#include <memory>
+#include <atomic>
 #include "../EventLoop.hh"
+#include "EventRing.hh"
+#include "SensorTable.hh"
 
 class Detector;
+class GcodeJob;
+class GcodeAnalysis;
+struct PrintCheckpoint;
 
 /**
  * This is an abstract representation of a device which accepts gcode for
@@ -20,10 +27,12 @@ class Detector;
  * - name()
  * - print_file()
  * - print()
+ * - print_job()
  * - on_shutdown()
  *
  * Optionally it can implement:
- * - sensor_readings()
+ * - resume_job()
+ * - print_analyzed_job()
  */
 class Device : public EventLoop::UserListener {
     public:
@@ -65,6 +74,16 @@ class Device : public EventLoop::UserListener {
             NET_ERR_NO_DEVICE = 4,
             // network request response timed out
             NET_ERR_TIMEOUT = 5,
+            // the print job could not be loaded (i.e. file does not exist)
+            ERR_INVALID_JOB = 6,
+            // the upload of the print job failed (i.e. unknown upload or the job could not be stored)
+            NET_ERR_UPLOAD = 7,
+            // the print job referenced by its hash isn't in the job cache of the daemon, it has to be uploaded
+            NET_ERR_NOT_CACHED = 8,
+            // the device has no checkpoint of an interrupted print job, which could be resumed
+            ERR_NO_CHECKPOINT = 9,
+            // the daemon has no job queue (i.e. the job cache is disabled), therefore the job can't be queued
+            NET_ERR_NO_QUEUE = 10,
             __LAST_ENTRY
         };
 
@@ -101,8 +120,9 @@ class Device : public EventLoop::UserListener {
                  * Is called while printing and informs the callee about the current printing state.
                  *
                  * How it works:
-                 * If the device is printing, this method is called when the gcoded receives a response on the
-                 * G-code M73 from the printer.
+                 * If the device is printing, this method is called whenever the progress derived from the
+                 * acknowledged commands and the analysis of the print job changes (see GcodeAnalysis). If the job
+                 * has no moves, it is called when the gcoded receives a response on the G-code M73 from the printer.
                  * See: https://www.reprap.org/wiki/G-code#M73:_Set.2FGet_build_percentage
                  *
                  * @param device Handle to the device which is calling this method.
@@ -138,7 +158,7 @@ class Device : public EventLoop::UserListener {
         /**
          * Returns the current state of the device
          */
-        State state() const { return m_state; }
+        State state() const { return m_state.load(std::memory_order_acquire); }
 
         /**
          * Returns true, if the device is an operational state.
@@ -172,6 +192,33 @@ class Device : public EventLoop::UserListener {
          */
         virtual PrintResult print(const std::string &gcode) = 0;
 
+        /**
+         * Sends an already loaded job to the printer. The job is immutable, so one job can be
+         * printed on several devices at the same time.
+         */
+        virtual PrintResult print_job(const std::shared_ptr<const GcodeJob> &job) = 0;
+
+        /**
+         * Same as print_job(), but with the analysis of the job (see GcodeAnalysis), which was
+         * computed in advance, i.e. for a queued job while the previous job was printed. So the
+         * print starts without delay. Devices, which don't use the analysis, print the job with
+         * print_job().
+         */
+        virtual PrintResult print_analyzed_job(const std::shared_ptr<const GcodeJob> &job,
+                                               const std::shared_ptr<const GcodeAnalysis> &analysis)
+        {
+            return print_job(job);
+        }
+
+        /**
+         * Resumes an interrupted print of the job from its checkpoint (see PrintCheckpoint).
+         * Devices, which don't store checkpoints, return PrintResult::ERR_NO_CHECKPOINT.
+         */
+        virtual PrintResult resume_job(const std::shared_ptr<const GcodeJob> &job, const PrintCheckpoint &checkpoint)
+        {
+            return PrintResult::ERR_NO_CHECKPOINT;
+        }
+
         /**
          * This is called, if the device state changes to shutdown.
          * This can be overriden by devices to turn of in a thread safe manner.
@@ -179,11 +226,12 @@ class Device : public EventLoop::UserListener {
         virtual void on_shutdown() {};
 
         /**
-         * returns all values from sensors of the device.
+         * Copies a consistent snapshot of the sensor readings of the device. This neither locks
+         * the device nor allocates memory (see SensorTable).
          */
-        virtual std::map<std::string, struct SensorValue> sensor_readings()
+        void sensor_readings(SensorTable::Snapshot &snapshot) const
         {
-            return std::map<std::string, struct SensorValue>();
+            m_sensor_table.read(snapshot);
         }
 
         /**
@@ -215,13 +263,22 @@ class Device : public EventLoop::UserListener {
 
     protected:
         Device()
-            : m_state(State::UNINITIALIZED)
+            : m_state(State::UNINITIALIZED),
+              m_events(EVENT_CAPACITY),
+              m_trigger_pending(false),
+              m_events_lost(false),
+              m_last_progress(NO_PROGRESS),
+              m_delivered_state(State::UNINITIALIZED)
         {
             m_user_event = EventLoop::get_event_loop().create_user_event(this);
         }
 
         /**
          * Changes the device state and triggers all listeners in a thread safe manner.
+         *
+         * The updates of the state, the progress and the sensor readings don't lock anything,
+         * which is held while the listeners are called. They are passed as events to the thread
+         * of the EventLoop, so they can be called from a realtime thread.
          */
         virtual void set_state(enum State new_state);
 
@@ -235,7 +292,43 @@ class Device : public EventLoop::UserListener {
          */
         void update_sensor_readings();
 
+        // the sensor readings of the device, it is written by the device only
+        SensorTable m_sensor_table;
+
     private:
+        /**
+         * An update, which is passed from the device to the thread, which calls the listeners.
+         */
+        struct Event {
+            enum class Type {
+                STATE,
+                PROGRESS,
+                SENSORS
+            };
+            Type type;
+            State state;
+            unsigned percentage;
+            unsigned remaining_time;
+        };
+
+        /**
+         * Appends the event and triggers the user event, if it is not already triggered.
+         */
+        void push_event(const Event &event);
+
+        /**
+         * Calls the listeners for the event.
+         * WARNING: This function assumes, that Device::m_mutex is already locked when called.
+         */
+        void dispatch_event(const Event &event);
+
+        /**
+         * Called, after events did not fit into the ring. Informs the listeners about the last
+         * progress, new sensor readings and the current state, if a state change was dropped.
+         * WARNING: This function assumes, that Device::m_mutex is already locked when called.
+         */
+        void dispatch_lost_events();
+
         /**
          * Tries to clean up listeners. If the needed mutex is locked, than no listener is clean up.
          * Using this in Device::unregister_listener() allows to unregister listeners from inside of a
@@ -249,17 +342,33 @@ class Device : public EventLoop::UserListener {
          */
         void clean_up_listeners();
 
+        static constexpr size_t EVENT_CAPACITY = 64;
+        // slots, which can only be taken by state changes. A dropped progress or sensor update is
+        // replaced by the last one (see dispatch_lost_events()).
+        static constexpr size_t STATE_RESERVE = 16;
+        static constexpr uint64_t NO_PROGRESS = UINT64_MAX;
+
+        // guards m_listeners, it is locked while the listeners are called and never by set_state(),
+        // update_progress() or update_sensor_readings()
         std::mutex m_mutex;
-        State m_state;
+        std::atomic<State> m_state;
         std::set<Listener *> m_listeners;
         std::function<void(size_t)> m_on_listener_unregister;
 
         std::mutex m_unregister_mutex;
         std::queue<Listener *> m_unregister_listeners;
+        // the user event is disabled, but not released before the destructor, since the
+        // producers of events use it without a lock
         std::shared_ptr<EventLoop::UserEvent> m_user_event;
-        std::list<enum State> m_state_list;
-        std::optional<std::pair<unsigned, unsigned>> m_progress_update;
-        bool m_sensor_reading_update;
+        EventRing<Event> m_events;
+        // set, while the user event is triggered and has not yet taken the events
+        std::atomic<bool> m_trigger_pending;
+        // set, if an event did not fit into the ring
+        std::atomic<bool> m_events_lost;
+        // the last progress (percentage in the upper half, remaining time in the lower half)
+        std::atomic<uint64_t> m_last_progress;
+        // only accessed by the thread of the listeners
+        State m_delivered_state;
 
         friend Detector;
 };
@@ -296,6 +405,11 @@ inline const std::string &Device::printres_to_str(Device::PrintResult res)
                                            "ERR_PRINTING",
                                            "NET_ERR_NO_DEVICE",
                                            "NET_ERR_TIMEOUT",
+                                           "ERR_INVALID_JOB",
+                                           "NET_ERR_UPLOAD",
+                                           "NET_ERR_NOT_CACHED",
+                                           "ERR_NO_CHECKPOINT",
+                                           "NET_ERR_NO_QUEUE",
                                            "<UNKNOWN_STATE>" };
     if (res > PrintResult::__LAST_ENTRY) {
         res = PrintResult::__LAST_ENTRY;
@@ -307,10 +421,11 @@ inline const std::string &Device::printres_to_str(Device::PrintResult res)
  * is_valid()
  */
 inline bool Device::is_valid() const {
-    return    m_state != State::UNINITIALIZED
-           && m_state != State::ERROR
-           && m_state != State::DISCONNECTED
-           && m_state != State::SHUTDOWN;
+    const State state = m_state.load(std::memory_order_acquire);
+    return    state != State::UNINITIALIZED
+           && state != State::ERROR
+           && state != State::DISCONNECTED
+           && state != State::SHUTDOWN;
 }
 
 
@@ -319,9 +434,7 @@ inline bool Device::is_valid() const {
  */
 inline Device::~Device()
 {
-    if (m_user_event) {
-        m_user_event->disable();
-    }
+    m_user_event->disable();
     m_user_event = nullptr;
 }
 
@@ -0,0 +1,121 @@
+#ifndef __EVENT_RING_HH__
+#define __EVENT_RING_HH__
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+/**
+ * Fixed-capacity lock free ring, which passes events from several producers to one consumer.
+ *
+ * The slots are allocated once by the constructor. Every slot has a sequence number, which tells
+ * whether the slot is free for the producer of a position or filled for the consumer. A producer
+ * reserves a position with a compare and swap and never waits for another thread, so the ring can
+ * be filled from a realtime thread. If the ring is full, try_push() fails instead of waiting for
+ * the consumer.
+ *
+ * try_pop() and empty() may only be called by one thread at a time.
+ */
+template<typename T>
+class EventRing {
+    public:
+        EventRing(const EventRing &) = delete;
+        EventRing(EventRing &&) = delete;
+        EventRing &operator=(const EventRing &) = delete;
+
+        /**
+         * Creates a ring with at least the given capacity. The capacity is rounded up to a power of two.
+         */
+        explicit EventRing(size_t capacity)
+            : m_push_pos(0),
+              m_pop_pos(0)
+        {
+            size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            m_slots.reset(new Slot[size]);
+            m_mask = size - 1;
+            for (size_t i = 0; i < size; ++i) {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        size_t capacity() const
+        {
+            return m_mask + 1;
+        }
+
+        /**
+         * Appends a copy of the event. Returns false, if the ring is full or less than reserve
+         * slots would be left. So less important events can't take the last slots.
+         */
+        bool try_push(const T &event, size_t reserve = 0)
+        {
+            size_t pos = m_push_pos.load(std::memory_order_relaxed);
+            Slot *slot;
+            while (true) {
+                // the check is not exact, since the consumer and other producers continue
+                if (reserve && ptrdiff_t(pos - m_pop_pos.load(std::memory_order_relaxed) + reserve) > ptrdiff_t(m_mask)) {
+                    return false;
+                }
+                slot = &m_slots[pos & m_mask];
+                const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                const ptrdiff_t diff = ptrdiff_t(sequence) - ptrdiff_t(pos);
+                if (0 == diff) {
+                    if (m_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (0 > diff) {
+                    // the consumer has not yet taken the event of the last round
+                    return false;
+                } else {
+                    pos = m_push_pos.load(std::memory_order_relaxed);
+                }
+            }
+            slot->event = event;
+            slot->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Moves the oldest event into event. Returns false, if the ring is empty or the oldest
+         * event is not yet completely written by its producer.
+         */
+        bool try_pop(T &event)
+        {
+            const size_t pos = m_pop_pos.load(std::memory_order_relaxed);
+            Slot &slot = m_slots[pos & m_mask];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+                return false;
+            }
+            event = std::move(slot.event);
+            slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+            m_pop_pos.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+         * Returns true, if try_pop() would fail.
+         */
+        bool empty() const
+        {
+            const size_t pos = m_pop_pos.load(std::memory_order_relaxed);
+            return m_slots[pos & m_mask].sequence.load(std::memory_order_acquire) != pos + 1;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            T event;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        size_t m_mask;
+        // the producers and the consumer don't share a cache line for their positions
+        alignas(64) std::atomic<size_t> m_push_pos;
+        // only written by the consumer, the producers read it for the reserve of try_push()
+        alignas(64) std::atomic<size_t> m_pop_pos;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "LineBuffer.hh"
+#include <cstring>
+
+
+/*
+ * LineBuffer()
+ */
+LineBuffer::LineBuffer(size_t capacity)
+    : m_buf(capacity),
+      m_begin(0),
+      m_scan(0),
+      m_end(0)
+{}
+
+
+/*
+ * write_area()
+ */
+char *LineBuffer::write_area(size_t &len)
+{
+    if (m_buf.size() == m_end && 0 < m_begin) {
+        std::memmove(m_buf.data(), m_buf.data() + m_begin, m_end - m_begin);
+        m_scan -= m_begin;
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+    len = m_buf.size() - m_end;
+    return m_buf.data() + m_end;
+}
+
+
+/*
+ * next_line()
+ */
+bool LineBuffer::next_line(std::string_view &line)
+{
+    const char *data = m_buf.data();
+    const char *eol = static_cast<const char *>(std::memchr(data + m_scan, '\n', m_end - m_scan));
+    if (!eol) {
+        m_scan = m_end;
+        if (m_begin == m_end) {
+            // everything is consumed, start again at the front to avoid moving data
+            clear();
+        } else if (0 == m_begin && m_buf.size() == m_end) {
+            // the line does not fit into the buffer
+            line = std::string_view(data, m_end);
+            clear();
+            return true;
+        }
+        return false;
+    }
+
+    line = std::string_view(data + m_begin, eol - data - m_begin);
+    if (!line.empty() && '\r' == line.back()) {
+        line.remove_suffix(1);
+    }
+    m_begin = eol - data + 1;
+    m_scan = m_begin;
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef __LINE_BUFFER_HH__
+#define __LINE_BUFFER_HH__
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+/**
+ * Receive buffer, which reassembles lines from a byte stream (i.e. a serial interface).
+ *
+ * Data is read directly into the buffer (see write_area() and commit()). A single read may
+ * contain several lines and lines may be split over several reads. next_line() returns the
+ * complete lines as views into the buffer, so no line is copied. An incomplete line at the end
+ * of the buffer is moved to the front of the buffer, if the buffer runs out of space.
+ */
+class LineBuffer {
+    public:
+        LineBuffer(const LineBuffer &) = delete;
+        LineBuffer(LineBuffer &&) = delete;
+        LineBuffer &operator=(const LineBuffer &) = delete;
+
+        explicit LineBuffer(size_t capacity = 4096);
+
+        /**
+         * Returns the free space at the end of the buffer, which can be filled by read().
+         * The returned length is never zero, as long as all lines are fetched with next_line()
+         * after each commit(). This invalidates all lines returned by next_line().
+         */
+        char *write_area(size_t &len);
+
+        /**
+         * Marks n bytes of the write area as filled.
+         */
+        void commit(size_t n)
+        {
+            m_end += n;
+        }
+
+        /**
+         * Stores the next complete line without the line break (and a carriage return before it)
+         * in line. The view is valid until the next call of write_area() or clear().
+         * A line which does not fit into the buffer is returned in pieces of the buffer size.
+         *
+         * Returns false, if there is no complete line in the buffer.
+         */
+        bool next_line(std::string_view &line);
+
+        /**
+         * Drops all buffered data.
+         */
+        void clear()
+        {
+            m_begin = 0;
+            m_scan = 0;
+            m_end = 0;
+        }
+
+    private:
+        std::vector<char> m_buf;
+        // begin of the first line, which is not returned yet
+        size_t m_begin;
+        // all bytes before this position are already searched for a line break
+        size_t m_scan;
+        // end of the received data
+        size_t m_end;
+};
+
+#endif
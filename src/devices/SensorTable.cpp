@@ -0,0 +1,152 @@
+#include "SensorTable.hh"
+#include <thread>
+#include <cstring>
+
+
+/*
+ * SensorTable()
+ */
+SensorTable::SensorTable()
+    : m_sequence(0),
+      m_count(0)
+{
+    for (Slot &slot: m_slots) {
+        slot.name[0] = '\0';
+        slot.unit[0] = '\0';
+        slot.has_unit = false;
+        slot.flags.store(0, std::memory_order_relaxed);
+        slot.current_value.store(0.0, std::memory_order_relaxed);
+        slot.set_point.store(0.0, std::memory_order_relaxed);
+    }
+}
+
+
+/*
+ * intern()
+ */
+std::optional<size_t> SensorTable::intern(std::string_view name, const char *unit)
+{
+    const size_t count = m_count.load(std::memory_order_relaxed);
+    for (size_t id = 0; id < count; ++id) {
+        if (name == m_slots[id].name) {
+            return id;
+        }
+    }
+    if (MAX_SENSORS <= count || MAX_NAME <= name.size() || (unit && MAX_UNIT <= std::strlen(unit))) {
+        return std::nullopt;
+    }
+
+    Slot &slot = m_slots[count];
+    std::memcpy(slot.name, name.data(), name.size());
+    slot.name[name.size()] = '\0';
+    slot.has_unit = unit;
+    if (unit) {
+        std::strcpy(slot.unit, unit);
+    }
+    // the readers see the name and the unit, as soon as they see the new count
+    m_count.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+
+/*
+ * begin_update()
+ */
+void SensorTable::begin_update()
+{
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+
+/*
+ * end_update()
+ */
+void SensorTable::end_update()
+{
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+/*
+ * set()
+ */
+void SensorTable::set(size_t id, double current_value, std::optional<double> set_point)
+{
+    Slot &slot = m_slots[id];
+    slot.current_value.store(current_value, std::memory_order_relaxed);
+    slot.set_point.store(set_point.value_or(0.0), std::memory_order_relaxed);
+    slot.flags.store(VALID | ((set_point) ? (HAS_SET_POINT) : (0)), std::memory_order_relaxed);
+}
+
+
+/*
+ * get()
+ */
+bool SensorTable::get(size_t id, double &current_value, std::optional<double> &set_point) const
+{
+    const Slot &slot = m_slots[id];
+    const uint8_t flags = slot.flags.load(std::memory_order_relaxed);
+    if (!(flags & VALID)) {
+        return false;
+    }
+    current_value = slot.current_value.load(std::memory_order_relaxed);
+    set_point.reset();
+    if (flags & HAS_SET_POINT) {
+        set_point = slot.set_point.load(std::memory_order_relaxed);
+    }
+    return true;
+}
+
+
+/*
+ * clear()
+ */
+void SensorTable::clear()
+{
+    begin_update();
+    const size_t count = m_count.load(std::memory_order_relaxed);
+    for (size_t id = 0; id < count; ++id) {
+        m_slots[id].flags.store(0, std::memory_order_relaxed);
+    }
+    end_update();
+}
+
+
+/*
+ * read()
+ */
+void SensorTable::read(Snapshot &snapshot) const
+{
+    while (true) {
+        const uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const size_t count = m_count.load(std::memory_order_acquire);
+        snapshot.count = 0;
+        for (size_t id = 0; id < count; ++id) {
+            const Slot &slot = m_slots[id];
+            const uint8_t flags = slot.flags.load(std::memory_order_relaxed);
+            if (!(flags & VALID)) {
+                continue;
+            }
+            Reading &reading = snapshot.readings[snapshot.count++];
+            reading.name = slot.name;
+            reading.unit = (slot.has_unit) ? (slot.unit) : (nullptr);
+            reading.current_value = slot.current_value.load(std::memory_order_relaxed);
+            reading.set_point.reset();
+            if (flags & HAS_SET_POINT) {
+                reading.set_point = slot.set_point.load(std::memory_order_relaxed);
+            }
+        }
+
+        // the copy is only consistent, if the writer did not start an update in the meantime
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence == m_sequence.load(std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
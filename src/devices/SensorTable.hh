@@ -0,0 +1,116 @@
+#ifndef __SENSOR_TABLE_HH__
+#define __SENSOR_TABLE_HH__
+
+#include <atomic>
+#include <optional>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed-capacity table of the sensor readings of a device.
+ *
+ * Every sensor gets a slot with a fixed id, when its name is interned the first time. The name and
+ * the unit of a slot are never changed afterwards, only its values. So a device updates its
+ * readings without allocating memory or building strings.
+ *
+ * The readings are published with a sequence lock: The writer makes the sequence number odd while
+ * it updates the values. A reader copies the values and repeats the copy, if the sequence number
+ * was odd or changed in the meantime. Therefore, a reader gets a consistent snapshot of all
+ * readings and never blocks the writer (i.e. a realtime thread).
+ *
+ * Only one thread may write at a time (intern(), begin_update(), set(), end_update(), clear()),
+ * any number of threads may read().
+ */
+class SensorTable {
+    public:
+        static constexpr size_t MAX_SENSORS = 32;
+        // including the terminating null character
+        static constexpr size_t MAX_NAME = 24;
+        static constexpr size_t MAX_UNIT = 16;
+
+        /**
+         * A reading of a snapshot. The name and the unit point into the table and are valid as
+         * long as the table exists.
+         */
+        struct Reading {
+            const char *name;
+            // nullptr, if the sensor has no unit
+            const char *unit;
+            double current_value;
+            std::optional<double> set_point;
+        };
+
+        /**
+         * Consistent copy of all valid readings (see read()).
+         */
+        struct Snapshot {
+            size_t count = 0;
+            Reading readings[MAX_SENSORS];
+        };
+
+        SensorTable(const SensorTable &) = delete;
+        SensorTable(SensorTable &&) = delete;
+        SensorTable &operator=(const SensorTable &) = delete;
+
+        SensorTable();
+
+        /**
+         * Returns the id of the sensor and adds it, if it is unknown. The unit (nullptr for none)
+         * is only used, if the sensor is added. Returns std::nullopt, if the table is full or the
+         * name or the unit is too long.
+         */
+        std::optional<size_t> intern(std::string_view name, const char *unit);
+
+        /**
+         * Frames the updates of the values with set(). The readers see all values of an update
+         * or none.
+         */
+        void begin_update();
+        void end_update();
+
+        /**
+         * Sets the values of the sensor and marks them as valid. May only be called between
+         * begin_update() and end_update().
+         */
+        void set(size_t id, double current_value, std::optional<double> set_point);
+
+        /**
+         * Returns the current value and the set point of the sensor, if it is valid. This is meant
+         * for the writer, i.e. to update a value depending on the previous one.
+         */
+        bool get(size_t id, double &current_value, std::optional<double> &set_point) const;
+
+        /**
+         * Marks all readings as invalid. The ids stay valid.
+         */
+        void clear();
+
+        /**
+         * Copies all valid readings into the snapshot.
+         */
+        void read(Snapshot &snapshot) const;
+
+    private:
+        enum Flags : uint8_t {
+            VALID = 1,
+            HAS_SET_POINT = 2
+        };
+
+        struct Slot {
+            // written once before the slot is counted, constant afterwards
+            char name[MAX_NAME];
+            char unit[MAX_UNIT];
+            bool has_unit;
+            std::atomic<uint8_t> flags;
+            std::atomic<double> current_value;
+            std::atomic<double> set_point;
+        };
+
+        // odd, while the writer updates the values
+        std::atomic<uint32_t> m_sequence;
+        std::atomic<size_t> m_count;
+        Slot m_slots[MAX_SENSORS];
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "SerialPort.hh"
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+/*
+ * speed_constant()
+ *
+ * Returns the Bxxx constant for a standard baud rate or BOTHER.
+ */
+tcflag_t speed_constant(uint32_t baud_rate)
+{
+    static const struct {
+        uint32_t baud_rate;
+        tcflag_t constant;
+    } speeds[] = {
+        { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 },
+        { 115200, B115200 }, { 230400, B230400 }, { 460800, B460800 }, { 500000, B500000 },
+        { 921600, B921600 }, { 1000000, B1000000 }, { 2000000, B2000000 }
+    };
+    for (const auto &speed: speeds) {
+        if (speed.baud_rate == baud_rate) {
+            return speed.constant;
+        }
+    }
+    return BOTHER;
+}
+
+}
+
+
+/*
+ * configure()
+ */
+bool SerialPort::configure(int fd, const Config::DeviceConfig &dev_conf)
+{
+    struct termios2 tty;
+    if (0 != ioctl(fd, TCGETS2, &tty)) {
+        return false;
+    }
+
+    // Standard baud rates are set with their constant, so they are still readable with the
+    // termios interface. Otherwise the rate is passed in c_ispeed and c_ospeed.
+    const tcflag_t speed = speed_constant(dev_conf.baud_rate);
+    tty.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tty.c_cflag |= speed | (speed << IBSHIFT);
+    tty.c_ispeed = dev_conf.baud_rate;
+    tty.c_ospeed = dev_conf.baud_rate;
+
+    // Raw mode: the lines are reassembled by the device. So a single read() can fetch all lines,
+    // which arrived since the last wakeup, instead of one line per read() in canonical mode.
+    tty.c_cflag = (tty.c_cflag & ~CSIZE) | CS8;
+    tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL);
+    tty.c_lflag = 0;
+    tty.c_oflag = 0;
+    tty.c_iflag &= ~(IXON | IXOFF | IXANY);
+    // The fd is non-blocking and polled by the event loop. With VTIME = 0, poll() reports the fd
+    // only as readable after VMIN bytes arrived. A single "ok" has just three bytes, therefore
+    // the default is to wake up on the first byte and drain everything with read().
+    tty.c_cc[VMIN] = dev_conf.serial_vmin;
+    tty.c_cc[VTIME] = dev_conf.serial_vtime;
+    tty.c_cflag |= (CLOCAL | CREAD);
+    tty.c_cflag &= ~(PARENB | PARODD);
+    tty.c_cflag &= ~CSTOPB;
+    tty.c_cflag &= ~CRTSCTS;
+
+    if (0 != ioctl(fd, TCSETS2, &tty)) {
+        return false;
+    }
+
+    // The low latency mode tells the driver to push received bytes immediately to the line
+    // discipline instead of collecting them for a few milliseconds.
+    struct serial_struct serial;
+    if (0 == ioctl(fd, TIOCGSERIAL, &serial)) {
+        const bool low_latency = serial.flags & ASYNC_LOW_LATENCY;
+        if (low_latency != dev_conf.serial_low_latency) {
+            if (dev_conf.serial_low_latency) {
+                serial.flags |= ASYNC_LOW_LATENCY;
+            } else {
+                serial.flags &= ~ASYNC_LOW_LATENCY;
+            }
+            if (0 != ioctl(fd, TIOCSSERIAL, &serial)) {
+                std::cerr << "Warning: Could not set low latency mode: " << strerror(errno) << "\n";
+            }
+        }
+    } else if (dev_conf.serial_low_latency) {
+        std::cerr << "Warning: Low latency mode isn't supported by the serial driver: " << strerror(errno) << "\n";
+    }
+
+    return true;
+}
+
+
+/*
+ * baud_rate()
+ */
+uint32_t SerialPort::baud_rate(int fd)
+{
+    struct termios2 tty;
+    if (0 != ioctl(fd, TCGETS2, &tty)) {
+        return 0;
+    }
+    return tty.c_ospeed;
+}
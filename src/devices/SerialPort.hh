@@ -0,0 +1,32 @@
+#ifndef __SERIAL_PORT_HH__
+#define __SERIAL_PORT_HH__
+
+#include <cstdint>
+#include "../Config.hh"
+
+/**
+ * Configures the serial interface of a device according to its Config::DeviceConfig.
+ *
+ * The interface is set to raw mode with 8 data bits, no parity and one stop bit. The baud rate is
+ * set with termios2 and BOTHER, so any rate supported by the driver can be used (i.e. 250000,
+ * which has no Bxxx constant). The glibc termios interface can't be used in the same translation
+ * unit, therefore all termios handling of the devices lives here.
+ */
+class SerialPort {
+    public:
+        SerialPort() = delete;
+
+        /**
+         * Configures the serial interface fd. Returns false and sets errno, if the interface
+         * can't be configured. Setting the low latency mode isn't supported by every driver
+         * (i.e. USB CDC ACM), in this case only a warning is printed.
+         */
+        static bool configure(int fd, const Config::DeviceConfig &dev_conf);
+
+        /**
+         * Returns the output baud rate of the serial interface fd or 0 on error.
+         */
+        static uint32_t baud_rate(int fd);
+};
+
+#endif
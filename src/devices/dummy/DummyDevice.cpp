@@ -1,7 +1,6 @@
 #include "DummyDevice.hh"
 #include <stdexcept>
 #include <iostream>
-#include <sstream>
 #include <unistd.h>
 
 
@@ -10,39 +9,18 @@
  */
 DummyDevice::DummyDevice(const std::string &name)
     : m_device(name),
+      m_sensor_simulation(*this),
       m_running(true)
 {
     set_state(State::OK);
-    m_sensor_readings_job = std::thread([this]() {
-                Device::SensorValue sv;
-                sv.current_value = 1.1;
-                sv.unit = "m";
-                sv.set_point = 2.2;
-                m_sensor_readings["first"] = sv;
-                sv.current_value = 3.3;
-                sv.unit = "m/s";
-                sv.set_point.reset();
-                m_sensor_readings["second"] = sv;
-                sv.current_value = 4.4;
-                sv.unit.reset();
-                sv.set_point = 5.5;
-                m_sensor_readings["third"] = sv;
-                sv.current_value = 4.4;
-                sv.unit.reset();
-                sv.set_point.reset();
-                m_sensor_readings["forth"] = sv;
-
-                while(m_running) {
-                    update_sensor_readings();
-                    for (auto it = m_sensor_readings.begin(); it != m_sensor_readings.end(); it++) {
-                        it->second.current_value *= 1.01;
-                        if (it->second.set_point) {
-                            (*it->second.set_point) *= 1.01;
-                        }
-                    }
-                    sleep(1);
-                }
-            });
+    m_sensor_table.begin_update();
+    m_sensor_table.set(*m_sensor_table.intern("first", "m"), 1.1, 2.2);
+    m_sensor_table.set(*m_sensor_table.intern("second", "m/s"), 3.3, std::nullopt);
+    m_sensor_table.set(*m_sensor_table.intern("third", nullptr), 4.4, 5.5);
+    m_sensor_table.set(*m_sensor_table.intern("forth", nullptr), 4.4, std::nullopt);
+    m_sensor_table.end_update();
+    update_sensor_readings();
+    m_sensor_timer = EventLoop::get_event_loop().create_timer(&m_sensor_simulation, std::chrono::seconds(1));
 }
 
 
@@ -55,9 +33,31 @@ DummyDevice::~DummyDevice()
     if (m_print_job.joinable()) {
         m_print_job.join();
     }
-    if (m_sensor_readings_job.joinable()) {
-        m_sensor_readings_job.join();
+    if (m_sensor_timer) {
+        m_sensor_timer->disable();
     }
+    m_sensor_timer = nullptr;
+}
+
+
+/*
+ * SensorSimulation::onTrigger()
+ */
+bool DummyDevice::SensorSimulation::onTrigger()
+{
+    SensorTable &table = m_dev.m_sensor_table;
+    table.begin_update();
+    double current_value;
+    std::optional<double> set_point;
+    for (size_t id = 0; table.get(id, current_value, set_point); ++id) {
+        if (set_point) {
+            (*set_point) *= 1.01;
+        }
+        table.set(id, current_value * 1.01, set_point);
+    }
+    table.end_update();
+    m_dev.update_sensor_readings();
+    return true;
 }
 
 
@@ -66,7 +66,14 @@ DummyDevice::~DummyDevice()
  */
 Device::PrintResult DummyDevice::print_file(const std::string &file_path)
 {
-    throw std::runtime_error("DummyDevice::print_file() not yet implemented!");
+    std::shared_ptr<const GcodeJob> job;
+    try {
+        job = GcodeJob::from_file(file_path);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to load G-code file: " << e.what() << "\n";
+        return PrintResult::ERR_INVALID_JOB;
+    }
+    return print_job(job);
 }
 
 
@@ -74,42 +81,44 @@ Device::PrintResult DummyDevice::print_file(const std::string &file_path)
  * print()
  */
 Device::PrintResult DummyDevice::print(const std::string &gcode)
+{
+    return print_job(GcodeJob::from_string(gcode));
+}
+
+
+/*
+ * print_job()
+ */
+Device::PrintResult DummyDevice::print_job(const std::shared_ptr<const GcodeJob> &job)
+{
+    if (state() != Device::State::OK) {
+        return PrintResult::ERR_INVALID_STATE;
+    }
+    return print_analyzed_job(job, GcodeAnalysis::analyze(*job));
+}
+
+
+/*
+ * print_analyzed_job()
+ */
+Device::PrintResult DummyDevice::print_analyzed_job(const std::shared_ptr<const GcodeJob> &job,
+                                                    const std::shared_ptr<const GcodeAnalysis> &analysis)
 {
     if (state() != Device::State::OK) {
         return PrintResult::ERR_INVALID_STATE;
     }
     const std::lock_guard<std::mutex> guard(m_mutex);
-    if (!m_curr_print.empty()) {
+    if (m_job) {
         return PrintResult::ERR_PRINTING;
     }
-    std::istringstream gcode_stream(gcode);
-
-    auto trim = [](std::string &s) {
-        s.erase(0, s.find_first_not_of(" \n\r\t\f\v"));
-        s.erase(s.find_last_not_of(" \n\r\t\f\v") + 1);
-    };
-
-    while (!gcode_stream.eof()) {
-        std::string line;
-        std::getline(gcode_stream, line);
-        std::string::size_type pos = line.find(';');
-        if (std::string::npos != pos) {
-            line = line.substr(0, pos);
-        }
-        if (0 == line.size()) {
-            continue;
-        }
-        trim(line);
-        if (0 == line.size()) {
-            continue;
-        }
-        m_curr_print.push_back(line);
-    }
+    m_job = job;
+    m_analysis = analysis;
+    m_next_line = 0;
 
     set_state(Device::State::PRINTING);
-    m_commands = m_curr_print.size();
+    m_commands = m_job->size();
     m_progress = 0;
-    m_remaining_time = m_curr_print.size() * 10 / 1000 / 60;
+    m_remaining_time = m_analysis->remaining_time(0);
     update_progress(m_progress, m_remaining_time);
 
     if (m_print_job.joinable()) {
@@ -123,12 +132,13 @@ Device::PrintResult DummyDevice::print(const std::string &gcode)
                     if (!m_running) {
                         return;
                     }
-                    if (m_curr_print.empty()) {
+                    if (m_next_line >= m_commands) {
                         break;
                     }
-                    m_curr_print.pop_front();
-                    int new_progress = 100 - (m_curr_print.size() * 100) / m_commands;
-                    int remaining_time = m_curr_print.size() * 10 / 1000 / 60;
+                    m_next_line++;
+                    // the progress of a real printer, which would print the job
+                    int new_progress = m_analysis->percentage(m_next_line);
+                    int remaining_time = m_analysis->remaining_time(m_next_line);
                     if (   new_progress != m_progress
                         || remaining_time != m_remaining_time) {
                         m_progress = new_progress;
@@ -140,6 +150,8 @@ Device::PrintResult DummyDevice::print(const std::string &gcode)
             }
             {
                 const std::lock_guard<std::mutex> guard(m_mutex);
+                m_job = nullptr;
+                m_analysis = nullptr;
                 update_progress(100, 0);
                 set_state(Device::State::OK);
             }
@@ -2,6 +2,8 @@
 #define __DUMMY_DEVICE_HH__
 
 #include "../Device.hh"
+#include "../../job/GcodeJob.hh"
+#include "../../job/GcodeAnalysis.hh"
 #include <mutex>
 #include <list>
 #include <thread>
@@ -18,22 +20,37 @@ class DummyDevice : public Device {
 
         virtual PrintResult print_file(const std::string &file_path) override;
         virtual PrintResult print(const std::string &gcode) override;
+        virtual PrintResult print_job(const std::shared_ptr<const GcodeJob> &job) override;
+        virtual PrintResult print_analyzed_job(const std::shared_ptr<const GcodeJob> &job,
+                                               const std::shared_ptr<const GcodeAnalysis> &analysis) override;
         virtual const std::string &name() const override 
         {
             return m_device;
         }
-
-        virtual std::map<std::string, struct Device::SensorValue> sensor_readings() override
-        {
-            return m_sensor_readings;
-        }
     private:
+        /**
+         * Changes the sensor readings every second.
+         */
+        class SensorSimulation : public EventLoop::UserListener {
+            public:
+                SensorSimulation(DummyDevice &dev)
+                    : m_dev(dev)
+                {}
+
+                bool onTrigger() override;
+
+            private:
+                DummyDevice &m_dev;
+        };
+
         std::string m_device;
         std::mutex m_mutex;
-        std::list<std::string> m_curr_print;
+        std::shared_ptr<const GcodeJob> m_job;
+        std::shared_ptr<const GcodeAnalysis> m_analysis;
+        size_t m_next_line;
         std::thread m_print_job;
-        std::thread m_sensor_readings_job;
-        std::map<std::string, Device::SensorValue> m_sensor_readings;
+        SensorSimulation m_sensor_simulation;
+        std::shared_ptr<EventLoop::UserEvent> m_sensor_timer;
         size_t m_commands;
         int m_progress;
         int m_remaining_time;
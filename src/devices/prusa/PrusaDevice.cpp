@@ -1,39 +1,13 @@
 #include "PrusaDevice.hh"
 #include <fcntl.h>
 #include <sys/ioctl.h>
-#include <termios.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <cstring>
 #include <stdexcept>
-#include <regex>
 #include <string>
-#include <fstream>
-
-// example for temperature readings: "T:21.6 /0.0 B:21.8 /0.0 T0:21.6 /0.0 @:0 B@:0 P:0.0 A:23.0"
-#define __TEMP_REGEX "((T[[:digit:]]*)|(B[[:digit:]]*)|(B@)|@|P|A):[[:digit:]]+(\\.[[:digit:]]+)?( /[[:digit:]]+\\.[[:digit:]])?[[:space:]]*"
-const std::regex __temp_regex(__TEMP_REGEX);
-const std::regex __full_temp_regex("(" __TEMP_REGEX ")+");
-
-
-// example for position readings: "X:0.00 Y:0.00 Z:0.15 E:0.00 Count X: 0.00 Y:0.00 Z:0.15 E:0.00"
-//                                                                     ^ (space!)
-#define __POS_REGEX "(([XYZE]:[[:space:]]?[[:digit:]]+(\\.[[:digit:]]+))|Count)[[:space:]]?"
-const std::regex __pos_regex(__POS_REGEX);
-const std::regex __full_pos_regex("(" __POS_REGEX "){9}");
-
-
-// example for fan readings: "E0:0 RPM PRN1:0 RPM E0@:0 PRN1@:0"
-#define __FAN_REGEX "((E)|(PRN))[[:digit:]]@?:[[:digit:]]+( RPM)?[[:space:]]?"
-const std::regex __fan_regex(__FAN_REGEX);
-const std::regex __full_fan_regex("(" __FAN_REGEX ")+");
-
-
-// example: NORMAL MODE: Percent done: 0; print time remaining in mins: 24; Change in mins: -1
-// example: SILENT MODE: Percent done: 1; print time remaining in mins: 24; Change in mins: -1
-#define __PROGRESS_REGEX "^NORMAL MODE: Percent done: ([[:digit:]]+); print time remaining in mins: ([[:digit:]]+);.*$"
-const std::regex __progress_regex(__PROGRESS_REGEX);
-
-
+#include <algorithm>
+#include <charconv>
 
 /*
  * PrusaDevice()
@@ -41,13 +15,36 @@ const std::regex __progress_regex(__PROGRESS_REGEX);
 PrusaDevice::PrusaDevice(const std::string &file, const std::string &name, const Config &conf)
     : m_device(file),
       m_name(name),
-      m_ev(EventLoop::get_realtime_event_loop(conf.use_realtime_scheduler())),
+      m_ev(RealtimeEventLoop::for_device(conf, name)),
       m_fd(-1),
-      m_send_lines(),
-      m_sended_lines(),
-      m_send_buf_helper(m_mutex, m_send_lines, m_sended_lines),
-      m_conf(conf)
+      // some slots are reserved for commands, which are not part of the print job
+      m_send_queue(conf.device_config(name).print_window_commands + 8),
+      m_send_buf_helper(m_mutex, m_send_queue),
+      m_finished_lines(0),
+      m_first_line(0),
+      m_prologue_lines(0),
+      m_progress(0),
+      m_remaining_time(0),
+      m_conf(conf),
+      m_dev_conf(conf.device_config(name)),
+      m_framing(false),
+      m_next_number(0),
+      m_stale_oks(0),
+      m_resend_pending(false),
+      m_resend_number(0)
 {
+    // the table is empty, so interning can't fail
+    m_temp_sensors[0] = *m_sensor_table.intern("temp_extruder", "celsius");
+    m_temp_sensors[1] = *m_sensor_table.intern("temp_bed", "celsius");
+    m_temp_sensors[2] = *m_sensor_table.intern("temp_ambient", "celsius");
+    const char *axes[] = { "pos_X", "pos_Y", "pos_Z", "pos_E" };
+    for (size_t axis = 0; axis < 4; ++axis) {
+        m_pos_sensors[axis] = *m_sensor_table.intern(axes[axis], "mm");
+    }
+
+    if (0 < m_dev_conf.checkpoint_interval && !conf.checkpoint_dir().empty()) {
+        m_checkpoint = std::make_unique<CheckpointWriter>(PrintCheckpoint::path(conf.checkpoint_dir(), name));
+    }
     initialize();
 }
 
@@ -70,10 +67,17 @@ void PrusaDevice::initialize()
         return;
     }
     const std::lock_guard<std::mutex> guard(m_mutex);
-    m_sensor_readings.clear();
-    m_send_lines.clear();
-    m_sended_lines.clear();
-    m_curr_print.clear();
+    // the printer restarted (i.e. after a power loss), the print can be resumed from the checkpoint
+    if (m_spooler.is_open() && m_checkpoint) {
+        m_checkpoint->flush();
+    }
+    m_sensor_table.clear();
+    m_send_queue.clear();
+    m_spooler.close();
+    m_analysis = nullptr;
+    m_framing = false;
+    m_stale_oks = 0;
+    m_resend_pending = false;
 
     set_state(State::INIT_DEVICE);
     m_pstate = DEVICE_NOT_READY;
@@ -83,17 +87,6 @@ void PrusaDevice::initialize()
         return;
     }
 
-    m_print_helper = [this](const std::string &line) {
-        const std::lock_guard<std::mutex> guard(m_mutex);
-        if (m_curr_print.empty()) {
-            update_progress(100, 0);
-            set_state(State::OK);
-            return;
-        }
-        send_command_nl(m_curr_print.front(), nullptr, m_print_helper);
-        m_curr_print.pop_front();
-    };
-
     m_fd = open(m_device.c_str(), O_RDWR | O_SYNC | O_NOCTTY | O_NONBLOCK);
     if (0 > m_fd) {
         if (EBUSY == errno) {
@@ -108,52 +101,48 @@ void PrusaDevice::initialize()
         return;
     }
 
-    struct termios tty;
-    if (0 != tcgetattr(m_fd, &tty)) {
-        close(m_fd);
-        m_fd = -1;
+    if (!SerialPort::configure(m_fd, m_dev_conf)) {
+        std::cerr << "Could not configure " << m_device << ": " << strerror(errno) << "\n";
         set_state(State::ERROR);
+        close_device();
         return;
     }
 
-    cfsetospeed(&tty, B115200);
-    cfsetispeed(&tty, B115200);
-
-    tty.c_cflag = (tty.c_cflag & ~CSIZE) | CS8;
-    tty.c_iflag &= ~IGNBRK;
-    tty.c_lflag = 0;
-    tty.c_lflag = ICANON;
-    tty.c_oflag = 0;
-    tty.c_iflag &= ~(IXON | IXOFF | IXANY);
-    tty.c_cflag |= (CLOCAL | CREAD);
-    tty.c_cflag &= ~(PARENB | PARODD);
-    tty.c_cflag &= ~CSTOPB;
-    tty.c_cflag &= ~CRTSCTS;
-
-    if (0 != tcsetattr(m_fd, TCSANOW, &tty)) {
-        set_state(State::ERROR);
-        return;
-    }
+    register_write_cb();
 
+    m_read_buffer.clear();
     m_read_helper.pd = this;
     m_read_helper.set_state = [this](enum State state){ set_state(state); };
 
     // this have to be the last call in this function!
     m_ev.register_read_cb(m_fd, [](int fd, void *arg) -> bool {
             struct read_helper *rh = static_cast<struct read_helper *>(arg);
-            char buf[1000];
+            LineBuffer &read_buffer = rh->pd->m_read_buffer;
             ssize_t n;
-            while(0 < (n = read(fd, buf, 1000))) {
-                if (!n) {
-                    continue;
+            while (true) {
+                size_t len;
+                char *area = read_buffer.write_area(len);
+                n = read(fd, area, len);
+                if (0 >= n) {
+                    break;
+                }
+                read_buffer.commit(n);
+
+                std::string_view line;
+                while (read_buffer.next_line(line)) {
+                    rh->pd->onReadedLine(line);
+                    // The line may have made the device invalid (i.e. an unrecoverable resend
+                    // request). The fd is closed here, after the loop stopped using it.
+                    if (!rh->pd->is_valid()) {
+                        rh->pd->close_device();
+                        return false;
+                    }
                 }
-                buf[n-1] = 0;
-                rh->pd->onReadedLine(buf);
-
             }
 
             if (0 == n) {
                 rh->set_state(State::DISCONNECTED);
+                rh->pd->close_device();
                 return false;
             }
 
@@ -161,6 +150,7 @@ void PrusaDevice::initialize()
                 std::cerr << "Error while reading from fd: " << strerror(errno) << "\n";
                 std::cerr << "fd: " << fd << "\n";
                 rh->set_state(State::ERROR);
+                rh->pd->close_device();
                 return false;
             }
             return true;
@@ -171,7 +161,7 @@ void PrusaDevice::initialize()
 /*
  * onReadedLine()
  */
-void PrusaDevice::onReadedLine(const std::string &readed_line)
+void PrusaDevice::onReadedLine(std::string_view readed_line)
 {
     if (!is_valid()) {
         return;
@@ -184,40 +174,57 @@ void PrusaDevice::onReadedLine(const std::string &readed_line)
         return;
     }
 
-    // we got an ok for an command, call the callback for finished
-    if (readed_line == "ok") {
-        struct send_buf finished_buf;
+    // we got an ok for an command, call the callback for finished. Some commands are answered
+    // within the line of the ok (i.e. M105: "ok T:210.0 /210.0 B:60.0 /60.0 ...").
+    uint32_t line_number;
+    if (readed_line == "ok" || 0 == readed_line.compare(0, 3, "ok ")) {
+        Action finished = Action::NONE;
         {
             const std::lock_guard<std::mutex> guard(m_mutex);
-            if (!m_sended_lines.empty()) {
-                finished_buf = m_sended_lines.front();
-                m_sended_lines.pop_front();
+            if (m_stale_oks) {
+                // acknowledgement of a rejected command, which is sent again
+                m_stale_oks--;
+            } else if (m_send_queue.has_written()) {
+                const SendQueue::Slot &front = m_send_queue.front();
+                if (m_resend_pending && front.prefix_len && m_resend_number == front.number) {
+                    m_resend_pending = false;
+                }
+                finished = front.action;
+                m_send_queue.pop();
             } else {
                 std::cerr << "Got ok, but didn't have commands in the queue!";
             }
         }
-        if (finished_buf.finished) {
-            finished_buf.finished(finished_buf.line);
+        if (3 < readed_line.size() && (state() == State::OK || state() == State::PRINTING)) {
+            parse_report(readed_line.substr(3));
         }
+        on_command_finished(finished);
         return;
     // we send an invalid command
     } else if (0 == readed_line.compare(0, std::strlen("echo:Unknown command:"), "echo:Unknown command:")) {
         const std::lock_guard<std::mutex> guard(m_mutex);
-        std::cerr << "Error: Command is not known by printer: " << m_sended_lines.front().line << std::endl;
+        if (m_send_queue.has_written()) {
+            std::cerr << "Error: Command is not known by printer: " << m_send_queue.front().line << std::endl;
+        }
         // TODO: Sending an invalid gcode command kills gocoded completely ... fix this!
         throw std::runtime_error("Sended an command to printer, which the printer does not know!");
+    } else if (PrusaParser::parse_resend(readed_line, line_number)) {
+        on_resend(line_number);
+        return;
+    // the firmware rejected a command because of a wrong line number or checksum
+    } else if (0 == readed_line.compare(0, std::strlen("Error:"), "Error:")) {
+        std::cerr << "Printer reported: " << readed_line << "\n";
+        return;
     }
 
-    struct send_buf curr_buf;
+    Action curr = Action::NONE;
     {
         const std::lock_guard<std::mutex> guard(m_mutex);
-        if (!m_sended_lines.empty()) {
-            curr_buf = m_sended_lines.front();
+        if (m_send_queue.has_written()) {
+            curr = m_send_queue.front().action;
         }
     }
-    if (curr_buf.parse_line) {
-        curr_buf.parse_line(readed_line);
-    }
+    on_command_output(curr, readed_line);
 
     if (state() == State::INIT_DEVICE) {
         switch(m_pstate) {
@@ -231,15 +238,31 @@ void PrusaDevice::onReadedLine(const std::string &readed_line)
                 break;
         };
     } else if (state() == State::OK || state() == State::PRINTING) {
-        if (std::regex_match(readed_line, __full_temp_regex)) {
-            parse_temp(readed_line);
-        } else if (std::regex_match(readed_line, __full_pos_regex)) {
-            parse_pos(readed_line);
-        } else if (std::regex_match(readed_line, __full_fan_regex)) {
-            parse_fan(readed_line);
-        } else {
-            parse_progress(readed_line);
-        }
+        parse_report(readed_line);
+    }
+}
+
+
+/*
+ * parse_report()
+ */
+void PrusaDevice::parse_report(std::string_view line)
+{
+    PrusaParser::Result result;
+    PrusaParser::parse(line, result);
+    switch (result.type) {
+        case PrusaParser::LineType::TEMPERATURE:
+            update_temp(result);
+            break;
+        case PrusaParser::LineType::POSITION:
+            update_pos(result);
+            break;
+        case PrusaParser::LineType::FAN:
+            update_fan(result);
+            break;
+        default:
+            parse_progress(line);
+            break;
     }
 }
 
@@ -258,44 +281,17 @@ void PrusaDevice::change_pstate(enum prusa_state pstate)
     switch (m_pstate) {
         case DEVICE_ACCEPTS_COMMANDS:
             // get firmware version and capabilities
-            send_command_nl("M115",
-                            [this](const std::string &read_line) {
-                                if (0 != read_line.compare(0, 4, "Cap:")) {
-                                    return;
-                                }
-                                const size_t second_colon = read_line.find(':', 5);
-                                if (std::string::npos == second_colon) {
-                                    return;
-                                }
-                                if ('1' != read_line[second_colon+1]) {
-                                    return;
-                                }
-                                const std::lock_guard<std::mutex> guard(m_mutex);
-                                m_capabilities.push_back(read_line.substr(4, second_colon-4));
-                            },
-                            [this](const std::string &bla){
-                                unsigned int bitmap = 0;
-                                {
-                                    const std::lock_guard<std::mutex> guard(m_mutex);
-                                    for (const auto &cap: m_capabilities) {
-                                        if ("AUTOREPORT_TEMP" == cap) {
-                                            bitmap |= 0x1 << 0;
-                                        } else if ("AUTOREPORT_FANS" == cap) {
-                                            bitmap |= 0x1 << 1;
-                                        } else if ("AUTOREPORT_POSITION" == cap) {
-                                            bitmap |= 0x1 << 2;
-                                        }
-                                    }
-                                }
-                                // enable autoreporting of senser readings
-                                std::string command = "M155 S2 C";
-                                command += std::to_string(bitmap);
-                                send_command_nl(command,
-                                                nullptr,
-                                                [this](const std::string &) {
-                                                    change_pstate(DEVICE_READY);
-                                                });
-                            });
+            send_command_nl("M115", Action::READ_CAPABILITIES);
+            break;
+        case DEVICE_TESTING_LATENCY:
+            {
+                const std::lock_guard<std::mutex> guard(m_mutex);
+                m_latency_test.remaining = m_dev_conf.serial_latency_test;
+                m_latency_test.min = std::chrono::steady_clock::duration::max();
+                m_latency_test.max = std::chrono::steady_clock::duration::zero();
+                m_latency_test.sum = std::chrono::steady_clock::duration::zero();
+                send_latency_test_command();
+            }
             break;
         case DEVICE_READY:
             set_state(State::OK);
@@ -307,48 +303,308 @@ void PrusaDevice::change_pstate(enum prusa_state pstate)
 }
 
 
+/*
+ * on_command_output()
+ */
+void PrusaDevice::on_command_output(Action action, std::string_view line)
+{
+    switch (action) {
+        case Action::READ_CAPABILITIES:
+            {
+                if (0 != line.compare(0, 4, "Cap:")) {
+                    return;
+                }
+                const size_t second_colon = line.find(':', 5);
+                if (std::string_view::npos == second_colon) {
+                    return;
+                }
+                if ('1' != line[second_colon+1]) {
+                    return;
+                }
+                const std::lock_guard<std::mutex> guard(m_mutex);
+                m_capabilities.emplace_back(line.substr(4, second_colon-4));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+
+/*
+ * on_command_finished()
+ */
+void PrusaDevice::on_command_finished(Action action)
+{
+    switch (action) {
+        case Action::JOB_LINE:
+            {
+                const std::lock_guard<std::mutex> guard(m_mutex);
+                m_finished_lines++;
+                if (m_checkpoint) {
+                    m_checkpoint->set_line(finished_job_lines());
+                    if (0 == m_finished_lines % m_dev_conf.checkpoint_interval) {
+                        m_checkpoint->flush();
+                    }
+                }
+                report_progress();
+                fill_print_window();
+            }
+            break;
+        case Action::READ_CAPABILITIES:
+            {
+                const std::lock_guard<std::mutex> guard(m_mutex);
+                unsigned int bitmap = 0;
+                for (const auto &cap: m_capabilities) {
+                    if ("AUTOREPORT_TEMP" == cap) {
+                        bitmap |= 0x1 << 0;
+                    } else if ("AUTOREPORT_FANS" == cap) {
+                        bitmap |= 0x1 << 1;
+                    } else if ("AUTOREPORT_POSITION" == cap) {
+                        bitmap |= 0x1 << 2;
+                    }
+                }
+                // enable autoreporting of senser readings
+                std::string command = "M155 S2 C";
+                command += std::to_string(bitmap);
+                send_command_nl(command, Action::ENABLE_AUTOREPORT);
+            }
+            break;
+        case Action::ENABLE_AUTOREPORT:
+            change_pstate((0 < m_dev_conf.serial_latency_test) ? DEVICE_TESTING_LATENCY : DEVICE_READY);
+            break;
+        case Action::LATENCY_TEST:
+            {
+                const std::chrono::steady_clock::duration round_trip = std::chrono::steady_clock::now() - m_latency_test.sent;
+                m_latency_test.min = std::min(m_latency_test.min, round_trip);
+                m_latency_test.max = std::max(m_latency_test.max, round_trip);
+                m_latency_test.sum += round_trip;
+                if (--m_latency_test.remaining) {
+                    const std::lock_guard<std::mutex> guard(m_mutex);
+                    send_latency_test_command();
+                    break;
+                }
+                report_latency();
+                change_pstate(DEVICE_READY);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+
+/*
+ * send_latency_test_command()
+ */
+void PrusaDevice::send_latency_test_command()
+{
+    // M105 is answered immediately, since it doesn't wait for the planner
+    m_latency_test.sent = std::chrono::steady_clock::now();
+    send_command_nl("M105", Action::LATENCY_TEST);
+}
+
+
+/*
+ * report_latency()
+ */
+void PrusaDevice::report_latency() const
+{
+    typedef std::chrono::duration<double, std::milli> ms;
+    const uint32_t count = m_dev_conf.serial_latency_test;
+    std::cout << m_name << ": round trip time of " << count << " commands"
+              << " (baud rate " << SerialPort::baud_rate(m_fd)
+              << ", low latency " << ((m_dev_conf.serial_low_latency)?("on"):("off"))
+              << ", VMIN " << m_dev_conf.serial_vmin
+              << ", VTIME " << m_dev_conf.serial_vtime << "):"
+              << " min " << ms(m_latency_test.min).count() << " ms,"
+              << " avg " << ms(m_latency_test.sum).count() / count << " ms,"
+              << " max " << ms(m_latency_test.max).count() << " ms\n";
+}
+
+
 /*
  * send_command_nl()
  */
-void PrusaDevice::send_command_nl(const std::string &command,
-                                  std::function<void(const std::string &line)> parse_line,
-                                  std::function<void(const std::string &line)> finished)
-{
-    const bool is_empty = m_send_lines.empty();
-    struct send_buf &sb = m_send_lines.emplace_back();
-    sb.line = command + "\n";
-    //std::cout << "send_command: " << command << "\n";
-    sb.finished = finished;
-    sb.parse_line = parse_line;
-
-    // it is important, that we only register the write callback if we didn't use an already
-    // registered write callback. If we would register a new one, while using the old one,
-    // than we mess up some memory (stack or heap) if the usage and registering happens on
-    // different threads.
-    if (!is_empty) {
+bool PrusaDevice::send_command_nl(std::string_view command, Action action)
+{
+    const bool had_unwritten = m_send_queue.has_unwritten();
+    if (!m_send_queue.push_copy(command, action)) {
+        std::cerr << "Error: Could not queue command: " << command << "\n";
+        return false;
+    }
+    frame_last_command(GcodeJob::checksum(command));
+    flush_queue(had_unwritten);
+    return true;
+}
+
+
+/*
+ * send_job_line_nl()
+ */
+bool PrusaDevice::send_job_line_nl(std::string_view line, uint8_t line_xor, bool expanded)
+{
+    static_assert(BinaryGcode::MAX_LINE_SIZE <= SendQueue::INLINE_SIZE, "An expanded line has to fit into a slot of the send queue.");
+    const bool had_unwritten = m_send_queue.has_unwritten();
+    const bool pushed = (expanded) ? (m_send_queue.push_copy(line, Action::JOB_LINE))
+                                   : (m_send_queue.push_view(line, Action::JOB_LINE));
+    if (!pushed) {
+        return false;
+    }
+    frame_last_command(line_xor);
+    flush_queue(had_unwritten);
+    return true;
+}
+
+
+/*
+ * frame_last_command()
+ */
+void PrusaDevice::frame_last_command(uint8_t line_xor)
+{
+    if (!m_framing) {
+        return;
+    }
+    // "N<number> <command>*<checksum>\n", the checksum is the XOR of all bytes before the '*'
+    char prefix[SendQueue::MAX_PREFIX];
+    char *end = prefix;
+    *end++ = 'N';
+    end = std::to_chars(end, prefix + sizeof(prefix) - 1, m_next_number).ptr;
+    *end++ = ' ';
+    const std::string_view prefix_view(prefix, end - prefix);
+
+    char suffix[SendQueue::MAX_SUFFIX];
+    end = suffix;
+    *end++ = '*';
+    end = std::to_chars(end, suffix + sizeof(suffix) - 1, GcodeJob::checksum(prefix_view, line_xor)).ptr;
+    *end++ = '\n';
+
+    m_send_queue.frame_last(m_next_number, prefix_view, std::string_view(suffix, end - suffix));
+    m_next_number++;
+}
+
+
+/*
+ * framing_overhead()
+ */
+size_t PrusaDevice::framing_overhead() const
+{
+    if (!m_framing) {
+        return 0;
+    }
+    size_t digits = 1;
+    for (uint32_t number = m_next_number; 10 <= number; number /= 10) {
+        digits++;
+    }
+    // "N<number> " and "*<checksum>", the new line is already counted
+    return 2 + digits + 4;
+}
+
+
+/*
+ * on_resend()
+ */
+void PrusaDevice::on_resend(uint32_t line_number)
+{
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    // The firmware acknowledges every rejected command after the resend request. These
+    // acknowledgements don't belong to any command in the queue.
+    m_stale_oks++;
+
+    if (!m_framing) {
+        std::cerr << "Printer requested line " << line_number << ", but no line numbers are sent.\n";
+        return;
+    }
+    // The firmware rejects all commands following the corrupted one with the same request, until
+    // it receives the requested line.
+    if (m_resend_pending && m_resend_number == line_number) {
+        return;
+    }
+
+    const int64_t position = m_send_queue.find_number(line_number);
+    if (0 > position) {
+        std::cerr << "Error: Printer requested line " << line_number << ", which is not available anymore.\n";
+        set_state(State::ERROR);
+        return;
+    }
+    const bool had_unwritten = m_send_queue.has_unwritten();
+    if (!m_send_queue.rewind(position)) {
+        // the line was already executed, sending it again would execute it twice
+        std::cerr << "Error: Printer requested line " << line_number << ", which is already acknowledged.\n";
+        set_state(State::ERROR);
         return;
     }
+    m_resend_pending = true;
+    m_resend_number = line_number;
+    flush_queue(had_unwritten);
+}
+
+
+/*
+ * flush_queue()
+ */
+void PrusaDevice::flush_queue(bool had_unwritten)
+{
+    // If there were unwritten commands before, the write callback is already woken up and
+    // sends the new command as well.
+    if (!had_unwritten) {
+        m_ev.trigger_write_cb(m_fd);
+    }
+}
+
+
+/*
+ * register_write_cb()
+ */
+void PrusaDevice::register_write_cb()
+{
+    // The write callback is registered only once. Registering a new one, while the old one is
+    // used, messes up some memory (stack or heap) if the usage and registering happens on
+    // different threads. Furthermore, registering allocates a new event for every command.
     m_ev.register_write_cb(m_fd, [](int fd, void *arg) -> bool {
             struct send_buf_helper *sb_helper = static_cast<struct send_buf_helper *>(arg);
             std::lock_guard<std::mutex> guard(sb_helper->mutex);
 
             ssize_t n = 0;
-            while(-1 != n) {
-                {
-                    if (sb_helper->send_lines.empty()) {
-                        break;
-                    }
-                    struct send_buf &curr = sb_helper->send_lines.front();
-                    size_t to_send = curr.line.size() - curr.sended;
-                    if (to_send > 0) {
-                        n = write(fd, curr.line.data(), to_send);
-                        if (n < 0) {
-                            break;
+            while (sb_helper->queue.has_unwritten()) {
+                // All unwritten commands are gathered into one writev(). This saves syscalls and
+                // USB packets, if several commands are acknowledged at once. The lines are written
+                // directly from their memory (i.e. the mapped G-code file) without assembling them
+                // in a temporary buffer. Prefix and suffix (line number, checksum and new line) are
+                // stored in the slot.
+                struct iovec iov[3 * MAX_WRITE_BATCH];
+                int iovcnt = 0;
+                size_t total = 0;
+                const size_t batch = std::min(sb_helper->queue.unwritten_count(), MAX_WRITE_BATCH);
+                for (size_t i = 0; i < batch; ++i) {
+                    const SendQueue::Slot &slot = sb_helper->queue.unwritten(i);
+                    total += slot.size() - slot.sent;
+                    const std::string_view parts[] = {
+                        std::string_view(slot.prefix, slot.prefix_len),
+                        slot.line,
+                        std::string_view(slot.suffix, slot.suffix_len)
+                    };
+                    size_t skip = slot.sent;
+                    for (const std::string_view &part: parts) {
+                        if (skip >= part.size()) {
+                            skip -= part.size();
+                            continue;
                         }
-                        curr.sended += n;
+                        iov[iovcnt].iov_base = const_cast<char *>(part.data() + skip);
+                        iov[iovcnt].iov_len = part.size() - skip;
+                        iovcnt++;
+                        skip = 0;
                     }
-                    sb_helper->sended_lines.push_back(curr);
-                    sb_helper->send_lines.pop_front();
+                }
+                n = writev(fd, iov, iovcnt);
+                if (n < 0) {
+                    break;
+                }
+
+                sb_helper->queue.advance_written(n);
+                if (size_t(n) < total) {
+                    // partial write, wait until the fd is writable again
+                    break;
                 }
             }
             if (   n == -1
@@ -356,7 +612,7 @@ void PrusaDevice::send_command_nl(const std::string &command,
                 return false;
             }
 
-            if (sb_helper->send_lines.empty()) {
+            if (!sb_helper->queue.has_unwritten()) {
                 return false;
             }
             return true;
@@ -366,137 +622,137 @@ void PrusaDevice::send_command_nl(const std::string &command,
 
 
 /*
- * parse_temp()
+ * update_temp()
  */
-void PrusaDevice::parse_temp(const std::string &line)
+void PrusaDevice::update_temp(const PrusaParser::Result &result)
 {
-    std::smatch m;
-    auto begin = line.begin();
-    const auto end = line.end();
-    while (std::regex_search(begin, end, m, __temp_regex)) {
-        begin = begin + m.position() + m[0].length();
-        struct SensorValue readings;
-
-        std::string::size_type colon_pos = m[0].str().find(':');
-        std::string::size_type slash_pos = m[0].str().find('/', colon_pos);
-
-        std::string type = m[0].str().substr(0, colon_pos);
-        readings.current_value = std::stod(m[0].str().substr(colon_pos+1));
-        readings.unit = "celsius";
-
-        if (std::string::npos != slash_pos) {
-            readings.set_point = std::stod(m[0].str().substr(slash_pos+1));
-        }
-
-        const std::lock_guard<std::mutex> guard(m_mutex);
-        if ("T" == type) {
-            m_sensor_readings["temp_extruder"] = readings;
-        } else if ("B" == type) {
-            m_sensor_readings["temp_bed"] = readings;
-        } else if ("A" == type) {
-            m_sensor_readings["temp_ambient"] = readings;
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    m_sensor_table.begin_update();
+    for (size_t i = 0; i < result.count; ++i) {
+        const PrusaParser::Reading &reading = result.readings[i];
+        size_t id;
+        if ("T" == reading.name) {
+            id = m_temp_sensors[0];
+        } else if ("B" == reading.name) {
+            id = m_temp_sensors[1];
+        } else if ("A" == reading.name) {
+            id = m_temp_sensors[2];
+        } else {
+            continue;
         }
+        m_sensor_table.set(id, reading.current_value, reading.set_point);
+    }
+    m_sensor_table.end_update();
+    if (m_checkpoint) {
+        double current_value;
+        std::optional<double> extruder;
+        std::optional<double> bed;
+        m_sensor_table.get(m_temp_sensors[0], current_value, extruder);
+        m_sensor_table.get(m_temp_sensors[1], current_value, bed);
+        m_checkpoint->set_temperatures(extruder.value_or(0.0), bed.value_or(0.0));
     }
 }
 
 
 
 /*
- * parse_pos()
+ * update_pos()
  */
-void PrusaDevice::parse_pos(const std::string &line)
+void PrusaDevice::update_pos(const PrusaParser::Result &result)
 {
-    std::smatch m;
-    auto begin = line.begin();
-    const auto end = line.end();
-    while (std::regex_search(begin, end, m, __pos_regex)) {
-        begin = begin + m.position() + m[0].length();
-        struct SensorValue readings;
-
-        // After "Count" there are only debug values
-        if ("Count " == m[0]) {
-            break;
-        }
-
-        std::string::size_type colon_pos = m[0].str().find(':');
-
-        std::string name = m[0].str().substr(0, colon_pos);
-        std::string::size_type space = name.find(' ');
-        if (std::string::npos != space) {
-            name = name.substr(0, space);
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    m_sensor_table.begin_update();
+    for (size_t i = 0; i < result.count; ++i) {
+        const PrusaParser::Reading &reading = result.readings[i];
+        size_t id;
+        if ("X" == reading.name) {
+            id = m_pos_sensors[0];
+        } else if ("Y" == reading.name) {
+            id = m_pos_sensors[1];
+        } else if ("Z" == reading.name) {
+            id = m_pos_sensors[2];
+        } else if ("E" == reading.name) {
+            id = m_pos_sensors[3];
+        } else {
+            continue;
         }
-        readings.current_value = std::stod(m[0].str().substr(colon_pos+1));
-        readings.unit = "mm";
-
-        const std::lock_guard<std::mutex> guard(m_mutex);
-        if ("X" == name) {
-            m_sensor_readings["pos_X"] = readings;
-        } else if ("Y" == name) {
-            m_sensor_readings["pos_Y"] = readings;
-        } else if ("Z" == name) {
-            m_sensor_readings["pos_Z"] = readings;
-        } else if ("E" == name) {
-            m_sensor_readings["pos_E"] = readings;
+        m_sensor_table.set(id, reading.current_value, std::nullopt);
+    }
+    m_sensor_table.end_update();
+    if (m_checkpoint) {
+        float position[4];
+        for (size_t axis = 0; axis < 4; ++axis) {
+            double current_value;
+            std::optional<double> set_point;
+            if (!m_sensor_table.get(m_pos_sensors[axis], current_value, set_point)) {
+                return;
+            }
+            position[axis] = current_value;
         }
+        m_checkpoint->set_position(position);
     }
 }
 
 
 /*
- * parse_fan()
+ * update_fan()
  */
-void PrusaDevice::parse_fan(const std::string &line)
+void PrusaDevice::update_fan(const PrusaParser::Result &result)
 {
-    std::smatch m;
-    auto begin = line.begin();
-    const auto end = line.end();
-    while (std::regex_search(begin, end, m, __fan_regex)) {
-        begin = begin + m.position() + m[0].length();
-
-        struct SensorValue readings;
-
-        // ignore power readings
-        if (std::string::npos != m[0].str().find('@')) {
-            continue;
-        }
-
-        std::string::size_type colon_pos = m[0].str().find(':');
-
-        std::string name = m[0].str().substr(0, colon_pos);
-        readings.current_value = std::stod(m[0].str().substr(colon_pos+1));
-        readings.unit = "rpm";
-
+    {
         const std::lock_guard<std::mutex> guard(m_mutex);
-        m_sensor_readings["fan_" + name] = readings;
+        // the fans are only known from the reports, their ids are looked up by name
+        char name[SensorTable::MAX_NAME] = "fan_";
+        m_sensor_table.begin_update();
+        for (size_t i = 0; i < result.count; ++i) {
+            const PrusaParser::Reading &reading = result.readings[i];
+            // ignore power readings
+            if (std::string_view::npos != reading.name.find('@')) {
+                continue;
+            }
+            const size_t len = std::min(reading.name.size(), sizeof(name) - 5);
+            std::memcpy(name + 4, reading.name.data(), len);
+            const std::optional<size_t> id = m_sensor_table.intern(std::string_view(name, 4 + len), "rpm");
+            if (id) {
+                m_sensor_table.set(*id, reading.current_value, std::nullopt);
+            }
+        }
+        m_sensor_table.end_update();
     }
     update_sensor_readings();
+}
 
-    /*
-    for (const auto &read: m_sensor_readings) {
-        std::cout << read.first << " = " << read.second.current_value;
-        if (read.second.set_point) {
-            std::cout << " / " << *read.second.set_point;
+
+/*
+ * parse_progress()
+ */
+void PrusaDevice::parse_progress(std::string_view line)
+{
+    unsigned percentage;
+    unsigned remaining;
+    if (PrusaParser::parse_progress(line, percentage, remaining)) {
+        const std::lock_guard<std::mutex> guard(m_mutex);
+        if (!m_analysis) {
+            update_progress(percentage, remaining);
         }
-        std::cout << "\n";
     }
-    */
 }
 
 
 /*
- * parse_progress()
+ * report_progress()
  */
-void PrusaDevice::parse_progress(const std::string &line)
+void PrusaDevice::report_progress()
 {
-    std::smatch match;
-    // TODO: distinguise between normal mode and silent mode ...
-    if (std::regex_match(line, match, __progress_regex)) {
-        if (match.size() != 3) {
-            throw std::runtime_error("This is unexpected and if it happends, than this is a programming error!");
-        }
-        const unsigned percentage = std::atoi(match[1].str().c_str());
-        const unsigned remaining = std::atoi(match[2].str().c_str());
-        update_progress(percentage, remaining);
+    if (!m_analysis) {
+        return;
+    }
+    const unsigned percentage = m_analysis->percentage(finished_job_lines());
+    const unsigned remaining_time = m_analysis->remaining_time(finished_job_lines());
+    if (percentage != m_progress || remaining_time != m_remaining_time) {
+        m_progress = percentage;
+        m_remaining_time = remaining_time;
+        update_progress(m_progress, m_remaining_time);
     }
 }
 
@@ -509,76 +765,104 @@ Device::PrintResult PrusaDevice::print_file(const std::string &file_path)
     if (state() != Device::State::OK) {
         return PrintResult::ERR_INVALID_STATE;
     }
-    const std::lock_guard<std::mutex> guard(m_mutex);
-    if (!m_curr_print.empty()) {
-        return PrintResult::ERR_PRINTING;
+
+    std::shared_ptr<const GcodeJob> job;
+    try {
+        job = GcodeJob::from_file(file_path);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to load G-code file: " << e.what() << "\n";
+        return PrintResult::ERR_INVALID_JOB;
     }
-    std::ifstream file(file_path);
+    return print_job(job);
+}
 
-    auto trim = [](std::string &s) {
-        s.erase(0, s.find_first_not_of(" \n\r\t\f\v"));
-        s.erase(s.find_last_not_of(" \n\r\t\f\v") + 1);
-    };
 
-    while (!file.eof()) {
-        std::string line;
-        std::getline(file, line);
-        std::string::size_type pos = line.find(';');
-        if (std::string::npos != pos) {
-            line = line.substr(0, pos);
-        }
-        if (0 == line.size()) {
-            continue;
-        }
-        trim(line);
-        if (0 == line.size()) {
-            continue;
-        }
-        m_curr_print.push_back(line);
+/*
+ * print()
+ */
+Device::PrintResult PrusaDevice::print(const std::string &gcode)
+{
+    if (state() != Device::State::OK) {
+        return PrintResult::ERR_INVALID_STATE;
     }
+    return print_job(GcodeJob::from_string(gcode));
+}
 
-    start_print();
 
-    return PrintResult::OK;
+/*
+ * print_job()
+ */
+Device::PrintResult PrusaDevice::print_job(const std::shared_ptr<const GcodeJob> &job)
+{
+    if (state() != Device::State::OK) {
+        return PrintResult::ERR_INVALID_STATE;
+    }
+    // the analysis is computed on the thread of the caller and not on the realtime thread
+    return print_analyzed_job(job, GcodeAnalysis::analyze(*job));
 }
 
 
 /*
- * print()
+ * print_analyzed_job()
  */
-Device::PrintResult PrusaDevice::print(const std::string &gcode)
+Device::PrintResult PrusaDevice::print_analyzed_job(const std::shared_ptr<const GcodeJob> &job,
+                                                    const std::shared_ptr<const GcodeAnalysis> &analysis)
 {
     if (state() != Device::State::OK) {
         return PrintResult::ERR_INVALID_STATE;
     }
+    // the hash for the checkpoints is computed on the thread of the caller and not on the
+    // realtime thread, it is computed only once for a job
+    if (m_checkpoint) {
+        job->content_hash();
+    }
     const std::lock_guard<std::mutex> guard(m_mutex);
-    if (!m_curr_print.empty()) {
-        return PrintResult::ERR_PRINTING;
+    return open_job(job, 0, nullptr, analysis);
+}
+
+
+/*
+ * resume_job()
+ */
+Device::PrintResult PrusaDevice::resume_job(const std::shared_ptr<const GcodeJob> &job, const PrintCheckpoint &checkpoint)
+{
+    if (state() != Device::State::OK) {
+        return PrintResult::ERR_INVALID_STATE;
+    }
+    if (job->content_hash() != checkpoint.job_hash) {
+        std::cerr << "The job does not belong to the checkpoint of " << m_name << ".\n";
+        return PrintResult::ERR_INVALID_JOB;
     }
-    std::istringstream gcode_stream(gcode);
+    std::shared_ptr<const GcodeJob> prologue;
+    try {
+        prologue = GcodeJob::from_string(checkpoint.resume_gcode(*job));
+    } catch (const std::exception &e) {
+        std::cerr << "Could not resume the print: " << e.what() << "\n";
+        return PrintResult::ERR_INVALID_JOB;
+    }
+    std::shared_ptr<const GcodeAnalysis> analysis = GcodeAnalysis::analyze(*job);
+    const std::lock_guard<std::mutex> guard(m_mutex);
+    return open_job(job, checkpoint.line, prologue, analysis);
+}
 
-    auto trim = [](std::string &s) {
-        s.erase(0, s.find_first_not_of(" \n\r\t\f\v"));
-        s.erase(s.find_last_not_of(" \n\r\t\f\v") + 1);
-    };
 
-    while (!gcode_stream.eof()) {
-        std::string line;
-        std::getline(gcode_stream, line);
-        std::string::size_type pos = line.find(';');
-        if (std::string::npos != pos) {
-            line = line.substr(0, pos);
-        }
-        if (0 == line.size()) {
-            continue;
-        }
-        trim(line);
-        if (0 == line.size()) {
-            continue;
-        }
-        m_curr_print.push_back(line);
+/*
+ * open_job()
+ */
+Device::PrintResult PrusaDevice::open_job(const std::shared_ptr<const GcodeJob> &job,
+                                          size_t first_line,
+                                          const std::shared_ptr<const GcodeJob> &prologue,
+                                          const std::shared_ptr<const GcodeAnalysis> &analysis)
+{
+    if (m_spooler.is_open()) {
+        return PrintResult::ERR_PRINTING;
     }
 
+    m_spooler.open(job, first_line, prologue);
+    m_first_line = first_line;
+    m_prologue_lines = (prologue) ? (prologue->size()) : (0);
+    // without moves, the analysis knows nothing better than the firmware
+    m_analysis = (0.0 < analysis->total_time()) ? (analysis) : (nullptr);
     start_print();
 
     return PrintResult::OK;
@@ -608,20 +892,70 @@ void PrusaDevice::start_print()
         return;
     }
 
-    if (m_curr_print.empty()) {
+    if (!m_spooler.is_open()) {
         return;
     }
 
     set_state(State::PRINTING);
+    m_finished_lines = 0;
+    if (m_checkpoint) {
+        m_checkpoint->begin(m_spooler.job()->content_hash(), m_first_line);
+    }
+    if (m_analysis) {
+        m_progress = m_analysis->percentage(m_first_line);
+        m_remaining_time = m_analysis->remaining_time(m_first_line);
+        update_progress(m_progress, m_remaining_time);
+    }
+    if (m_dev_conf.serial_checksums) {
+        // reset the line number of the firmware, the first command of the job gets number 1
+        m_framing = true;
+        m_next_number = 0;
+        m_stale_oks = 0;
+        m_resend_pending = false;
+        send_command_nl("M110 N0", Action::NONE);
+    }
+    fill_print_window();
+}
 
-    for (int i = 0; i < 2; ++i) {
-        if (m_curr_print.empty()) {
-            update_progress(100, 0);
-            set_state(State::OK);
-            return;
+
+/*
+ * fill_print_window()
+ */
+void PrusaDevice::fill_print_window()
+{
+    if (!m_spooler.is_open()) {
+        return;
+    }
+
+    // The firmware buffers received commands until its planner can take them. Keeping this buffer
+    // filled avoids, that the planner runs empty while waiting for the next command (i.e. short
+    // segments of curves). Without a byte budget, only the number of commands is limited.
+    std::string_view line;
+    while (   m_send_queue.size() < m_dev_conf.print_window_commands
+           && m_spooler.peek(line)) {
+        // a single command is always sent, even if it exceeds the byte budget. Otherwise the print
+        // would be stuck.
+        if (   0 != m_dev_conf.print_window_bytes
+            && !m_send_queue.empty()
+            && m_send_queue.bytes() + line.size() + 1 + framing_overhead() > m_dev_conf.print_window_bytes) {
+            break;
+        }
+        if (!send_job_line_nl(line, m_spooler.line_xor(), m_spooler.is_tokenized())) {
+            break;
+        }
+        m_spooler.skip();
+    }
+
+    if (   !m_spooler.peek(line)
+        && m_send_queue.empty()) {
+        m_spooler.close();
+        m_analysis = nullptr;
+        m_framing = false;
+        if (m_checkpoint) {
+            m_checkpoint->finish();
         }
-        send_command_nl(m_curr_print.front(), nullptr, m_print_helper);
-        m_curr_print.pop_front();
+        update_progress(100, 0);
+        set_state(State::OK);
     }
 }
 
@@ -635,7 +969,19 @@ void PrusaDevice::set_state(enum State state)
         return;
     }
     Device::set_state(state);
-    if (!is_valid() && 0 <= m_fd) {
+    // the checkpoint is written immediately, since the print can't be continued
+    if (!is_valid() && m_checkpoint) {
+        m_checkpoint->flush();
+    }
+}
+
+
+/*
+ * close_device()
+ */
+void PrusaDevice::close_device()
+{
+    if (0 <= m_fd) {
         m_ev.unregister_read_cb(m_fd);
         m_ev.unregister_write_cb(m_fd);
         close(m_fd);
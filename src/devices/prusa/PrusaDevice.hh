@@ -6,8 +6,18 @@
 #include <mutex>
 #include <functional>
 #include <list>
+#include <cstdint>
+#include <string_view>
+#include <chrono>
+#include "../LineBuffer.hh"
+#include "../CommandQueue.hh"
+#include "../CheckpointWriter.hh"
+#include "../SerialPort.hh"
 #include "../../Config.hh"
-#include "../../EventLoop.hh"
+#include "../../RealtimeEventLoop.hh"
+#include "../../job/GcodeSpooler.hh"
+#include "../../job/GcodeAnalysis.hh"
+#include "PrusaParser.hh"
 
 class PrusaDevice : public Device {
     public:
@@ -19,21 +29,19 @@ class PrusaDevice : public Device {
         PrusaDevice(const std::string &file, const std::string &name, const Config &conf);
         virtual ~PrusaDevice();
 
-        void onReadedLine(const std::string &readedLine);
+        void onReadedLine(std::string_view readed_line);
 
         virtual PrintResult print_file(const std::string &file_path) override;
         virtual PrintResult print(const std::string &gcode) override;
+        virtual PrintResult print_job(const std::shared_ptr<const GcodeJob> &job) override;
+        virtual PrintResult print_analyzed_job(const std::shared_ptr<const GcodeJob> &job,
+                                               const std::shared_ptr<const GcodeAnalysis> &analysis) override;
+        virtual PrintResult resume_job(const std::shared_ptr<const GcodeJob> &job, const PrintCheckpoint &checkpoint) override;
         virtual const std::string &name() const override 
         {
             return m_name;
         }
 
-        std::map<std::string, struct SensorValue> sensor_readings() override
-        {
-            const std::lock_guard<std::mutex> guard(m_mutex);
-            return m_sensor_readings;
-        }
-
         virtual void on_shutdown() override;
     protected:
         virtual void set_state(enum State new_state) override;
@@ -48,35 +56,143 @@ class PrusaDevice : public Device {
             UNINITIALIZED = 0,
             DEVICE_NOT_READY,
             DEVICE_ACCEPTS_COMMANDS,
+            DEVICE_TESTING_LATENCY,
             DEVICE_READY
         };
 
         void change_pstate(enum prusa_state pstate);
         
+        /**
+         * Tells the device, what to do with the output and the acknowledgement of a command.
+         */
+        enum class Action : uint8_t {
+            NONE = 0,
+            // a line of the current print job, the next lines are sent after the acknowledgement
+            JOB_LINE,
+            // M115: collects the capabilities of the firmware
+            READ_CAPABILITIES,
+            // M155: enables the auto reporting, the device is ready after the acknowledgement
+            ENABLE_AUTOREPORT,
+            // M105: measures the round trip time (see Config::DeviceConfig::serial_latency_test)
+            LATENCY_TEST
+        };
+
         /**
          * Sends a G-code command to the 3D printer. This is an asynchronous interface: All commands are buffered on the
          * host and send as soon as the used file descriptor is ready for writing. This could overload the printer.
          * Therefore, an implementation using this interface have to wait for the printer acknowledgement before sending the
          * next command.
          *
-         * The function "finished" is called, when the 3d printer acknowledged the command and the function "parse_line" is
-         * called for each received output line of the printer between sending the command and receiving the acknowledgment.
+         * The command is copied into the send queue. on_command_finished() is called with the given action, when the 3d
+         * printer acknowledged the command and on_command_output() is called for each received output line of the
+         * printer between sending the command and receiving the acknowledgment.
+         *
+         * Be aware, that depending on the firmware implementation, not all lines provided to on_command_output() are related
+         * to the send command. If the printer supports an auto report feature, on_command_output() also get these auto
+         * reported lines, if they happen to occur between the sending and the acknowledgement of the command.
          *
-         * Be aware, that depending on the firmware implementation, not all lines provided to parse_line are related to
-         * the send command. If the printer supports an auto report feature, "parse_line" also get these auto reported lines,
-         * if they happen to occur between the sending and the acknowledgement of the command.
+         * Returns false, if the send queue is full. m_mutex has to be locked.
+         */
+        bool send_command_nl(std::string_view command, Action action);
+
+        /**
+         * Same as send_command_nl(), but for a line of the print job in m_spooler. The line is not copied.
+         * The job has to stay open, until the line is acknowledged or the send queue is cleared.
+         * line_xor is the XOR of all bytes of the line (see GcodeJob::line_xor()). An expanded
+         * line of a binary job is only valid until the next line is expanded, so it is copied
+         * into the send queue (see GcodeJob::is_tokenized()).
+         */
+        bool send_job_line_nl(std::string_view line, uint8_t line_xor, bool expanded);
+
+        /**
+         * Prefixes the last pushed command with the next line number and appends the checksum,
+         * if line numbers are enabled (m_framing). line_xor is the XOR of all bytes of the command.
+         */
+        void frame_last_command(uint8_t line_xor);
+
+        /**
+         * Returns an upper bound for the bytes, which frame_last_command() adds to the next command.
+         */
+        size_t framing_overhead() const;
+
+        /**
+         * Handles a resend request of the firmware: The requested command and all following
+         * commands are sent again.
+         */
+        void on_resend(uint32_t line_number);
+
+        /**
+         * Registers the write callback, which sends all unwritten commands in m_send_queue.
+         * This is done once after opening the device, afterwards the callback is woken up by flush_queue().
+         */
+        void register_write_cb();
+
+        /**
+         * Wakes up the write callback, if the last pushed command is the only unwritten one.
+         */
+        void flush_queue(bool had_unwritten);
+
+        /**
+         * Unregisters the callbacks and closes the connection to the printer. It must not be
+         * called while the read callback still reads from the fd, since the fd can be reused.
          */
-        void send_command_nl(const std::string &command,
-                             std::function<void(const std::string &line)> parse_line,
-                             std::function<void(const std::string &line)> finished);
+        void close_device();
 
-        void parse_temp(const std::string &line);
-        void parse_pos(const std::string &line);
-        void parse_fan(const std::string &line);
-        void parse_progress(const std::string &line);
+        /**
+         * Sends the next command of the round trip measurement. m_mutex has to be locked.
+         */
+        void send_latency_test_command();
+
+        /**
+         * Prints the result of the round trip measurement together with the serial settings.
+         */
+        void report_latency() const;
+
+        void on_command_output(Action action, std::string_view line);
+        void on_command_finished(Action action);
+
+        void update_temp(const PrusaParser::Result &result);
+        void update_pos(const PrusaParser::Result &result);
+        void update_fan(const PrusaParser::Result &result);
+        void parse_progress(std::string_view line);
+
+        /**
+         * Parses a report of the printer (temperatures, position, fans or progress).
+         */
+        void parse_report(std::string_view line);
+
+        /**
+         * Reports the progress of the print job from m_analysis, if it changed since the last
+         * report. m_mutex has to be locked.
+         */
+        void report_progress();
+
+        /**
+         * Opens the job and starts the print, beginning with the prologue and the given line of
+         * the job. The analysis is the one of the job. m_mutex has to be locked.
+         */
+        PrintResult open_job(const std::shared_ptr<const GcodeJob> &job,
+                             size_t first_line,
+                             const std::shared_ptr<const GcodeJob> &prologue,
+                             const std::shared_ptr<const GcodeAnalysis> &analysis);
 
         void start_print();
 
+        /**
+         * Returns the number of lines of the job, which are acknowledged, including the lines
+         * before the first line of a resumed print. m_mutex has to be locked.
+         */
+        size_t finished_job_lines() const
+        {
+            return m_first_line + ((m_finished_lines > m_prologue_lines) ? (m_finished_lines - m_prologue_lines) : (0));
+        }
+
+        /**
+         * Sends lines of the print job until the print window (see Config::DeviceConfig) is full.
+         * Finishes the print, if all lines are sent and acknowledged. m_mutex has to be locked.
+         */
+        void fill_print_window();
+
     public:
         struct read_helper {
             std::function<void(enum State)> set_state;
@@ -85,25 +201,17 @@ class PrusaDevice : public Device {
 
     private:
 
-        struct send_buf {
-            std::string line;
-            size_t sended;
-            std::function<void(const std::string &line)> parse_line;
-            std::function<void(const std::string &line)> finished;
+        typedef CommandQueue<Action> SendQueue;
 
-            send_buf()
-                : sended(0)
-            {};
-        };
+        // maximum number of commands, which are written with a single writev()
+        static constexpr size_t MAX_WRITE_BATCH = 32;
 
         struct send_buf_helper {
             std::mutex &mutex;
-            std::list<struct send_buf> &send_lines;
-            std::list<struct send_buf> &sended_lines;
-            send_buf_helper(std::mutex &m, std::list<struct send_buf> &sl, std::list<struct send_buf> &sdl)
+            SendQueue &queue;
+            send_buf_helper(std::mutex &m, SendQueue &q)
                 : mutex(m),
-                  send_lines(sl),
-                  sended_lines(sdl)
+                  queue(q)
             {};
         };
 
@@ -113,18 +221,49 @@ class PrusaDevice : public Device {
         std::string m_name;
         int m_fd;
         enum prusa_state m_pstate;
-        EventLoop &m_ev;
+        RealtimeEventLoop &m_ev;
 
         std::mutex m_mutex;
+        SendQueue m_send_queue;
         struct send_buf_helper m_send_buf_helper;
-        std::list<struct send_buf> m_send_lines;
-        std::list<struct send_buf> m_sended_lines;
         std::list<std::string> m_capabilities;
-        std::map<std::string, struct SensorValue> m_sensor_readings;
-        std::list<std::string> m_curr_print;
-        std::function<void(const std::string &line)> m_print_helper;
+        // ids of temp_extruder, temp_bed, temp_ambient and pos_X, pos_Y, pos_Z, pos_E in m_sensor_table
+        size_t m_temp_sensors[3];
+        size_t m_pos_sensors[4];
+        GcodeSpooler m_spooler;
+        // drives the progress of the print job, the firmware progress reports are ignored then
+        std::shared_ptr<const GcodeAnalysis> m_analysis;
+        // number of acknowledged lines of the print job, including the prologue
+        size_t m_finished_lines;
+        // the print started with this line of the job after the prologue (see GcodeSpooler::open())
+        size_t m_first_line;
+        size_t m_prologue_lines;
+        // nullptr, if the checkpoints are disabled
+        std::unique_ptr<CheckpointWriter> m_checkpoint;
+        unsigned m_progress;
+        unsigned m_remaining_time;
         struct read_helper m_read_helper;
+        LineBuffer m_read_buffer;
         const Config &m_conf;
+        const Config::DeviceConfig &m_dev_conf;
+
+        struct latency_test {
+            uint32_t remaining;
+            std::chrono::steady_clock::time_point sent;
+            std::chrono::steady_clock::duration min;
+            std::chrono::steady_clock::duration max;
+            std::chrono::steady_clock::duration sum;
+        };
+        struct latency_test m_latency_test;
+
+        // the commands are sent with line numbers and checksums
+        bool m_framing;
+        uint32_t m_next_number;
+        // number of expected acknowledgements for rejected commands
+        size_t m_stale_oks;
+        // a resend of m_resend_number is in progress
+        bool m_resend_pending;
+        uint32_t m_resend_number;
 };
 
 #endif
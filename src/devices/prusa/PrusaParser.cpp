@@ -0,0 +1,341 @@
+#include "PrusaParser.hh"
+#include <charconv>
+#include <cstdint>
+
+namespace {
+
+/*
+ * consume()
+ */
+bool consume(std::string_view &s, std::string_view prefix)
+{
+    if (0 != s.compare(0, prefix.size(), prefix)) {
+        return false;
+    }
+    s.remove_prefix(prefix.size());
+    return true;
+}
+
+
+/*
+ * is_space()
+ */
+bool is_space(char c)
+{
+    return ' ' == c || '\t' == c || '\n' == c || '\r' == c || '\f' == c || '\v' == c;
+}
+
+
+/*
+ * is_digit()
+ */
+bool is_digit(char c)
+{
+    return '0' <= c && '9' >= c;
+}
+
+
+/*
+ * skip_space()
+ */
+void skip_space(std::string_view &s)
+{
+    while (!s.empty() && is_space(s[0])) {
+        s.remove_prefix(1);
+    }
+}
+
+
+/*
+ * parse_unsigned()
+ */
+template<typename T>
+bool parse_unsigned(std::string_view &s, T &value, size_t &digits)
+{
+    const std::from_chars_result res = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (std::errc() != res.ec) {
+        return false;
+    }
+    digits = res.ptr - s.data();
+    s.remove_prefix(digits);
+    return true;
+}
+
+
+/*
+ * parse_number()
+ *
+ * Parses a decimal number like "21.6". The integer and the fraction digits are parsed as one
+ * integer, which is divided by the matching power of ten. Since both operands are exact, the
+ * result is the same as the one of std::stod(). This avoids the locale handling of std::stod()
+ * and does not need the floating point overloads of std::from_chars().
+ */
+bool parse_number(std::string_view &s, double &value, bool allow_sign, bool require_fraction)
+{
+    static const uint64_t pow10[] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull
+    };
+    constexpr size_t max_digits = sizeof(pow10)/sizeof(pow10[0]) - 1;
+
+    bool negative = false;
+    if (allow_sign && !s.empty() && '-' == s[0]) {
+        negative = true;
+        s.remove_prefix(1);
+    }
+
+    uint64_t number;
+    size_t int_digits;
+    if (!parse_unsigned(s, number, int_digits)) {
+        return false;
+    }
+
+    size_t frac_digits = 0;
+    if (2 <= s.size() && '.' == s[0] && is_digit(s[1])) {
+        s.remove_prefix(1);
+        uint64_t fraction;
+        if (!parse_unsigned(s, fraction, frac_digits)) {
+            return false;
+        }
+        if (max_digits < int_digits + frac_digits) {
+            return false;
+        }
+        number = number * pow10[frac_digits] + fraction;
+    } else if (require_fraction) {
+        return false;
+    } else if (max_digits < int_digits) {
+        return false;
+    }
+
+    value = double(number) / double(pow10[frac_digits]);
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
+
+/*
+ * add_reading()
+ */
+PrusaParser::Reading *add_reading(PrusaParser::Result &result, std::string_view name)
+{
+    if (PrusaParser::MAX_READINGS <= result.count) {
+        return nullptr;
+    }
+    PrusaParser::Reading &reading = result.readings[result.count++];
+    reading.name = name;
+    reading.set_point.reset();
+    return &reading;
+}
+
+}
+
+
+/*
+ * parse()
+ */
+void PrusaParser::parse(std::string_view line, Result &result)
+{
+    result.type = LineType::OTHER;
+    result.count = 0;
+    if (line.empty()) {
+        return;
+    }
+
+    bool valid = false;
+    LineType type = LineType::OTHER;
+    switch (line[0]) {
+        case 'X':
+            type = LineType::POSITION;
+            valid = parse_position(line, result);
+            break;
+        case 'E':
+            type = LineType::FAN;
+            valid = parse_fan(line, result);
+            break;
+        case 'P':
+            if (0 == line.compare(0, 3, "PRN")) {
+                type = LineType::FAN;
+                valid = parse_fan(line, result);
+                break;
+            }
+            // "P:" is the temperature of the PINDA probe
+            [[fallthrough]];
+        case 'T':
+        case 'B':
+        case '@':
+        case 'A':
+            type = LineType::TEMPERATURE;
+            valid = parse_temperature(line, result);
+            break;
+        default:
+            break;
+    }
+
+    if (valid && result.count) {
+        result.type = type;
+    } else {
+        result.count = 0;
+    }
+}
+
+
+/*
+ * parse_temperature()
+ */
+bool PrusaParser::parse_temperature(std::string_view s, Result &result)
+{
+    // grammar: (name ':' number (' /' number)? space*)+
+    // with name: T[0-9]* | B[0-9]* | B@ | @ | P | A
+    while (!s.empty()) {
+        size_t name_len = 1;
+        if ('T' == s[0] || 'B' == s[0]) {
+            if ('B' == s[0] && 2 <= s.size() && '@' == s[1]) {
+                name_len = 2;
+            } else {
+                while (name_len < s.size() && is_digit(s[name_len])) {
+                    name_len++;
+                }
+            }
+        } else if ('@' != s[0] && 'P' != s[0] && 'A' != s[0]) {
+            return false;
+        }
+        Reading *reading = add_reading(result, s.substr(0, name_len));
+        s.remove_prefix(name_len);
+        if (!reading || !consume(s, ":")) {
+            return false;
+        }
+        if (!parse_number(s, reading->current_value, false, false)) {
+            return false;
+        }
+        if (consume(s, " /")) {
+            double set_point;
+            if (!parse_number(s, set_point, false, false)) {
+                return false;
+            }
+            reading->set_point = set_point;
+        }
+        skip_space(s);
+    }
+    return true;
+}
+
+
+/*
+ * parse_position()
+ */
+bool PrusaParser::parse_position(std::string_view s, Result &result)
+{
+    // grammar: (([XYZE] ':' space? number) | "Count") space?)+
+    bool count_reached = false;
+    while (!s.empty()) {
+        if (consume(s, "Count")) {
+            count_reached = true;
+        } else {
+            if ('X' != s[0] && 'Y' != s[0] && 'Z' != s[0] && 'E' != s[0]) {
+                return false;
+            }
+            const std::string_view name = s.substr(0, 1);
+            s.remove_prefix(1);
+            if (!consume(s, ":")) {
+                return false;
+            }
+            if (!s.empty() && is_space(s[0])) {
+                s.remove_prefix(1);
+            }
+            double value;
+            if (!parse_number(s, value, true, true)) {
+                return false;
+            }
+            // after "Count" there are only debug values
+            if (!count_reached) {
+                Reading *reading = add_reading(result, name);
+                if (!reading) {
+                    return false;
+                }
+                reading->current_value = value;
+            }
+        }
+        if (!s.empty() && is_space(s[0])) {
+            s.remove_prefix(1);
+        }
+    }
+    return true;
+}
+
+
+/*
+ * parse_fan()
+ */
+bool PrusaParser::parse_fan(std::string_view s, Result &result)
+{
+    // grammar: (("E" | "PRN") [0-9] '@'? ':' number " RPM"? space?)+
+    while (!s.empty()) {
+        size_t name_len;
+        if ('E' == s[0]) {
+            name_len = 1;
+        } else if (0 == s.compare(0, 3, "PRN")) {
+            name_len = 3;
+        } else {
+            return false;
+        }
+        if (name_len >= s.size() || !is_digit(s[name_len])) {
+            return false;
+        }
+        name_len++;
+        if (name_len < s.size() && '@' == s[name_len]) {
+            name_len++;
+        }
+        Reading *reading = add_reading(result, s.substr(0, name_len));
+        s.remove_prefix(name_len);
+        if (!reading || !consume(s, ":")) {
+            return false;
+        }
+        if (!parse_number(s, reading->current_value, false, false)) {
+            return false;
+        }
+        consume(s, " RPM");
+        if (!s.empty() && is_space(s[0])) {
+            s.remove_prefix(1);
+        }
+    }
+    return true;
+}
+
+
+/*
+ * parse_progress()
+ */
+bool PrusaParser::parse_progress(std::string_view s, unsigned &percentage, unsigned &remaining)
+{
+    // TODO: distinguise between normal mode and silent mode ...
+    size_t digits;
+    return    consume(s, "NORMAL MODE: Percent done: ")
+           && parse_unsigned(s, percentage, digits)
+           && consume(s, "; print time remaining in mins: ")
+           && parse_unsigned(s, remaining, digits)
+           && consume(s, ";");
+}
+
+
+/*
+ * parse_resend()
+ */
+bool PrusaParser::parse_resend(std::string_view s, uint32_t &line_number)
+{
+    if (consume(s, "Resend:")) {
+        skip_space(s);
+    } else if (consume(s, "rs ")) {
+        consume(s, "N");
+    } else {
+        return false;
+    }
+    size_t digits;
+    if (!parse_unsigned(s, line_number, digits)) {
+        return false;
+    }
+    skip_space(s);
+    return s.empty();
+}
@@ -0,0 +1,73 @@
+#ifndef __PRUSA_PARSER_HH__
+#define __PRUSA_PARSER_HH__
+
+#include <string_view>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Parser for the lines reported by the Prusa firmware.
+ *
+ * The parser classifies a line and extracts all values in a single pass over the line. It does
+ * not allocate memory: the names of the readings are views into the parsed line. Therefore, the
+ * results are only valid as long as the line exists.
+ */
+class PrusaParser {
+    public:
+        enum class LineType {
+            // the line is not a sensor reading
+            OTHER,
+            // example: "T:21.6 /0.0 B:21.8 /0.0 T0:21.6 /0.0 @:0 B@:0 P:0.0 A:23.0"
+            TEMPERATURE,
+            // example: "X:0.00 Y:0.00 Z:0.15 E:0.00 Count X: 0.00 Y:0.00 Z:0.15 E:0.00"
+            POSITION,
+            // example: "E0:0 RPM PRN1:0 RPM E0@:0 PRN1@:0"
+            FAN
+        };
+
+        struct Reading {
+            // name of the reading as reported by the firmware (i.e. "T", "B@", "X" or "PRN1")
+            std::string_view name;
+            double current_value;
+            std::optional<double> set_point;
+        };
+
+        static constexpr size_t MAX_READINGS = 16;
+
+        struct Result {
+            LineType type;
+            size_t count;
+            Reading readings[MAX_READINGS];
+        };
+
+        /**
+         * Classifies the line and stores all readings of the line in result.
+         * If the line is not a valid sensor reading, than the type is set to LineType::OTHER and
+         * no readings are stored.
+         *
+         * For position readings, only the values before "Count" are stored. The values after it
+         * are debug values of the firmware.
+         */
+        static void parse(std::string_view line, Result &result);
+
+        /**
+         * Parses a progress report like
+         * "NORMAL MODE: Percent done: 0; print time remaining in mins: 24; Change in mins: -1".
+         * Returns false, if the line is not a progress report of the normal mode.
+         */
+        static bool parse_progress(std::string_view line, unsigned &percentage, unsigned &remaining);
+
+        /**
+         * Parses a resend request like "Resend: 123" (Marlin/Prusa) or "rs N123" (Repetier).
+         * Returns false, if the line is not a resend request.
+         */
+        static bool parse_resend(std::string_view line, uint32_t &line_number);
+
+    private:
+        static bool parse_temperature(std::string_view line, Result &result);
+        static bool parse_position(std::string_view line, Result &result);
+        static bool parse_fan(std::string_view line, Result &result);
+};
+
+#endif
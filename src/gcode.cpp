@@ -1,11 +1,30 @@
 #include <iostream>
-#include <fstream>
 #include <chrono>
 #include <thread>
 #include <iomanip>
 #include <atomic>
+#include <fstream>
 #include "ConfigGcode.hh"
 #include "client/Client.hh"
+#include "job/GcodeJob.hh"
+#include "job/ArcFitter.hh"
+
+/*
+ * fit_arcs()
+ */
+std::shared_ptr<const GcodeJob> fit_arcs(const std::shared_ptr<const GcodeJob> &job, const ConfigGcode &conf)
+{
+    if (!conf.arc_tolerance()) {
+        return job;
+    }
+    ArcFitter::Statistics statistics;
+    std::shared_ptr<const GcodeJob> fitted = ArcFitter::fit(*job, *conf.arc_tolerance(), statistics);
+    std::cout << "Arc fitting: " << statistics.input_lines << " -> " << statistics.output_lines
+              << " commands (" << statistics.fitted_moves << " moves replaced by "
+              << statistics.arcs << " arcs)\n";
+    return fitted;
+}
+
 
 /*
  * send()
@@ -55,41 +74,82 @@ int send(Client &client, const ConfigGcode &conf)
         }
     }
 
-    std::ifstream gcode_file;
-    gcode_file.open(filename);
-    if (!gcode_file.is_open()) {
-        std::cerr << "Failed to open file: " << filename << "\n";
+    std::shared_ptr<const GcodeJob> job;
+    try {
+        job = fit_arcs(GcodeJob::from_file(filename), conf);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
         return 1;
     }
 
-    auto trim = [](std::string &s) {
-        s.erase(0, s.find_first_not_of(" \n\r\t\f\v"));
-        s.erase(s.find_last_not_of(" \n\r\t\f\v") + 1);
-    };
-
-    std::string gcode;
-    // strip out all comments and blank lines.
-    while (!gcode_file.eof()) {
-        std::string line;
-        std::getline(gcode_file, line);
-        std::string::size_type pos = line.find(';');
-        if (std::string::npos != pos) {
-            line = line.substr(0, pos);
+    std::atomic_int count = devices->size();
+    // the job is sent only once to each provider, which prints it on all of its devices
+    client.print_job(*devices, job, [&count, &conf](const Client::DeviceInfo &dev, Device::PrintResult res) {
+        std::cout << "print ";
+        if (conf.resolve_aliases() && dev.provider_alias.size()) {
+            std::cout << dev.provider_alias;
+        } else {
+            std::cout << dev.provider;
         }
-        if (0 == line.size()) {
-            continue;
+        std::cout << "/";
+        if (conf.resolve_aliases() && dev.device_alias.size()) {
+            std::cout << dev.device_alias;
+        } else {
+            std::cout << dev.name;
         }
-        trim(line);
-        if (0 == line.size()) {
-            continue;
+        std::cout << " " << Device::printres_to_str(res) << "\n";
+        count -= 1;
+    });
+
+    while (count != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    return 0;
+}
+
+
+/*
+ * resume()
+ */
+int resume(Client &client, const ConfigGcode &conf)
+{
+    if (!conf.command() || "resume" != *conf.command()) {
+        std::cerr << "Invalid command!\n";
+        return 1;
+    }
+
+    const size_t c_args_size = conf.command_args().size();
+    if (1 < c_args_size) {
+        std::cerr << "Too many arguments for resume command. See 'gcode resume --help'.\n";
+        return 1;
+    }
+
+    std::string hint = "*";
+    if (1 <= c_args_size) {
+        hint = conf.command_args()[0];
+    }
+    std::unique_ptr<std::vector<Client::DeviceInfo>> devices = client.devices(hint);
+
+    if (0 == devices->size()) {
+        std::cerr << "No devices found.\n";
+    }
+
+    if ( 1 < devices->size()) {
+        std::cout << "Found " << devices->size() << " devices. If you want to resume the prints of all of these devicese, than enter the number of devices.\n";
+        std::cout << "No. of devices: ";
+        std::string user_input;
+        std::getline(std::cin, user_input);
+        size_t dev_count = std::strtoul(user_input.c_str(), nullptr, 0);
+        if (devices->size() != dev_count) {
+            return 1;
         }
-        gcode += line + "\n";
     }
 
     std::atomic_int count = devices->size();
-    for (const auto &dev: *devices) {
-        client.print(dev, gcode, [&count, &conf](const Client::DeviceInfo &dev, Device::PrintResult res) {
-            std::cout << "print ";
+    for (const auto &device: *devices) {
+        client.resume(device, [&count, &conf](const Client::DeviceInfo &dev, Device::PrintResult res) {
+            std::cout << "resume ";
             if (conf.resolve_aliases() && dev.provider_alias.size()) {
                 std::cout << dev.provider_alias;
             } else {
@@ -114,6 +174,247 @@ int send(Client &client, const ConfigGcode &conf)
 }
 
 
+/*
+ * device_name()
+ */
+std::string device_name(const Client::DeviceInfo &dev, const ConfigGcode &conf)
+{
+    std::string name = (conf.resolve_aliases() && dev.provider_alias.size()) ? (dev.provider_alias) : (dev.provider);
+    name += "/";
+    name += (conf.resolve_aliases() && dev.device_alias.size()) ? (dev.device_alias) : (dev.name);
+    return name;
+}
+
+
+/*
+ * parse_number()
+ */
+std::optional<uint64_t> parse_number(const std::string &value)
+{
+    if (value.empty() || std::string::npos != value.find_first_not_of("0123456789")) {
+        return std::nullopt;
+    }
+    return std::strtoull(value.c_str(), nullptr, 10);
+}
+
+
+/*
+ * queue()
+ */
+int queue(Client &client, const ConfigGcode &conf)
+{
+    if (!conf.command() || "queue" != *conf.command()) {
+        std::cerr << "Invalid command!\n";
+        return 1;
+    }
+
+    const std::vector<std::string> &args = conf.command_args();
+    if (args.empty()) {
+        std::cerr << "You have to provide an ACTION. See 'gcode queue --help'.\n";
+        return 1;
+    }
+    const std::string &action = args[0];
+
+    if ("add" == action) {
+        if (2 > args.size() || 3 < args.size()) {
+            std::cerr << "Wrong argument count: See 'gcode queue --help'.\n";
+            return 1;
+        }
+        const std::string &filename = args[1];
+        std::unique_ptr<std::vector<Client::DeviceInfo>> devices = client.devices((3 == args.size()) ? (args[2]) : ("*"));
+        if (0 == devices->size()) {
+            std::cerr << "No devices found.\n";
+            return 1;
+        }
+        if (1 < devices->size()) {
+            std::cout << "Found " << devices->size() << " devices. If you want to queue the gcode for all of these devicese, than enter the number of devices.\n";
+            std::cout << "No. of devices: ";
+            std::string user_input;
+            std::getline(std::cin, user_input);
+            size_t dev_count = std::strtoul(user_input.c_str(), nullptr, 0);
+            if (devices->size() != dev_count) {
+                return 1;
+            }
+        }
+
+        std::shared_ptr<const GcodeJob> job;
+        try {
+            job = fit_arcs(GcodeJob::from_file(filename), conf);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+
+        std::atomic_int count = devices->size();
+        client.print_job(*devices, job, [&count, &conf](const Client::DeviceInfo &dev, Device::PrintResult res) {
+            std::cout << "queue " << device_name(dev, conf) << " " << Device::printres_to_str(res) << "\n";
+            count -= 1;
+        }, true);
+
+        while (count != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    } else if ("list" == action) {
+        if (2 < args.size()) {
+            std::cerr << "Wrong argument count: See 'gcode queue --help'.\n";
+            return 1;
+        }
+        std::unique_ptr<std::vector<Client::DeviceInfo>> devices = client.devices((2 == args.size()) ? (args[1]) : ("*"));
+        for (const auto &dev: *devices) {
+            std::cout << device_name(dev, conf) << ":";
+            const std::vector<MsgJobQueue::Job> jobs = client.job_queue(dev);
+            if (jobs.empty()) {
+                std::cout << " <empty>";
+            }
+            std::cout << "\n";
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                std::cout << "  " << i << ": job " << jobs[i].id << " (" << Sha256::to_hex(jobs[i].job_hash).substr(0, 16) << ")\n";
+            }
+        }
+    } else if ("move" == action || "cancel" == action) {
+        const size_t expected = ("move" == action) ? (4) : (3);
+        if (expected != args.size()) {
+            std::cerr << "Wrong argument count: See 'gcode queue --help'.\n";
+            return 1;
+        }
+        std::unique_ptr<std::vector<Client::DeviceInfo>> devices = client.devices(args[1]);
+        if (1 != devices->size()) {
+            std::cerr << "The DEVICE_HINT '" << args[1] << "' has to match exactly one device, but it matches " << devices->size() << ".\n";
+            return 1;
+        }
+        const std::optional<uint64_t> job_id = parse_number(args[2]);
+        if (!job_id) {
+            std::cerr << "Invalid JOB_ID: '" << args[2] << "'\n";
+            return 1;
+        }
+        if ("move" == action) {
+            const std::optional<uint64_t> position = parse_number(args[3]);
+            if (!position || UINT32_MAX < *position) {
+                std::cerr << "Invalid POSITION: '" << args[3] << "'\n";
+                return 1;
+            }
+            client.move_job(devices->front(), *job_id, *position);
+        } else {
+            client.cancel_job(devices->front(), *job_id);
+        }
+    } else {
+        std::cerr << "Unknown ACTION: '" << action << "'. See 'gcode queue --help'.\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * dispatch()
+ */
+int dispatch(Client &client, const ConfigGcode &conf)
+{
+    if (!conf.command() || "dispatch" != *conf.command()) {
+        std::cerr << "Invalid command!\n";
+        return 1;
+    }
+
+    const std::vector<std::string> &args = conf.command_args();
+    if (2 > args.size()) {
+        std::cerr << "You have to provide a DEVICE_HINT and at least one gcode file. See 'gcode dispatch --help'.\n";
+        return 1;
+    }
+
+    std::vector<std::shared_ptr<const GcodeJob>> jobs;
+    try {
+        for (size_t i = 1; i < args.size(); ++i) {
+            jobs.push_back(fit_arcs(GcodeJob::from_file(args[i]), conf));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    if (client.devices(args[0])->empty()) {
+        std::cout << "No devices found yet. Waiting for devices.\n";
+    }
+
+    int ret = 0;
+    client.dispatch(jobs, args[0], [&args, &conf, &ret](size_t job, const Client::DeviceInfo &dev, Device::PrintResult res) {
+        std::cout << "dispatch " << args[job + 1] << " -> " << device_name(dev, conf) << " " << Device::printres_to_str(res) << "\n";
+        if (Device::PrintResult::OK != res) {
+            ret = 1;
+        }
+    });
+
+    return ret;
+}
+
+
+/*
+ * convert()
+ */
+int convert(const ConfigGcode &conf)
+{
+    if (2 != conf.command_args().size()) {
+        std::cerr << "The convert command expects an input and an output file. See 'gcode convert --help'.\n";
+        return 1;
+    }
+    const std::string &input = conf.command_args()[0];
+    const std::string &output = conf.command_args()[1];
+
+    std::shared_ptr<const GcodeJob> job;
+    try {
+        job = fit_arcs(GcodeJob::from_file(input), conf);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Could not open output file: " << output << "\n";
+        return 1;
+    }
+
+    std::string buffer;
+    if (!job->is_binary()) {
+        BinaryGcode::append_header(buffer);
+    }
+    BinaryGcode::LineBuffer line_buffer;
+    BinaryGcode::Command command;
+    size_t tokenized = 0;
+    for (size_t i = 0; i < job->size(); ++i) {
+        const std::string_view line = job->line(i, line_buffer);
+        if (job->is_binary()) {
+            buffer += line;
+            buffer += '\n';
+        } else {
+            if (BinaryGcode::parse(line, command)) {
+                tokenized++;
+            }
+            BinaryGcode::append_record(line, buffer);
+        }
+        // the output is written in blocks, so large jobs are not held in memory
+        if (buffer.size() >= 64 * 1024) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+    out.close();
+    if (!out) {
+        std::cerr << "Could not write output file: " << output << "\n";
+        return 1;
+    }
+
+    const uint64_t output_size = std::filesystem::file_size(output);
+    std::cout << "Converted " << job->size() << " commands";
+    if (!job->is_binary()) {
+        std::cout << " (" << tokenized << " tokenized)";
+    }
+    std::cout << " from " << job->data_size() << " to " << output_size << " bytes.\n";
+    return 0;
+}
+
+
 /*
  * alias()
  */
@@ -261,6 +562,11 @@ int main(int argc, char **argv)
         return 0;
     }
 
+    // the conversion works offline
+    if ("convert" == *conf.command()) {
+        return convert(conf);
+    }
+
     Client client(conf);
 
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -301,6 +607,12 @@ int main(int argc, char **argv)
         }
     } else if ("send" == *conf.command()) {
         return send(client, conf);
+    } else if ("resume" == *conf.command()) {
+        return resume(client, conf);
+    } else if ("queue" == *conf.command()) {
+        return queue(client, conf);
+    } else if ("dispatch" == *conf.command()) {
+        return dispatch(client, conf);
     } else if ("alias" == *conf.command()) {
         return alias(client, conf);
     } else if ("sr" == *conf.command()) {
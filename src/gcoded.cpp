@@ -7,6 +7,9 @@
 #include "Aliases.hh"
 #include <unistd.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <cstring>
+#include <cerrno>
 
 bool running = true;
 
@@ -35,6 +38,12 @@ int main(int argc, char **argv)
         Aliases aliases(conf);
         Interface interface(conf, aliases);
 
+        // only the pages mapped so far (code, libraries, heap) are locked. MCL_FUTURE would also
+        // lock the mapped print jobs. The stacks of the realtime threads are locked by themselves.
+        if (conf.lock_memory() && mlockall(MCL_CURRENT)) {
+            std::cerr << "WARNING: Could not lock the memory of gcoded: " << std::strerror(errno) << "\n";
+        }
+
         while(running) {
             sleep(1);
         }
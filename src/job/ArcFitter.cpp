@@ -0,0 +1,483 @@
+#include "ArcFitter.hh"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+static constexpr int64_t POW10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+// decimals of the generated words
+static constexpr uint8_t ARC_DECIMALS = 3;
+// a single move of an arc must not turn more than a quarter circle
+static constexpr double MAX_MOVE_ANGLE = M_PI / 2;
+
+
+/*
+ * to_word()
+ */
+static BinaryGcode::Word to_word(char letter, double value)
+{
+    BinaryGcode::Word word;
+    word.letter = letter;
+    word.has_value = true;
+    word.decimals = ARC_DECIMALS;
+    word.mantissa = std::llround(value * POW10[ARC_DECIMALS]);
+    return word;
+}
+
+
+/*
+ * to_e_units()
+ */
+static int64_t to_e_units(const BinaryGcode::Word &word)
+{
+    return word.mantissa * POW10[ArcFitter::E_DECIMALS - word.decimals];
+}
+
+
+/*
+ * ArcFitter()
+ */
+ArcFitter::ArcFitter(double tolerance)
+    : m_tolerance(tolerance),
+      m_output(nullptr)
+{
+    if (!(0.0 < tolerance)) {
+        throw std::runtime_error("ArcFitter: The tolerance has to be positive.");
+    }
+    reset();
+}
+
+
+/*
+ * reset()
+ */
+void ArcFitter::reset()
+{
+    m_statistics = Statistics();
+    m_relative = false;
+    m_relative_e = false;
+    m_x.reset();
+    m_y.reset();
+    m_e.reset();
+    m_run.clear();
+    m_arc.reset();
+}
+
+
+/*
+ * fit()
+ */
+ArcFitter::Statistics ArcFitter::fit(const GcodeJob &job, const std::function<void(std::string_view)> &output)
+{
+    reset();
+    m_output = &output;
+    m_statistics.input_lines = job.size();
+
+    BinaryGcode::LineBuffer buffer;
+    BinaryGcode::Command command;
+    Move move;
+    for (size_t i = 0; i < job.size(); ++i) {
+        const std::string_view line = job.line(i, buffer);
+        const bool parsed = job.command(i, command);
+        if (parsed && to_move(command, line, move)) {
+            add_move(std::move(move));
+            continue;
+        }
+        flush();
+        track((parsed) ? (&command) : (nullptr), line);
+        emit(line);
+    }
+    flush();
+
+    m_output = nullptr;
+    return m_statistics;
+}
+
+
+/*
+ * fit()
+ */
+std::shared_ptr<const GcodeJob> ArcFitter::fit(const GcodeJob &job, double tolerance, Statistics &statistics)
+{
+    const bool binary = job.is_binary();
+    std::string gcode;
+    if (binary) {
+        BinaryGcode::append_header(gcode);
+    }
+    ArcFitter fitter(tolerance);
+    statistics = fitter.fit(job, [&gcode, binary](std::string_view line) {
+        if (binary) {
+            BinaryGcode::append_record(line, gcode);
+        } else {
+            gcode.append(line);
+            gcode += '\n';
+        }
+    });
+    return GcodeJob::from_string(gcode);
+}
+
+
+/*
+ * to_move()
+ */
+bool ArcFitter::to_move(const BinaryGcode::Command &command, std::string_view line, Move &move) const
+{
+    if (!command.is('G', 1) || m_relative || !m_x || !m_y) {
+        return false;
+    }
+    move.x_word.reset();
+    move.y_word.reset();
+    move.e_word.reset();
+    move.f_word.reset();
+    for (size_t i = 1; i < command.word_count; ++i) {
+        const BinaryGcode::Word &word = command.words[i];
+        if (!word.has_value) {
+            return false;
+        }
+        switch (word.letter) {
+            case 'X':
+                move.x_word = word;
+                break;
+            case 'Y':
+                move.y_word = word;
+                break;
+            case 'E':
+                move.e_word = word;
+                break;
+            case 'F':
+                move.f_word = word;
+                break;
+            default:
+                // i.e. Z, so the move is not in the plane
+                return false;
+        }
+    }
+    if (!move.x_word && !move.y_word) {
+        return false;
+    }
+
+    move.extrusion = 0;
+    if (move.e_word) {
+        if (m_relative_e) {
+            move.extrusion = to_e_units(*move.e_word);
+        } else if (m_e) {
+            move.extrusion = to_e_units(*move.e_word) - *m_e;
+        } else {
+            return false;
+        }
+        // retractions are kept as they are
+        if (0 > move.extrusion) {
+            return false;
+        }
+    }
+
+    move.x = (move.x_word) ? (move.x_word->value()) : (*m_x);
+    move.y = (move.y_word) ? (move.y_word->value()) : (*m_y);
+    move.length = std::hypot(move.x - *m_x, move.y - *m_y);
+    if (0.0 == move.length) {
+        return false;
+    }
+    move.line = line;
+    return true;
+}
+
+
+/*
+ * add_move()
+ */
+void ArcFitter::add_move(Move &&move)
+{
+    // the feed rate may only be set by the first move and a run either extrudes or travels
+    if (    !m_run.empty()
+         && (    move.f_word
+              || (0 < move.extrusion) != (0 < m_run.front().extrusion)
+              || MAX_MOVES == m_run.size())) {
+        flush();
+    }
+    if (m_run.empty()) {
+        m_start_x = *m_x;
+        m_start_y = *m_y;
+    }
+    m_x = move.x;
+    m_y = move.y;
+    if (m_e) {
+        *m_e += move.extrusion;
+    }
+    m_run.push_back(std::move(move));
+    if (MIN_MOVES > m_run.size()) {
+        return;
+    }
+
+    Arc arc;
+    if (fit_run(arc)) {
+        m_arc = arc;
+        return;
+    }
+    if (m_arc) {
+        // the run without the last move is an arc, the last move may start the next one
+        Move last = std::move(m_run.back());
+        m_run.pop_back();
+        const double end_x = m_run.back().x;
+        const double end_y = m_run.back().y;
+        flush();
+        m_start_x = end_x;
+        m_start_y = end_y;
+        m_run.push_back(std::move(last));
+        return;
+    }
+    // slide the window: the first move can't be part of an arc with the following moves
+    const Move &first = m_run.front();
+    emit(first.line);
+    m_start_x = first.x;
+    m_start_y = first.y;
+    m_run.erase(m_run.begin());
+}
+
+
+/*
+ * fit_run()
+ */
+bool ArcFitter::fit_run(Arc &arc) const
+{
+    // the circle through the start, the middle and the end of the run
+    const size_t middle = m_run.size() / 2;
+    const double ax = m_start_x;
+    const double ay = m_start_y;
+    const double bx = m_run[middle - 1].x;
+    const double by = m_run[middle - 1].y;
+    const double cx = m_run.back().x;
+    const double cy = m_run.back().y;
+    const double d = 2.0 * (ax * (by - cy) + bx * (cy - ay) + cx * (ay - by));
+    if (0.0 == d) {
+        return false;
+    }
+    const double a2 = ax * ax + ay * ay;
+    const double b2 = bx * bx + by * by;
+    const double c2 = cx * cx + cy * cy;
+    arc.center_x = (a2 * (by - cy) + b2 * (cy - ay) + c2 * (ay - by)) / d;
+    arc.center_y = (a2 * (cx - bx) + b2 * (ax - cx) + c2 * (bx - ax)) / d;
+    const double radius = std::hypot(ax - arc.center_x, ay - arc.center_y);
+    if (!(MAX_RADIUS >= radius)) {
+        return false;
+    }
+
+    double sweep = 0.0;
+    double total_length = 0.0;
+    int64_t total_extrusion = 0;
+    double prev_x = ax - arc.center_x;
+    double prev_y = ay - arc.center_y;
+    for (const Move &move: m_run) {
+        const double x = move.x - arc.center_x;
+        const double y = move.y - arc.center_y;
+        if (m_tolerance < std::fabs(std::hypot(x, y) - radius)) {
+            return false;
+        }
+        // the arc bulges out of the chord by the sagitta
+        const double half_chord = move.length / 2;
+        if (half_chord > radius || m_tolerance < radius - std::sqrt(radius * radius - half_chord * half_chord)) {
+            return false;
+        }
+        const double angle = std::atan2(prev_x * y - prev_y * x, prev_x * x + prev_y * y);
+        if (    MAX_MOVE_ANGLE < std::fabs(angle)
+             || 0.0 == angle
+             || (0.0 != sweep && (0.0 > angle) != (0.0 > sweep))) {
+            return false;
+        }
+        sweep += angle;
+        total_length += move.length;
+        total_extrusion += move.extrusion;
+        prev_x = x;
+        prev_y = y;
+    }
+    if (2 * M_PI <= std::fabs(sweep)) {
+        return false;
+    }
+    arc.clockwise = 0.0 > sweep;
+
+    if (0 < total_extrusion) {
+        const double rate = total_extrusion / total_length;
+        for (const Move &move: m_run) {
+            if (EXTRUSION_TOLERANCE * rate < std::fabs(move.extrusion / move.length - rate)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+/*
+ * flush()
+ */
+void ArcFitter::flush()
+{
+    if (m_arc) {
+        emit_arc();
+    } else {
+        for (const Move &move: m_run) {
+            emit(move.line);
+        }
+    }
+    m_run.clear();
+    m_arc.reset();
+}
+
+
+/*
+ * emit_arc()
+ */
+void ArcFitter::emit_arc()
+{
+    const Arc &arc = *m_arc;
+    const Move &last = m_run.back();
+    m_line.assign((arc.clockwise) ? ("G2") : ("G3"));
+
+    // the end point is taken from the original words, so it is exactly the same
+    std::optional<BinaryGcode::Word> x_word;
+    std::optional<BinaryGcode::Word> y_word;
+    for (auto it = m_run.rbegin(); it != m_run.rend() && (!x_word || !y_word); ++it) {
+        if (!x_word && it->x_word) {
+            x_word = it->x_word;
+        }
+        if (!y_word && it->y_word) {
+            y_word = it->y_word;
+        }
+    }
+    m_line += ' ';
+    ((x_word) ? (*x_word) : (to_word('X', last.x))).append_to(m_line);
+    m_line += ' ';
+    ((y_word) ? (*y_word) : (to_word('Y', last.y))).append_to(m_line);
+    // the center is relative to the start point
+    m_line += ' ';
+    to_word('I', arc.center_x - m_start_x).append_to(m_line);
+    m_line += ' ';
+    to_word('J', arc.center_y - m_start_y).append_to(m_line);
+
+    if (last.e_word) {
+        BinaryGcode::Word e_word = *last.e_word;
+        if (m_relative_e) {
+            // sum up the extrusion with the largest precision of the run
+            int64_t extrusion = 0;
+            e_word.decimals = 0;
+            for (const Move &move: m_run) {
+                // a travel run may mix moves with E0 and moves without E
+                if (!move.e_word) {
+                    continue;
+                }
+                extrusion += move.extrusion;
+                e_word.decimals = std::max(e_word.decimals, move.e_word->decimals);
+            }
+            e_word.mantissa = extrusion / POW10[E_DECIMALS - e_word.decimals];
+        }
+        m_line += ' ';
+        e_word.append_to(m_line);
+    }
+    if (m_run.front().f_word) {
+        m_line += ' ';
+        m_run.front().f_word->append_to(m_line);
+    }
+
+    emit(m_line);
+    m_statistics.arcs++;
+    m_statistics.fitted_moves += m_run.size();
+}
+
+
+/*
+ * emit()
+ */
+void ArcFitter::emit(std::string_view line)
+{
+    m_statistics.output_lines++;
+    (*m_output)(line);
+}
+
+
+/*
+ * track()
+ */
+void ArcFitter::track(const BinaryGcode::Command *command, std::string_view line)
+{
+    if (!command) {
+        // a move, which can't be parsed, or a tool change leaves an unknown position
+        if (!line.empty() && ('G' == line[0] || 'T' == line[0])) {
+            m_x.reset();
+            m_y.reset();
+            m_e.reset();
+        }
+        return;
+    }
+
+    const BinaryGcode::Word &opcode = command->words[0];
+    if ('M' == opcode.letter) {
+        if (command->is('M', 82)) {
+            m_relative_e = false;
+        } else if (command->is('M', 83)) {
+            m_relative_e = true;
+        }
+        return;
+    }
+    if ('T' == opcode.letter) {
+        m_x.reset();
+        m_y.reset();
+        m_e.reset();
+        return;
+    }
+    if ('G' != opcode.letter) {
+        return;
+    }
+
+    if (command->is('G', 0) || command->is('G', 1) || command->is('G', 2) || command->is('G', 3)) {
+        const bool relative_e = m_relative || m_relative_e;
+        for (size_t i = 1; i < command->word_count; ++i) {
+            const BinaryGcode::Word &word = command->words[i];
+            if (!word.has_value) {
+                continue;
+            }
+            std::optional<double> *axis = nullptr;
+            if ('X' == word.letter) {
+                axis = &m_x;
+            } else if ('Y' == word.letter) {
+                axis = &m_y;
+            } else if ('E' == word.letter) {
+                if (!relative_e) {
+                    m_e = to_e_units(word);
+                } else if (m_e) {
+                    *m_e += to_e_units(word);
+                }
+                continue;
+            } else {
+                continue;
+            }
+            if (!m_relative) {
+                *axis = word.value();
+            } else if (*axis) {
+                **axis += word.value();
+            }
+        }
+    } else if (command->is('G', 90)) {
+        m_relative = false;
+        m_relative_e = false;
+    } else if (command->is('G', 91)) {
+        m_relative = true;
+    } else if (command->is('G', 92)) {
+        if (1 == command->word_count) {
+            m_x.reset();
+            m_y.reset();
+            m_e.reset();
+        }
+        for (size_t i = 1; i < command->word_count; ++i) {
+            const BinaryGcode::Word &word = command->words[i];
+            if ('X' == word.letter) {
+                m_x = word.value();
+            } else if ('Y' == word.letter) {
+                m_y = word.value();
+            } else if ('E' == word.letter) {
+                m_e = to_e_units(word);
+            }
+        }
+    } else if (!command->is('G', 4) && !command->is('G', 21)) {
+        // i.e. homing or probing
+        m_x.reset();
+        m_y.reset();
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef __ARC_FITTER_HH__
+#define __ARC_FITTER_HH__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <cstdint>
+#include "GcodeJob.hh"
+#include "BinaryGcode.hh"
+
+/**
+ * Pre-processing of a print job, which replaces runs of G1 moves on a circle by G2/G3 arcs.
+ *
+ * Slicers approximate curves by many short G1 segments. Every command costs a round trip on the
+ * serial line, so a printer may starve on curves, while it waits for the next segment. The
+ * firmware interpolates an arc itself, so a whole run of segments needs only one command.
+ *
+ * A run is only replaced, if all its points are within the tolerance of the arc, it turns in
+ * one direction, it does not move Z or change the feed rate, and it extrudes evenly along its
+ * length. All other commands are passed unchanged. The position is tracked through G90/G91,
+ * M82/M83, G92 and homing. After commands with unknown movements, fitting is suspended until the
+ * position is known again.
+ */
+class ArcFitter {
+    public:
+        struct Statistics {
+            size_t input_lines = 0;
+            size_t output_lines = 0;
+            size_t arcs = 0;
+            // number of G1 moves, which are replaced by arcs
+            size_t fitted_moves = 0;
+        };
+
+        /**
+         * tolerance is the maximum deviation of the arc from the original path in mm.
+         */
+        explicit ArcFitter(double tolerance);
+
+        /**
+         * Fits arcs into the job and passes every resulting command to output.
+         */
+        Statistics fit(const GcodeJob &job, const std::function<void(std::string_view)> &output);
+
+        /**
+         * Returns a new job with fitted arcs. The new job has the format of the given job.
+         */
+        static std::shared_ptr<const GcodeJob> fit(const GcodeJob &job, double tolerance, Statistics &statistics);
+
+        // a run is only replaced, if it has at least this number of moves
+        static constexpr size_t MIN_MOVES = 3;
+        static constexpr size_t MAX_MOVES = 256;
+        // arcs with a larger radius are nearly straight and lose precision in the firmware
+        static constexpr double MAX_RADIUS = 1000.0;
+        // maximum relative deviation of the extrusion per length of a move from the whole run
+        static constexpr double EXTRUSION_TOLERANCE = 0.05;
+        // decimals of the extrusion, which is summed up in integers
+        static constexpr uint8_t E_DECIMALS = BinaryGcode::MAX_DECIMALS;
+
+    private:
+        struct Move {
+            // the original command
+            std::string line;
+            double x;
+            double y;
+            double length;
+            // extruded filament in units of 10^-E_DECIMALS mm, 0 for a travel move
+            int64_t extrusion;
+            std::optional<BinaryGcode::Word> x_word;
+            std::optional<BinaryGcode::Word> y_word;
+            std::optional<BinaryGcode::Word> e_word;
+            std::optional<BinaryGcode::Word> f_word;
+        };
+
+        struct Arc {
+            double center_x;
+            double center_y;
+            bool clockwise;
+        };
+
+        void reset();
+
+        /**
+         * Returns true and fills move, if the command is a G1 move, which can be part of an arc.
+         */
+        bool to_move(const BinaryGcode::Command &command, std::string_view line, Move &move) const;
+
+        void add_move(Move &&move);
+
+        /**
+         * Returns true, if all moves of the current run are on an arc within the tolerance.
+         */
+        bool fit_run(Arc &arc) const;
+
+        /**
+         * Outputs the current run as arc, if it fits, otherwise unchanged.
+         */
+        void flush();
+
+        void emit_arc();
+        void emit(std::string_view line);
+
+        /**
+         * Updates the tracked position and modes for a command, which is passed unchanged.
+         */
+        void track(const BinaryGcode::Command *command, std::string_view line);
+
+    private:
+        const double m_tolerance;
+        const std::function<void(std::string_view)> *m_output;
+        Statistics m_statistics;
+
+        // G91 makes all axes relative, M83 only the extruder
+        bool m_relative;
+        bool m_relative_e;
+        std::optional<double> m_x;
+        std::optional<double> m_y;
+        // absolute extruder position in units of 10^-E_DECIMALS mm
+        std::optional<int64_t> m_e;
+
+        // the current run starts at the position before its first move
+        std::vector<Move> m_run;
+        double m_start_x;
+        double m_start_y;
+        // set, if the current run fits an arc
+        std::optional<Arc> m_arc;
+        std::string m_line;
+};
+
+#endif
@@ -0,0 +1,347 @@
+#include "BinaryGcode.hh"
+#include <stdexcept>
+#include <charconv>
+#include <cstring>
+
+// decimals of a word without value
+static constexpr uint8_t NO_VALUE = 7;
+// maximum number of digits of a mantissa, so it fits into an int64_t
+static constexpr size_t MAX_DIGITS = 18;
+// maximum size of an encoded word: the letter byte and a varint of 64 bit
+static constexpr size_t MAX_WORD_SIZE = 11;
+
+static constexpr uint64_t POW10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+
+/*
+ * value()
+ */
+double BinaryGcode::Word::value() const
+{
+    if (!has_value) {
+        return 0.0;
+    }
+    return static_cast<double>(mantissa) / POW10[decimals];
+}
+
+
+/*
+ * append_to()
+ */
+void BinaryGcode::Word::append_to(std::string &out) const
+{
+    // BinaryGcode::expand() writes the same format
+    out += letter;
+    if (!has_value) {
+        return;
+    }
+    char buf[24];
+    char *end = buf;
+    uint64_t magnitude = mantissa;
+    if (0 > mantissa) {
+        *end++ = '-';
+        magnitude = -magnitude;
+    }
+    end = std::to_chars(end, buf + sizeof(buf), magnitude / POW10[decimals]).ptr;
+    if (0 < decimals) {
+        *end++ = '.';
+        uint64_t frac = magnitude % POW10[decimals];
+        for (size_t i = decimals; 0 < i; --i) {
+            end[i - 1] = '0' + frac % 10;
+            frac /= 10;
+        }
+        end += decimals;
+    }
+    out.append(buf, end - buf);
+}
+
+
+/*
+ * find()
+ */
+const BinaryGcode::Word *BinaryGcode::Command::find(char letter) const
+{
+    for (size_t i = 1; i < word_count; ++i) {
+        if (letter == words[i].letter) {
+            return &words[i];
+        }
+    }
+    return nullptr;
+}
+
+
+/*
+ * is_binary()
+ */
+bool BinaryGcode::is_binary(std::string_view data)
+{
+    return HEADER_SIZE <= data.size() && 0 == std::memcmp(data.data(), MAGIC, sizeof(MAGIC));
+}
+
+
+/*
+ * append_header()
+ */
+void BinaryGcode::append_header(std::string &out)
+{
+    out.append(MAGIC, sizeof(MAGIC));
+    out += static_cast<char>(VERSION);
+    out.append(HEADER_SIZE - sizeof(MAGIC) - 1, '\0');
+}
+
+
+/*
+ * parse()
+ */
+bool BinaryGcode::parse(std::string_view line, Command &command)
+{
+    command.word_count = 0;
+    if (line.empty() || MAX_LINE_SIZE < line.size()) {
+        return false;
+    }
+
+    size_t pos = 0;
+    while (pos < line.size()) {
+        if (MAX_WORDS == command.word_count) {
+            return false;
+        }
+        Word &word = command.words[command.word_count++];
+        word.letter = line[pos++];
+        word.has_value = false;
+        word.decimals = 0;
+        word.mantissa = 0;
+        if ('A' > word.letter || 'Z' < word.letter) {
+            return false;
+        }
+
+        // the words are separated by exactly one space, otherwise the expansion would differ
+        size_t end = line.find(' ', pos);
+        if (std::string_view::npos == end) {
+            end = line.size();
+        }
+        const std::string_view value = line.substr(pos, end - pos);
+        pos = end;
+        if (pos < line.size() && ++pos == line.size()) {
+            return false;
+        }
+        if (value.empty()) {
+            continue;
+        }
+
+        size_t i = 0;
+        const bool negative = '-' == value[0];
+        if (negative) {
+            i++;
+        }
+        uint64_t mantissa = 0;
+        const size_t int_begin = i;
+        for (; i < value.size() && '0' <= value[i] && '9' >= value[i]; ++i) {
+            mantissa = mantissa * 10 + (value[i] - '0');
+        }
+        const size_t int_digits = i - int_begin;
+        // "X.5" and "X01" can't be restored
+        if (0 == int_digits || (1 < int_digits && '0' == value[int_begin])) {
+            return false;
+        }
+        size_t decimals = 0;
+        if (i < value.size()) {
+            if ('.' != value[i++]) {
+                return false;
+            }
+            const size_t frac_begin = i;
+            for (; i < value.size() && '0' <= value[i] && '9' >= value[i]; ++i) {
+                mantissa = mantissa * 10 + (value[i] - '0');
+            }
+            decimals = i - frac_begin;
+            if (i != value.size() || 0 == decimals || MAX_DECIMALS < decimals) {
+                return false;
+            }
+        }
+        // "-0" can't be restored from the mantissa
+        if (MAX_DIGITS < int_digits + decimals || (negative && 0 == mantissa)) {
+            return false;
+        }
+        word.has_value = true;
+        word.decimals = decimals;
+        word.mantissa = (negative) ? (-static_cast<int64_t>(mantissa)) : (static_cast<int64_t>(mantissa));
+    }
+    return true;
+}
+
+
+/*
+ * append_record()
+ */
+void BinaryGcode::append_record(std::string_view line, std::string &out)
+{
+    Command command;
+    if (!parse(line, command)) {
+        append_record(line, false, out);
+        return;
+    }
+
+    char body[MAX_WORDS * MAX_WORD_SIZE];
+    size_t size = 0;
+    for (size_t i = 0; i < command.word_count; ++i) {
+        const Word &word = command.words[i];
+        const uint8_t decimals = (word.has_value) ? (word.decimals) : (NO_VALUE);
+        body[size++] = static_cast<char>((word.letter - 'A') | (decimals << 5));
+        if (!word.has_value) {
+            continue;
+        }
+        // zigzag encoding, so small negative values need few bytes
+        uint64_t value = (static_cast<uint64_t>(word.mantissa) << 1) ^ static_cast<uint64_t>(word.mantissa >> 63);
+        while (0x80 <= value) {
+            body[size++] = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        body[size++] = static_cast<char>(value);
+    }
+    append_record(std::string_view(body, size), true, out);
+}
+
+
+/*
+ * append_record()
+ */
+void BinaryGcode::append_record(std::string_view body, bool tokenized, std::string &out)
+{
+    append_varint((uint64_t(body.size()) << 1) | ((tokenized) ? (1) : (0)), out);
+    out.append(body);
+}
+
+
+/*
+ * next_record()
+ */
+bool BinaryGcode::next_record(std::string_view data, size_t &pos, std::string_view &body, bool &tokenized)
+{
+    if (pos >= data.size()) {
+        return false;
+    }
+    const uint64_t header = read_varint(data, pos);
+    const uint64_t size = header >> 1;
+    if (data.size() - pos < size) {
+        throw std::runtime_error("Binary G-code record at offset " + std::to_string(pos) + " is truncated.");
+    }
+    tokenized = header & 1;
+    body = data.substr(pos, size);
+    pos += size;
+    return true;
+}
+
+
+/*
+ * expand()
+ */
+std::string_view BinaryGcode::expand(std::string_view body, LineBuffer &buffer)
+{
+    size_t size = 0;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        const uint8_t token = body[pos++];
+        const char letter = 'A' + (token & 0x1f);
+        const uint8_t decimals = token >> 5;
+        if ('Z' < letter || (NO_VALUE != decimals && MAX_DECIMALS < decimals)) {
+            throw std::runtime_error("Corrupted binary G-code record.");
+        }
+
+        // sign, 20 digits and the decimal point
+        char word[24];
+        char *end = word;
+        *end++ = letter;
+        if (NO_VALUE != decimals) {
+            const uint64_t value = read_varint(body, pos);
+            const int64_t mantissa = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+            uint64_t magnitude = mantissa;
+            if (0 > mantissa) {
+                *end++ = '-';
+                magnitude = -magnitude;
+            }
+            end = std::to_chars(end, word + sizeof(word), magnitude / POW10[decimals]).ptr;
+            if (0 < decimals) {
+                *end++ = '.';
+                uint64_t frac = magnitude % POW10[decimals];
+                for (size_t i = decimals; 0 < i; --i) {
+                    end[i - 1] = '0' + frac % 10;
+                    frac /= 10;
+                }
+                end += decimals;
+            }
+        }
+
+        const size_t separator = (0 < size) ? (1) : (0);
+        if (buffer.size() - size < separator + (end - word)) {
+            throw std::runtime_error("Binary G-code record exceeds the maximum line size.");
+        }
+        if (separator) {
+            buffer[size++] = ' ';
+        }
+        std::memcpy(buffer.data() + size, word, end - word);
+        size += end - word;
+    }
+    return std::string_view(buffer.data(), size);
+}
+
+
+/*
+ * decode()
+ */
+void BinaryGcode::decode(std::string_view body, Command &command)
+{
+    command.word_count = 0;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        if (MAX_WORDS == command.word_count) {
+            throw std::runtime_error("Binary G-code record has too many words.");
+        }
+        const uint8_t token = body[pos++];
+        Word &word = command.words[command.word_count++];
+        word.letter = 'A' + (token & 0x1f);
+        word.decimals = token >> 5;
+        word.has_value = NO_VALUE != word.decimals;
+        word.mantissa = 0;
+        if ('Z' < word.letter || (word.has_value && MAX_DECIMALS < word.decimals)) {
+            throw std::runtime_error("Corrupted binary G-code record.");
+        }
+        if (word.has_value) {
+            const uint64_t value = read_varint(body, pos);
+            word.mantissa = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        } else {
+            word.decimals = 0;
+        }
+    }
+}
+
+
+/*
+ * append_varint()
+ */
+void BinaryGcode::append_varint(uint64_t value, std::string &out)
+{
+    while (0x80 <= value) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+
+/*
+ * read_varint()
+ */
+uint64_t BinaryGcode::read_varint(std::string_view data, size_t &pos)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (pos >= data.size()) {
+            throw std::runtime_error("Binary G-code is truncated.");
+        }
+        const uint8_t byte = data[pos++];
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Corrupted binary G-code: invalid number.");
+}
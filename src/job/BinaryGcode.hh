@@ -0,0 +1,130 @@
+#ifndef __BINARY_GCODE_HH__
+#define __BINARY_GCODE_HH__
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Compact binary format of pre-parsed G-code.
+ *
+ * A binary job starts with a header (magic and version), which is followed by one record per
+ * command. A record is either tokenized or raw:
+ *
+ *   record    := varint(body_size << 1 | tokenized) body
+ *   tokenized := word+
+ *   word      := uint8_t(letter - 'A' | decimals << 5) [zigzag varint of the mantissa]
+ *   raw       := the command text
+ *
+ * The first word of a tokenized command is its opcode (i.e. G1 or M862.3), the further words are
+ * its parameters. The value of a word is mantissa / 10^decimals, where decimals 7 marks a word
+ * without value. A command is only tokenized, if the expansion results in exactly the same text
+ * (see parse()). All other commands (i.e. M117 with a message) are stored raw. Therefore, a
+ * binary job is lossless and its commands are sent to the device as they were in the text.
+ *
+ * The format roughly halves the size of typical slicer output and the parameters of a command
+ * can be read without parsing text.
+ */
+class BinaryGcode {
+    public:
+        static constexpr char MAGIC[4] = { 'G', 'C', 'D', 'B' };
+        static constexpr uint8_t VERSION = 1;
+        static constexpr size_t HEADER_SIZE = 8;
+        // maximum size of the expansion of a tokenized command. Longer commands are stored raw.
+        static constexpr size_t MAX_LINE_SIZE = 96;
+        static constexpr size_t MAX_WORDS = 32;
+        static constexpr uint8_t MAX_DECIMALS = 6;
+
+        struct Word {
+            char letter;
+            bool has_value;
+            uint8_t decimals;
+            int64_t mantissa;
+
+            double value() const;
+
+            /**
+             * Appends the word as text (i.e. "X10.25").
+             */
+            void append_to(std::string &out) const;
+        };
+
+        /**
+         * A tokenized command.
+         */
+        struct Command {
+            std::array<Word, MAX_WORDS> words;
+            size_t word_count = 0;
+
+            /**
+             * Returns the word with the given letter (the opcode is skipped) or nullptr.
+             */
+            const Word *find(char letter) const;
+
+            /**
+             * Returns true, if the opcode is the given letter and number (i.e. 'G', 1).
+             */
+            bool is(char letter, int64_t number) const
+            {
+                return    0 < word_count
+                       && letter == words[0].letter
+                       && words[0].has_value
+                       && 0 == words[0].decimals
+                       && number == words[0].mantissa;
+            }
+        };
+
+        typedef std::array<char, MAX_LINE_SIZE> LineBuffer;
+
+        /**
+         * Returns true, if the data starts with the header of a binary job.
+         */
+        static bool is_binary(std::string_view data);
+
+        /**
+         * Appends the header of a binary job.
+         */
+        static void append_header(std::string &out);
+
+        /**
+         * Tokenizes a command, which is already stripped (see GcodeJob::strip()). Returns false, if
+         * the command can't be represented exactly, i.e. because of a text parameter.
+         */
+        static bool parse(std::string_view line, Command &command);
+
+        /**
+         * Appends the record of the command to out, tokenized if possible, otherwise raw.
+         */
+        static void append_record(std::string_view line, std::string &out);
+
+        /**
+         * Appends a record with the given body.
+         */
+        static void append_record(std::string_view body, bool tokenized, std::string &out);
+
+        /**
+         * Reads the record at pos and advances pos to the next record. Returns false at the end
+         * of the data. Throws an std::runtime_error, if the record is truncated.
+         */
+        static bool next_record(std::string_view data, size_t &pos, std::string_view &body, bool &tokenized);
+
+        /**
+         * Expands the body of a tokenized record into buffer and returns the command text.
+         * Throws an std::runtime_error, if the record is corrupted.
+         */
+        static std::string_view expand(std::string_view body, LineBuffer &buffer);
+
+        /**
+         * Decodes the body of a tokenized record. Throws an std::runtime_error, if the record is
+         * corrupted.
+         */
+        static void decode(std::string_view body, Command &command);
+
+    private:
+        static void append_varint(uint64_t value, std::string &out);
+        static uint64_t read_varint(std::string_view data, size_t &pos);
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "Compression.hh"
+#include <stdexcept>
+#include <cstring>
+
+// size of the blocks, in which the output of the (de)compression is produced
+static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+/*
+ * type_to_str()
+ */
+const std::string &Compression::type_to_str(Type type)
+{
+    static const std::string types[] = { "none",
+                                         "deflate",
+                                         "<UNKNOWN_COMPRESSION>" };
+    if (type > Type::__LAST_ENTRY) {
+        type = Type::__LAST_ENTRY;
+    }
+    return types[static_cast<size_t>(type)];
+}
+
+
+/*
+ * Deflater()
+ */
+Compression::Deflater::Deflater()
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+    // G-code is sent once, the default level is a good trade off between speed and ratio
+    if (Z_OK != deflateInit(&m_stream, Z_DEFAULT_COMPRESSION)) {
+        throw std::runtime_error("Could not initialize the compressor.");
+    }
+}
+
+
+/*
+ * ~Deflater()
+ */
+Compression::Deflater::~Deflater()
+{
+    deflateEnd(&m_stream);
+}
+
+
+/*
+ * add()
+ */
+void Compression::Deflater::add(std::string_view data, std::string &out)
+{
+    run(data, Z_NO_FLUSH, out);
+}
+
+
+/*
+ * finish()
+ */
+void Compression::Deflater::finish(std::string &out)
+{
+    run(std::string_view(), Z_FINISH, out);
+    deflateReset(&m_stream);
+}
+
+
+/*
+ * run()
+ */
+void Compression::Deflater::run(std::string_view data, int flush, std::string &out)
+{
+    m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    m_stream.avail_in = data.size();
+    int ret;
+    do {
+        const size_t old_size = out.size();
+        out.resize(old_size + BLOCK_SIZE);
+        m_stream.next_out = reinterpret_cast<Bytef *>(out.data() + old_size);
+        m_stream.avail_out = BLOCK_SIZE;
+        ret = deflate(&m_stream, flush);
+        if (Z_STREAM_ERROR == ret) {
+            throw std::runtime_error("Compression failed.");
+        }
+        out.resize(old_size + BLOCK_SIZE - m_stream.avail_out);
+    } while (0 == m_stream.avail_out || (Z_FINISH == flush && Z_STREAM_END != ret));
+}
+
+
+/*
+ * Inflater()
+ */
+Compression::Inflater::Inflater()
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+    if (Z_OK != inflateInit(&m_stream)) {
+        throw std::runtime_error("Could not initialize the decompressor.");
+    }
+}
+
+
+/*
+ * ~Inflater()
+ */
+Compression::Inflater::~Inflater()
+{
+    inflateEnd(&m_stream);
+}
+
+
+/*
+ * add()
+ */
+bool Compression::Inflater::add(std::string_view data, const std::function<void(std::string_view)> &output)
+{
+    char block[BLOCK_SIZE];
+    m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    m_stream.avail_in = data.size();
+    int ret;
+    do {
+        m_stream.next_out = reinterpret_cast<Bytef *>(block);
+        m_stream.avail_out = sizeof(block);
+        ret = inflate(&m_stream, Z_NO_FLUSH);
+        if (Z_OK != ret && Z_STREAM_END != ret && Z_BUF_ERROR != ret) {
+            std::string err = "Decompression failed: ";
+            err += (m_stream.msg) ? (m_stream.msg) : ("corrupted data");
+            inflateReset(&m_stream);
+            throw std::runtime_error(err);
+        }
+        if (sizeof(block) != m_stream.avail_out) {
+            output(std::string_view(block, sizeof(block) - m_stream.avail_out));
+        }
+    } while (Z_STREAM_END != ret && 0 == m_stream.avail_out);
+
+    if (Z_STREAM_END == ret) {
+        const bool trailing_data = 0 != m_stream.avail_in;
+        inflateReset(&m_stream);
+        if (trailing_data) {
+            throw std::runtime_error("Decompression failed: data after the end of the stream");
+        }
+        return true;
+    }
+    return false;
+}
+
+
+/*
+ * decompress()
+ */
+void Compression::decompress(Type type, std::string_view data, const std::function<void(std::string_view)> &output)
+{
+    switch (type) {
+        case Type::NONE:
+            output(data);
+            return;
+        case Type::DEFLATE:
+            {
+                Inflater inflater;
+                if (!inflater.add(data, output)) {
+                    throw std::runtime_error("Decompression failed: incomplete data");
+                }
+            }
+            return;
+        default:
+            throw std::runtime_error("Unsupported compression " + std::to_string(static_cast<unsigned>(type)) + ".");
+    }
+}
+
+
+/*
+ * compress()
+ */
+void Compression::compress(Type type, std::string_view data, std::string &out)
+{
+    switch (type) {
+        case Type::NONE:
+            out.append(data);
+            return;
+        case Type::DEFLATE:
+            {
+                Deflater deflater;
+                deflater.add(data, out);
+                deflater.finish(out);
+            }
+            return;
+        default:
+            throw std::runtime_error("Unsupported compression " + std::to_string(static_cast<unsigned>(type)) + ".");
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef __COMPRESSION_HH__
+#define __COMPRESSION_HH__
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <zlib.h>
+
+/**
+ * Compression of G-code for the transport via MQTT.
+ *
+ * G-code text compresses very well (typically 5-10x). The data is compressed and decompressed
+ * as a stream, so neither side has to hold the whole uncompressed job in memory.
+ */
+class Compression {
+    public:
+        /**
+         * Codecs, which can be negotiated between client and daemon. The values are part of the
+         * MQTT messages and must not be changed.
+         */
+        enum class Type : uint8_t {
+            NONE = 0,
+            DEFLATE = 1,
+            __LAST_ENTRY
+        };
+
+        static const std::string &type_to_str(Type type);
+
+        /**
+         * Returns true, if the type is supported by this build.
+         */
+        static bool is_valid(uint8_t type)
+        {
+            return type < static_cast<uint8_t>(Type::__LAST_ENTRY);
+        }
+
+        /**
+         * Streaming compressor. Data is appended with add() and the stream is completed with
+         * finish(). After finish(), the compressor can be used for a new stream.
+         */
+        class Deflater {
+            public:
+                Deflater(const Deflater &) = delete;
+                Deflater &operator=(const Deflater &) = delete;
+                Deflater();
+                ~Deflater();
+
+                /**
+                 * Compresses data and appends the compressed output to out.
+                 */
+                void add(std::string_view data, std::string &out);
+
+                /**
+                 * Completes the stream, appends the remaining output to out and resets the
+                 * compressor.
+                 */
+                void finish(std::string &out);
+
+            private:
+                void run(std::string_view data, int flush, std::string &out);
+
+            private:
+                z_stream m_stream;
+        };
+
+        /**
+         * Streaming decompressor. The decompressed data is passed in blocks of limited size to
+         * the output function, so compressed data can be written to a file without holding the
+         * decompressed data in memory. Throws an std::runtime_error on corrupted data.
+         */
+        class Inflater {
+            public:
+                Inflater(const Inflater &) = delete;
+                Inflater &operator=(const Inflater &) = delete;
+                Inflater();
+                ~Inflater();
+
+                /**
+                 * Decompresses data. Returns true, if the end of the stream is reached. The
+                 * inflater is reset afterwards, so the next call starts a new stream.
+                 */
+                bool add(std::string_view data, const std::function<void(std::string_view)> &output);
+
+            private:
+                z_stream m_stream;
+        };
+
+        /**
+         * Decompresses a complete stream of the given type. Throws an std::runtime_error, if the
+         * data is corrupted or incomplete.
+         */
+        static void decompress(Type type, std::string_view data, const std::function<void(std::string_view)> &output);
+
+        /**
+         * Compresses a complete stream of the given type and appends it to out.
+         */
+        static void compress(Type type, std::string_view data, std::string &out);
+};
+
+#endif
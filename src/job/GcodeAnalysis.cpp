@@ -0,0 +1,446 @@
+#include "GcodeAnalysis.hh"
+#include <deque>
+#include <cmath>
+#include <algorithm>
+
+// number of moves, which are planned ahead. This is the size of the planner buffer of the firmware.
+static constexpr size_t PLANNER_SIZE = 16;
+// feed rate in mm/s until the first F word
+static constexpr double DEFAULT_FEEDRATE = 25.0;
+static constexpr char AXIS_LETTERS[] = { 'X', 'Y', 'Z', 'E' };
+
+namespace {
+
+/**
+ * A move, which is not yet finished.
+ */
+struct Block {
+    size_t line;
+    double length;
+    double nominal_speed;
+    double acceleration;
+    double max_entry_speed;
+    double entry_speed;
+    // direction of the move
+    double unit[GcodeAnalysis::AXES];
+};
+
+
+/**
+ * Plans the speeds of the moves and adds their times to the commands.
+ */
+class Planner {
+    public:
+        Planner(const GcodeAnalysis::MachineLimits &limits, std::vector<float> &times)
+            : m_limits(limits),
+              m_times(times),
+              m_has_previous(false)
+        {}
+
+        /**
+         * Adds a move with the given distances of the axes and the feed rate in mm/s.
+         */
+        void add(size_t line, const double (&delta)[GcodeAnalysis::AXES], double feedrate)
+        {
+            Block block;
+            block.line = line;
+            block.length = std::sqrt(delta[GcodeAnalysis::X] * delta[GcodeAnalysis::X]
+                                     + delta[GcodeAnalysis::Y] * delta[GcodeAnalysis::Y]
+                                     + delta[GcodeAnalysis::Z] * delta[GcodeAnalysis::Z]);
+            const bool extruder_only = 0.0 == block.length;
+            if (extruder_only) {
+                block.length = std::fabs(delta[GcodeAnalysis::E]);
+            }
+            if (0.0 == block.length) {
+                return;
+            }
+
+            block.nominal_speed = feedrate;
+            if (extruder_only) {
+                block.acceleration = m_limits.retract_acceleration;
+            } else if (0.0 != delta[GcodeAnalysis::E]) {
+                block.acceleration = m_limits.acceleration;
+            } else {
+                block.acceleration = m_limits.travel_acceleration;
+            }
+            for (size_t axis = 0; axis < GcodeAnalysis::AXES; ++axis) {
+                block.unit[axis] = delta[axis] / block.length;
+                const double share = std::fabs(block.unit[axis]);
+                if (0.0 == share) {
+                    continue;
+                }
+                if (0.0 < m_limits.max_feedrate[axis] && block.nominal_speed * share > m_limits.max_feedrate[axis]) {
+                    block.nominal_speed = m_limits.max_feedrate[axis] / share;
+                }
+                if (0.0 < m_limits.max_acceleration[axis] && block.acceleration * share > m_limits.max_acceleration[axis]) {
+                    block.acceleration = m_limits.max_acceleration[axis] / share;
+                }
+            }
+
+            block.max_entry_speed = junction_speed(block);
+            block.entry_speed = 0.0;
+            m_has_previous = true;
+            std::copy(block.unit, block.unit + GcodeAnalysis::AXES, m_previous_unit);
+            m_previous_speed = block.nominal_speed;
+
+            m_blocks.push_back(block);
+            if (PLANNER_SIZE < m_blocks.size()) {
+                plan();
+                finish_first();
+            }
+        }
+
+        /**
+         * Finishes all moves, i.e. before a command, which waits until the printer stops.
+         */
+        void flush()
+        {
+            plan();
+            while (!m_blocks.empty()) {
+                finish_first();
+            }
+            m_has_previous = false;
+        }
+
+    private:
+        /**
+         * Returns the speed from or to standstill, which doesn't exceed the jerk.
+         */
+        double safe_speed(const double (&unit)[GcodeAnalysis::AXES], double nominal_speed) const
+        {
+            double speed = nominal_speed;
+            for (size_t axis = 0; axis < GcodeAnalysis::AXES; ++axis) {
+                const double share = std::fabs(unit[axis]);
+                if (0.0 < m_limits.jerk[axis] && speed * share > m_limits.jerk[axis]) {
+                    speed = m_limits.jerk[axis] / share;
+                }
+            }
+            return speed;
+        }
+
+        /**
+         * Returns the maximum speed at the junction of the previous move and the given move.
+         */
+        double junction_speed(const Block &block) const
+        {
+            if (!m_has_previous) {
+                return safe_speed(block.unit, block.nominal_speed);
+            }
+            // the change of the speed of each axis is limited by the jerk
+            double speed = std::min(m_previous_speed, block.nominal_speed);
+            for (size_t axis = 0; axis < GcodeAnalysis::AXES; ++axis) {
+                const double change = std::fabs(block.unit[axis] - m_previous_unit[axis]);
+                if (0.0 < m_limits.jerk[axis] && speed * change > m_limits.jerk[axis]) {
+                    speed = m_limits.jerk[axis] / change;
+                }
+            }
+            return speed;
+        }
+
+        /**
+         * Plans the entry speeds, so all moves can stop at the end of the buffer. The entry speed
+         * of the first move is already fixed by the finished move before.
+         */
+        void plan()
+        {
+            double exit_speed = 0.0;
+            for (size_t i = m_blocks.size(); 1 < i; --i) {
+                Block &block = m_blocks[i - 1];
+                block.entry_speed = std::min(block.max_entry_speed,
+                                             std::sqrt(exit_speed * exit_speed + 2 * block.acceleration * block.length));
+                exit_speed = block.entry_speed;
+            }
+            for (size_t i = 1; i < m_blocks.size(); ++i) {
+                const Block &previous = m_blocks[i - 1];
+                m_blocks[i].entry_speed = std::min(m_blocks[i].entry_speed,
+                                                   std::sqrt(previous.entry_speed * previous.entry_speed + 2 * previous.acceleration * previous.length));
+            }
+        }
+
+        /**
+         * Adds the time of the first move with a trapezoidal speed profile.
+         */
+        void finish_first()
+        {
+            const Block &block = m_blocks.front();
+            const double v0 = block.entry_speed;
+            const double v1 = (1 < m_blocks.size()) ? (m_blocks[1].entry_speed) : (0.0);
+            const double v = block.nominal_speed;
+            const double a = block.acceleration;
+            const double accelerate = (v * v - v0 * v0) / (2 * a);
+            const double decelerate = (v * v - v1 * v1) / (2 * a);
+            double time;
+            if (accelerate + decelerate <= block.length) {
+                time = (v - v0) / a + (v - v1) / a + (block.length - accelerate - decelerate) / v;
+            } else {
+                // the nominal speed is not reached
+                const double peak = std::sqrt((2 * a * block.length + v0 * v0 + v1 * v1) / 2);
+                time = (peak - v0) / a + (peak - v1) / a;
+            }
+            m_times[block.line] += time;
+            m_blocks.pop_front();
+        }
+
+    private:
+        const GcodeAnalysis::MachineLimits &m_limits;
+        std::vector<float> &m_times;
+        std::deque<Block> m_blocks;
+        bool m_has_previous;
+        double m_previous_unit[GcodeAnalysis::AXES];
+        double m_previous_speed;
+};
+
+
+/*
+ * to_axis()
+ */
+int to_axis(char letter)
+{
+    for (int axis = 0; axis < GcodeAnalysis::AXES; ++axis) {
+        if (AXIS_LETTERS[axis] == letter) {
+            return axis;
+        }
+    }
+    return -1;
+}
+
+}
+
+
+/*
+ * analyze()
+ */
+std::shared_ptr<const GcodeAnalysis> GcodeAnalysis::analyze(const GcodeJob &job, const MachineLimits &machine_limits)
+{
+    std::shared_ptr<GcodeAnalysis> analysis(new GcodeAnalysis());
+    analysis->m_times.assign(job.size(), 0.0f);
+
+    MachineLimits limits = machine_limits;
+    Planner planner(limits, analysis->m_times);
+    double position[AXES] = { 0.0, 0.0, 0.0, 0.0 };
+    double feedrate = DEFAULT_FEEDRATE;
+    // M220
+    double feedrate_factor = 1.0;
+    bool relative = false;
+    bool relative_e = false;
+    // the layers are detected by extruding moves and by moves in the plane in parallel
+    std::vector<Layer> moving_layers;
+    size_t z_line = 0;
+    double filament = 0.0;
+
+    BinaryGcode::Command command;
+    for (size_t i = 0; i < job.size(); ++i) {
+        if (!job.command(i, command) || 0 == command.word_count) {
+            continue;
+        }
+        if (command.is('G', 0) || command.is('G', 1) || command.is('G', 2) || command.is('G', 3)) {
+            double target[AXES];
+            std::copy(position, position + AXES, target);
+            for (size_t w = 1; w < command.word_count; ++w) {
+                const BinaryGcode::Word &word = command.words[w];
+                if ('F' == word.letter && 0 < word.mantissa) {
+                    feedrate = word.value() / 60.0;
+                }
+                const int axis = to_axis(word.letter);
+                if (0 > axis || !word.has_value) {
+                    continue;
+                }
+                if (relative || (E == axis && relative_e)) {
+                    target[axis] += word.value();
+                } else {
+                    target[axis] = word.value();
+                }
+            }
+
+            double delta[AXES];
+            for (size_t axis = 0; axis < AXES; ++axis) {
+                delta[axis] = target[axis] - position[axis];
+            }
+            const BinaryGcode::Word *center_x = command.find('I');
+            const BinaryGcode::Word *center_y = command.find('J');
+            if ((command.is('G', 2) || command.is('G', 3)) && (center_x || center_y)) {
+                // an arc is planned as one move with the length of the arc
+                const double cx = (center_x) ? (center_x->value()) : (0.0);
+                const double cy = (center_y) ? (center_y->value()) : (0.0);
+                const double radius = std::hypot(cx, cy);
+                // the angle between the vectors from the center to the start and to the end
+                const double start_x = -cx;
+                const double start_y = -cy;
+                const double end_x = delta[X] - cx;
+                const double end_y = delta[Y] - cy;
+                double angle = std::atan2(start_x * end_y - start_y * end_x, start_x * end_x + start_y * end_y);
+                if (command.is('G', 2)) {
+                    angle = -angle;
+                }
+                if (0.0 >= angle) {
+                    angle += 2 * M_PI;
+                }
+                const double arc = radius * angle;
+                const double chord = std::hypot(delta[X], delta[Y]);
+                if (0.0 < chord) {
+                    delta[X] *= arc / chord;
+                    delta[Y] *= arc / chord;
+                } else {
+                    // full circle
+                    delta[X] = arc;
+                }
+            }
+            planner.add(i, delta, feedrate * feedrate_factor);
+
+            if (target[Z] != position[Z]) {
+                z_line = i;
+            }
+            const bool planar = 0.0 != delta[X] || 0.0 != delta[Y];
+            if (planar && (moving_layers.empty() || target[Z] > moving_layers.back().z)) {
+                moving_layers.push_back({ z_line, float(target[Z]), 0.0f, float(filament) });
+            }
+            if (    planar
+                 && 0.0 < delta[E]
+                 && (analysis->m_layers.empty() || target[Z] > analysis->m_layers.back().z)) {
+                analysis->m_layers.push_back({ z_line, float(target[Z]), 0.0f, float(filament) });
+            }
+            filament += target[E] - position[E];
+            std::copy(target, target + AXES, position);
+        } else if (command.is('G', 4)) {
+            planner.flush();
+            const BinaryGcode::Word *ms = command.find('P');
+            const BinaryGcode::Word *s = command.find('S');
+            if (ms) {
+                analysis->m_times[i] += ms->value() / 1000.0;
+            } else if (s) {
+                analysis->m_times[i] += s->value();
+            }
+        } else if (command.is('G', 28)) {
+            planner.flush();
+            const bool all = !command.find('X') && !command.find('Y') && !command.find('Z');
+            for (int axis: { X, Y, Z }) {
+                if (all || command.find(AXIS_LETTERS[axis])) {
+                    position[axis] = 0.0;
+                }
+            }
+        } else if (command.is('G', 90)) {
+            relative = false;
+            relative_e = false;
+        } else if (command.is('G', 91)) {
+            relative = true;
+        } else if (command.is('G', 92)) {
+            for (size_t w = 1; w < command.word_count; ++w) {
+                const int axis = to_axis(command.words[w].letter);
+                if (0 <= axis) {
+                    position[axis] = command.words[w].value();
+                }
+            }
+        } else if (command.is('M', 82)) {
+            relative_e = false;
+        } else if (command.is('M', 83)) {
+            relative_e = true;
+        } else if (command.is('M', 201) || command.is('M', 203) || command.is('M', 205)) {
+            double *values = (command.is('M', 201))
+                             ? (limits.max_acceleration)
+                             : ((command.is('M', 203)) ? (limits.max_feedrate) : (limits.jerk));
+            for (size_t w = 1; w < command.word_count; ++w) {
+                const int axis = to_axis(command.words[w].letter);
+                if (0 <= axis) {
+                    values[axis] = command.words[w].value();
+                }
+            }
+        } else if (command.is('M', 204)) {
+            for (size_t w = 1; w < command.word_count; ++w) {
+                const BinaryGcode::Word &word = command.words[w];
+                if (0 >= word.mantissa) {
+                    continue;
+                }
+                if ('S' == word.letter) {
+                    limits.acceleration = limits.travel_acceleration = word.value();
+                } else if ('P' == word.letter) {
+                    limits.acceleration = word.value();
+                } else if ('R' == word.letter) {
+                    limits.retract_acceleration = word.value();
+                } else if ('T' == word.letter) {
+                    limits.travel_acceleration = word.value();
+                }
+            }
+        } else if (command.is('M', 220)) {
+            const BinaryGcode::Word *s = command.find('S');
+            if (s && 0 < s->mantissa) {
+                feedrate_factor = s->value() / 100.0;
+            }
+        } else if (   command.is('M', 400)
+                   || command.is('M', 109)
+                   || command.is('M', 190)
+                   || command.is('M', 600)) {
+            // the printer finishes all moves before it waits
+            planner.flush();
+        }
+    }
+    planner.flush();
+
+    // the time per command is accumulated
+    double time = 0.0;
+    for (float &t: analysis->m_times) {
+        time += t;
+        t = time;
+    }
+    if (analysis->m_layers.empty()) {
+        analysis->m_layers = std::move(moving_layers);
+    }
+    for (Layer &layer: analysis->m_layers) {
+        layer.time = (0 < layer.line) ? (analysis->m_times[layer.line - 1]) : (0.0f);
+    }
+    analysis->m_filament = filament;
+    return analysis;
+}
+
+
+/*
+ * analyze()
+ */
+std::shared_ptr<const GcodeAnalysis> GcodeAnalysis::analyze(const GcodeJob &job)
+{
+    return analyze(job, MachineLimits());
+}
+
+
+/*
+ * layer()
+ */
+size_t GcodeAnalysis::layer(size_t index) const
+{
+    auto it = std::upper_bound(m_layers.begin(), m_layers.end(), index, [](size_t i, const Layer &layer) {
+        return i < layer.line;
+    });
+    if (m_layers.begin() == it) {
+        return m_layers.size();
+    }
+    return (it - m_layers.begin()) - 1;
+}
+
+
+/*
+ * percentage()
+ */
+unsigned GcodeAnalysis::percentage(size_t finished) const
+{
+    if (0 == finished || m_times.empty()) {
+        return 0;
+    }
+    finished = std::min(finished, m_times.size());
+    if (0.0f >= m_times.back()) {
+        // a job without moves
+        return finished * 100 / m_times.size();
+    }
+    return std::min(100.0, std::floor(m_times[finished - 1] * 100.0 / m_times.back()));
+}
+
+
+/*
+ * remaining_time()
+ */
+unsigned GcodeAnalysis::remaining_time(size_t finished) const
+{
+    if (m_times.empty()) {
+        return 0;
+    }
+    const double done = (0 == finished) ? (0.0) : (m_times[std::min(finished, m_times.size()) - 1]);
+    return std::lround((m_times.back() - done) / 60.0);
+}
@@ -0,0 +1,142 @@
+#ifndef __GCODE_ANALYSIS_HH__
+#define __GCODE_ANALYSIS_HH__
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include "GcodeJob.hh"
+
+/**
+ * Static analysis of a print job: the print time of each command, the layers and the filament.
+ *
+ * The motion of the printer is simulated like the planner of a Marlin based firmware does it:
+ * each move accelerates and decelerates with the limited acceleration and the speed at the
+ * junction of two moves is limited by the jerk. A look-ahead of the same size as the planner
+ * buffer of the firmware plans the speeds. The limits are taken from MachineLimits and are
+ * updated by the commands of the job (M201, M203, M204, M205), so the analysis uses the same
+ * limits as the firmware, which gets the same commands. Waiting for temperatures is not
+ * predictable and is not part of the time.
+ *
+ * The analysis is done once per job and needs 4 bytes per command. Afterwards, the progress of
+ * the print can be derived from the number of finished commands (see percentage() and
+ * remaining_time()), without asking the printer.
+ */
+class GcodeAnalysis {
+    public:
+        enum Axis {
+            X = 0,
+            Y,
+            Z,
+            E,
+            AXES
+        };
+
+        /**
+         * Limits of the motion of a printer. The defaults are the ones of a Prusa i3 MK3S.
+         * Limits, which are 0, are not applied.
+         */
+        struct MachineLimits {
+            // mm/s
+            double max_feedrate[AXES] = { 200.0, 200.0, 12.0, 120.0 };
+            // mm/s^2
+            double max_acceleration[AXES] = { 1000.0, 1000.0, 200.0, 5000.0 };
+            // mm/s^2 of moves with extrusion, of moves of the extruder only and of travel moves
+            double acceleration = 1250.0;
+            double retract_acceleration = 1250.0;
+            double travel_acceleration = 1250.0;
+            // maximum instantaneous change of the speed in mm/s
+            double jerk[AXES] = { 8.0, 8.0, 0.4, 4.5 };
+        };
+
+        struct Layer {
+            // index of the first command of the layer
+            size_t line;
+            float z;
+            // time and filament before the layer starts
+            float time;
+            float filament;
+        };
+
+        GcodeAnalysis(const GcodeAnalysis &) = delete;
+        GcodeAnalysis &operator=(const GcodeAnalysis &) = delete;
+
+        /**
+         * Analyzes the job with the given limits of the printer.
+         */
+        static std::shared_ptr<const GcodeAnalysis> analyze(const GcodeJob &job, const MachineLimits &limits);
+
+        /**
+         * Same as above with the default limits.
+         */
+        static std::shared_ptr<const GcodeAnalysis> analyze(const GcodeJob &job);
+
+        /**
+         * Returns the number of analyzed commands, which is the size of the job.
+         */
+        size_t size() const
+        {
+            return m_times.size();
+        }
+
+        /**
+         * Returns the time in seconds from the start of the print until the command with the
+         * given index is finished.
+         */
+        double time(size_t index) const
+        {
+            return m_times[index];
+        }
+
+        /**
+         * Returns the estimated print time in seconds.
+         */
+        double total_time() const
+        {
+            return (m_times.empty()) ? (0.0) : (m_times.back());
+        }
+
+        /**
+         * Returns the extruded filament in mm.
+         */
+        double filament() const
+        {
+            return m_filament;
+        }
+
+        /**
+         * Returns the layers in the order of printing. A layer starts at the first move at a
+         * new height, which extrudes. If the job never extrudes, a layer starts at the first
+         * move in the plane at a new height.
+         */
+        const std::vector<Layer> &layers() const
+        {
+            return m_layers;
+        }
+
+        /**
+         * Returns the index of the layer, which contains the command with the given index, or
+         * layers().size(), if the command is printed before the first layer.
+         */
+        size_t layer(size_t index) const;
+
+        /**
+         * Returns the progress in percent after the given number of commands is finished.
+         */
+        unsigned percentage(size_t finished) const;
+
+        /**
+         * Returns the remaining print time in minutes after the given number of commands is
+         * finished.
+         */
+        unsigned remaining_time(size_t finished) const;
+
+    private:
+        GcodeAnalysis() = default;
+
+        // cumulative time in seconds per command
+        std::vector<float> m_times;
+        std::vector<Layer> m_layers;
+        double m_filament = 0.0;
+};
+
+#endif
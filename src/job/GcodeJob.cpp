@@ -0,0 +1,296 @@
+#include "GcodeJob.hh"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/*
+ * GcodeJob()
+ */
+GcodeJob::GcodeJob()
+    : m_data(nullptr),
+      m_data_size(0),
+      m_map(nullptr),
+      m_binary(false)
+{}
+
+
+/*
+ * ~GcodeJob()
+ */
+GcodeJob::~GcodeJob()
+{
+    if (m_map) {
+        munmap(m_map, m_data_size);
+        m_map = nullptr;
+    }
+}
+
+
+/*
+ * from_file()
+ */
+std::shared_ptr<const GcodeJob> GcodeJob::from_file(const std::string &file_path)
+{
+    std::shared_ptr<GcodeJob> job(new GcodeJob());
+
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (0 > fd) {
+        std::string err = "Could not open G-code file '" + file_path + "': ";
+        err += std::strerror(errno);
+        throw std::runtime_error(err);
+    }
+
+    struct stat st;
+    if (0 != fstat(fd, &st)) {
+        std::string err = "Could not stat G-code file '" + file_path + "': ";
+        err += std::strerror(errno);
+        close(fd);
+        throw std::runtime_error(err);
+    }
+
+    // mmap() does not accept a length of zero. An empty file is just an empty job.
+    if (0 < st.st_size) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == map) {
+            std::string err = "Could not map G-code file '" + file_path + "': ";
+            err += std::strerror(errno);
+            close(fd);
+            throw std::runtime_error(err);
+        }
+        // the mapping keeps the file referenced
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        job->m_map = map;
+        job->m_data = static_cast<const char *>(map);
+        job->m_data_size = st.st_size;
+    }
+    close(fd);
+
+    job->index();
+    return job;
+}
+
+
+/*
+ * from_string()
+ */
+std::shared_ptr<const GcodeJob> GcodeJob::from_string(const std::string &gcode)
+{
+    std::shared_ptr<GcodeJob> job(new GcodeJob());
+    job->m_buffer = gcode;
+    job->m_data = job->m_buffer.data();
+    job->m_data_size = job->m_buffer.size();
+    job->index();
+    return job;
+}
+
+
+/*
+ * strip()
+ */
+std::string_view GcodeJob::strip(std::string_view line)
+{
+    std::string_view::size_type pos = line.find(';');
+    if (std::string_view::npos != pos) {
+        line.remove_suffix(line.size() - pos);
+    }
+    pos = line.find_first_not_of(" \n\r\t\f\v");
+    if (std::string_view::npos == pos) {
+        return std::string_view();
+    }
+    line.remove_prefix(pos);
+    line.remove_suffix(line.size() - line.find_last_not_of(" \n\r\t\f\v") - 1);
+    return line;
+}
+
+
+/*
+ * checksum()
+ */
+uint8_t GcodeJob::checksum(std::string_view data, uint8_t init)
+{
+    uint8_t cs = init;
+    for (char c: data) {
+        cs ^= uint8_t(c);
+    }
+    return cs;
+}
+
+
+/*
+ * command()
+ */
+bool GcodeJob::command(size_t index, BinaryGcode::Command &command) const
+{
+    const uint64_t entry = m_lines[index];
+    const std::string_view data(m_data + (entry >> OFFSET_SHIFT), (entry >> LENGTH_SHIFT) & LENGTH_MASK);
+    if (entry & TOKENIZED_BIT) {
+        BinaryGcode::decode(data, command);
+        return true;
+    }
+    return BinaryGcode::parse(data, command);
+}
+
+
+/*
+ * serialized_header()
+ */
+std::string_view GcodeJob::serialized_header() const
+{
+    // an empty job has no header, so it is the same in both formats
+    if (!m_binary || m_lines.empty()) {
+        return std::string_view();
+    }
+    return std::string_view(m_data, BinaryGcode::HEADER_SIZE);
+}
+
+
+/*
+ * serialize()
+ */
+void GcodeJob::serialize(size_t index, std::string &out) const
+{
+    const uint64_t entry = m_lines[index];
+    const std::string_view data(m_data + (entry >> OFFSET_SHIFT), (entry >> LENGTH_SHIFT) & LENGTH_MASK);
+    if (m_binary) {
+        BinaryGcode::append_record(data, entry & TOKENIZED_BIT, out);
+    } else {
+        out += data;
+        out += '\n';
+    }
+}
+
+
+/*
+ * serialized_size()
+ */
+size_t GcodeJob::serialized_size(size_t index) const
+{
+    const size_t length = (m_lines[index] >> LENGTH_SHIFT) & LENGTH_MASK;
+    if (!m_binary) {
+        return length + 1;
+    }
+    // the varint of the record header has 7 bit per byte
+    size_t header = 1;
+    for (uint64_t value = uint64_t(length) << 1; 0x80 <= value; value >>= 7) {
+        header++;
+    }
+    return header + length;
+}
+
+
+/*
+ * serialized_size()
+ */
+uint64_t GcodeJob::serialized_size() const
+{
+    uint64_t total = serialized_header().size();
+    for (size_t i = 0; i < size(); ++i) {
+        total += serialized_size(i);
+    }
+    return total;
+}
+
+
+/*
+ * content_hash()
+ */
+const Sha256::Digest &GcodeJob::content_hash() const
+{
+    std::call_once(m_hash_once, [this]() {
+        Sha256 sha;
+        sha.update(serialized_header());
+        std::string record;
+        for (size_t i = 0; i < size(); ++i) {
+            record.clear();
+            serialize(i, record);
+            sha.update(record);
+        }
+        m_hash = sha.digest();
+    });
+    return m_hash;
+}
+
+
+/*
+ * index()
+ */
+void GcodeJob::index()
+{
+    if (MAX_OFFSET < m_data_size) {
+        throw std::runtime_error("G-code job is too large to be indexed.");
+    }
+    if (BinaryGcode::is_binary(std::string_view(m_data, m_data_size))) {
+        index_binary();
+        return;
+    }
+
+    m_lines.clear();
+    // the number of line breaks is an upper bound for the number of commands, reserving it upfront
+    // avoids that the index temporarily needs twice the memory while growing.
+    m_lines.reserve(std::count(m_data, m_data + m_data_size, '\n') + 1);
+
+    const char *pos = m_data;
+    const char *const end = m_data + m_data_size;
+    while (pos < end) {
+        const char *eol = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (!eol) {
+            eol = end;
+        }
+        const std::string_view line = strip(std::string_view(pos, eol - pos));
+        pos = eol + 1;
+        if (line.empty()) {
+            continue;
+        }
+        if (LENGTH_MASK < line.size()) {
+            std::string err = "G-code line ";
+            err += std::to_string(m_lines.size() + 1);
+            err += " is too long.";
+            throw std::runtime_error(err);
+        }
+        const uint64_t offset = line.data() - m_data;
+        m_lines.push_back(  (offset << OFFSET_SHIFT)
+                          | (uint64_t(line.size()) << LENGTH_SHIFT)
+                          | checksum(line));
+    }
+}
+
+
+/*
+ * index_binary()
+ */
+void GcodeJob::index_binary()
+{
+    if (BinaryGcode::VERSION != static_cast<uint8_t>(m_data[sizeof(BinaryGcode::MAGIC)])) {
+        throw std::runtime_error("Unsupported version " + std::to_string(static_cast<uint8_t>(m_data[sizeof(BinaryGcode::MAGIC)]))
+                                 + " of binary G-code.");
+    }
+    m_binary = true;
+    m_lines.clear();
+
+    const std::string_view data(m_data, m_data_size);
+    size_t pos = BinaryGcode::HEADER_SIZE;
+    std::string_view body;
+    bool tokenized;
+    BinaryGcode::LineBuffer buffer;
+    while (BinaryGcode::next_record(data, pos, body, tokenized)) {
+        if (LENGTH_MASK < body.size()) {
+            std::string err = "G-code line ";
+            err += std::to_string(m_lines.size() + 1);
+            err += " is too long.";
+            throw std::runtime_error(err);
+        }
+        // the expansion also validates the record, so a corrupted job is rejected upfront
+        const std::string_view line = (tokenized) ? (BinaryGcode::expand(body, buffer)) : (body);
+        const uint64_t offset = body.data() - m_data;
+        m_lines.push_back(  (offset << OFFSET_SHIFT)
+                          | ((tokenized) ? (TOKENIZED_BIT) : (0))
+                          | (uint64_t(body.size()) << LENGTH_SHIFT)
+                          | checksum(line));
+    }
+}
@@ -0,0 +1,198 @@
+#ifndef __GCODE_JOB_HH__
+#define __GCODE_JOB_HH__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include "Sha256.hh"
+#include "BinaryGcode.hh"
+
+/**
+ * Immutable representation of a G-code print job.
+ *
+ * A job loaded from a file is memory mapped. The job itself only keeps a compact index with one
+ * 64 bit entry (offset and length) for each meaningful line. Comments, blank lines and surrounding
+ * whitespaces are stripped while the index is built. Therefore, line() returns a view directly
+ * into the mapped pages and no copy of the G-code is needed to send it to a device.
+ *
+ * A job can also be loaded from the binary format (see BinaryGcode), which is detected by its
+ * header. Then, the index points to the records. Tokenized commands are expanded to text only on
+ * access (see line(size_t, BinaryGcode::LineBuffer &)), raw commands are returned as views.
+ *
+ * Jobs are only accessible via std::shared_ptr, so several consumers can share one job.
+ */
+class GcodeJob {
+    public:
+        GcodeJob(const GcodeJob &) = delete;
+        GcodeJob(GcodeJob &&) = delete;
+        GcodeJob &operator=(const GcodeJob &) = delete;
+        ~GcodeJob();
+
+        /**
+         * Maps the file and indexes all lines.
+         * Throws an std::runtime_error, if the file can't be opened or mapped.
+         */
+        static std::shared_ptr<const GcodeJob> from_file(const std::string &file_path);
+
+        /**
+         * Copies the G-code and indexes all lines.
+         */
+        static std::shared_ptr<const GcodeJob> from_string(const std::string &gcode);
+
+        /**
+         * Returns the number of commands in the job.
+         */
+        size_t size() const
+        {
+            return m_lines.size();
+        }
+
+        /**
+         * Returns the command with the given index. The returned view is valid as long as the job exists.
+         * It does not contain comments or a line break. Throws an std::runtime_error, if the
+         * command is tokenized (see is_tokenized()).
+         */
+        std::string_view line(size_t index) const
+        {
+            const uint64_t entry = m_lines[index];
+            if (entry & TOKENIZED_BIT) {
+                throw std::runtime_error("G-code command " + std::to_string(index) + " is tokenized and has to be expanded.");
+            }
+            return std::string_view(m_data + (entry >> OFFSET_SHIFT), (entry >> LENGTH_SHIFT) & LENGTH_MASK);
+        }
+
+        /**
+         * Same as above, but works for all commands. A tokenized command is expanded into buffer
+         * and the returned view is only valid until buffer is used again.
+         */
+        std::string_view line(size_t index, BinaryGcode::LineBuffer &buffer) const
+        {
+            const uint64_t entry = m_lines[index];
+            const std::string_view data(m_data + (entry >> OFFSET_SHIFT), (entry >> LENGTH_SHIFT) & LENGTH_MASK);
+            if (entry & TOKENIZED_BIT) {
+                return BinaryGcode::expand(data, buffer);
+            }
+            return data;
+        }
+
+        /**
+         * Returns true, if the command with the given index is a tokenized command of a binary
+         * job, which is expanded by line(size_t, BinaryGcode::LineBuffer &).
+         */
+        bool is_tokenized(size_t index) const
+        {
+            return m_lines[index] & TOKENIZED_BIT;
+        }
+
+        /**
+         * Returns true, if the job was loaded from the binary format.
+         */
+        bool is_binary() const
+        {
+            return m_binary;
+        }
+
+        /**
+         * Returns the parameters of the command with the given index. Returns false, if the
+         * command can't be tokenized (see BinaryGcode::parse()).
+         */
+        bool command(size_t index, BinaryGcode::Command &command) const;
+
+        /**
+         * Returns the XOR of all bytes of the command with the given index. This is precomputed while
+         * indexing, so the checksum of a line numbered command (see checksum()) is cheap.
+         */
+        uint8_t line_xor(size_t index) const
+        {
+            return m_lines[index] & XOR_MASK;
+        }
+
+        /**
+         * Calculates the checksum used by the Marlin/Prusa firmware for line numbered commands,
+         * which is the XOR of all bytes before the '*'.
+         */
+        static uint8_t checksum(std::string_view data, uint8_t init = 0);
+
+        /**
+         * Returns the size of the raw G-code in bytes (including comments).
+         */
+        size_t data_size() const
+        {
+            return m_data_size;
+        }
+
+        /**
+         * The serialized form of a job is the content, which is uploaded to the daemon. For a
+         * text job, it consists of the commands, each terminated by a line break. For a binary
+         * job, it consists of the header and the records. The serialized job is loaded again as
+         * the same job.
+         */
+        std::string_view serialized_header() const;
+
+        /**
+         * Appends the serialized command with the given index to out.
+         */
+        void serialize(size_t index, std::string &out) const;
+
+        /**
+         * Returns the size of the serialized command with the given index.
+         */
+        size_t serialized_size(size_t index) const;
+
+        /**
+         * Returns the size of the whole serialized job.
+         */
+        uint64_t serialized_size() const;
+
+        /**
+         * Returns the SHA-256 of the serialized job. This is the content, which is uploaded to
+         * the daemon, so it identifies the job in the JobCache. The hash is calculated on the
+         * first call only.
+         */
+        const Sha256::Digest &content_hash() const;
+
+        /**
+         * Removes comments and leading and trailing whitespaces from a G-code line.
+         */
+        static std::string_view strip(std::string_view line);
+
+    private:
+        GcodeJob();
+
+        /**
+         * Builds the line index over m_data.
+         */
+        void index();
+
+        /**
+         * Builds the index over the records of a binary job.
+         */
+        void index_binary();
+
+        // layout of an index entry:
+        // | offset (39 bit) | tokenized (1 bit) | length (16 bit) | XOR of the line (8 bit) |
+        static constexpr uint64_t XOR_MASK = 0xff;
+        static constexpr unsigned LENGTH_SHIFT = 8;
+        static constexpr uint64_t LENGTH_MASK = 0xffff;
+        static constexpr uint64_t TOKENIZED_BIT = uint64_t(1) << 24;
+        static constexpr unsigned OFFSET_SHIFT = 25;
+        static constexpr uint64_t MAX_OFFSET = (uint64_t(1) << 39) - 1;
+
+    private:
+        const char *m_data;
+        size_t m_data_size;
+        // only set, if the job is memory mapped
+        void *m_map;
+        // only used, if the job was created from a string
+        std::string m_buffer;
+        std::vector<uint64_t> m_lines;
+        bool m_binary;
+        mutable std::once_flag m_hash_once;
+        mutable Sha256::Digest m_hash;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef __GCODE_SPOOLER_HH__
+#define __GCODE_SPOOLER_HH__
+
+#include <string_view>
+#include <memory>
+#include "GcodeJob.hh"
+
+/**
+ * Provides the commands of a print job line by line.
+ *
+ * The spooler is a cursor over a GcodeJob. The job is memory mapped and indexed, therefore the
+ * memory consumption of the spooler is constant and independent of the size of the print job.
+ * Tokenized commands of a binary job are expanded into a buffer of the spooler, just before
+ * they are sent.
+ *
+ * Optionally, the commands of a prologue are provided before the first line of the job, i.e. to
+ * bring the printer into the state of the job, if a print is resumed (see PrintCheckpoint).
+ */
+class GcodeSpooler {
+    public:
+        GcodeSpooler(const GcodeSpooler &) = delete;
+        GcodeSpooler &operator=(const GcodeSpooler &) = delete;
+
+        GcodeSpooler()
+            : m_next(0),
+              m_prologue_next(0)
+        {}
+
+        /**
+         * Starts spooling the given job at the given line. All commands of the prologue are
+         * provided before the first line. A previously opened job is closed.
+         */
+        void open(const std::shared_ptr<const GcodeJob> &job,
+                  size_t first_line = 0,
+                  const std::shared_ptr<const GcodeJob> &prologue = nullptr)
+        {
+            m_job = job;
+            m_next = first_line;
+            m_prologue = prologue;
+            m_prologue_next = 0;
+        }
+
+        /**
+         * Closes the current job.
+         */
+        void close()
+        {
+            m_job = nullptr;
+            m_next = 0;
+            m_prologue = nullptr;
+            m_prologue_next = 0;
+        }
+
+        /**
+         * Returns true, if a job is opened.
+         */
+        bool is_open() const
+        {
+            return m_job != nullptr;
+        }
+
+        /**
+         * Returns the currently opened job or nullptr.
+         */
+        const std::shared_ptr<const GcodeJob> &job() const
+        {
+            return m_job;
+        }
+
+        /**
+         * Stores the next command of the job in line. The view points into the job and stays valid
+         * as long as the job exists. If the command is tokenized (see GcodeJob::is_tokenized()),
+         * the view points into the spooler and is only valid until the next call of next() or
+         * peek().
+         *
+         * Returns false, if the job has no more commands.
+         */
+        bool next(std::string_view &line)
+        {
+            if (!peek(line)) {
+                return false;
+            }
+            skip();
+            return true;
+        }
+
+        /**
+         * Same as next(), but the line is not consumed.
+         */
+        bool peek(std::string_view &line)
+        {
+            if (in_prologue()) {
+                line = m_prologue->line(m_prologue_next, m_buffer);
+                return true;
+            }
+            if (!m_job || m_next >= m_job->size()) {
+                return false;
+            }
+            line = m_job->line(m_next, m_buffer);
+            return true;
+        }
+
+        /**
+         * Consumes the next command without returning it, i.e. after peek().
+         */
+        void skip()
+        {
+            if (in_prologue()) {
+                m_prologue_next++;
+            } else if (m_job && m_next < m_job->size()) {
+                m_next++;
+            }
+        }
+
+        /**
+         * Returns the XOR of all bytes of the next command (see GcodeJob::line_xor()). There
+         * has to be a next command.
+         */
+        uint8_t line_xor() const
+        {
+            return (in_prologue()) ? (m_prologue->line_xor(m_prologue_next)) : (m_job->line_xor(m_next));
+        }
+
+        /**
+         * Returns true, if the next command is tokenized (see GcodeJob::is_tokenized()). There
+         * has to be a next command.
+         */
+        bool is_tokenized() const
+        {
+            return (in_prologue()) ? (m_prologue->is_tokenized(m_prologue_next)) : (m_job->is_tokenized(m_next));
+        }
+
+        /**
+         * Returns the index of the line of the job which will be returned by the next call of
+         * next(), after the prologue is consumed.
+         */
+        size_t position() const
+        {
+            return m_next;
+        }
+
+    private:
+        bool in_prologue() const
+        {
+            return m_job && m_prologue && m_prologue_next < m_prologue->size();
+        }
+
+    private:
+        std::shared_ptr<const GcodeJob> m_job;
+        size_t m_next;
+        std::shared_ptr<const GcodeJob> m_prologue;
+        size_t m_prologue_next;
+        BinaryGcode::LineBuffer m_buffer;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "JobCache.hh"
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+
+
+/*
+ * JobCache()
+ */
+JobCache::JobCache(const std::filesystem::path &dir, uint64_t max_bytes, const std::vector<Sha256::Digest> &pinned)
+    : m_dir(dir),
+      m_max_bytes(max_bytes),
+      m_size(0)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+    if (ec) {
+        throw std::runtime_error("Could not create job cache directory '" + m_dir.string() + "': " + ec.message());
+    }
+
+    struct cached_file {
+        Sha256::Digest hash;
+        uint64_t size;
+        std::filesystem::file_time_type last_use;
+    };
+    std::vector<struct cached_file> files;
+    std::filesystem::directory_iterator iter(m_dir, ec);
+    if (ec) {
+        throw std::runtime_error("Could not read job cache directory '" + m_dir.string() + "': " + ec.message());
+    }
+    for (const auto &dir_entry: iter) {
+        struct cached_file file;
+        // other files (i.e. left over temporary files) are ignored
+        if (   !dir_entry.is_regular_file(ec)
+            || !Sha256::from_hex(dir_entry.path().filename().string(), file.hash)) {
+            continue;
+        }
+        file.size = dir_entry.file_size(ec);
+        if (ec) {
+            continue;
+        }
+        file.last_use = dir_entry.last_write_time(ec);
+        if (ec) {
+            continue;
+        }
+        files.push_back(file);
+    }
+
+    std::sort(files.begin(), files.end(), [](const struct cached_file &a, const struct cached_file &b) {
+        return a.last_use > b.last_use;
+    });
+    for (const auto &file: files) {
+        m_entries.push_back({ file.hash, file.size });
+        m_index[file.hash] = std::prev(m_entries.end());
+        m_size += file.size;
+    }
+    for (const auto &hash: pinned) {
+        pin(hash);
+    }
+    // the budget may have been reduced since the last start
+    evict(0);
+}
+
+
+/*
+ * lookup()
+ */
+std::optional<std::filesystem::path> JobCache::lookup(const Sha256::Digest &hash)
+{
+    auto iter = m_index.find(hash);
+    if (m_index.end() == iter) {
+        return std::nullopt;
+    }
+
+    const std::filesystem::path job_path = path(hash);
+    std::error_code ec;
+    std::filesystem::last_write_time(job_path, std::filesystem::file_time_type::clock::now(), ec);
+    if (ec) {
+        // the file was removed behind our back
+        m_size -= iter->second->size;
+        m_entries.erase(iter->second);
+        m_index.erase(iter);
+        return std::nullopt;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, iter->second);
+    return job_path;
+}
+
+
+/*
+ * insert()
+ */
+std::optional<std::filesystem::path> JobCache::insert(const Sha256::Digest &hash, const std::filesystem::path &file)
+{
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(file, ec);
+    if (ec) {
+        throw std::runtime_error("Could not add '" + file.string() + "' to the job cache: " + ec.message());
+    }
+    if (size > m_max_bytes) {
+        return std::nullopt;
+    }
+
+    auto iter = m_index.find(hash);
+    if (m_index.end() != iter) {
+        m_size -= iter->second->size;
+        m_entries.erase(iter->second);
+        m_index.erase(iter);
+    }
+    evict(size);
+
+    const std::filesystem::path job_path = path(hash);
+    std::filesystem::rename(file, job_path, ec);
+    if (ec) {
+        // i.e. the upload directory is on another file system
+        const std::filesystem::path tmp_path = m_dir / (".tmp_" + Sha256::to_hex(hash));
+        std::filesystem::copy_file(file, tmp_path, std::filesystem::copy_options::overwrite_existing, ec);
+        if (!ec) {
+            std::filesystem::rename(tmp_path, job_path, ec);
+        }
+        if (ec) {
+            std::error_code remove_ec;
+            std::filesystem::remove(tmp_path, remove_ec);
+            throw std::runtime_error("Could not add '" + file.string() + "' to the job cache: " + ec.message());
+        }
+    }
+    std::filesystem::last_write_time(job_path, std::filesystem::file_time_type::clock::now(), ec);
+
+    m_entries.push_front({ hash, size });
+    m_index[hash] = m_entries.begin();
+    m_size += size;
+    return job_path;
+}
+
+
+/*
+ * pin()
+ */
+void JobCache::pin(const Sha256::Digest &hash)
+{
+    m_pins[hash]++;
+}
+
+
+/*
+ * unpin()
+ */
+void JobCache::unpin(const Sha256::Digest &hash)
+{
+    auto iter = m_pins.find(hash);
+    if (m_pins.end() == iter) {
+        return;
+    }
+    if (0 == --iter->second) {
+        m_pins.erase(iter);
+    }
+}
+
+
+/*
+ * evict()
+ */
+void JobCache::evict(uint64_t needed)
+{
+    auto iter = m_entries.end();
+    while (m_entries.begin() != iter && m_size + needed > m_max_bytes) {
+        --iter;
+        if (m_pins.count(iter->hash)) {
+            continue;
+        }
+        const std::filesystem::path job_path = path(iter->hash);
+        std::error_code ec;
+        std::filesystem::remove(job_path, ec);
+        if (ec) {
+            std::cerr << "Could not remove '" << job_path.string() << "' from the job cache: " << ec.message() << "\n";
+        }
+        m_size -= iter->size;
+        m_index.erase(iter->hash);
+        iter = m_entries.erase(iter);
+    }
+}
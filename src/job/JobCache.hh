@@ -0,0 +1,99 @@
+#ifndef __JOB_CACHE_HH__
+#define __JOB_CACHE_HH__
+
+#include <string>
+#include <filesystem>
+#include <optional>
+#include <list>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "Sha256.hh"
+
+/**
+ * Content addressed on-disk cache of print jobs.
+ *
+ * Each job is stored in a file, which is named by the hex SHA-256 of its content (see
+ * GcodeJob::content_hash()). If the cache exceeds its byte budget, the least recently used jobs
+ * are removed. The order of use is persisted in the modification time of the files, so the cache
+ * survives restarts of the daemon. Removing a job, which is still printed, is fine, since a job
+ * loaded with GcodeJob::from_file() keeps the file referenced. Pinned jobs (i.e. queued jobs, see
+ * JobQueue) are never removed, even if the cache exceeds its budget.
+ *
+ * The cache is not thread safe.
+ */
+class JobCache {
+    public:
+        JobCache(const JobCache &) = delete;
+        JobCache &operator=(const JobCache &) = delete;
+
+        /**
+         * Opens the cache in the directory dir, which is created if necessary, and loads the
+         * already cached jobs. The jobs in pinned are pinned (see pin()) before the cache is
+         * shrunk to its budget, so i.e. queued jobs survive a restart. Throws an
+         * std::runtime_error, if the directory can't be created or read.
+         */
+        JobCache(const std::filesystem::path &dir, uint64_t max_bytes, const std::vector<Sha256::Digest> &pinned = {});
+
+        /**
+         * Returns the path of the cached job with the given hash and marks it as recently used.
+         */
+        std::optional<std::filesystem::path> lookup(const Sha256::Digest &hash);
+
+        /**
+         * Moves the file into the cache as the job with the given hash and returns its new path.
+         * The file has to be in the same file system as the cache, otherwise it is copied. A
+         * job, which is larger than the whole budget, is not cached and std::nullopt is returned.
+         * Throws an std::runtime_error, if the file can't be moved or copied.
+         */
+        std::optional<std::filesystem::path> insert(const Sha256::Digest &hash, const std::filesystem::path &file);
+
+        /**
+         * Protects the job with the given hash from being removed, until unpin() is called as
+         * often as pin(). The job doesn't have to be in the cache yet.
+         */
+        void pin(const Sha256::Digest &hash);
+        void unpin(const Sha256::Digest &hash);
+
+        /**
+         * Returns the number of bytes of all cached jobs.
+         */
+        uint64_t size() const
+        {
+            return m_size;
+        }
+
+        size_t count() const
+        {
+            return m_entries.size();
+        }
+
+    private:
+        struct entry {
+            Sha256::Digest hash;
+            uint64_t size;
+        };
+
+        std::filesystem::path path(const Sha256::Digest &hash) const
+        {
+            return m_dir / Sha256::to_hex(hash);
+        }
+
+        /**
+         * Removes the least recently used jobs, which aren't pinned, until the cache has room for
+         * the given number of bytes.
+         */
+        void evict(uint64_t needed);
+
+    private:
+        std::filesystem::path m_dir;
+        uint64_t m_max_bytes;
+        uint64_t m_size;
+        // most recently used job first
+        std::list<struct entry> m_entries;
+        std::map<Sha256::Digest, std::list<struct entry>::iterator> m_index;
+        // hash -> number of pins
+        std::map<Sha256::Digest, unsigned> m_pins;
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "JobQueue.hh"
+#include <stdexcept>
+#include <algorithm>
+#include <system_error>
+
+
+/*
+ * JobQueue()
+ */
+JobQueue::JobQueue(const std::filesystem::path &file)
+    : m_db(nullptr)
+{
+    std::error_code ec;
+    if (file.has_parent_path()) {
+        std::filesystem::create_directories(file.parent_path(), ec);
+    }
+
+    int ret = sqlite3_open(file.c_str(), &m_db);
+    if (SQLITE_OK != ret) {
+        std::string err = "JobQueue::";
+        err += __func__;
+        err += "(): Could not open '" + file.string() + "': ";
+        err += sqlite3_errmsg(m_db);
+        sqlite3_close(m_db);
+        m_db = nullptr;
+        throw std::runtime_error(err);
+    }
+    sqlite3_busy_timeout(m_db, 10);
+
+    // the position orders the jobs of a device, the id is never reused (AUTOINCREMENT)
+    const char create_table[] =
+        "CREATE TABLE IF NOT EXISTS job_queue "
+        "(id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " device TEXT NOT NULL,"
+        " position INTEGER NOT NULL,"
+        " job_hash TEXT NOT NULL)";
+    try {
+        exec(create_table, __func__);
+    } catch (...) {
+        sqlite3_close(m_db);
+        m_db = nullptr;
+        throw;
+    }
+}
+
+
+/*
+ * ~JobQueue()
+ */
+JobQueue::~JobQueue()
+{
+    if (m_db) {
+        sqlite3_close(m_db);
+        m_db = nullptr;
+    }
+}
+
+
+/*
+ * enqueue()
+ */
+uint64_t JobQueue::enqueue(const std::string &device, const Sha256::Digest &job_hash)
+{
+    const std::string hex = Sha256::to_hex(job_hash);
+    // an aggregate without rows returns NULL, so the first job of a device gets position 0
+    sqlite3_stmt *stmt = prepare("INSERT INTO job_queue (device, position, job_hash) "
+                                 "SELECT ?1, COALESCE(MAX(position) + 1, 0), ?2 FROM job_queue WHERE device = ?1",
+                                 __func__);
+    check(stmt, sqlite3_bind_text(stmt, 1, device.data(), device.size(), SQLITE_TRANSIENT), SQLITE_OK, __func__, "bind device");
+    check(stmt, sqlite3_bind_text(stmt, 2, hex.data(), hex.size(), SQLITE_TRANSIENT), SQLITE_OK, __func__, "bind job hash");
+    check(stmt, sqlite3_step(stmt), SQLITE_DONE, __func__, "execute INSERT statement");
+    sqlite3_finalize(stmt);
+    return sqlite3_last_insert_rowid(m_db);
+}
+
+
+/*
+ * jobs()
+ */
+std::vector<JobQueue::Entry> JobQueue::jobs(const std::string &device)
+{
+    sqlite3_stmt *stmt = prepare("SELECT id, job_hash FROM job_queue WHERE device = ?1 ORDER BY position, id", __func__);
+    check(stmt, sqlite3_bind_text(stmt, 1, device.data(), device.size(), SQLITE_TRANSIENT), SQLITE_OK, __func__, "bind device");
+
+    std::vector<Entry> entries;
+    int ret;
+    while (SQLITE_ROW == (ret = sqlite3_step(stmt))) {
+        Entry entry;
+        entry.id = sqlite3_column_int64(stmt, 0);
+        const char *hex = (const char *)sqlite3_column_text(stmt, 1);
+        // a damaged entry is skipped, it can still be removed by its id
+        if (!hex || !Sha256::from_hex(hex, entry.job_hash)) {
+            continue;
+        }
+        entries.push_back(entry);
+    }
+    check(stmt, ret, SQLITE_DONE, __func__, "execute SELECT statement");
+    sqlite3_finalize(stmt);
+    return entries;
+}
+
+
+/*
+ * all_jobs()
+ */
+std::vector<Sha256::Digest> JobQueue::all_jobs()
+{
+    sqlite3_stmt *stmt = prepare("SELECT job_hash FROM job_queue", __func__);
+
+    std::vector<Sha256::Digest> hashes;
+    int ret;
+    while (SQLITE_ROW == (ret = sqlite3_step(stmt))) {
+        Sha256::Digest hash;
+        const char *hex = (const char *)sqlite3_column_text(stmt, 0);
+        if (hex && Sha256::from_hex(hex, hash)) {
+            hashes.push_back(hash);
+        }
+    }
+    check(stmt, ret, SQLITE_DONE, __func__, "execute SELECT statement");
+    sqlite3_finalize(stmt);
+    return hashes;
+}
+
+
+/*
+ * remove()
+ */
+bool JobQueue::remove(const std::string &device, uint64_t id)
+{
+    sqlite3_stmt *stmt = prepare("DELETE FROM job_queue WHERE device = ?1 AND id = ?2", __func__);
+    check(stmt, sqlite3_bind_text(stmt, 1, device.data(), device.size(), SQLITE_TRANSIENT), SQLITE_OK, __func__, "bind device");
+    check(stmt, sqlite3_bind_int64(stmt, 2, id), SQLITE_OK, __func__, "bind id");
+    check(stmt, sqlite3_step(stmt), SQLITE_DONE, __func__, "execute DELETE statement");
+    sqlite3_finalize(stmt);
+    return 0 < sqlite3_changes(m_db);
+}
+
+
+/*
+ * move()
+ */
+bool JobQueue::move(const std::string &device, uint64_t id, size_t position)
+{
+    // the positions of all jobs of the device are written again in one transaction
+    exec("BEGIN IMMEDIATE", __func__);
+    try {
+        std::vector<uint64_t> ids;
+        for (const auto &entry: jobs(device)) {
+            ids.push_back(entry.id);
+        }
+        auto iter = std::find(ids.begin(), ids.end(), id);
+        if (ids.end() == iter) {
+            exec("ROLLBACK", __func__);
+            return false;
+        }
+        ids.erase(iter);
+        ids.insert(ids.begin() + std::min(position, ids.size()), id);
+
+        sqlite3_stmt *stmt = prepare("UPDATE job_queue SET position = ?1 WHERE id = ?2", __func__);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            check(stmt, sqlite3_bind_int64(stmt, 1, i), SQLITE_OK, __func__, "bind position");
+            check(stmt, sqlite3_bind_int64(stmt, 2, ids[i]), SQLITE_OK, __func__, "bind id");
+            check(stmt, sqlite3_step(stmt), SQLITE_DONE, __func__, "execute UPDATE statement");
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        exec("COMMIT", __func__);
+    } catch (...) {
+        sqlite3_exec(m_db, "ROLLBACK", NULL, NULL, NULL);
+        throw;
+    }
+    return true;
+}
+
+
+/*
+ * prepare()
+ */
+sqlite3_stmt *JobQueue::prepare(const std::string &s_stmt, const char *func)
+{
+    sqlite3_stmt *stmt;
+    const int ret = sqlite3_prepare_v2(m_db,
+                                       s_stmt.data(),
+                                       s_stmt.size(),
+                                       &stmt,
+                                       NULL);
+    if (SQLITE_OK != ret) {
+        sqlite3_finalize(stmt);
+        std::string err = "JobQueue::";
+        err += func;
+        err += "(): Failed to prepare statement: ";
+        err += sqlite3_errmsg(m_db);
+        throw std::runtime_error(err);
+    }
+    return stmt;
+}
+
+
+/*
+ * check()
+ */
+void JobQueue::check(sqlite3_stmt *stmt, int ret, int expected, const char *func, const char *what)
+{
+    if (expected == ret) {
+        return;
+    }
+    std::string err = "JobQueue::";
+    err += func;
+    err += "(): Failed to ";
+    err += what;
+    err += ": ";
+    err += sqlite3_errmsg(m_db);
+    sqlite3_finalize(stmt);
+    throw std::runtime_error(err);
+}
+
+
+/*
+ * exec()
+ */
+void JobQueue::exec(const char *s_stmt, const char *func)
+{
+    if (SQLITE_OK != sqlite3_exec(m_db, s_stmt, NULL, NULL, NULL)) {
+        std::string err = "JobQueue::";
+        err += func;
+        err += "(): Failed to execute '";
+        err += s_stmt;
+        err += "': ";
+        err += sqlite3_errmsg(m_db);
+        throw std::runtime_error(err);
+    }
+}
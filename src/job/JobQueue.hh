@@ -0,0 +1,84 @@
+#ifndef __JOB_QUEUE_HH__
+#define __JOB_QUEUE_HH__
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+#include <sqlite3.h>
+#include "Sha256.hh"
+
+/**
+ * Persistent print job queues of the devices.
+ *
+ * The queues are stored in an SQLite database, so they survive restarts of the daemon. A queued
+ * job is referenced by its hash (see GcodeJob::content_hash()), the job itself is kept in the
+ * job cache (see JobCache::pin()). Every queued job gets an id, which is unique across all
+ * queues and never reused, so a client can't move or cancel another job by accident.
+ *
+ * All methods throw an std::runtime_error, if the database fails. The class is not thread safe.
+ */
+class JobQueue {
+    public:
+        struct Entry {
+            uint64_t id;
+            Sha256::Digest job_hash;
+        };
+
+        JobQueue(const JobQueue &) = delete;
+        JobQueue &operator=(const JobQueue &) = delete;
+
+        /**
+         * Opens the database in the given file, which is created if necessary.
+         */
+        explicit JobQueue(const std::filesystem::path &file);
+        ~JobQueue();
+
+        /**
+         * Appends the job to the queue of the device and returns the id of the entry.
+         */
+        uint64_t enqueue(const std::string &device, const Sha256::Digest &job_hash);
+
+        /**
+         * Returns the queued jobs of the device, the next job first.
+         */
+        std::vector<Entry> jobs(const std::string &device);
+
+        /**
+         * Returns the queued jobs of all devices, i.e. to pin them in the job cache.
+         */
+        std::vector<Sha256::Digest> all_jobs();
+
+        /**
+         * Removes the entry with the given id from the queue of the device. Returns false, if the
+         * device has no such entry.
+         */
+        bool remove(const std::string &device, uint64_t id);
+
+        /**
+         * Moves the entry with the given id to the given position in the queue of the device. 0
+         * is the next job, a position beyond the end moves the entry to the end. Returns false, if
+         * the device has no such entry.
+         */
+        bool move(const std::string &device, uint64_t id, size_t position);
+
+    private:
+        /**
+         * Prepares the statement or throws an std::runtime_error, which names the calling
+         * function.
+         */
+        sqlite3_stmt *prepare(const std::string &s_stmt, const char *func);
+
+        /**
+         * Finalizes the statement and throws an std::runtime_error, if ret is not the expected
+         * result.
+         */
+        void check(sqlite3_stmt *stmt, int ret, int expected, const char *func, const char *what);
+
+        void exec(const char *s_stmt, const char *func);
+
+    private:
+        sqlite3 *m_db;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "JobUpload.hh"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/*
+ * JobUpload()
+ */
+JobUpload::JobUpload(const std::filesystem::path &dir,
+                     uint64_t total_size,
+                     const std::optional<Sha256::Digest> &job_hash,
+                     Compression::Type compression)
+    : m_total_size(total_size),
+      m_received(0),
+      m_next_sequence(0),
+      m_last_activity(std::chrono::steady_clock::now()),
+      m_job_hash(job_hash),
+      m_compression(compression)
+{
+    std::string path = (dir / "gcoded_upload_XXXXXX").string();
+    m_fd = mkostemp(path.data(), O_CLOEXEC);
+    if (0 > m_fd) {
+        std::string err = "Could not create spool file in '" + dir.string() + "': ";
+        err += std::strerror(errno);
+        throw std::runtime_error(err);
+    }
+    m_file_path = path;
+}
+
+
+/*
+ * ~JobUpload()
+ */
+JobUpload::~JobUpload()
+{
+    close(m_fd);
+    unlink(m_file_path.c_str());
+}
+
+
+/*
+ * append()
+ */
+bool JobUpload::append(uint32_t sequence, std::string_view data, Compression::Type compression)
+{
+    if (sequence != m_next_sequence) {
+        return false;
+    }
+
+    const uint64_t old_received = m_received;
+    const Sha256 old_sha = m_sha;
+    try {
+        // the decompressed data is written in blocks, it is never held in memory as a whole
+        Compression::decompress(compression, data, [this](std::string_view block) {
+            write_data(block);
+        });
+    } catch (const std::exception &) {
+        // drop the written part of the chunk
+        if (   0 != ftruncate(m_fd, old_received)
+            || 0 > lseek(m_fd, old_received, SEEK_SET)) {
+            std::string err = "Could not truncate spool file '" + m_file_path + "': ";
+            err += std::strerror(errno);
+            throw std::runtime_error(err);
+        }
+        m_received = old_received;
+        m_sha = old_sha;
+        throw;
+    }
+    m_next_sequence++;
+    m_last_activity = std::chrono::steady_clock::now();
+    return true;
+}
+
+
+/*
+ * write_data()
+ */
+void JobUpload::write_data(std::string_view data)
+{
+    // checked for every block, so a small compressed chunk can't fill the disk
+    if (m_total_size - m_received < data.size()) {
+        throw std::runtime_error("Upload exceeds the announced size of " + std::to_string(m_total_size) + " bytes.");
+    }
+
+    m_sha.update(data);
+    while (!data.empty()) {
+        const ssize_t n = write(m_fd, data.data(), data.size());
+        if (0 > n) {
+            if (EINTR == errno) {
+                continue;
+            }
+            std::string err = "Could not write spool file '" + m_file_path + "': ";
+            err += std::strerror(errno);
+            throw std::runtime_error(err);
+        }
+        data.remove_prefix(n);
+        m_received += n;
+    }
+}
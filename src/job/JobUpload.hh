@@ -0,0 +1,119 @@
+#ifndef __JOB_UPLOAD_HH__
+#define __JOB_UPLOAD_HH__
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <chrono>
+#include <optional>
+#include <cstdint>
+#include "Sha256.hh"
+#include "Compression.hh"
+
+/**
+ * Receiver of a print job, which is uploaded in numbered chunks.
+ *
+ * Each chunk is written to a spool file immediately, so the memory consumption is independent
+ * of the size of the job. The chunks have to arrive in order. A chunk with another sequence
+ * number than next_sequence() is dropped, the sender has to resend all chunks starting at
+ * next_sequence() (go-back-N). The spool file is removed by the destructor. A job loaded with
+ * GcodeJob::from_file() stays valid after that, since the mapping keeps the file referenced.
+ */
+class JobUpload {
+    public:
+        JobUpload(const JobUpload &) = delete;
+        JobUpload(JobUpload &&) = delete;
+        JobUpload &operator=(const JobUpload &) = delete;
+
+        /**
+         * Creates a spool file for a job of total_size bytes in the given directory. job_hash is
+         * the hash announced by the sender, which has to be checked against content_hash().
+         * compression is the compression negotiated with the sender (see compression()).
+         * Throws an std::runtime_error, if the file can't be created.
+         */
+        JobUpload(const std::filesystem::path &dir,
+                  uint64_t total_size,
+                  const std::optional<Sha256::Digest> &job_hash = std::nullopt,
+                  Compression::Type compression = Compression::Type::NONE);
+        ~JobUpload();
+
+        /**
+         * Appends the data of the chunk with the given sequence number to the spool file. The
+         * data is decompressed as a complete stream of the given compression, the announced size
+         * and the hash refer to the decompressed data. Returns false, if the chunk is not the
+         * next expected one. Throws an std::runtime_error, if the data exceeds the announced
+         * size, is corrupted or the spool file can't be written. In this case, nothing of the
+         * chunk is appended, so it can be sent again.
+         */
+        bool append(uint32_t sequence,
+                    std::string_view data,
+                    Compression::Type compression = Compression::Type::NONE);
+
+        /**
+         * Returns true, if the given number of chunks and bytes are received completely.
+         */
+        bool complete(uint32_t chunk_count, uint64_t total_size) const
+        {
+            return chunk_count == m_next_sequence && total_size == m_total_size && m_received == m_total_size;
+        }
+
+        uint32_t next_sequence() const
+        {
+            return m_next_sequence;
+        }
+
+        uint64_t received() const
+        {
+            return m_received;
+        }
+
+        const std::string &file_path() const
+        {
+            return m_file_path;
+        }
+
+        const std::optional<Sha256::Digest> &job_hash() const
+        {
+            return m_job_hash;
+        }
+
+        /**
+         * Returns the compression, which the sender should use for the chunks.
+         */
+        Compression::Type compression() const
+        {
+            return m_compression;
+        }
+
+        /**
+         * Returns the SHA-256 of the data received so far.
+         */
+        Sha256::Digest content_hash() const
+        {
+            return m_sha.digest();
+        }
+
+        /**
+         * Returns the time of the creation or the last appended chunk.
+         */
+        std::chrono::steady_clock::time_point last_activity() const
+        {
+            return m_last_activity;
+        }
+
+    private:
+        void write_data(std::string_view data);
+
+    private:
+        std::string m_file_path;
+        int m_fd;
+        uint64_t m_total_size;
+        uint64_t m_received;
+        uint32_t m_next_sequence;
+        std::chrono::steady_clock::time_point m_last_activity;
+        std::optional<Sha256::Digest> m_job_hash;
+        Compression::Type m_compression;
+        Sha256 m_sha;
+};
+
+#endif
@@ -0,0 +1,294 @@
+#include "PrintCheckpoint.hh"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <stdexcept>
+
+static constexpr uint32_t RECORD_MAGIC = 0x50434347; // "GCCP"
+static constexpr uint32_t RECORD_VERSION = 1;
+static constexpr char AXIS_LETTERS[] = { 'X', 'Y', 'Z', 'E' };
+// feed rates of the moves to the print in mm/min
+static constexpr double RESUME_XY_FEEDRATE = 3000.0;
+static constexpr double RESUME_Z_FEEDRATE = 600.0;
+
+namespace {
+
+/**
+ * A slot of the checkpoint file.
+ */
+struct record {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sequence;
+    uint8_t job_hash[32];
+    uint64_t line;
+    float position[4];
+    float temp_extruder;
+    float temp_bed;
+    uint8_t has_position;
+    uint8_t reserved[7];
+    // FNV-1a of all previous bytes
+    uint64_t checksum;
+};
+
+
+/*
+ * checksum()
+ */
+uint64_t checksum(const struct record &rec)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&rec);
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < offsetof(struct record, checksum); ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+
+/*
+ * append_command()
+ */
+void append_command(std::string &gcode, const char *format, double value)
+{
+    char line[64];
+    snprintf(line, sizeof(line), format, value);
+    gcode += line;
+    gcode += '\n';
+}
+
+}
+
+
+/*
+ * store()
+ */
+void PrintCheckpoint::store(int fd, uint64_t sequence) const
+{
+    struct record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = RECORD_MAGIC;
+    rec.version = RECORD_VERSION;
+    rec.sequence = sequence;
+    memcpy(rec.job_hash, job_hash.data(), sizeof(rec.job_hash));
+    rec.line = line;
+    memcpy(rec.position, position, sizeof(rec.position));
+    rec.temp_extruder = temp_extruder;
+    rec.temp_bed = temp_bed;
+    rec.has_position = has_position;
+    rec.checksum = checksum(rec);
+
+    // the other slot keeps the previous checkpoint, until this one is on the disk
+    const off_t offset = (sequence % 2) * sizeof(rec);
+    if (sizeof(rec) != pwrite(fd, &rec, sizeof(rec), offset)) {
+        throw std::runtime_error(std::string("Could not write checkpoint: ") + strerror(errno));
+    }
+    if (0 != fdatasync(fd)) {
+        throw std::runtime_error(std::string("Could not synchronize checkpoint: ") + strerror(errno));
+    }
+}
+
+
+/*
+ * load()
+ */
+std::optional<PrintCheckpoint> PrintCheckpoint::load(const std::filesystem::path &file)
+{
+    const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (0 > fd) {
+        return std::nullopt;
+    }
+    std::optional<struct record> latest;
+    for (int slot = 0; slot < 2; ++slot) {
+        struct record rec;
+        if (   sizeof(rec) != pread(fd, &rec, sizeof(rec), slot * sizeof(rec))
+            || RECORD_MAGIC != rec.magic
+            || RECORD_VERSION != rec.version
+            || checksum(rec) != rec.checksum) {
+            continue;
+        }
+        if (!latest || rec.sequence > latest->sequence) {
+            latest = rec;
+        }
+    }
+    close(fd);
+    if (!latest) {
+        return std::nullopt;
+    }
+
+    PrintCheckpoint checkpoint;
+    memcpy(checkpoint.job_hash.data(), latest->job_hash, checkpoint.job_hash.size());
+    checkpoint.line = latest->line;
+    checkpoint.has_position = latest->has_position;
+    memcpy(checkpoint.position, latest->position, sizeof(checkpoint.position));
+    checkpoint.temp_extruder = latest->temp_extruder;
+    checkpoint.temp_bed = latest->temp_bed;
+    return checkpoint;
+}
+
+
+/*
+ * path()
+ */
+std::filesystem::path PrintCheckpoint::path(const std::filesystem::path &dir, const std::string &device)
+{
+    return dir / (device + ".checkpoint");
+}
+
+
+/*
+ * resume_gcode()
+ */
+std::string PrintCheckpoint::resume_gcode(const GcodeJob &job) const
+{
+    if (line > job.size()) {
+        throw std::runtime_error("The checkpoint is beyond the end of the job.");
+    }
+
+    // the state of the printer after the commands before the checkpoint
+    double pos[4] = { 0.0, 0.0, 0.0, 0.0 };
+    bool known[4] = { false, false, false, false };
+    bool relative = false;
+    bool relative_e = false;
+    std::optional<double> feedrate;
+    std::optional<double> fan;
+    double extruder = 0.0;
+    double bed = 0.0;
+
+    BinaryGcode::Command command;
+    for (size_t i = 0; i < line; ++i) {
+        if (!job.command(i, command) || 0 == command.word_count) {
+            continue;
+        }
+        if (command.is('G', 0) || command.is('G', 1) || command.is('G', 2) || command.is('G', 3)) {
+            for (size_t w = 1; w < command.word_count; ++w) {
+                const BinaryGcode::Word &word = command.words[w];
+                if (!word.has_value) {
+                    continue;
+                }
+                if ('F' == word.letter) {
+                    feedrate = word.value();
+                    continue;
+                }
+                for (size_t axis = 0; axis < 4; ++axis) {
+                    if (AXIS_LETTERS[axis] != word.letter) {
+                        continue;
+                    }
+                    if (relative || (3 == axis && relative_e)) {
+                        pos[axis] += word.value();
+                    } else {
+                        pos[axis] = word.value();
+                        known[axis] = true;
+                    }
+                }
+            }
+        } else if (command.is('G', 28)) {
+            const bool all = !command.find('X') && !command.find('Y') && !command.find('Z');
+            for (size_t axis = 0; axis < 3; ++axis) {
+                if (all || command.find(AXIS_LETTERS[axis])) {
+                    pos[axis] = 0.0;
+                    known[axis] = true;
+                }
+            }
+        } else if (command.is('G', 90)) {
+            relative = false;
+            relative_e = false;
+        } else if (command.is('G', 91)) {
+            relative = true;
+        } else if (command.is('G', 92)) {
+            for (size_t axis = 0; axis < 4; ++axis) {
+                const BinaryGcode::Word *word = command.find(AXIS_LETTERS[axis]);
+                if (word && word->has_value) {
+                    pos[axis] = word->value();
+                    known[axis] = true;
+                }
+            }
+        } else if (command.is('M', 82)) {
+            relative_e = false;
+        } else if (command.is('M', 83)) {
+            relative_e = true;
+        } else if (command.is('M', 104) || command.is('M', 109) || command.is('M', 140) || command.is('M', 190)) {
+            const BinaryGcode::Word *word = command.find('S');
+            if (!word) {
+                word = command.find('R');
+            }
+            if (word && word->has_value) {
+                ((command.is('M', 140) || command.is('M', 190)) ? (bed) : (extruder)) = word->value();
+            }
+        } else if (command.is('M', 106)) {
+            const BinaryGcode::Word *word = command.find('S');
+            fan = (word && word->has_value) ? (word->value()) : (255.0);
+        } else if (command.is('M', 107)) {
+            fan = 0.0;
+        }
+    }
+
+    // the reported values are used, if the job doesn't tell the position
+    for (size_t axis = 0; axis < 4; ++axis) {
+        if (!known[axis] && has_position) {
+            pos[axis] = position[axis];
+            known[axis] = true;
+        }
+    }
+    // the reported set points are the latest ones, they include changes on the printer
+    if (0.0f < temp_extruder) {
+        extruder = temp_extruder;
+    }
+    if (0.0f < temp_bed) {
+        bed = temp_bed;
+    }
+
+    std::string gcode;
+    // all heaters are switched on at once
+    if (0.0 < bed) {
+        append_command(gcode, "M140 S%.0f", bed);
+    }
+    if (0.0 < extruder) {
+        append_command(gcode, "M104 S%.0f", extruder);
+    }
+    // the nozzle is still at the height of the print
+    if (known[2]) {
+        append_command(gcode, "G92 Z%.3f", pos[2]);
+    }
+    gcode += "G91\n";
+    append_command(gcode, "G1 Z%.3f F600", RESUME_LIFT);
+    gcode += "G90\n";
+    gcode += "G28 X Y\n";
+    if (0.0 < bed) {
+        append_command(gcode, "M190 S%.0f", bed);
+    }
+    if (0.0 < extruder) {
+        append_command(gcode, "M109 S%.0f", extruder);
+    }
+    if (known[0] && known[1]) {
+        char move[96];
+        snprintf(move, sizeof(move), "G1 X%.3f Y%.3f F%.0f\n", pos[0], pos[1], RESUME_XY_FEEDRATE);
+        gcode += move;
+    }
+    if (known[2]) {
+        char move[64];
+        snprintf(move, sizeof(move), "G1 Z%.3f F%.0f\n", pos[2], RESUME_Z_FEEDRATE);
+        gcode += move;
+    }
+    if (known[3]) {
+        append_command(gcode, "G92 E%.5f", pos[3]);
+    }
+    gcode += (relative_e) ? ("M83\n") : ("M82\n");
+    if (relative) {
+        gcode += "G91\n";
+    }
+    if (fan) {
+        if (0.0 < *fan) {
+            append_command(gcode, "M106 S%.0f", *fan);
+        } else {
+            gcode += "M107\n";
+        }
+    }
+    if (feedrate) {
+        append_command(gcode, "G1 F%.0f", *feedrate);
+    }
+    return gcode;
+}
@@ -0,0 +1,79 @@
+#ifndef __PRINT_CHECKPOINT_HH__
+#define __PRINT_CHECKPOINT_HH__
+
+#include <string>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+#include <cstddef>
+#include "Sha256.hh"
+#include "GcodeJob.hh"
+
+/**
+ * The state of a print job, which is needed to resume the print after the connection to the
+ * printer got lost (i.e. a USB glitch or a power loss of the printer).
+ *
+ * A checkpoint is stored in a file of a fixed size with two slots, which are written
+ * alternately (see store()). A checkpoint, which is torn by a crash while writing, is detected
+ * by its checksum and the checkpoint of the other slot is used.
+ */
+struct PrintCheckpoint {
+    // hash of the print job (see GcodeJob::content_hash())
+    Sha256::Digest job_hash;
+    // number of acknowledged commands, the print is resumed with the command of this index
+    uint64_t line;
+    // last reported position of the axes X, Y, Z and E in mm
+    bool has_position;
+    float position[4];
+    // last reported set points of the temperatures in celsius, 0 if the heater is off
+    float temp_extruder;
+    float temp_bed;
+
+    PrintCheckpoint()
+        : job_hash{},
+          line(0),
+          has_position(false),
+          position{ 0.0f, 0.0f, 0.0f, 0.0f },
+          temp_extruder(0.0f),
+          temp_bed(0.0f)
+    {}
+
+    /**
+     * Writes the checkpoint into the slot of the given sequence number of the opened file and
+     * synchronizes it to the disk. The sequence number has to increase with each call, the
+     * checkpoint with the highest sequence number is loaded. This doesn't allocate memory.
+     * Throws an std::runtime_error, if the checkpoint can't be written.
+     */
+    void store(int fd, uint64_t sequence) const;
+
+    /**
+     * Loads the latest valid checkpoint from the file. Returns std::nullopt, if the file
+     * doesn't exist or doesn't contain a valid checkpoint.
+     */
+    static std::optional<PrintCheckpoint> load(const std::filesystem::path &file);
+
+    /**
+     * Returns the path of the checkpoint file of a device.
+     */
+    static std::filesystem::path path(const std::filesystem::path &dir, const std::string &device);
+
+    /**
+     * Returns the commands, which bring the printer into the state of the job at the checkpoint,
+     * so the print continues with the command at index line. The state (position, modes of the
+     * positioning, feed rate, fan and temperatures) is derived from the commands of the job
+     * before the checkpoint. The reported values of the checkpoint are used, if the job doesn't
+     * tell them.
+     *
+     * The Z axis isn't homed, since the probe would hit the printed part. The current height is
+     * set to the one of the checkpoint, the nozzle is lifted and only X and Y are homed. The
+     * printer is heated up, before the nozzle returns to the print.
+     *
+     * Throws an std::runtime_error, if the checkpoint is beyond the end of the job.
+     */
+    std::string resume_gcode(const GcodeJob &job) const;
+
+    // the nozzle is lifted by this distance in mm before X and Y are homed
+    static constexpr double RESUME_LIFT = 2.0;
+};
+
+#endif
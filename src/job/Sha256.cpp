@@ -0,0 +1,187 @@
+#include "Sha256.hh"
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotr(uint32_t x, unsigned n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+}
+
+
+/*
+ * Sha256()
+ */
+Sha256::Sha256()
+    : m_state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+      m_block_len(0),
+      m_total_len(0)
+{}
+
+
+/*
+ * update()
+ */
+void Sha256::update(std::string_view data)
+{
+    const uint8_t *pos = reinterpret_cast<const uint8_t *>(data.data());
+    size_t len = data.size();
+    m_total_len += len;
+
+    if (m_block_len) {
+        const size_t n = std::min(len, sizeof(m_block) - m_block_len);
+        memcpy(m_block + m_block_len, pos, n);
+        m_block_len += n;
+        pos += n;
+        len -= n;
+        if (sizeof(m_block) != m_block_len) {
+            return;
+        }
+        transform(m_block);
+        m_block_len = 0;
+    }
+    // full blocks are hashed directly from the input
+    while (len >= sizeof(m_block)) {
+        transform(pos);
+        pos += sizeof(m_block);
+        len -= sizeof(m_block);
+    }
+    memcpy(m_block, pos, len);
+    m_block_len = len;
+}
+
+
+/*
+ * digest()
+ */
+Sha256::Digest Sha256::digest() const
+{
+    Sha256 final(*this);
+    const uint64_t bit_len = m_total_len * 8;
+
+    // padding: 0x80, zeros and the message length in bits, so the message ends on a block
+    uint8_t padding[72] = { 0x80 };
+    const size_t padding_len = (m_block_len < 56) ? (56 - m_block_len) : (120 - m_block_len);
+    for (unsigned i = 0; i < 8; ++i) {
+        padding[padding_len + i] = bit_len >> (56 - 8 * i);
+    }
+    final.update(std::string_view(reinterpret_cast<const char *>(padding), padding_len + 8));
+
+    Digest digest;
+    for (unsigned i = 0; i < 8; ++i) {
+        digest[4 * i] = final.m_state[i] >> 24;
+        digest[4 * i + 1] = final.m_state[i] >> 16;
+        digest[4 * i + 2] = final.m_state[i] >> 8;
+        digest[4 * i + 3] = final.m_state[i];
+    }
+    return digest;
+}
+
+
+/*
+ * to_hex()
+ */
+std::string Sha256::to_hex(const Digest &digest)
+{
+    static const char hex_chars[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(2 * digest.size());
+    for (uint8_t byte: digest) {
+        hex += hex_chars[byte >> 4];
+        hex += hex_chars[byte & 0xf];
+    }
+    return hex;
+}
+
+
+/*
+ * from_hex()
+ */
+bool Sha256::from_hex(std::string_view hex, Digest &digest)
+{
+    if (2 * digest.size() != hex.size()) {
+        return false;
+    }
+    auto nibble = [](char c) -> int {
+        if ('0' <= c && c <= '9') {
+            return c - '0';
+        } else if ('a' <= c && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    };
+    for (size_t i = 0; i < digest.size(); ++i) {
+        const int high = nibble(hex[2 * i]);
+        const int low = nibble(hex[2 * i + 1]);
+        if (0 > high || 0 > low) {
+            return false;
+        }
+        digest[i] = (high << 4) | low;
+    }
+    return true;
+}
+
+
+/*
+ * transform()
+ */
+void Sha256::transform(const uint8_t *block)
+{
+    uint32_t w[64];
+    for (unsigned i = 0; i < 16; ++i) {
+        w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16)
+             | (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+    }
+    for (unsigned i = 16; i < 64; ++i) {
+        const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = m_state[0];
+    uint32_t b = m_state[1];
+    uint32_t c = m_state[2];
+    uint32_t d = m_state[3];
+    uint32_t e = m_state[4];
+    uint32_t f = m_state[5];
+    uint32_t g = m_state[6];
+    uint32_t h = m_state[7];
+    for (unsigned i = 0; i < 64; ++i) {
+        const uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        const uint32_t ch = (e & f) ^ (~e & g);
+        const uint32_t t1 = h + s1 + ch + K[i] + w[i];
+        const uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
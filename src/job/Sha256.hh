@@ -0,0 +1,52 @@
+#ifndef __SHA256_HH__
+#define __SHA256_HH__
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Incremental SHA-256 (FIPS 180-4).
+ *
+ * Used to identify print jobs by their content (see JobCache). The data can be passed in
+ * arbitrary pieces with update(), so a job never has to be held in memory as a whole.
+ */
+class Sha256 {
+    public:
+        typedef std::array<uint8_t, 32> Digest;
+
+        Sha256();
+
+        /**
+         * Adds data to the hash.
+         */
+        void update(std::string_view data);
+
+        /**
+         * Returns the hash of all data added so far. Further data can still be added afterwards.
+         */
+        Digest digest() const;
+
+        /**
+         * Returns the digest as lower case hexadecimal string.
+         */
+        static std::string to_hex(const Digest &digest);
+
+        /**
+         * Parses a digest from a hexadecimal string. Returns false, if hex is not a valid digest.
+         */
+        static bool from_hex(std::string_view hex, Digest &digest);
+
+    private:
+        void transform(const uint8_t *block);
+
+    private:
+        uint32_t m_state[8];
+        uint8_t m_block[64];
+        size_t m_block_len;
+        uint64_t m_total_len;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "MsgJobQueue.hh"
+#include <stdexcept>
+
+/*
+ * MsgJobQueue()
+ */
+MsgJobQueue::MsgJobQueue()
+    : m_type(MsgType::Type::JOB_QUEUE)
+{
+    m_msg.job_count = 0;
+}
+
+
+/*
+ * encode()
+ */
+void MsgJobQueue::encode(std::vector<char> &encoded_msg) const
+{
+    m_type.encode(encoded_msg);
+    encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
+    for (const auto &job: m_jobs) {
+        struct header_job header;
+        memset(&header, 0, sizeof(header));
+        header.id = job.id;
+        memcpy(header.job_hash, job.job_hash.data(), sizeof(header.job_hash));
+        encoded_msg.insert(encoded_msg.end(), (char *)&header, ((char *)&header) + sizeof(header));
+    }
+}
+
+
+/*
+ * decode()
+ */
+size_t MsgJobQueue::decode(const std::vector<char> &encoded_msg)
+{
+    size_t pos = m_type.decode(encoded_msg);
+    if (m_type.type() != MsgType::Type::JOB_QUEUE) {
+        throw std::runtime_error("MsgJobQueue::decode(): Wrong message type.");
+    }
+    if (encoded_msg.size() - pos < sizeof(m_msg)) {
+        throw std::runtime_error("MsgJobQueue::decode(): Invalid encoded message: message to short");
+    }
+    memcpy(&m_msg, encoded_msg.data() + pos, sizeof(m_msg));
+    pos += sizeof(m_msg);
+    if ((encoded_msg.size() - pos) / sizeof(struct header_job) != m_msg.job_count
+        || 0 != (encoded_msg.size() - pos) % sizeof(struct header_job)) {
+        throw std::runtime_error("MsgJobQueue::decode(): Invalid encoded message: length fields does not add up the the exact message size.");
+    }
+
+    m_jobs.clear();
+    m_jobs.reserve(m_msg.job_count);
+    for (uint32_t i = 0; i < m_msg.job_count; ++i) {
+        struct header_job header;
+        memcpy(&header, encoded_msg.data() + pos, sizeof(header));
+        pos += sizeof(header);
+        Job job;
+        job.id = header.id;
+        memcpy(job.job_hash.data(), header.job_hash, job.job_hash.size());
+        m_jobs.push_back(job);
+    }
+    return pos;
+}
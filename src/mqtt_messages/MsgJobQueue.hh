@@ -0,0 +1,70 @@
+#ifndef __MSG_JOB_QUEUE_HH__
+#define __MSG_JOB_QUEUE_HH__
+
+#include <vector>
+#include "Msg.hh"
+#include "MsgType.hh"
+#include "job/Sha256.hh"
+
+/**
+ * The job queue of a device (see JobQueue), sent by the daemon as retained message after every
+ * change of the queue. The next job is the first one.
+ */
+class MsgJobQueue : public Msg {
+    public:
+        struct Job {
+            // the id of the queue entry, which is used to move or cancel it (see MsgJobQueueRequest)
+            uint64_t id;
+            Sha256::Digest job_hash;
+
+            bool operator==(const Job &b) const
+            {
+                return id == b.id && job_hash == b.job_hash;
+            }
+        };
+
+        MsgJobQueue();
+        virtual ~MsgJobQueue() {};
+
+        struct header_msg {
+            uint32_t job_count;
+        };
+
+        struct header_job {
+            uint64_t id;
+            uint8_t job_hash[32];
+        };
+
+        bool operator==(const MsgJobQueue &b)
+        {
+            return    m_type == b.m_type
+                   && 0 == memcmp(&m_msg, &b.m_msg, sizeof(m_msg))
+                   && m_jobs == b.m_jobs;
+        }
+
+        bool operator!=(const MsgJobQueue &b)
+        {
+            return !(*this == b);
+        }
+
+        void encode(std::vector<char> &encoded_msg) const override;
+        size_t decode(const std::vector<char> &encoded_msg) override;
+
+        void add_job(uint64_t id, const Sha256::Digest &job_hash)
+        {
+            m_jobs.push_back({ id, job_hash });
+            m_msg.job_count = m_jobs.size();
+        }
+
+        const std::vector<Job> &jobs() const
+        {
+            return m_jobs;
+        }
+
+    private:
+        MsgType m_type;
+        struct header_msg m_msg;
+        std::vector<Job> m_jobs;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "MsgJobQueueRequest.hh"
+#include <stdexcept>
+
+/*
+ * MsgJobQueueRequest()
+ */
+MsgJobQueueRequest::MsgJobQueueRequest()
+    : MsgJobQueueRequest(Action::CANCEL, 0)
+{
+}
+
+
+/*
+ * MsgJobQueueRequest()
+ */
+MsgJobQueueRequest::MsgJobQueueRequest(Action action, uint64_t job_id, uint32_t position)
+    : m_type(MsgType::Type::JOB_QUEUE_REQUEST)
+{
+    // the padding is part of the comparison in operator==()
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.job_id = job_id;
+    m_msg.position = position;
+    m_msg.action = static_cast<uint8_t>(action);
+}
+
+
+/*
+ * encode()
+ */
+void MsgJobQueueRequest::encode(std::vector<char> &encoded_msg) const
+{
+    m_type.encode(encoded_msg);
+    encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
+}
+
+
+/*
+ * decode()
+ */
+size_t MsgJobQueueRequest::decode(const std::vector<char> &encoded_msg)
+{
+    size_t pos = m_type.decode(encoded_msg);
+    if (m_type.type() != MsgType::Type::JOB_QUEUE_REQUEST) {
+        throw std::runtime_error("MsgJobQueueRequest::decode(): Wrong message type.");
+    }
+    if (encoded_msg.size() - pos < sizeof(m_msg)) {
+        throw std::runtime_error("MsgJobQueueRequest::decode(): Invalid encoded message: message to short");
+    }
+    memcpy(&m_msg, encoded_msg.data() + pos, sizeof(m_msg));
+    pos += sizeof(m_msg);
+    if (   static_cast<uint8_t>(Action::MOVE) != m_msg.action
+        && static_cast<uint8_t>(Action::CANCEL) != m_msg.action) {
+        throw std::runtime_error("MsgJobQueueRequest::decode(): Invalid encoded message: unknown action");
+    }
+    return pos;
+}
@@ -0,0 +1,62 @@
+#ifndef __MSG_JOB_QUEUE_REQUEST_HH__
+#define __MSG_JOB_QUEUE_REQUEST_HH__
+
+#include "Msg.hh"
+#include "MsgType.hh"
+
+/**
+ * Changes an entry of the job queue of a device, sent by a client. The entry is referenced by
+ * the id from MsgJobQueue. The daemon answers with the changed MsgJobQueue. Jobs are added to
+ * the queue with MsgPrint::set_enqueue().
+ */
+class MsgJobQueueRequest : public Msg {
+    public:
+        enum class Action {
+            // moves the job to the position (0 is the next job)
+            MOVE = 1,
+            // removes the job from the queue
+            CANCEL = 2
+        };
+
+        MsgJobQueueRequest();
+        MsgJobQueueRequest(Action action, uint64_t job_id, uint32_t position = 0);
+        virtual ~MsgJobQueueRequest() {};
+
+        struct header_msg {
+            uint64_t job_id;
+            uint32_t position;
+            uint8_t action;
+        };
+
+        bool operator==(const MsgJobQueueRequest &b)
+        {
+            return    m_type == b.m_type
+                   && 0 == memcmp(&m_msg, &b.m_msg, sizeof(m_msg));
+        }
+
+        bool operator!=(const MsgJobQueueRequest &b)
+        {
+            return !(*this == b);
+        }
+
+        void encode(std::vector<char> &encoded_msg) const override;
+        size_t decode(const std::vector<char> &encoded_msg) override;
+
+        Action action() const {
+            return static_cast<Action>(m_msg.action);
+        }
+
+        uint64_t job_id() const {
+            return m_msg.job_id;
+        }
+
+        uint32_t position() const {
+            return m_msg.position;
+        }
+
+    private:
+        MsgType m_type;
+        struct header_msg m_msg;
+};
+
+#endif
@@ -8,7 +8,7 @@
 MsgPrint::MsgPrint()
     : m_type(MsgType::Type::PRINT)
 {
-    m_msg.gcode_len = 0;
+    memset(&m_msg, 0, sizeof(m_msg));
     constexpr size_t len = sizeof(uint64_t);
     if (   len != getrandom(&m_msg.request_code_part1, len, 0)
         || len != getrandom(&m_msg.request_code_part2, len, 0)) {
@@ -20,12 +20,19 @@ MsgPrint::MsgPrint()
 /*
  * MsgPrint()
  */
-MsgPrint::MsgPrint(const std::string &gcode)
+MsgPrint::MsgPrint(const std::string &gcode, Compression::Type compression)
     : m_type(MsgType::Type::PRINT)
 { 
     // TODO: We allways copy the whole gcode ... this could be more efficient!
     m_gcode = gcode;
-    m_msg.gcode_len = gcode.size();
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.compression = static_cast<uint8_t>(compression);
+    if (Compression::Type::NONE != compression) {
+        Compression::compress(compression, gcode, m_compressed_gcode);
+        m_msg.gcode_len = m_compressed_gcode.size();
+    } else {
+        m_msg.gcode_len = gcode.size();
+    }
     constexpr size_t len = sizeof(uint64_t);
     if (   len != getrandom(&m_msg.request_code_part1, len, 0)
         || len != getrandom(&m_msg.request_code_part2, len, 0)) {
@@ -34,6 +41,37 @@ MsgPrint::MsgPrint(const std::string &gcode)
 }
 
 
+/*
+ * MsgPrint()
+ */
+MsgPrint::MsgPrint(const Sha256::Digest &job_hash)
+    : m_type(MsgType::Type::PRINT)
+{
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.has_job_hash = 1;
+    memcpy(m_msg.job_hash, job_hash.data(), sizeof(m_msg.job_hash));
+    constexpr size_t len = sizeof(uint64_t);
+    if (   len != getrandom(&m_msg.request_code_part1, len, 0)
+        || len != getrandom(&m_msg.request_code_part2, len, 0)) {
+        throw std::runtime_error("Could not get random number from OS for MsgPrint message!\n");
+    }
+}
+
+
+/*
+ * MsgPrint()
+ */
+MsgPrint::MsgPrint(uint64_t request_code_part1, uint64_t request_code_part2, const Sha256::Digest &job_hash)
+    : m_type(MsgType::Type::PRINT)
+{
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.request_code_part1 = request_code_part1;
+    m_msg.request_code_part2 = request_code_part2;
+    m_msg.has_job_hash = 1;
+    memcpy(m_msg.job_hash, job_hash.data(), sizeof(m_msg.job_hash));
+}
+
+
 /*
  * encode()
  */
@@ -42,7 +80,9 @@ void MsgPrint::encode(std::vector<char> &encoded_msg) const
     m_type.encode(encoded_msg);
     encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
     // TODO: Check for maximum MQTT message size!
-    encoded_msg.insert(encoded_msg.end(), m_gcode.data(), m_gcode.data() + m_gcode.size());
+    const std::string &gcode = (Compression::Type::NONE != compression()) ? (m_compressed_gcode) : (m_gcode);
+    encoded_msg.insert(encoded_msg.end(), gcode.data(), gcode.data() + gcode.size());
+    m_targets.encode(encoded_msg);
 }
 
 
@@ -61,11 +101,42 @@ size_t MsgPrint::decode(const std::vector<char> &encoded_msg)
     memcpy(&m_msg, encoded_msg.data() + pos, sizeof(m_msg));
     pos += sizeof(m_msg);
     // TODO: Check for maximum MQTT message size!
-    if (encoded_msg.size() - pos != m_msg.gcode_len) {
+    if (encoded_msg.size() - pos < m_msg.gcode_len) {
         throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: length fields does not add up the the exact message size.");
     }
+    if (m_msg.has_job_hash && 0 != m_msg.gcode_len) {
+        throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: job hash and gcode are exclusive.");
+    }
+    if (m_msg.resume && (m_msg.has_job_hash || 0 != m_msg.gcode_len)) {
+        throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: a resumed print has no job.");
+    }
+    if (m_msg.enqueue && !m_msg.has_job_hash) {
+        throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: a queued job is referenced by its hash.");
+    }
+    if (!Compression::is_valid(m_msg.compression)) {
+        throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: unknown compression");
+    }
     m_gcode.clear();
-    m_gcode.append(encoded_msg.data() + pos, m_msg.gcode_len);
+    m_compressed_gcode.clear();
+    if (Compression::Type::NONE != compression()) {
+        m_compressed_gcode.append(encoded_msg.data() + pos, m_msg.gcode_len);
+        // a small message may expand to a huge G-code, so the limit is checked for every block
+        Compression::decompress(compression(), m_compressed_gcode, [this](std::string_view data) {
+            if (m_max_gcode_size - m_gcode.size() < data.size()) {
+                throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: gcode exceeds the maximum size of " + std::to_string(m_max_gcode_size) + " bytes.");
+            }
+            m_gcode.append(data);
+        });
+    } else {
+        if (m_max_gcode_size < m_msg.gcode_len) {
+            throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: gcode exceeds the maximum size of " + std::to_string(m_max_gcode_size) + " bytes.");
+        }
+        m_gcode.append(encoded_msg.data() + pos, m_msg.gcode_len);
+    }
     pos += m_msg.gcode_len;
+    pos = m_targets.decode(encoded_msg, pos, m_msg.target_count);
+    if (encoded_msg.size() != pos) {
+        throw std::runtime_error("MsgPrint::decode(): Invalid encoded message: length fields does not add up the the exact message size.");
+    }
     return pos;
 }
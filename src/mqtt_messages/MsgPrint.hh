@@ -2,13 +2,33 @@
 #define __MSG_PRINT_HH__
 
 #include <string>
+#include <optional>
+#include <limits>
 #include "Msg.hh"
 #include "MsgType.hh"
+#include "PrintTargets.hh"
+#include "job/Sha256.hh"
+#include "job/Compression.hh"
 
 class MsgPrint : public Msg {
     public:
         MsgPrint();
-        MsgPrint(const std::string &gcode);
+        /**
+         * Requests to print the given G-code. The G-code is sent with the given compression, the
+         * receiver gets it uncompressed from gcode().
+         */
+        MsgPrint(const std::string &gcode, Compression::Type compression = Compression::Type::NONE);
+        /**
+         * Requests to print the job with the given hash (see GcodeJob::content_hash()) from the job
+         * cache of the daemon. If the job isn't cached, the daemon answers with
+         * Device::PrintResult::NET_ERR_NOT_CACHED and the job has to be uploaded with the
+         * request code of this message (see MsgUploadBegin).
+         */
+        MsgPrint(const Sha256::Digest &job_hash);
+        /**
+         * Same as above, but for an already sent request, i.e. to repeat a lost request.
+         */
+        MsgPrint(uint64_t request_code_part1, uint64_t request_code_part2, const Sha256::Digest &job_hash);
         virtual ~MsgPrint() {};
 
         struct header_msg {
@@ -18,7 +38,21 @@ class MsgPrint : public Msg {
             // request code, it is necessary to create a new message!
             uint64_t request_code_part1;
             uint64_t request_code_part2;
+            // size of the gcode as sent, i.e. after the compression
             size_t gcode_len;
+            // if set, the gcode is empty and the job is referenced by its hash
+            uint8_t has_job_hash;
+            uint8_t job_hash[32];
+            // number of further devices, which print the same job (see PrintTargets)
+            uint16_t target_count;
+            // compression of the gcode (see Compression::Type)
+            uint8_t compression;
+            // if set, the gcode is empty and the interrupted print of the device is resumed from
+            // its checkpoint (see PrintCheckpoint)
+            uint8_t resume;
+            // if set, the job referenced by the hash is appended to the job queue of the device
+            // instead of being printed immediately (see JobQueue)
+            uint8_t enqueue;
         };
 
         bool operator==(const MsgPrint &b)
@@ -26,7 +60,8 @@ class MsgPrint : public Msg {
             
             return    m_type == b.m_type
                    && 0 == memcmp(&m_msg, &b.m_msg, sizeof(m_msg))
-                   && m_gcode == b.m_gcode;
+                   && m_gcode == b.m_gcode
+                   && m_targets == b.m_targets;
         }
 
         bool operator!=(const MsgPrint &b)
@@ -37,22 +72,81 @@ class MsgPrint : public Msg {
         void encode(std::vector<char> &encoded_msg) const override;
         size_t decode(const std::vector<char> &encoded_msg) override;
 
+        /**
+         * Limits the size of the G-code, which decode() accepts after the decompression. A
+         * message with a larger G-code is rejected with an std::runtime_error, before the whole
+         * G-code is decompressed. By default, the size is not limited.
+         */
+        void set_max_gcode_size(size_t max_gcode_size) {
+            m_max_gcode_size = max_gcode_size;
+        }
+
         const std::string &gcode() const {
             return m_gcode;
         }
 
+        Compression::Type compression() const {
+            return static_cast<Compression::Type>(m_msg.compression);
+        }
+
+        const PrintTargets &targets() const {
+            return m_targets;
+        }
+
+        void set_targets(const PrintTargets &targets) {
+            m_targets = targets;
+            m_msg.target_count = targets.size();
+        }
+
+        /**
+         * Turns the request into a request to resume the interrupted print of the device. The
+         * message must not contain a job.
+         */
+        void set_resume(bool resume) {
+            m_msg.resume = resume;
+        }
+
+        bool resume() const {
+            return m_msg.resume;
+        }
+
+        /**
+         * Turns the request into a request to append the job to the job queue of the devices.
+         * Only jobs referenced by their hash can be queued.
+         */
+        void set_enqueue(bool enqueue) {
+            m_msg.enqueue = enqueue;
+        }
+
+        bool enqueue() const {
+            return m_msg.enqueue;
+        }
+
+        std::optional<Sha256::Digest> job_hash() const {
+            if (!m_msg.has_job_hash) {
+                return std::nullopt;
+            }
+            Sha256::Digest hash;
+            memcpy(hash.data(), m_msg.job_hash, hash.size());
+            return hash;
+        }
+
         uint64_t request_code_part1() const {
             return m_msg.request_code_part1;
         }
 
         uint64_t request_code_part2() const {
-            return m_msg.request_code_part1;
+            return m_msg.request_code_part2;
         }
 
     private:
         MsgType m_type;
         struct header_msg m_msg;
         std::string m_gcode;
+        // the compressed gcode, empty without compression
+        std::string m_compressed_gcode;
+        PrintTargets m_targets;
+        size_t m_max_gcode_size = std::numeric_limits<size_t>::max();
 };
 
 #endif
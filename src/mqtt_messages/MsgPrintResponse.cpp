@@ -24,6 +24,18 @@ MsgPrintResponse::MsgPrintResponse(const MsgPrint &print_msg, Device::PrintResul
 }
 
 
+/*
+ * MsgPrintResponse()
+ */
+MsgPrintResponse::MsgPrintResponse(uint64_t request_code_part1, uint64_t request_code_part2, Device::PrintResult print_result)
+    : m_type(MsgType::Type::PRINT_RESPONSE)
+{
+    m_msg.request_code_part1 = request_code_part1;
+    m_msg.request_code_part2 = request_code_part2;
+    m_msg.print_result = static_cast<uint8_t>(print_result);
+}
+
+
 /*
  * encode()
  */
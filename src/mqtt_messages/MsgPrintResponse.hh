@@ -11,6 +11,10 @@ class MsgPrintResponse : public Msg {
     public:
         MsgPrintResponse();
         MsgPrintResponse(const MsgPrint &print_msg, Device::PrintResult print_result);
+        /**
+         * Creates the response for an upload (see MsgUploadCommit).
+         */
+        MsgPrintResponse(uint64_t request_code_part1, uint64_t request_code_part2, Device::PrintResult print_result);
         virtual ~MsgPrintResponse() {};
 
         struct header_msg {
@@ -44,7 +48,7 @@ class MsgPrintResponse : public Msg {
         }
 
         uint64_t request_code_part2() const {
-            return m_msg.request_code_part1;
+            return m_msg.request_code_part2;
         }
 
     private:
@@ -27,40 +27,78 @@ struct SRHeader {
  */
 void MsgSensorReadings::encode(std::vector<char> &encoded_msg) const
 {
-    SRHeader head;
     m_type.encode(encoded_msg);
     encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
     for (const auto &value: m_readings) {
-        head.size_name = value.first.size();
-        if (value.first.size() > 0xff) {
-                throw std::runtime_error("Sensor name is longer than the allowed maximum of 0xff.");
-        }
-        head.size_unit = 0;
+        std::optional<std::string_view> unit;
         if (value.second.unit) {
-            if (value.second.unit->size() > 0xff) {
-                throw std::runtime_error("Unit filed is longer than the allowed maximum of 0xff.");
-            }
-            head.size_unit = value.second.unit->size();
-        }
-        head.fields = 0;
-        if (value.second.set_point) {
-            head.fields |= SRHEADER_FIELDS_SET_POINT;
+            unit = *value.second.unit;
         }
-        encoded_msg.insert(encoded_msg.end(), (char *)&head, ((char *)&head) + sizeof(head));
-        encoded_msg.insert(encoded_msg.end(),
-                           (char *)&value.second.current_value,
-                           ((char *)&value.second.current_value) + sizeof(value.second.current_value));
-        if (value.second.set_point) {
-            encoded_msg.insert(encoded_msg.end(),
-                               (char *)&*value.second.set_point,
-                               ((char *)&*value.second.set_point) + sizeof(*value.second.set_point));
+        encode_reading(encoded_msg, value.first, value.second.current_value, value.second.set_point, unit);
+    }
+}
+
+
+/*
+ * encode()
+ */
+void MsgSensorReadings::encode(const SensorTable::Snapshot &snapshot, std::vector<char> &encoded_msg)
+{
+    if (snapshot.count > 0xff) {
+        throw std::runtime_error("Too many sensor readings for mqtt message.");
+    }
+    MsgType(MsgType::Type::SENSOR_READINGS).encode(encoded_msg);
+    struct header_msg msg;
+    msg.count = snapshot.count;
+    encoded_msg.insert(encoded_msg.end(), (char *)&msg, ((char *)&msg) + sizeof(msg));
+    for (size_t i = 0; i < snapshot.count; ++i) {
+        const SensorTable::Reading &reading = snapshot.readings[i];
+        std::optional<std::string_view> unit;
+        if (reading.unit) {
+            unit = reading.unit;
         }
-        encoded_msg.insert(encoded_msg.end(), (char *)value.first.data(), ((char *)value.first.data()) + value.first.size());
-        if (value.second.unit) {
-            encoded_msg.insert(encoded_msg.end(),
-                               (char *)value.second.unit->data(),
-                               (char *)(value.second.unit->data()) + value.second.unit->size());
+        encode_reading(encoded_msg, reading.name, reading.current_value, reading.set_point, unit);
+    }
+}
+
+
+/*
+ * encode_reading()
+ */
+void MsgSensorReadings::encode_reading(std::vector<char> &encoded_msg,
+                                       std::string_view name,
+                                       double current_value,
+                                       const std::optional<double> &set_point,
+                                       const std::optional<std::string_view> &unit)
+{
+    SRHeader head;
+    head.size_name = name.size();
+    if (name.size() > 0xff) {
+            throw std::runtime_error("Sensor name is longer than the allowed maximum of 0xff.");
+    }
+    head.size_unit = 0;
+    if (unit) {
+        if (unit->size() > 0xff) {
+            throw std::runtime_error("Unit filed is longer than the allowed maximum of 0xff.");
         }
+        head.size_unit = unit->size();
+    }
+    head.fields = 0;
+    if (set_point) {
+        head.fields |= SRHEADER_FIELDS_SET_POINT;
+    }
+    encoded_msg.insert(encoded_msg.end(), (char *)&head, ((char *)&head) + sizeof(head));
+    encoded_msg.insert(encoded_msg.end(),
+                       (char *)&current_value,
+                       ((char *)&current_value) + sizeof(current_value));
+    if (set_point) {
+        encoded_msg.insert(encoded_msg.end(),
+                           (char *)&*set_point,
+                           ((char *)&*set_point) + sizeof(*set_point));
+    }
+    encoded_msg.insert(encoded_msg.end(), name.data(), name.data() + name.size());
+    if (unit) {
+        encoded_msg.insert(encoded_msg.end(), unit->data(), unit->data() + unit->size());
     }
 }
 
@@ -30,6 +30,12 @@ class MsgSensorReadings : public Msg {
         void encode(std::vector<char> &encoded_msg) const override;
         size_t decode(const std::vector<char> &encoded_msg) override;
 
+        /**
+         * Encodes the readings of the snapshot directly, without copying them into a message.
+         * The result can be decoded by decode().
+         */
+        static void encode(const SensorTable::Snapshot &snapshot, std::vector<char> &encoded_msg);
+
         void add_sensor_reading(const std::string &sensor_name, const Device::SensorValue &value);
 
         const std::map<std::string, Device::SensorValue> &sensor_readings() const
@@ -38,6 +44,12 @@ class MsgSensorReadings : public Msg {
         }
 
     private:
+        static void encode_reading(std::vector<char> &encoded_msg,
+                                   std::string_view name,
+                                   double current_value,
+                                   const std::optional<double> &set_point,
+                                   const std::optional<std::string_view> &unit);
+
         MsgType m_type;
         struct header_msg m_msg;
         std::map<std::string, Device::SensorValue> m_readings;
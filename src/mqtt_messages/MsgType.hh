@@ -15,9 +15,15 @@ class MsgType : public Msg {
             ALIASES_SET = 6,
             ALIASES_SET_PROVIDER = 7,
             SENSOR_READINGS = 8,
+            UPLOAD_BEGIN = 9,
+            UPLOAD_CHUNK = 10,
+            UPLOAD_COMMIT = 11,
+            UPLOAD_CREDIT = 12,
+            JOB_QUEUE = 13,
+            JOB_QUEUE_REQUEST = 14,
             // this entry needs to be the last element and needs a number which is higher
             // by one compared to the previous enty
-            __LAST_ENTRY = 9
+            __LAST_ENTRY = 15
         };
 
         struct header_msg {
@@ -0,0 +1,74 @@
+#include "MsgUploadBegin.hh"
+#include <stdexcept>
+#include <sys/random.h>
+
+/*
+ * MsgUploadBegin()
+ */
+MsgUploadBegin::MsgUploadBegin()
+    : MsgUploadBegin(0, 0)
+{
+}
+
+
+/*
+ * MsgUploadBegin()
+ */
+MsgUploadBegin::MsgUploadBegin(uint64_t total_size, uint32_t chunk_size)
+    : m_type(MsgType::Type::UPLOAD_BEGIN)
+{
+    // the padding is part of the comparison in operator==()
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.total_size = total_size;
+    m_msg.chunk_size = chunk_size;
+    constexpr size_t len = sizeof(uint64_t);
+    if (   len != getrandom(&m_msg.request_code_part1, len, 0)
+        || len != getrandom(&m_msg.request_code_part2, len, 0)) {
+        throw std::runtime_error("Could not get random number from OS for MsgUploadBegin message!\n");
+    }
+}
+
+
+/*
+ * MsgUploadBegin()
+ */
+MsgUploadBegin::MsgUploadBegin(uint64_t request_code_part1, uint64_t request_code_part2, uint64_t total_size, uint32_t chunk_size)
+    : m_type(MsgType::Type::UPLOAD_BEGIN)
+{
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.request_code_part1 = request_code_part1;
+    m_msg.request_code_part2 = request_code_part2;
+    m_msg.total_size = total_size;
+    m_msg.chunk_size = chunk_size;
+}
+
+
+/*
+ * encode()
+ */
+void MsgUploadBegin::encode(std::vector<char> &encoded_msg) const
+{
+    m_type.encode(encoded_msg);
+    encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
+}
+
+
+/*
+ * decode()
+ */
+size_t MsgUploadBegin::decode(const std::vector<char> &encoded_msg)
+{
+    size_t pos = m_type.decode(encoded_msg);
+    if (m_type.type() != MsgType::Type::UPLOAD_BEGIN) {
+        throw std::runtime_error("MsgUploadBegin::decode(): Wrong message type.");
+    }
+    if (encoded_msg.size() - pos < sizeof(m_msg)) {
+        throw std::runtime_error("MsgUploadBegin::decode(): Invalid encoded message: message to short");
+    }
+    memcpy(&m_msg, encoded_msg.data() + pos, sizeof(m_msg));
+    pos += sizeof(m_msg);
+    if (0 == m_msg.chunk_size) {
+        throw std::runtime_error("MsgUploadBegin::decode(): Invalid encoded message: chunk size is zero");
+    }
+    return pos;
+}
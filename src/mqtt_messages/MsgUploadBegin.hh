@@ -0,0 +1,111 @@
+#ifndef __MSG_UPLOAD_BEGIN_HH__
+#define __MSG_UPLOAD_BEGIN_HH__
+
+#include <optional>
+#include "Msg.hh"
+#include "MsgType.hh"
+#include "job/Sha256.hh"
+#include "job/Compression.hh"
+
+/**
+ * Starts a chunked upload of a print job (see MsgUploadChunk and MsgUploadCommit).
+ *
+ * A print job is uploaded in chunks, so neither the client nor the daemon has to hold the whole
+ * job in memory and no message exceeds the maximum message size of the broker. The daemon
+ * answers with MsgUploadCredit, which tells the client how many chunks it may send. Sending this
+ * message again for a running upload is allowed and only requests a new MsgUploadCredit.
+ *
+ * If the upload has a job hash, the daemon verifies the uploaded job against it and adds the job
+ * to its job cache, so it can be printed again with MsgPrint without another upload.
+ *
+ * The client offers a compression of the chunks. The daemon confirms the compression, which it
+ * accepts, in MsgUploadCredit. Until the first MsgUploadCredit, the client does not know it.
+ */
+class MsgUploadBegin : public Msg {
+    public:
+        MsgUploadBegin();
+        MsgUploadBegin(uint64_t total_size, uint32_t chunk_size);
+        /**
+         * Creates the message for an already started upload, i.e. to request a new MsgUploadCredit.
+         */
+        MsgUploadBegin(uint64_t request_code_part1, uint64_t request_code_part2, uint64_t total_size, uint32_t chunk_size);
+        virtual ~MsgUploadBegin() {};
+
+        struct header_msg {
+            // 128 bit random number, which identifies the upload. It is copied to all other
+            // messages of the upload and to the MsgPrintResponse after the commit.
+            uint64_t request_code_part1;
+            uint64_t request_code_part2;
+            // size of the whole print job in bytes
+            uint64_t total_size;
+            // maximum size of the data of a single chunk
+            uint32_t chunk_size;
+            // if set, job_hash is the SHA-256 of the whole job (see GcodeJob::content_hash())
+            uint8_t has_job_hash;
+            uint8_t job_hash[32];
+            // compression offered by the client (see Compression::Type)
+            uint8_t compression;
+        };
+
+        bool operator==(const MsgUploadBegin &b)
+        {
+            return    m_type == b.m_type
+                   && 0 == memcmp(&m_msg, &b.m_msg, sizeof(m_msg));
+        }
+
+        bool operator!=(const MsgUploadBegin &b)
+        {
+            return !(*this == b);
+        }
+
+        void encode(std::vector<char> &encoded_msg) const override;
+        size_t decode(const std::vector<char> &encoded_msg) override;
+
+        uint64_t request_code_part1() const {
+            return m_msg.request_code_part1;
+        }
+
+        uint64_t request_code_part2() const {
+            return m_msg.request_code_part2;
+        }
+
+        uint64_t total_size() const {
+            return m_msg.total_size;
+        }
+
+        uint32_t chunk_size() const {
+            return m_msg.chunk_size;
+        }
+
+        std::optional<Sha256::Digest> job_hash() const {
+            if (!m_msg.has_job_hash) {
+                return std::nullopt;
+            }
+            Sha256::Digest hash;
+            memcpy(hash.data(), m_msg.job_hash, hash.size());
+            return hash;
+        }
+
+        void set_job_hash(const Sha256::Digest &hash) {
+            m_msg.has_job_hash = 1;
+            memcpy(m_msg.job_hash, hash.data(), sizeof(m_msg.job_hash));
+        }
+
+        /**
+         * Returns the offered compression. Unknown values, i.e. of a newer client, are returned
+         * as they are. Use Compression::is_valid() to check them.
+         */
+        uint8_t compression() const {
+            return m_msg.compression;
+        }
+
+        void set_compression(Compression::Type compression) {
+            m_msg.compression = static_cast<uint8_t>(compression);
+        }
+
+    private:
+        MsgType m_type;
+        struct header_msg m_msg;
+};
+
+#endif
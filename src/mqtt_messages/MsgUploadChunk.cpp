@@ -0,0 +1,69 @@
+#include "MsgUploadChunk.hh"
+#include <stdexcept>
+
+/*
+ * MsgUploadChunk()
+ */
+MsgUploadChunk::MsgUploadChunk()
+    : m_type(MsgType::Type::UPLOAD_CHUNK)
+{
+    // the padding is part of the comparison in operator==()
+    memset(&m_msg, 0, sizeof(m_msg));
+}
+
+
+/*
+ * MsgUploadChunk()
+ */
+MsgUploadChunk::MsgUploadChunk(uint64_t request_code_part1,
+                               uint64_t request_code_part2,
+                               uint32_t sequence,
+                               std::string_view data,
+                               Compression::Type compression)
+    : m_type(MsgType::Type::UPLOAD_CHUNK),
+      m_data(data)
+{
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.request_code_part1 = request_code_part1;
+    m_msg.request_code_part2 = request_code_part2;
+    m_msg.sequence = sequence;
+    m_msg.data_len = data.size();
+    m_msg.compression = static_cast<uint8_t>(compression);
+}
+
+
+/*
+ * encode()
+ */
+void MsgUploadChunk::encode(std::vector<char> &encoded_msg) const
+{
+    m_type.encode(encoded_msg);
+    encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
+    encoded_msg.insert(encoded_msg.end(), m_data.data(), m_data.data() + m_data.size());
+}
+
+
+/*
+ * decode()
+ */
+size_t MsgUploadChunk::decode(const std::vector<char> &encoded_msg)
+{
+    size_t pos = m_type.decode(encoded_msg);
+    if (m_type.type() != MsgType::Type::UPLOAD_CHUNK) {
+        throw std::runtime_error("MsgUploadChunk::decode(): Wrong message type.");
+    }
+    if (encoded_msg.size() - pos < sizeof(m_msg)) {
+        throw std::runtime_error("MsgUploadChunk::decode(): Invalid encoded message: message to short");
+    }
+    memcpy(&m_msg, encoded_msg.data() + pos, sizeof(m_msg));
+    pos += sizeof(m_msg);
+    if (!Compression::is_valid(m_msg.compression)) {
+        throw std::runtime_error("MsgUploadChunk::decode(): Invalid encoded message: unknown compression");
+    }
+    if (encoded_msg.size() - pos != m_msg.data_len) {
+        throw std::runtime_error("MsgUploadChunk::decode(): Invalid encoded message: length fields does not add up the the exact message size.");
+    }
+    m_data.assign(encoded_msg.data() + pos, m_msg.data_len);
+    pos += m_msg.data_len;
+    return pos;
+}
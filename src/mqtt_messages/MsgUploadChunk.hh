@@ -0,0 +1,81 @@
+#ifndef __MSG_UPLOAD_CHUNK_HH__
+#define __MSG_UPLOAD_CHUNK_HH__
+
+#include <string>
+#include <string_view>
+#include "Msg.hh"
+#include "MsgType.hh"
+#include "job/Compression.hh"
+
+/**
+ * A chunk of an upload started with MsgUploadBegin. The chunks are numbered consecutively
+ * starting at 0. The daemon only accepts the chunk with the next expected sequence number.
+ *
+ * A compressed chunk is a complete stream of its own, so every chunk can be decompressed on its
+ * own and a lost chunk can be sent again without the chunks before it.
+ */
+class MsgUploadChunk : public Msg {
+    public:
+        MsgUploadChunk();
+        MsgUploadChunk(uint64_t request_code_part1,
+                       uint64_t request_code_part2,
+                       uint32_t sequence,
+                       std::string_view data,
+                       Compression::Type compression = Compression::Type::NONE);
+        virtual ~MsgUploadChunk() {};
+
+        struct header_msg {
+            // copied from MsgUploadBegin
+            uint64_t request_code_part1;
+            uint64_t request_code_part2;
+            uint32_t sequence;
+            // size of the data as sent, i.e. after the compression
+            uint32_t data_len;
+            uint8_t compression;
+        };
+
+        bool operator==(const MsgUploadChunk &b)
+        {
+            return    m_type == b.m_type
+                   && 0 == memcmp(&m_msg, &b.m_msg, sizeof(m_msg))
+                   && m_data == b.m_data;
+        }
+
+        bool operator!=(const MsgUploadChunk &b)
+        {
+            return !(*this == b);
+        }
+
+        void encode(std::vector<char> &encoded_msg) const override;
+        size_t decode(const std::vector<char> &encoded_msg) override;
+
+        uint64_t request_code_part1() const {
+            return m_msg.request_code_part1;
+        }
+
+        uint64_t request_code_part2() const {
+            return m_msg.request_code_part2;
+        }
+
+        uint32_t sequence() const {
+            return m_msg.sequence;
+        }
+
+        /**
+         * Returns the data as sent, i.e. compressed with compression().
+         */
+        const std::string &data() const {
+            return m_data;
+        }
+
+        Compression::Type compression() const {
+            return static_cast<Compression::Type>(m_msg.compression);
+        }
+
+    private:
+        MsgType m_type;
+        struct header_msg m_msg;
+        std::string m_data;
+};
+
+#endif
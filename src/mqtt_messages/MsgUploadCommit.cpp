@@ -0,0 +1,55 @@
+#include "MsgUploadCommit.hh"
+#include <stdexcept>
+
+/*
+ * MsgUploadCommit()
+ */
+MsgUploadCommit::MsgUploadCommit()
+    : MsgUploadCommit(0, 0, 0, 0)
+{
+}
+
+
+/*
+ * MsgUploadCommit()
+ */
+MsgUploadCommit::MsgUploadCommit(uint64_t request_code_part1, uint64_t request_code_part2, uint32_t chunk_count, uint64_t total_size)
+    : m_type(MsgType::Type::UPLOAD_COMMIT)
+{
+    // the padding is part of the comparison in operator==()
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.request_code_part1 = request_code_part1;
+    m_msg.request_code_part2 = request_code_part2;
+    m_msg.chunk_count = chunk_count;
+    m_msg.total_size = total_size;
+}
+
+
+/*
+ * encode()
+ */
+void MsgUploadCommit::encode(std::vector<char> &encoded_msg) const
+{
+    m_type.encode(encoded_msg);
+    encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
+    m_targets.encode(encoded_msg);
+}
+
+
+/*
+ * decode()
+ */
+size_t MsgUploadCommit::decode(const std::vector<char> &encoded_msg)
+{
+    size_t pos = m_type.decode(encoded_msg);
+    if (m_type.type() != MsgType::Type::UPLOAD_COMMIT) {
+        throw std::runtime_error("MsgUploadCommit::decode(): Wrong message type.");
+    }
+    if (encoded_msg.size() - pos < sizeof(m_msg)) {
+        throw std::runtime_error("MsgUploadCommit::decode(): Invalid encoded message: message to short");
+    }
+    memcpy(&m_msg, encoded_msg.data() + pos, sizeof(m_msg));
+    pos += sizeof(m_msg);
+    pos = m_targets.decode(encoded_msg, pos, m_msg.target_count);
+    return pos;
+}
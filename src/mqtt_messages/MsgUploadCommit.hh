@@ -0,0 +1,76 @@
+#ifndef __MSG_UPLOAD_COMMIT_HH__
+#define __MSG_UPLOAD_COMMIT_HH__
+
+#include "Msg.hh"
+#include "MsgType.hh"
+#include "PrintTargets.hh"
+
+/**
+ * Finishes an upload started with MsgUploadBegin. If the daemon received all chunks, it starts
+ * the print and answers with a MsgPrintResponse carrying the request code of the upload.
+ * Otherwise, it answers with a MsgUploadCredit, so the client sends the missing chunks.
+ * The job is also printed on all further targets (see PrintTargets).
+ */
+class MsgUploadCommit : public Msg {
+    public:
+        MsgUploadCommit();
+        MsgUploadCommit(uint64_t request_code_part1, uint64_t request_code_part2, uint32_t chunk_count, uint64_t total_size);
+        virtual ~MsgUploadCommit() {};
+
+        struct header_msg {
+            // copied from MsgUploadBegin
+            uint64_t request_code_part1;
+            uint64_t request_code_part2;
+            uint32_t chunk_count;
+            uint64_t total_size;
+            // number of further devices, which print the job (see PrintTargets)
+            uint16_t target_count;
+        };
+
+        bool operator==(const MsgUploadCommit &b)
+        {
+            return    m_type == b.m_type
+                   && 0 == memcmp(&m_msg, &b.m_msg, sizeof(m_msg))
+                   && m_targets == b.m_targets;
+        }
+
+        bool operator!=(const MsgUploadCommit &b)
+        {
+            return !(*this == b);
+        }
+
+        void encode(std::vector<char> &encoded_msg) const override;
+        size_t decode(const std::vector<char> &encoded_msg) override;
+
+        uint64_t request_code_part1() const {
+            return m_msg.request_code_part1;
+        }
+
+        uint64_t request_code_part2() const {
+            return m_msg.request_code_part2;
+        }
+
+        uint32_t chunk_count() const {
+            return m_msg.chunk_count;
+        }
+
+        uint64_t total_size() const {
+            return m_msg.total_size;
+        }
+
+        const PrintTargets &targets() const {
+            return m_targets;
+        }
+
+        void set_targets(const PrintTargets &targets) {
+            m_targets = targets;
+            m_msg.target_count = targets.size();
+        }
+
+    private:
+        MsgType m_type;
+        struct header_msg m_msg;
+        PrintTargets m_targets;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "MsgUploadCredit.hh"
+#include <stdexcept>
+
+/*
+ * MsgUploadCredit()
+ */
+MsgUploadCredit::MsgUploadCredit()
+    : MsgUploadCredit(0, 0, 0, 0)
+{
+}
+
+
+/*
+ * MsgUploadCredit()
+ */
+MsgUploadCredit::MsgUploadCredit(uint64_t request_code_part1,
+                                 uint64_t request_code_part2,
+                                 uint32_t acknowledged,
+                                 uint32_t credit,
+                                 Compression::Type compression)
+    : m_type(MsgType::Type::UPLOAD_CREDIT)
+{
+    // the padding is part of the comparison in operator==()
+    memset(&m_msg, 0, sizeof(m_msg));
+    m_msg.request_code_part1 = request_code_part1;
+    m_msg.request_code_part2 = request_code_part2;
+    m_msg.acknowledged = acknowledged;
+    m_msg.credit = credit;
+    m_msg.compression = static_cast<uint8_t>(compression);
+}
+
+
+/*
+ * encode()
+ */
+void MsgUploadCredit::encode(std::vector<char> &encoded_msg) const
+{
+    m_type.encode(encoded_msg);
+    encoded_msg.insert(encoded_msg.end(), (char *)&m_msg, ((char *)&m_msg) + sizeof(m_msg));
+}
+
+
+/*
+ * decode()
+ */
+size_t MsgUploadCredit::decode(const std::vector<char> &encoded_msg)
+{
+    size_t pos = m_type.decode(encoded_msg);
+    if (m_type.type() != MsgType::Type::UPLOAD_CREDIT) {
+        throw std::runtime_error("MsgUploadCredit::decode(): Wrong message type.");
+    }
+    if (encoded_msg.size() - pos < sizeof(m_msg)) {
+        throw std::runtime_error("MsgUploadCredit::decode(): Invalid encoded message: message to short");
+    }
+    memcpy(&m_msg, encoded_msg.data() + pos, sizeof(m_msg));
+    pos += sizeof(m_msg);
+    if (m_msg.acknowledged > m_msg.credit) {
+        throw std::runtime_error("MsgUploadCredit::decode(): Invalid encoded message: acknowledged chunks exceed the credit");
+    }
+    if (!Compression::is_valid(m_msg.compression)) {
+        throw std::runtime_error("MsgUploadCredit::decode(): Invalid encoded message: unknown compression");
+    }
+    return pos;
+}
@@ -0,0 +1,77 @@
+#ifndef __MSG_UPLOAD_CREDIT_HH__
+#define __MSG_UPLOAD_CREDIT_HH__
+
+#include "Msg.hh"
+#include "MsgType.hh"
+#include "job/Compression.hh"
+
+/**
+ * Flow control of an upload started with MsgUploadBegin, sent by the daemon.
+ *
+ * All chunks with a sequence number smaller than acknowledged are stored by the daemon. The
+ * client may send all chunks with a sequence number smaller than credit. If acknowledged is
+ * smaller than the sequence number of the next chunk of the client, then chunks got lost and the
+ * client has to continue with the chunk acknowledged.
+ *
+ * compression is the compression of the chunks, which the daemon accepted from the offer in
+ * MsgUploadBegin. The client may send uncompressed chunks in any case.
+ */
+class MsgUploadCredit : public Msg {
+    public:
+        MsgUploadCredit();
+        MsgUploadCredit(uint64_t request_code_part1,
+                        uint64_t request_code_part2,
+                        uint32_t acknowledged,
+                        uint32_t credit,
+                        Compression::Type compression = Compression::Type::NONE);
+        virtual ~MsgUploadCredit() {};
+
+        struct header_msg {
+            // copied from MsgUploadBegin
+            uint64_t request_code_part1;
+            uint64_t request_code_part2;
+            uint32_t acknowledged;
+            uint32_t credit;
+            uint8_t compression;
+        };
+
+        bool operator==(const MsgUploadCredit &b)
+        {
+            return    m_type == b.m_type
+                   && 0 == memcmp(&m_msg, &b.m_msg, sizeof(m_msg));
+        }
+
+        bool operator!=(const MsgUploadCredit &b)
+        {
+            return !(*this == b);
+        }
+
+        void encode(std::vector<char> &encoded_msg) const override;
+        size_t decode(const std::vector<char> &encoded_msg) override;
+
+        uint64_t request_code_part1() const {
+            return m_msg.request_code_part1;
+        }
+
+        uint64_t request_code_part2() const {
+            return m_msg.request_code_part2;
+        }
+
+        uint32_t acknowledged() const {
+            return m_msg.acknowledged;
+        }
+
+        uint32_t credit() const {
+            return m_msg.credit;
+        }
+
+        Compression::Type compression() const {
+            return static_cast<Compression::Type>(m_msg.compression);
+        }
+
+    private:
+        MsgType m_type;
+        struct header_msg m_msg;
+};
+
+#endif
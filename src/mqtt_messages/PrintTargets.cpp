@@ -0,0 +1,56 @@
+#include "PrintTargets.hh"
+#include <stdexcept>
+#include <cstring>
+
+/*
+ * add()
+ */
+void PrintTargets::add(uint64_t request_code_part1, uint64_t request_code_part2, const std::string &device)
+{
+    if (UINT8_MAX < device.size()) {
+        throw std::runtime_error("PrintTargets::add(): Device name '" + device + "' is too long.");
+    }
+    m_targets.push_back({ request_code_part1, request_code_part2, device });
+}
+
+
+/*
+ * encode()
+ */
+void PrintTargets::encode(std::vector<char> &encoded_msg) const
+{
+    for (const auto &target: m_targets) {
+        struct header_target header;
+        memset(&header, 0, sizeof(header));
+        header.request_code_part1 = target.request_code_part1;
+        header.request_code_part2 = target.request_code_part2;
+        header.device_name_len = target.device.size();
+        encoded_msg.insert(encoded_msg.end(), (char *)&header, ((char *)&header) + sizeof(header));
+        encoded_msg.insert(encoded_msg.end(), target.device.begin(), target.device.end());
+    }
+}
+
+
+/*
+ * decode()
+ */
+size_t PrintTargets::decode(const std::vector<char> &encoded_msg, size_t pos, size_t count)
+{
+    m_targets.clear();
+    for (size_t i = 0; i < count; ++i) {
+        struct header_target header;
+        if (encoded_msg.size() - pos < sizeof(header)) {
+            throw std::runtime_error("PrintTargets::decode(): Invalid encoded message: message to short");
+        }
+        memcpy(&header, encoded_msg.data() + pos, sizeof(header));
+        pos += sizeof(header);
+        if (encoded_msg.size() - pos < header.device_name_len) {
+            throw std::runtime_error("PrintTargets::decode(): Invalid encoded message: message to short");
+        }
+        m_targets.push_back({ header.request_code_part1,
+                              header.request_code_part2,
+                              std::string(encoded_msg.data() + pos, header.device_name_len) });
+        pos += header.device_name_len;
+    }
+    return pos;
+}
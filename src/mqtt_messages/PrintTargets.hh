@@ -0,0 +1,68 @@
+#ifndef __PRINT_TARGETS_HH__
+#define __PRINT_TARGETS_HH__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Further devices of a print request (see MsgPrint and MsgUploadCommit).
+ *
+ * A print request is sent to one device of a provider, but it can name further devices of the
+ * same provider, which print the same job. So a job is uploaded only once per provider. Each
+ * target has its own request code, the daemon answers with one MsgPrintResponse per device on the
+ * topic of this device.
+ */
+class PrintTargets {
+    public:
+        struct header_target {
+            uint64_t request_code_part1;
+            uint64_t request_code_part2;
+            uint8_t device_name_len;
+        };
+
+        struct Target {
+            uint64_t request_code_part1;
+            uint64_t request_code_part2;
+            std::string device;
+
+            bool operator==(const Target &b) const
+            {
+                return    request_code_part1 == b.request_code_part1
+                       && request_code_part2 == b.request_code_part2
+                       && device == b.device;
+            }
+        };
+
+        bool operator==(const PrintTargets &b) const
+        {
+            return m_targets == b.m_targets;
+        }
+
+        /**
+         * Adds a device. Throws an std::runtime_error, if the device name is too long to be encoded.
+         */
+        void add(uint64_t request_code_part1, uint64_t request_code_part2, const std::string &device);
+
+        const std::vector<Target> &targets() const
+        {
+            return m_targets;
+        }
+
+        size_t size() const
+        {
+            return m_targets.size();
+        }
+
+        void encode(std::vector<char> &encoded_msg) const;
+
+        /**
+         * Decodes count targets beginning at pos and returns the position after the last target.
+         */
+        size_t decode(const std::vector<char> &encoded_msg, size_t pos, size_t count);
+
+    private:
+        std::vector<Target> m_targets;
+};
+
+#endif
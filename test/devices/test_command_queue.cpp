@@ -0,0 +1,212 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <devices/CommandQueue.hh>
+
+// counts all allocations of the process, while g_count is set
+static std::atomic<bool> g_count(false);
+static std::atomic<size_t> g_allocs(0);
+
+void *operator new(size_t size)
+{
+    if (g_count) {
+        g_allocs++;
+    }
+    void *p = std::malloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+enum class Action {
+    NONE,
+    JOB_LINE,
+    CONTROL
+};
+
+int main(int argc, char **argv)
+{
+    {
+        CommandQueue<Action> queue(5);
+        if (8 != queue.capacity() || !queue.empty() || 0 != queue.bytes()) {
+            return FAIL;
+        }
+
+        if (!queue.push_copy("M115", Action::CONTROL)) {
+            return FAIL;
+        }
+        const std::string job_line = "G1 X10";
+        if (!queue.push_view(job_line, Action::JOB_LINE)) {
+            return FAIL;
+        }
+        if (2 != queue.size() || 5 + 7 != queue.bytes()) {
+            return FAIL;
+        }
+        if (queue.has_written() || !queue.has_unwritten()) {
+            return FAIL;
+        }
+        if ("M115" != queue.unwritten().line || Action::CONTROL != queue.unwritten().action) {
+            return FAIL;
+        }
+        queue.mark_written();
+        // job lines are not copied
+        if (job_line.data() != queue.unwritten().line.data()) {
+            return FAIL;
+        }
+        queue.mark_written();
+        if (queue.has_unwritten() || !queue.has_written()) {
+            return FAIL;
+        }
+        queue.pop();
+        if (Action::JOB_LINE != queue.front().action || 7 != queue.bytes()) {
+            return FAIL;
+        }
+        queue.pop();
+        if (!queue.empty() || 0 != queue.bytes()) {
+            return FAIL;
+        }
+
+        // a full queue and too long commands are rejected
+        for (size_t i = 0; i < queue.capacity(); ++i) {
+            if (!queue.push_copy("M105", Action::CONTROL)) {
+                return FAIL;
+            }
+        }
+        if (!queue.full() || queue.push_copy("M105", Action::CONTROL) || queue.push_view("M105", Action::CONTROL)) {
+            return FAIL;
+        }
+        queue.clear();
+        if (queue.push_copy(std::string(CommandQueue<Action>::INLINE_SIZE + 1, 'X'), Action::CONTROL)) {
+            return FAIL;
+        }
+    }
+
+    // partial writes
+    {
+        CommandQueue<Action> queue(4);
+        queue.push_view("G1 X1", Action::JOB_LINE);
+        queue.push_view("G1 X22", Action::JOB_LINE);
+        queue.push_copy("M105", Action::CONTROL);
+        // "G1 X1\nG1 "
+        queue.advance_written(9);
+        if (2 != queue.unwritten_count() || 3 != queue.unwritten().sent || "G1 X22" != queue.unwritten().line) {
+            return FAIL;
+        }
+        if ("M105" != queue.unwritten(1).line || 0 != queue.unwritten(1).sent) {
+            return FAIL;
+        }
+        // "X22\nM105\n"
+        queue.advance_written(9);
+        if (queue.has_unwritten() || 3 != queue.size()) {
+            return FAIL;
+        }
+        // surplus bytes are ignored
+        queue.advance_written(1);
+        if (queue.has_unwritten()) {
+            return FAIL;
+        }
+    }
+
+    // framed commands and resending
+    {
+        CommandQueue<Action> queue(4);
+        queue.push_view("G1 X1", Action::JOB_LINE);
+        if (!queue.frame_last(1, "N1 ", "*99\n") || 3 + 5 + 4 != queue.bytes()) {
+            return FAIL;
+        }
+        queue.push_view("G1 X2", Action::JOB_LINE);
+        queue.frame_last(2, "N2 ", "*96\n");
+        queue.push_view("G1 X3", Action::JOB_LINE);
+        queue.frame_last(3, "N3 ", "*97\n");
+        if (queue.frame_last(3, "N3 ", "*123456789\n")) {
+            return FAIL;
+        }
+        // "N1 G1 X1*99\nN2 G"
+        queue.advance_written(16);
+        if (4 != queue.unwritten().sent || 2 != queue.unwritten().number) {
+            return FAIL;
+        }
+        queue.advance_written(20);
+        queue.pop();
+        if (2 != queue.size() || 24 != queue.bytes() || 3 != queue.write_position()) {
+            return FAIL;
+        }
+
+        // the acknowledged line 1 is still retained
+        if (0 != queue.find_number(1) || 2 != queue.find_number(3) || -1 != queue.find_number(4)) {
+            return FAIL;
+        }
+        if (!queue.rewind(queue.find_number(2))) {
+            return FAIL;
+        }
+        if (2 != queue.unwritten_count() || 0 != queue.unwritten().sent || 2 != queue.unwritten().number) {
+            return FAIL;
+        }
+        // the acknowledged line 1 is not sent again
+        if (queue.rewind(queue.find_number(1))) {
+            return FAIL;
+        }
+        if (2 != queue.size() || 24 != queue.bytes() || 2 != queue.unwritten().number) {
+            return FAIL;
+        }
+
+        // unframed commands have no line number
+        queue.clear();
+        queue.push_copy("M105", Action::CONTROL);
+        if (-1 != queue.find_number(0)) {
+            return FAIL;
+        }
+
+        // overwritten commands are not retained
+        queue.clear();
+        for (uint32_t i = 0; i < 6; ++i) {
+            queue.push_view("G1 X1", Action::JOB_LINE);
+            queue.frame_last(i, "N0 ", "*0\n");
+            queue.advance_written(queue.bytes());
+            queue.pop();
+        }
+        if (-1 != queue.find_number(1) || 2 != queue.find_number(2)) {
+            return FAIL;
+        }
+    }
+
+    // sending and acknowledging commands must not allocate memory
+    {
+        const std::string job = "G1 X10 Y10\nG1 X20 Y20\nG1 X30 Y10\n";
+        CommandQueue<Action> queue(4);
+        g_count = true;
+        size_t pos = 0;
+        for (size_t i = 0; i < 100000; ++i) {
+            while (!queue.full()) {
+                const size_t eol = job.find('\n', pos);
+                queue.push_view(std::string_view(job).substr(pos, eol - pos), Action::JOB_LINE);
+                pos = (eol + 1) % job.size();
+            }
+            if (0 == i % 16) {
+                queue.push_copy("M105", Action::CONTROL);
+            }
+            queue.advance_written(queue.bytes());
+            queue.pop();
+        }
+        g_count = false;
+        if (0 != g_allocs) {
+            std::cerr << "allocations: " << g_allocs << "\n";
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <devices/EventRing.hh>
+
+struct Event {
+    uint32_t producer;
+    uint32_t number;
+};
+
+int main(int argc, char **argv)
+{
+    {
+        EventRing<Event> ring(3);
+        Event event;
+        if (4 != ring.capacity() || !ring.empty() || ring.try_pop(event)) {
+            return FAIL;
+        }
+        for (uint32_t i = 0; i < 4; ++i) {
+            if (!ring.try_push({0, i})) {
+                return FAIL;
+            }
+        }
+        // a full ring drops the event instead of waiting
+        if (ring.try_push({0, 4}) || ring.empty()) {
+            return FAIL;
+        }
+        for (uint32_t i = 0; i < 4; ++i) {
+            if (!ring.try_pop(event) || i != event.number) {
+                return FAIL;
+            }
+        }
+        if (!ring.empty() || !ring.try_push({0, 5}) || !ring.try_pop(event) || 5 != event.number) {
+            return FAIL;
+        }
+        // the last two slots are reserved for pushes without a reserve
+        if (!ring.try_push({0, 6}, 2) || !ring.try_push({0, 7}, 2) || ring.try_push({0, 8}, 2)) {
+            return FAIL;
+        }
+        if (!ring.try_push({0, 9}) || !ring.try_push({0, 10}) || ring.try_push({0, 11})) {
+            return FAIL;
+        }
+    }
+
+    // the events of every producer arrive in order and none is lost or duplicated
+    {
+        constexpr uint32_t PRODUCERS = 4;
+        constexpr uint32_t EVENTS = 100000;
+        EventRing<Event> ring(64);
+        std::vector<std::thread> producers;
+        for (uint32_t p = 0; p < PRODUCERS; ++p) {
+            producers.emplace_back([&ring, p]() {
+                    for (uint32_t i = 0; i < EVENTS; ++i) {
+                        while (!ring.try_push({p, i})) {
+                            std::this_thread::yield();
+                        }
+                    }
+            });
+        }
+
+        std::vector<uint32_t> next(PRODUCERS, 0);
+        size_t received = 0;
+        bool ok = true;
+        while (received < PRODUCERS * EVENTS) {
+            Event event;
+            if (!ring.try_pop(event)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (PRODUCERS <= event.producer || next[event.producer] != event.number) {
+                ok = false;
+                break;
+            }
+            next[event.producer]++;
+            received++;
+        }
+        for (auto &producer: producers) {
+            producer.join();
+        }
+        if (!ok || !ring.empty()) {
+            std::cerr << "received " << received << " events in order\n";
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,92 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <devices/LineBuffer.hh>
+
+/*
+ * Writes the data in pieces of at most chunk bytes into the buffer and collects all lines.
+ */
+static std::vector<std::string> feed(LineBuffer &buffer, const std::string &data, size_t chunk)
+{
+    std::vector<std::string> lines;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t len;
+        char *area = buffer.write_area(len);
+        if (0 == len) {
+            std::cerr << "write area is empty\n";
+            return lines;
+        }
+        len = std::min(len, std::min(chunk, data.size() - pos));
+        std::memcpy(area, data.data() + pos, len);
+        buffer.commit(len);
+        pos += len;
+
+        std::string_view line;
+        while (buffer.next_line(line)) {
+            lines.emplace_back(line);
+        }
+    }
+    return lines;
+}
+
+static bool equal(const std::vector<std::string> &lines, const std::vector<std::string> &expected)
+{
+    if (lines != expected) {
+        std::cerr << "got:";
+        for (const auto &line: lines) {
+            std::cerr << " '" << line << "'";
+        }
+        std::cerr << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const std::string data = "start\nok\r\nT:21.6 /0.0 B:21.8 /0.0\n\nok\npartial";
+    const std::vector<std::string> expected = { "start", "ok", "T:21.6 /0.0 B:21.8 /0.0", "", "ok" };
+
+    // coalesced lines, split lines and lines split at every byte
+    for (size_t chunk: { size_t(1), size_t(2), size_t(5), size_t(1000) }) {
+        LineBuffer buffer(64);
+        if (!equal(feed(buffer, data, chunk), expected)) {
+            return FAIL;
+        }
+        // the incomplete line is completed by the next read
+        if (!equal(feed(buffer, "_line\n", chunk), { "partial_line" })) {
+            return FAIL;
+        }
+    }
+
+    // the incomplete line is moved to the front, if the buffer is full
+    {
+        LineBuffer buffer(16);
+        if (!equal(feed(buffer, "0123456789\nabcdefghij\nklm\n", 4), { "0123456789", "abcdefghij", "klm" })) {
+            return FAIL;
+        }
+    }
+
+    // lines which are longer than the buffer are returned in pieces
+    {
+        LineBuffer buffer(8);
+        if (!equal(feed(buffer, "0123456789abcdef\nok\n", 3), { "01234567", "89abcdef", "", "ok" })) {
+            return FAIL;
+        }
+    }
+
+    // clear() drops incomplete lines
+    {
+        LineBuffer buffer(16);
+        feed(buffer, "garbage", 16);
+        buffer.clear();
+        if (!equal(feed(buffer, "ok\n", 16), { "ok" })) {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
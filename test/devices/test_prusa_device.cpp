@@ -0,0 +1,274 @@
+/*
+ * Prints a job with PrusaDevice on an emulated printer (pseudo terminal) and checks, that sending
+ * and acknowledging the lines of the job does not allocate memory. The job is printed as text and
+ * in the binary format, which is expanded while sending.
+ */
+#include "../mqtt_messages/test_header.hh"
+#include <devices/prusa/PrusaDevice.hh>
+#include <job/BinaryGcode.hh>
+#include <job/GcodeJob.hh>
+#include <job/PrintCheckpoint.hh>
+#include <Config.hh>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+// counts all allocations of the process (including the ones of libevent), while g_count is set
+static std::atomic<bool> g_count(false);
+static std::atomic<size_t> g_allocs(0);
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    if (g_count.load(std::memory_order_relaxed)) {
+        g_allocs++;
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    if (g_count.load(std::memory_order_relaxed)) {
+        g_allocs++;
+    }
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (g_count.load(std::memory_order_relaxed)) {
+        g_allocs++;
+    }
+    return __libc_realloc(ptr, size);
+}
+}
+
+const size_t JOB_LINES = 10000;
+const size_t COUNT_BEGIN = 1000;
+const size_t COUNT_END = 9000;
+
+static std::atomic<bool> g_stop(false);
+static std::atomic<size_t> g_acknowledged(0);
+
+/*
+ * Emulates the firmware. It answers every line with "ok" and does not allocate memory. Like the
+ * firmware, it reports the temperatures of M105 within the line of the ok.
+ */
+static void emulate_printer(int master)
+{
+    auto reply = [master](const char *msg) {
+        size_t len = std::strlen(msg);
+        while (len) {
+            ssize_t n = write(master, msg, len);
+            if (0 < n) {
+                msg += n;
+                len -= n;
+            }
+        }
+    };
+
+    reply("LCD status changed\n");
+    char line[256];
+    size_t line_len = 0;
+    while (!g_stop) {
+        struct pollfd pfd = { master, POLLIN, 0 };
+        if (0 >= poll(&pfd, 1, 10)) {
+            continue;
+        }
+        char buf[4096];
+        ssize_t n = read(master, buf, sizeof(buf));
+        for (ssize_t i = 0; i < n; ++i) {
+            if ('\n' != buf[i]) {
+                if (line_len < sizeof(line)) {
+                    line[line_len++] = buf[i];
+                }
+                continue;
+            }
+            if (4 == line_len && 0 == std::memcmp(line, "M115", 4)) {
+                reply("Cap:AUTOREPORT_TEMP:1\n");
+            } else if ('G' == line[0]) {
+                const size_t acknowledged = ++g_acknowledged;
+                if (COUNT_BEGIN == acknowledged) {
+                    g_count = true;
+                } else if (COUNT_END == acknowledged) {
+                    g_count = false;
+                }
+            }
+            const bool m105 = 4 <= line_len && memmem(line, line_len, "M105", 4);
+            line_len = 0;
+            if (m105) {
+                reply("ok T:210.0 /210.0 B:60.0 /60.0 T0:210.0 /210.0 @:0 B@:0 P:0.0 A:0.0\n");
+            } else {
+                reply("ok\n");
+            }
+        }
+    }
+}
+
+static bool wait_for_state(const Device &dev, Device::State state)
+{
+    for (int i = 0; i < 10000; ++i) {
+        if (dev.state() == state) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cerr << "timeout, device state: " << Device::state_to_str(dev.state()) << "\n";
+    return false;
+}
+
+static int run()
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (0 > master || 0 != grantpt(master) || 0 != unlockpt(master)) {
+        std::cerr << "Could not create pseudo terminal.\n";
+        return FAIL;
+    }
+
+    char conf_path[] = "/tmp/test_prusa_device_XXXXXX";
+    int fd = mkstemp(conf_path);
+    if (0 > fd) {
+        return FAIL;
+    }
+    close(fd);
+    char checkpoint_dir[] = "/tmp/test_prusa_device_checkpoints_XXXXXX";
+    if (!mkdtemp(checkpoint_dir)) {
+        return FAIL;
+    }
+    {
+        std::ofstream conf_file(conf_path);
+        conf_file << "use_realtime_scheduler = false\n";
+        conf_file << "print_window_commands = 4\n";
+        conf_file << "baud_rate = 250000\n";
+        conf_file << "serial_latency_test = 5\n";
+        conf_file << "checkpoint_dir = " << checkpoint_dir << "\n";
+    }
+    char arg0[] = "test_prusa_device";
+    char arg1[] = "-c";
+    char *argv[] = { arg0, arg1, conf_path, nullptr };
+    Config *conf = new Config(3, argv);
+    unlink(conf_path);
+
+    // the device is never destroyed, since the event loop may still reference it
+    PrusaDevice *dev = new PrusaDevice(ptsname(master), "test", *conf);
+    std::thread emulator(emulate_printer, master);
+
+    if (!wait_for_state(*dev, Device::State::OK)) {
+        return FAIL;
+    }
+
+    std::stringstream gcode;
+    for (size_t i = 0; i < JOB_LINES; ++i) {
+        gcode << "G1 X" << (100 + i % 50) << ".5 Y" << (100 + i % 37) << ".25\n";
+    }
+    if (Device::PrintResult::OK != dev->print(gcode.str())) {
+        return FAIL;
+    }
+    if (!wait_for_state(*dev, Device::State::OK)) {
+        return FAIL;
+    }
+    if (JOB_LINES != g_acknowledged) {
+        std::cerr << "acknowledged lines: " << g_acknowledged << "\n";
+        return FAIL;
+    }
+    if (0 != g_allocs) {
+        std::cerr << "allocations while printing: " << g_allocs << "\n";
+        return FAIL;
+    }
+
+    // the same job in the binary format
+    auto text_job = GcodeJob::from_string(gcode.str());
+    std::string binary;
+    BinaryGcode::append_header(binary);
+    for (size_t i = 0; i < text_job->size(); ++i) {
+        BinaryGcode::append_record(text_job->line(i), binary);
+    }
+    char job_path[] = "/tmp/test_prusa_device_job_XXXXXX";
+    fd = mkstemp(job_path);
+    if (0 > fd || binary.size() != size_t(write(fd, binary.data(), binary.size()))) {
+        return FAIL;
+    }
+    close(fd);
+    auto binary_job = GcodeJob::from_file(job_path);
+    unlink(job_path);
+    if (!binary_job->is_tokenized(0)) {
+        return FAIL;
+    }
+    g_acknowledged = 0;
+    if (Device::PrintResult::OK != dev->print_job(binary_job)) {
+        return FAIL;
+    }
+    if (!wait_for_state(*dev, Device::State::OK)) {
+        return FAIL;
+    }
+
+    if (JOB_LINES != g_acknowledged) {
+        std::cerr << "acknowledged lines of the binary job: " << g_acknowledged << "\n";
+        return FAIL;
+    }
+    if (0 != g_allocs) {
+        std::cerr << "allocations while printing the binary job: " << g_allocs << "\n";
+        return FAIL;
+    }
+
+    // resume the text job near its end, the prologue is sent before the remaining lines
+    PrintCheckpoint checkpoint;
+    checkpoint.job_hash = text_job->content_hash();
+    checkpoint.line = JOB_LINES - 100;
+    if (Device::PrintResult::ERR_INVALID_JOB != dev->resume_job(binary_job, checkpoint)) {
+        return FAIL;
+    }
+    size_t prologue_moves = 0;
+    std::istringstream prologue(checkpoint.resume_gcode(*text_job));
+    for (std::string line; std::getline(prologue, line);) {
+        if ('G' == line[0]) {
+            prologue_moves++;
+        }
+    }
+    g_acknowledged = 0;
+    if (Device::PrintResult::OK != dev->resume_job(text_job, checkpoint)) {
+        return FAIL;
+    }
+    if (!wait_for_state(*dev, Device::State::OK)) {
+        return FAIL;
+    }
+
+    g_stop = true;
+    emulator.join();
+
+    if (100 + prologue_moves != g_acknowledged) {
+        std::cerr << "acknowledged lines of the resumed job: " << g_acknowledged << "\n";
+        return FAIL;
+    }
+
+    // the checkpoint of a finished print is removed
+    const std::filesystem::path checkpoint_file = PrintCheckpoint::path(checkpoint_dir, "test");
+    for (int i = 0; i < 1000 && std::filesystem::exists(checkpoint_file); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (std::filesystem::exists(checkpoint_file)) {
+        return FAIL;
+    }
+    std::filesystem::remove_all(checkpoint_dir);
+    return SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    const int ret = run();
+    std::cout.flush();
+    std::cerr.flush();
+    // skip the destructors of the event loops, which may still reference the device
+    _exit(ret);
+}
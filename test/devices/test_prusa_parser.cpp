@@ -0,0 +1,137 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <devices/prusa/PrusaParser.hh>
+
+struct expected_reading {
+    const char *name;
+    double current_value;
+    bool has_set_point;
+    double set_point;
+};
+
+static bool check(const char *line,
+                  PrusaParser::LineType type,
+                  std::initializer_list<expected_reading> expected)
+{
+    PrusaParser::Result result;
+    PrusaParser::parse(line, result);
+    if (type != result.type) {
+        std::cerr << "wrong type for line '" << line << "'\n";
+        return false;
+    }
+    if (expected.size() != result.count) {
+        std::cerr << "expected " << expected.size() << " readings, got " << result.count << " for line '" << line << "'\n";
+        return false;
+    }
+    size_t i = 0;
+    for (const auto &exp: expected) {
+        const PrusaParser::Reading &reading = result.readings[i++];
+        if (   exp.name != reading.name
+            || exp.current_value != reading.current_value
+            || exp.has_set_point != reading.set_point.has_value()
+            || (exp.has_set_point && exp.set_point != *reading.set_point)) {
+            std::cerr << "unexpected reading '" << reading.name << "' for line '" << line << "'\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (!check("T:21.6 /0.0 B:21.8 /60.0 T0:21.6 /0.0 @:0 B@:0 P:0.0 A:23.0",
+               PrusaParser::LineType::TEMPERATURE,
+               {
+                   { "T", 21.6, true, 0.0 },
+                   { "B", 21.8, true, 60.0 },
+                   { "T0", 21.6, true, 0.0 },
+                   { "@", 0, false, 0 },
+                   { "B@", 0, false, 0 },
+                   { "P", 0.0, false, 0 },
+                   { "A", 23.0, false, 0 },
+               })) {
+        return FAIL;
+    }
+
+    if (!check("X:0.00 Y:-1.25 Z:0.15 E:0.00 Count X: 0.00 Y:0.00 Z:0.15 E:0.00",
+               PrusaParser::LineType::POSITION,
+               {
+                   { "X", 0.0, false, 0 },
+                   { "Y", -1.25, false, 0 },
+                   { "Z", 0.15, false, 0 },
+                   { "E", 0.0, false, 0 },
+               })) {
+        return FAIL;
+    }
+
+    if (!check("E0:4200 RPM PRN1:0 RPM E0@:255 PRN1@:0",
+               PrusaParser::LineType::FAN,
+               {
+                   { "E0", 4200, false, 0 },
+                   { "PRN1", 0, false, 0 },
+                   { "E0@", 255, false, 0 },
+                   { "PRN1@", 0, false, 0 },
+               })) {
+        return FAIL;
+    }
+
+    const char *others[] = {
+        "",
+        "ok",
+        "echo:busy: processing",
+        "LCD status changed",
+        "T:21.6 /0.0 B:",
+        "TX:21.6",
+        "X:0.00 Y:abc",
+        "Cap:AUTOREPORT_TEMP:1",
+        "PRN:0 RPM",
+        "NORMAL MODE: Percent done: 0; print time remaining in mins: 24; Change in mins: -1",
+    };
+    for (const char *line: others) {
+        if (!check(line, PrusaParser::LineType::OTHER, {})) {
+            return FAIL;
+        }
+    }
+
+    {
+        unsigned percentage = 0;
+        unsigned remaining = 0;
+        if (!PrusaParser::parse_progress("NORMAL MODE: Percent done: 12; print time remaining in mins: 24; Change in mins: -1",
+                                         percentage,
+                                         remaining)) {
+            return FAIL;
+        }
+        if (12 != percentage || 24 != remaining) {
+            return FAIL;
+        }
+        if (PrusaParser::parse_progress("SILENT MODE: Percent done: 1; print time remaining in mins: 24; Change in mins: -1",
+                                        percentage,
+                                        remaining)) {
+            return FAIL;
+        }
+        if (PrusaParser::parse_progress("NORMAL MODE: Percent done: ", percentage, remaining)) {
+            return FAIL;
+        }
+    }
+
+    {
+        uint32_t line_number = 0;
+        if (!PrusaParser::parse_resend("Resend: 123", line_number) || 123 != line_number) {
+            return FAIL;
+        }
+        if (!PrusaParser::parse_resend("Resend:7", line_number) || 7 != line_number) {
+            return FAIL;
+        }
+        if (!PrusaParser::parse_resend("rs N42", line_number) || 42 != line_number) {
+            return FAIL;
+        }
+        if (   PrusaParser::parse_resend("Resend: ", line_number)
+            || PrusaParser::parse_resend("Resend: 12 ok", line_number)
+            || PrusaParser::parse_resend("ok", line_number)) {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,224 @@
+/*
+ * Prints a job with line numbers and checksums on an emulated printer (pseudo terminal), which
+ * rejects some lines like the firmware does on a corrupted transmission. Checks, that every line
+ * of the job is accepted exactly once and in the right order. A resend request for an already
+ * acknowledged line has to stop the print instead of executing the lines twice.
+ */
+#include "../mqtt_messages/test_header.hh"
+#include <devices/prusa/PrusaDevice.hh>
+#include <job/GcodeJob.hh>
+#include <Config.hh>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+const size_t JOB_LINES = 3000;
+
+static std::atomic<bool> g_stop(false);
+static std::vector<std::string> g_accepted;
+static size_t g_rejected = 0;
+
+/*
+ * Emulates the line number and checksum handling of the Marlin/Prusa firmware. The first
+ * transmission of the lines in corrupted_lines is treated as corrupted. After accepting the line
+ * acknowledged_resend (0 for none), the emulator requests this line again, as if it lost it.
+ */
+static void emulate_printer(int master, std::set<uint32_t> corrupted_lines, uint32_t acknowledged_resend)
+{
+    auto reply = [master](const std::string &msg) {
+        const char *data = msg.data();
+        size_t len = msg.size();
+        while (len) {
+            ssize_t n = write(master, data, len);
+            if (0 < n) {
+                data += n;
+                len -= n;
+            }
+        }
+    };
+
+    uint32_t last_number = 0;
+    auto reject = [&](const char *reason) {
+        g_rejected++;
+        reply(std::string("Error:") + reason + ", Last Line: " + std::to_string(last_number) + "\n"
+              + "Resend: " + std::to_string(last_number + 1) + "\nok\n");
+    };
+
+    reply("LCD status changed\n");
+    std::string buf;
+    while (!g_stop) {
+        struct pollfd pfd = { master, POLLIN, 0 };
+        if (0 >= poll(&pfd, 1, 10)) {
+            continue;
+        }
+        char tmp[4096];
+        const ssize_t n = read(master, tmp, sizeof(tmp));
+        if (0 < n) {
+            buf.append(tmp, n);
+        }
+
+        std::string::size_type eol;
+        while (std::string::npos != (eol = buf.find('\n'))) {
+            std::string line = buf.substr(0, eol);
+            buf.erase(0, eol + 1);
+
+            if ('N' != line[0]) {
+                if ("M115" == line) {
+                    reply("Cap:AUTOREPORT_TEMP:1\n");
+                }
+                reply("ok\n");
+                continue;
+            }
+
+            const std::string::size_type star = line.find('*');
+            const std::string::size_type space = line.find(' ');
+            if (std::string::npos == star || std::string::npos == space) {
+                reject("No Checksum with line number");
+                continue;
+            }
+            const uint32_t number = std::stoul(line.substr(1, space - 1));
+            if (corrupted_lines.erase(number)) {
+                line[space + 1] ^= 0x20;
+            }
+            const unsigned checksum = std::stoul(line.substr(star + 1));
+            const std::string command = line.substr(space + 1, star - space - 1);
+            if (GcodeJob::checksum(std::string_view(line).substr(0, star)) != checksum) {
+                reject("checksum mismatch");
+                continue;
+            }
+            if ("M110 N0" == command) {
+                last_number = 0;
+                reply("ok\n");
+                continue;
+            }
+            if (last_number + 1 != number) {
+                reject("Line Number is not Last Line Number+1");
+                continue;
+            }
+            last_number = number;
+            g_accepted.push_back(command);
+            reply("ok\n");
+            if (acknowledged_resend == number) {
+                acknowledged_resend = 0;
+                last_number = number - 1;
+                reply("Resend: " + std::to_string(number) + "\nok\n");
+            }
+        }
+    }
+}
+
+static bool wait_for_state(const Device &dev, Device::State state)
+{
+    for (int i = 0; i < 10000; ++i) {
+        if (dev.state() == state) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cerr << "timeout, device state: " << Device::state_to_str(dev.state()) << "\n";
+    return false;
+}
+
+static int run(std::set<uint32_t> corrupted_lines, uint32_t acknowledged_resend)
+{
+    g_stop = false;
+    g_accepted.clear();
+    g_rejected = 0;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (0 > master || 0 != grantpt(master) || 0 != unlockpt(master)) {
+        std::cerr << "Could not create pseudo terminal.\n";
+        return FAIL;
+    }
+
+    char conf_path[] = "/tmp/test_prusa_resend_XXXXXX";
+    int fd = mkstemp(conf_path);
+    if (0 > fd) {
+        return FAIL;
+    }
+    close(fd);
+    {
+        std::ofstream conf_file(conf_path);
+        conf_file << "use_realtime_scheduler = false\n";
+        conf_file << "print_window_commands[test] = 8\n";
+        conf_file << "serial_checksums[test] = true\n";
+        conf_file << "checkpoint_interval = 0\n";
+    }
+    char arg0[] = "test_prusa_resend";
+    char arg1[] = "-c";
+    char *argv[] = { arg0, arg1, conf_path, nullptr };
+    Config *conf = new Config(3, argv);
+    unlink(conf_path);
+
+    // the device is never destroyed, since the event loop may still reference it
+    PrusaDevice *dev = new PrusaDevice(ptsname(master), "test", *conf);
+    std::thread emulator(emulate_printer, master, corrupted_lines, acknowledged_resend);
+
+    if (!wait_for_state(*dev, Device::State::OK)) {
+        return FAIL;
+    }
+
+    std::vector<std::string> job_lines;
+    std::stringstream gcode;
+    for (size_t i = 0; i < JOB_LINES; ++i) {
+        job_lines.push_back("G1 X" + std::to_string(100 + i % 50) + ".5 Y" + std::to_string(100 + i % 37) + ".25");
+        gcode << job_lines.back() << "\n";
+    }
+    if (Device::PrintResult::OK != dev->print(gcode.str())) {
+        return FAIL;
+    }
+    if (acknowledged_resend) {
+        if (!wait_for_state(*dev, Device::State::ERROR)) {
+            return FAIL;
+        }
+        g_stop = true;
+        emulator.join();
+        // no line was sent again after the resend request
+        if (   acknowledged_resend != g_accepted.size()
+            || !std::equal(g_accepted.begin(), g_accepted.end(), job_lines.begin())) {
+            std::cerr << "accepted lines: " << g_accepted.size() << "\n";
+            return FAIL;
+        }
+        return SUCCESS;
+    }
+    if (!wait_for_state(*dev, Device::State::OK)) {
+        return FAIL;
+    }
+
+    g_stop = true;
+    emulator.join();
+
+    if (job_lines != g_accepted) {
+        std::cerr << "accepted lines: " << g_accepted.size() << " of " << job_lines.size() << "\n";
+        return FAIL;
+    }
+    if (6 > g_rejected) {
+        std::cerr << "rejected lines: " << g_rejected << "\n";
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    // the corrupted lines include a line directly following a corrupted one and the last line
+    int ret = run({ 1, 500, 1000, 1001, 2500, JOB_LINES }, 0);
+    if (SUCCESS == ret) {
+        ret = run({}, 100);
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    // skip the destructors of the event loops, which may still reference the device
+    _exit(ret);
+}
@@ -0,0 +1,111 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <devices/SensorTable.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        SensorTable table;
+        SensorTable::Snapshot snapshot;
+        const std::optional<size_t> temp = table.intern("temp", "celsius");
+        const std::optional<size_t> pos = table.intern("pos", nullptr);
+        if (!temp || !pos || *temp == *pos || temp != table.intern("temp", "mm")) {
+            return FAIL;
+        }
+        if (table.intern(std::string(SensorTable::MAX_NAME, 'x'), nullptr)) {
+            return FAIL;
+        }
+
+        // only the readings with values are part of the snapshot
+        table.read(snapshot);
+        if (0 != snapshot.count) {
+            return FAIL;
+        }
+        table.begin_update();
+        table.set(*pos, 1.5, std::nullopt);
+        table.end_update();
+        table.read(snapshot);
+        if (   1 != snapshot.count
+            || 0 != std::strcmp("pos", snapshot.readings[0].name)
+            || nullptr != snapshot.readings[0].unit
+            || 1.5 != snapshot.readings[0].current_value
+            || snapshot.readings[0].set_point) {
+            return FAIL;
+        }
+
+        table.begin_update();
+        table.set(*temp, 20.0, 215.0);
+        table.end_update();
+        double current_value;
+        std::optional<double> set_point;
+        if (!table.get(*temp, current_value, set_point) || 20.0 != current_value || 215.0 != set_point) {
+            return FAIL;
+        }
+        table.read(snapshot);
+        if (   2 != snapshot.count
+            || 0 != std::strcmp("celsius", snapshot.readings[0].unit)
+            || 215.0 != snapshot.readings[0].set_point) {
+            return FAIL;
+        }
+
+        // the ids stay valid after clear()
+        table.clear();
+        table.read(snapshot);
+        if (0 != snapshot.count || table.get(*temp, current_value, set_point) || temp != table.intern("temp", nullptr)) {
+            return FAIL;
+        }
+
+        for (size_t i = 2; i < SensorTable::MAX_SENSORS; ++i) {
+            if (!table.intern("s" + std::to_string(i), nullptr)) {
+                return FAIL;
+            }
+        }
+        if (table.intern("full", nullptr)) {
+            return FAIL;
+        }
+    }
+
+    // a reader never sees the values of two different updates
+    {
+        constexpr size_t SENSORS = 8;
+        SensorTable table;
+        for (size_t i = 0; i < SENSORS; ++i) {
+            table.intern("sensor" + std::to_string(i), "m");
+        }
+        std::atomic<bool> running(true);
+        std::thread writer([&table, &running]() {
+                for (double value = 0.0; running; value += 1.0) {
+                    table.begin_update();
+                    for (size_t id = 0; id < SENSORS; ++id) {
+                        table.set(id, value, value);
+                    }
+                    table.end_update();
+                }
+        });
+
+        bool ok = true;
+        SensorTable::Snapshot snapshot;
+        for (size_t i = 0; i < 100000 && ok; ++i) {
+            table.read(snapshot);
+            for (size_t j = 0; j < snapshot.count; ++j) {
+                if (   SENSORS != snapshot.count
+                    || snapshot.readings[0].current_value != snapshot.readings[j].current_value
+                    || snapshot.readings[0].current_value != snapshot.readings[j].set_point) {
+                    ok = false;
+                }
+            }
+        }
+        running = false;
+        writer.join();
+        if (!ok) {
+            std::cerr << "inconsistent snapshot\n";
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
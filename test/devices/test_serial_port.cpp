@@ -0,0 +1,48 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <devices/SerialPort.hh>
+#include <termios.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (0 > master || 0 != grantpt(master) || 0 != unlockpt(master)) {
+        std::cerr << "Could not create pseudo terminal.\n";
+        return FAIL;
+    }
+    int fd = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (0 > fd) {
+        return FAIL;
+    }
+
+    // 250000 has no Bxxx constant
+    Config::DeviceConfig dev_conf;
+    dev_conf.baud_rate = 250000;
+    dev_conf.serial_vmin = 0;
+    dev_conf.serial_vtime = 5;
+    if (!SerialPort::configure(fd, dev_conf)) {
+        return FAIL;
+    }
+    if (250000 != SerialPort::baud_rate(fd)) {
+        std::cerr << "baud rate: " << SerialPort::baud_rate(fd) << "\n";
+        return FAIL;
+    }
+
+    struct termios tty;
+    if (0 != tcgetattr(fd, &tty)) {
+        return FAIL;
+    }
+    if (0 != tty.c_cc[VMIN] || 5 != tty.c_cc[VTIME] || (tty.c_lflag & ICANON) || CS8 != (tty.c_cflag & CSIZE)) {
+        return FAIL;
+    }
+
+    // standard baud rates are still readable with the termios interface
+    dev_conf.baud_rate = 115200;
+    if (!SerialPort::configure(fd, dev_conf) || 0 != tcgetattr(fd, &tty) || B115200 != cfgetospeed(&tty)) {
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,177 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <job/ArcFitter.hh>
+#include <job/GcodeJob.hh>
+
+/*
+ * Returns the commands of a job.
+ */
+static std::vector<std::string> commands(const GcodeJob &job)
+{
+    std::vector<std::string> result;
+    BinaryGcode::LineBuffer buffer;
+    for (size_t i = 0; i < job.size(); ++i) {
+        result.emplace_back(job.line(i, buffer));
+    }
+    return result;
+}
+
+/*
+ * Returns segments of a circle around (100, 100) with radius 10, which start at (110, 100).
+ */
+static std::string circle(size_t segments, double sweep, bool extrude)
+{
+    std::string gcode;
+    char line[128];
+    for (size_t i = 1; i <= segments; ++i) {
+        const double angle = sweep * i / segments;
+        if (extrude) {
+            snprintf(line, sizeof(line), "G1 X%.3f Y%.3f E0.05000\n", 100 + 10 * std::cos(angle), 100 + 10 * std::sin(angle));
+        } else {
+            snprintf(line, sizeof(line), "G1 X%.3f Y%.3f\n", 100 + 10 * std::cos(angle), 100 + 10 * std::sin(angle));
+        }
+        gcode += line;
+    }
+    return gcode;
+}
+
+int main(int argc, char **argv)
+{
+    if (2 != argc) {
+        std::cerr << "usage: test_arc_fitter GCODE_FILE\n";
+        return FAIL;
+    }
+
+    // a counter clockwise half circle becomes one G3
+    {
+        const std::string gcode = "G90\nM83\nG1 X110 Y100 F3000\nG1 F1800\n" + circle(36, M_PI, true) + "M107\n";
+        ArcFitter::Statistics statistics;
+        auto job = ArcFitter::fit(*GcodeJob::from_string(gcode), 0.01, statistics);
+        const std::vector<std::string> result = commands(*job);
+        if (   1 != statistics.arcs
+            || 36 != statistics.fitted_moves
+            || 41 != statistics.input_lines
+            || 6 != statistics.output_lines
+            || job->size() != statistics.output_lines
+            || "G1 F1800" != result[3]
+            || "G3 X90.000 Y100.000 I-10.000 J0.000 E1.80000" != result[4]
+            || "M107" != result[5]) {
+            std::cerr << "half circle: " << result[4] << "\n";
+            return FAIL;
+        }
+    }
+
+    // clockwise, with absolute extrusion and the feed rate on the first move
+    {
+        std::string gcode = "G90\nM82\nG92 E0\nG1 X110 Y100\n";
+        char line[128];
+        for (size_t i = 1; i <= 12; ++i) {
+            const double angle = -M_PI / 2 * i / 12;
+            snprintf(line, sizeof(line), "G1 X%.3f Y%.3f E%.4f%s\n", 100 + 10 * std::cos(angle), 100 + 10 * std::sin(angle), 0.1 * i, (1 == i) ? (" F1200") : (""));
+            gcode += line;
+        }
+        ArcFitter::Statistics statistics;
+        auto job = ArcFitter::fit(*GcodeJob::from_string(gcode), 0.05, statistics);
+        const std::vector<std::string> result = commands(*job);
+        if (1 != statistics.arcs || 5 != result.size() || "G2 X100.000 Y90.000 I-10.000 J0.000 E1.2000 F1200" != result[4]) {
+            std::cerr << "quarter circle: " << result.back() << "\n";
+            return FAIL;
+        }
+    }
+
+    // a travel with relative extrusion, where only the last move has an E word
+    {
+        std::string travel = circle(36, M_PI, false);
+        travel.insert(travel.size() - 1, " E0");
+        const std::string gcode = "G90\nM83\nG1 X110 Y100 F3000\n" + travel;
+        ArcFitter::Statistics statistics;
+        auto job = ArcFitter::fit(*GcodeJob::from_string(gcode), 0.01, statistics);
+        const std::vector<std::string> result = commands(*job);
+        if (1 != statistics.arcs || 4 != result.size() || "G3 X90.000 Y100.000 I-10.000 J0.000 E0" != result[3]) {
+            std::cerr << "travel: " << result.back() << "\n";
+            return FAIL;
+        }
+    }
+
+    // commands, which can't be fitted, are passed unchanged
+    for (const std::string &gcode: std::vector<std::string>{
+            // relative positioning
+            "G91\nG92 X110 Y100\n" + circle(36, M_PI, true),
+            // straight lines
+            std::string("G90\nG92 X0 Y0\nG1 X1 Y0\nG1 X2 Y0\nG1 X3 Y0\nG1 X4 Y0\nG1 X4 Y1\nG1 X4 Y2\nG1 X4 Y3\n"),
+            // the segments are longer than the tolerance allows
+            "G90\nG92 X110 Y100\n" + circle(6, M_PI, false),
+            // a retraction interrupts the extrusion
+            "G90\nM83\nG92 X110 Y100\n" + circle(2, M_PI / 18, true) + "G1 E-0.8\n" + "G1 X109.397 Y103.420 E0.05\n",
+            // uneven extrusion
+            "G90\nM83\nG92 X110 Y100\nG1 X109.962 Y100.872 E0.05\nG1 X109.848 Y101.736 E0.5\nG1 X109.659 Y102.588 E0.05\nG1 X109.397 Y103.420 E0.05\n",
+            // a Z move in between
+            "G90\nG92 X110 Y100\nG1 X109.962 Y100.872\nG1 X109.848 Y101.736 Z0.4\nG1 X109.659 Y102.588\nG1 X109.397 Y103.420\n" }) {
+        ArcFitter::Statistics statistics;
+        auto job = GcodeJob::from_string(gcode);
+        auto fitted = ArcFitter::fit(*job, 0.01, statistics);
+        if (0 != statistics.arcs || commands(*job) != commands(*fitted)) {
+            std::cerr << "unexpected arc in:\n" << gcode;
+            return FAIL;
+        }
+    }
+
+    if (ArcFitter(0.01).fit(*GcodeJob::from_string(""), [](std::string_view) { }).output_lines) {
+        return FAIL;
+    }
+    try {
+        ArcFitter fitter(0.0);
+        return FAIL;
+    } catch (const std::runtime_error &) {
+    }
+
+    // a sliced job: all commands except the G1 moves are kept in order
+    {
+        auto job = GcodeJob::from_file(argv[1]);
+        ArcFitter::Statistics statistics;
+        auto fitted = ArcFitter::fit(*job, 0.01, statistics);
+        std::cout << "Arc fitting: " << statistics.input_lines << " -> " << statistics.output_lines
+                  << " commands (" << statistics.fitted_moves << " moves replaced by "
+                  << statistics.arcs << " arcs)\n";
+        if (    job->size() != statistics.input_lines
+             || fitted->size() != statistics.output_lines
+             || statistics.input_lines - statistics.fitted_moves + statistics.arcs != statistics.output_lines
+             || 0 == statistics.arcs) {
+            return FAIL;
+        }
+        std::vector<std::string> original;
+        for (const std::string &line: commands(*job)) {
+            if (0 != line.compare(0, 3, "G1 ")) {
+                original.push_back(line);
+            }
+        }
+        std::vector<std::string> result;
+        for (const std::string &line: commands(*fitted)) {
+            if (0 != line.compare(0, 3, "G1 ") && 0 != line.compare(0, 3, "G2 ") && 0 != line.compare(0, 3, "G3 ")) {
+                result.push_back(line);
+            }
+        }
+        if (original != result) {
+            return FAIL;
+        }
+
+        // the binary format results in the same commands
+        std::string binary;
+        BinaryGcode::append_header(binary);
+        BinaryGcode::LineBuffer buffer;
+        for (size_t i = 0; i < job->size(); ++i) {
+            BinaryGcode::append_record(job->line(i, buffer), binary);
+        }
+        ArcFitter::Statistics binary_statistics;
+        auto fitted_binary = ArcFitter::fit(*GcodeJob::from_string(binary), 0.01, binary_statistics);
+        if (!fitted_binary->is_binary() || commands(*fitted) != commands(*fitted_binary)) {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,183 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <job/BinaryGcode.hh>
+#include <job/GcodeJob.hh>
+#include <job/GcodeSpooler.hh>
+
+/*
+ * Encodes a single command and returns its expansion.
+ */
+static std::string round_trip(std::string_view line, bool &tokenized)
+{
+    std::string record;
+    BinaryGcode::append_record(line, record);
+    size_t pos = 0;
+    std::string_view body;
+    if (!BinaryGcode::next_record(record, pos, body, tokenized) || record.size() != pos) {
+        return "<invalid record>";
+    }
+    if (!tokenized) {
+        return std::string(body);
+    }
+    BinaryGcode::LineBuffer buffer;
+    return std::string(BinaryGcode::expand(body, buffer));
+}
+
+int main(int argc, char **argv)
+{
+    // the expansion is always the original command
+    for (const char *line: { "G1 X102.345 Y-98.123 E0.04512",
+                             "G28 W",
+                             "M862.3 P \"MK3S\"",
+                             "M117 Printing...",
+                             "G1 X.5",
+                             "G1 X-0.0",
+                             "G1 X01",
+                             "G1X10",
+                             "G1 X1.",
+                             "T0",
+                             "M104 S215",
+                             "G1 F1234567.123456",
+                             "g1 x10" }) {
+        bool tokenized;
+        if (line != round_trip(line, tokenized)) {
+            std::cerr << "'" << line << "' was expanded to '" << round_trip(line, tokenized) << "'\n";
+            return FAIL;
+        }
+    }
+
+    {
+        BinaryGcode::Command command;
+        if (   !BinaryGcode::parse("G1 X102.345 Y-98.1 E0.04512 F1800", command)
+            || !command.is('G', 1)
+            || command.is('G', 0)
+            || 5 != command.word_count
+            || !command.find('Y')
+            || -98.1 != command.find('Y')->value()
+            || 1800 != command.find('F')->value()
+            || command.find('Z')) {
+            return FAIL;
+        }
+        if (   !BinaryGcode::parse("M862.3 P", command)
+            || command.is('M', 862)
+            || 8623 != command.words[0].mantissa
+            || command.find('P')->has_value) {
+            return FAIL;
+        }
+        if (BinaryGcode::parse("M117 Printing...", command) || BinaryGcode::parse("G1 X-0", command)) {
+            return FAIL;
+        }
+    }
+
+    // corrupted records are rejected
+    {
+        std::string record;
+        BinaryGcode::append_record("G1 X102.345 Y-98.123", record);
+        size_t pos = 0;
+        std::string_view body;
+        bool tokenized;
+        BinaryGcode::LineBuffer buffer;
+        bool got_exception = false;
+        try {
+            BinaryGcode::next_record(std::string_view(record).substr(0, record.size() - 1), pos, body, tokenized);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        pos = 0;
+        BinaryGcode::next_record(record, pos, body, tokenized);
+        try {
+            BinaryGcode::expand(body.substr(0, body.size() - 1), buffer);
+            got_exception = false;
+        } catch (const std::runtime_error &e) {
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+
+    if (2 != argc) {
+        std::cerr << "Usage: " << argv[0] << " GCODE_FILE\n";
+        return FAIL;
+    }
+
+    // a converted job provides the same commands as the text job
+    auto text_job = GcodeJob::from_file(argv[1]);
+    std::string binary;
+    BinaryGcode::append_header(binary);
+    size_t tokenized = 0;
+    for (size_t i = 0; i < text_job->size(); ++i) {
+        BinaryGcode::append_record(text_job->line(i), binary);
+    }
+    const std::filesystem::path file_path = std::filesystem::temp_directory_path() / ("test_binary_gcode_" + std::to_string(getpid()));
+    std::ofstream(file_path, std::ios::binary) << binary;
+    auto job = GcodeJob::from_file(file_path);
+    std::filesystem::remove(file_path);
+
+    if (!job->is_binary() || text_job->is_binary() || text_job->size() != job->size()) {
+        return FAIL;
+    }
+    BinaryGcode::LineBuffer buffer;
+    BinaryGcode::Command command;
+    BinaryGcode::Command text_command;
+    for (size_t i = 0; i < job->size(); ++i) {
+        if (   text_job->line(i) != job->line(i, buffer)
+            || text_job->line_xor(i) != job->line_xor(i)) {
+            std::cerr << "line " << i << ": expected '" << text_job->line(i) << "' got '" << job->line(i, buffer) << "'\n";
+            return FAIL;
+        }
+        if (job->is_tokenized(i)) {
+            tokenized++;
+            if (   !job->command(i, command)
+                || !text_job->command(i, text_command)
+                || command.word_count != text_command.word_count
+                || command.words[command.word_count - 1].mantissa != text_command.words[command.word_count - 1].mantissa) {
+                return FAIL;
+            }
+        }
+    }
+    std::cout << tokenized << " of " << job->size() << " commands tokenized, "
+              << text_job->serialized_size() << " bytes as text, " << binary.size() << " bytes binary\n";
+    if (tokenized * 10 < job->size() * 9 || binary.size() * 10 > text_job->serialized_size() * 7) {
+        return FAIL;
+    }
+
+    // the serialized binary job is the file itself
+    if (binary.size() != job->serialized_size()) {
+        return FAIL;
+    }
+    std::string serialized(job->serialized_header());
+    for (size_t i = 0; i < job->size(); ++i) {
+        job->serialize(i, serialized);
+    }
+    if (binary != serialized) {
+        return FAIL;
+    }
+
+    // the spooler expands the commands on the fly
+    GcodeSpooler spooler;
+    spooler.open(job);
+    std::string_view line;
+    for (size_t i = 0; spooler.next(line); ++i) {
+        if (text_job->line(i) != line) {
+            return FAIL;
+        }
+    }
+
+    bool got_exception = false;
+    try {
+        for (size_t i = 0; i < job->size(); ++i) {
+            job->line(i);
+        }
+    } catch (const std::runtime_error &e) {
+        got_exception = true;
+    }
+    if (!got_exception) {
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <job/Compression.hh>
+
+static std::string decompress(Compression::Type type, std::string_view data)
+{
+    std::string out;
+    Compression::decompress(type, data, [&out](std::string_view block) {
+        out.append(block);
+    });
+    return out;
+}
+
+static bool throws(Compression::Type type, std::string_view data)
+{
+    try {
+        decompress(type, data);
+    } catch (const std::runtime_error &e) {
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    // larger than the internal blocks, so the output is produced in many pieces
+    std::string gcode;
+    for (int i = 0; i < 20000; ++i) {
+        gcode += "G1 X" + std::to_string(i % 200) + " Y" + std::to_string(i % 170) + " E0.04\n";
+    }
+
+    for (auto type: { Compression::Type::NONE, Compression::Type::DEFLATE }) {
+        std::string compressed;
+        Compression::compress(type, gcode, compressed);
+        if (gcode != decompress(type, compressed)) {
+            std::cerr << "round trip failed for " << Compression::type_to_str(type) << "\n";
+            return FAIL;
+        }
+    }
+
+    {
+        std::string compressed;
+        Compression::compress(Compression::Type::DEFLATE, gcode, compressed);
+        if (compressed.size() * 4 > gcode.size()) {
+            std::cerr << "poor compression: " << compressed.size() << " of " << gcode.size() << " bytes\n";
+            return FAIL;
+        }
+
+        // incomplete, corrupted and trailing data
+        if (   !throws(Compression::Type::DEFLATE, std::string_view(compressed).substr(0, compressed.size() / 2))
+            || !throws(Compression::Type::DEFLATE, "G28\n")
+            || !throws(Compression::Type::DEFLATE, compressed + "x")) {
+            return FAIL;
+        }
+    }
+
+    // a streaming deflater produces independent streams after finish()
+    {
+        Compression::Deflater deflater;
+        Compression::Inflater inflater;
+        for (int stream = 0; stream < 3; ++stream) {
+            std::string compressed;
+            for (size_t pos = 0; pos < gcode.size(); pos += 1000) {
+                deflater.add(std::string_view(gcode).substr(pos, 1000), compressed);
+            }
+            deflater.finish(compressed);
+
+            std::string out;
+            bool end = false;
+            // the compressed data may arrive in arbitrary pieces
+            for (size_t pos = 0; pos < compressed.size(); pos += 7) {
+                if (end) {
+                    return FAIL;
+                }
+                end = inflater.add(std::string_view(compressed).substr(pos, 7), [&out](std::string_view block) {
+                    out.append(block);
+                });
+            }
+            if (!end || gcode != out) {
+                return FAIL;
+            }
+        }
+    }
+
+    if (   "deflate" != Compression::type_to_str(Compression::Type::DEFLATE)
+        || !Compression::is_valid(1)
+        || Compression::is_valid(2)) {
+        return FAIL;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <job/GcodeAnalysis.hh>
+#include <job/GcodeJob.hh>
+
+static bool near(double value, double expected, double tolerance)
+{
+    if (std::fabs(value - expected) > tolerance) {
+        std::cerr << value << " is not " << expected << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (2 != argc) {
+        std::cerr << "usage: test_gcode_analysis GCODE_FILE\n";
+        return FAIL;
+    }
+
+    GcodeAnalysis::MachineLimits limits;
+    limits.acceleration = limits.travel_acceleration = 1000.0;
+
+    // 100 mm at 100 mm/s: accelerating and decelerating takes 0.1 s and 5 mm each
+    {
+        auto analysis = GcodeAnalysis::analyze(*GcodeJob::from_string("G90\nM83\nG1 X100 E5 F6000\n"), limits);
+        if (   3 != analysis->size()
+            || 0.0 != analysis->time(1)
+            || !near(analysis->total_time(), 1.1, 1e-4)
+            || !near(analysis->filament(), 5.0, 1e-9)
+            || 0 != analysis->percentage(2)
+            || 100 != analysis->percentage(3)) {
+            return FAIL;
+        }
+    }
+
+    // collinear moves don't slow down at the junction, a corner does
+    {
+        auto straight = GcodeAnalysis::analyze(*GcodeJob::from_string("G1 X50 F6000\nG1 X100\n"), limits);
+        auto corner = GcodeAnalysis::analyze(*GcodeJob::from_string("G1 X50 F6000\nG1 X50 Y50\n"), limits);
+        if (   !near(straight->total_time(), 1.1, 1e-4)
+            || !near(straight->time(0), 0.55, 1e-4)
+            || 50 != straight->percentage(1)
+            || !(corner->total_time() > 1.15)) {
+            return FAIL;
+        }
+    }
+
+    // the limits are updated by the job, a dwell and the feed rate factor add time
+    {
+        auto analysis = GcodeAnalysis::analyze(*GcodeJob::from_string("M204 S500\nM220 S50\nG1 X100 F12000\nG4 P500\nG4 S2\n"), limits);
+        // 100 mm/s with 500 mm/s^2: 10 mm and 0.2 s for accelerating and decelerating each
+        if (!near(analysis->total_time(), 0.4 + 0.8 + 2.5, 1e-4)) {
+            return FAIL;
+        }
+        auto limited = GcodeAnalysis::analyze(*GcodeJob::from_string("M203 X50\nG1 X100 F6000\n"), limits);
+        if (!near(limited->total_time(), 0.05 + 0.05 + 97.5 / 50, 1e-4)) {
+            return FAIL;
+        }
+    }
+
+    // relative moves, arcs and extrusion
+    {
+        auto analysis = GcodeAnalysis::analyze(*GcodeJob::from_string("G91\nG1 X10 E1 F600\nG1 X10 E1\nG90\nG92 E0\nG1 E-1\nG3 X40 Y0 I10 J0 E1\n"), limits);
+        if (!near(analysis->filament(), 2.0 - 1.0 + 2.0, 1e-9)) {
+            return FAIL;
+        }
+        // the half circle takes about 10 * PI mm at 10 mm/s
+        if (!near(analysis->time(6) - analysis->time(5), M_PI, 0.02)) {
+            return FAIL;
+        }
+    }
+
+    // layers start at the first extruding move of a new height, a Z hop is no layer
+    {
+        auto analysis = GcodeAnalysis::analyze(*GcodeJob::from_string(
+                    "G90\nM83\n"
+                    "G1 Z0.2\nG1 X10 E1\n"
+                    "G1 Z0.6\nG1 X20\nG1 Z0.2\nG1 X30 E1\n"
+                    "G1 Z0.4\nG1 X0 Y10\nG1 X10 E1\n"), limits);
+        const std::vector<GcodeAnalysis::Layer> &layers = analysis->layers();
+        if (   2 != layers.size()
+            || 2 != layers[0].line
+            || 0.2f != layers[0].z
+            || 8 != layers[1].line
+            || 0.4f != layers[1].z
+            || !near(layers[1].filament, 2.0, 1e-6)
+            || layers[1].time != analysis->time(7)
+            || 2 != analysis->layer(1)
+            || 0 != analysis->layer(7)
+            || 1 != analysis->layer(10)) {
+            return FAIL;
+        }
+    }
+
+    // the sliced job: compare with the M73 progress of the slicer
+    {
+        auto job = GcodeJob::from_file(argv[1]);
+        auto analysis = GcodeAnalysis::analyze(*job);
+        std::cout << "Estimated print time: " << analysis->total_time() << " s, "
+                  << analysis->layers().size() << " layers\n";
+        // the slicer estimates 24 minutes
+        if (!near(analysis->total_time(), 24 * 60, 4 * 60) || 0.0 != analysis->filament()) {
+            return FAIL;
+        }
+        BinaryGcode::LineBuffer buffer;
+        size_t checked = 0;
+        for (size_t i = 0; i < job->size(); ++i) {
+            const std::string_view line = job->line(i, buffer);
+            if (0 != line.compare(0, 5, "M73 P")) {
+                continue;
+            }
+            const unsigned percentage = std::atoi(std::string(line.substr(5)).c_str());
+            if (!near(analysis->percentage(i + 1), percentage, 6)) {
+                std::cerr << "progress at line " << i << "\n";
+                return FAIL;
+            }
+            checked++;
+        }
+        if (50 > checked || 0 != analysis->remaining_time(job->size()) || analysis->total_time() != analysis->time(job->size() - 1)) {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <fstream>
+#include <job/GcodeJob.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        if ("G1 X1" != GcodeJob::strip("  G1 X1 ; move\r")) {
+            return FAIL;
+        }
+        if (!GcodeJob::strip(" ; only a comment").empty()) {
+            return FAIL;
+        }
+        if (!GcodeJob::strip(" \t\r").empty()) {
+            return FAIL;
+        }
+    }
+
+    {
+        auto job = GcodeJob::from_string("; comment only\n"
+                                         "G28 W ; home all without mesh bed level\n"
+                                         "\n"
+                                         "   \t\r\n"
+                                         "  M104 S215\r\n"
+                                         "G1 X10 Y10\n"
+                                         "M84");
+        const std::string expected[] = { "G28 W", "M104 S215", "G1 X10 Y10", "M84" };
+        if (4 != job->size()) {
+            return FAIL;
+        }
+        for (size_t i = 0; i < job->size(); ++i) {
+            if (expected[i] != job->line(i)) {
+                std::cerr << "expected '" << expected[i] << "' got '" << job->line(i) << "'\n";
+                return FAIL;
+            }
+        }
+    }
+
+    {
+        // well known example of a line numbered command: "N0 M110 N0*125"
+        if (125 != GcodeJob::checksum("N0 M110 N0")) {
+            return FAIL;
+        }
+        auto job = GcodeJob::from_string("M110 N0\nG1 X10 Y10 ; move\n");
+        if (GcodeJob::checksum("N0 ", job->line_xor(0)) != 125) {
+            return FAIL;
+        }
+        if (GcodeJob::checksum("G1 X10 Y10") != job->line_xor(1)) {
+            return FAIL;
+        }
+    }
+
+    {
+        bool got_exception = false;
+        try {
+            GcodeJob::from_file("/this/file/does/not/exist.gcode");
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+
+    if (2 <= argc) {
+        // the mapped file has to produce exactly the same lines as the naive line by line parsing
+        auto job = GcodeJob::from_file(argv[1]);
+        std::ifstream file(argv[1]);
+        std::string line;
+        size_t index = 0;
+        while (std::getline(file, line)) {
+            std::string_view stripped = GcodeJob::strip(line);
+            if (stripped.empty()) {
+                continue;
+            }
+            if (   index >= job->size()
+                || stripped != job->line(index)
+                || GcodeJob::checksum(stripped) != job->line_xor(index)) {
+                std::cerr << "Mismatch in line " << index << "\n";
+                return FAIL;
+            }
+            index++;
+        }
+        if (index != job->size()) {
+            return FAIL;
+        }
+        std::cout << argv[1] << ": " << job->size() << " commands\n";
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <job/GcodeJob.hh>
+#include <job/GcodeSpooler.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        auto job = GcodeJob::from_string("; comment only\n"
+                                         "G28 W ; home all without mesh bed level\n"
+                                         "\n"
+                                         "   \t\r\n"
+                                         "  M104 S215\r\n"
+                                         "G1 X10 Y10\n"
+                                         "M84");
+        GcodeSpooler spooler;
+        std::string_view line;
+        if (spooler.is_open() || spooler.next(line)) {
+            return FAIL;
+        }
+        spooler.open(job);
+        const std::string expected[] = { "G28 W", "M104 S215", "G1 X10 Y10", "M84" };
+        for (const auto &exp: expected) {
+            if (!spooler.next(line)) {
+                return FAIL;
+            }
+            if (exp != line) {
+                std::cerr << "expected '" << exp << "' got '" << line << "'\n";
+                return FAIL;
+            }
+        }
+        if (spooler.next(line)) {
+            return FAIL;
+        }
+        if (4 != spooler.position()) {
+            return FAIL;
+        }
+
+        // a job is resumed at the given line
+        spooler.open(job, 2);
+        if (!spooler.next(line) || "G1 X10 Y10" != line) {
+            return FAIL;
+        }
+        if (!spooler.next(line) || "M84" != line) {
+            return FAIL;
+        }
+        if (spooler.next(line) || 4 != spooler.position()) {
+            return FAIL;
+        }
+
+        // the prologue is provided before the first line
+        spooler.open(job, 3, GcodeJob::from_string("G28 X Y\nM83\n"));
+        if (   !spooler.peek(line) || "G28 X Y" != line
+            || GcodeJob::checksum("G28 X Y") != spooler.line_xor()
+            || 3 != spooler.position()) {
+            return FAIL;
+        }
+        spooler.skip();
+        if (!spooler.next(line) || "M83" != line || !spooler.next(line) || "M84" != line || spooler.next(line)) {
+            return FAIL;
+        }
+
+        spooler.close();
+        if (spooler.is_open() || spooler.next(line)) {
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,108 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <cstdlib>
+#include <job/JobCache.hh>
+
+static Sha256::Digest write_job(const std::filesystem::path &file, const std::string &content)
+{
+    std::ofstream out(file);
+    out << content;
+    Sha256 sha;
+    sha.update(content);
+    return sha.digest();
+}
+
+int main(int argc, char **argv)
+{
+    char tmp[] = "/tmp/test_job_cache_XXXXXX";
+    if (!mkdtemp(tmp)) {
+        return FAIL;
+    }
+    const std::filesystem::path base(tmp);
+    const std::filesystem::path cache_dir = base / "cache";
+    int ret = SUCCESS;
+
+    {
+        JobCache cache(cache_dir, 100);
+        const Sha256::Digest hash_a = write_job(base / "a", std::string(40, 'a'));
+        const Sha256::Digest hash_b = write_job(base / "b", std::string(40, 'b'));
+        const Sha256::Digest hash_c = write_job(base / "c", std::string(40, 'c'));
+
+        if (cache.lookup(hash_a)) {
+            ret = FAIL;
+        }
+        const auto path_a = cache.insert(hash_a, base / "a");
+        if (   !path_a
+            || std::filesystem::exists(base / "a")
+            || cache_dir / Sha256::to_hex(hash_a) != *path_a
+            || cache.lookup(hash_a) != path_a) {
+            ret = FAIL;
+        }
+        cache.insert(hash_b, base / "b");
+        // a was used more recently than b, so b is evicted for c
+        cache.lookup(hash_a);
+        cache.insert(hash_c, base / "c");
+        if (   2 != cache.count()
+            || 80 != cache.size()
+            || !cache.lookup(hash_a)
+            || cache.lookup(hash_b)
+            || std::filesystem::exists(cache_dir / Sha256::to_hex(hash_b))) {
+            ret = FAIL;
+        }
+
+        // jobs larger than the budget are not cached
+        const Sha256::Digest hash_large = write_job(base / "large", std::string(101, 'l'));
+        if (cache.insert(hash_large, base / "large") || 2 != cache.count()) {
+            ret = FAIL;
+        }
+
+        // a pinned job is kept, although it is the least recently used one
+        cache.pin(hash_a);
+        cache.lookup(hash_c);
+        const Sha256::Digest hash_d = write_job(base / "d", std::string(40, 'd'));
+        cache.insert(hash_d, base / "d");
+        if (   !std::filesystem::exists(cache_dir / Sha256::to_hex(hash_a))
+            || std::filesystem::exists(cache_dir / Sha256::to_hex(hash_c))
+            || 2 != cache.count()) {
+            ret = FAIL;
+        }
+        cache.unpin(hash_a);
+    }
+
+    // the cache is restored after a restart and shrunk to a smaller budget
+    {
+        std::ofstream(cache_dir / "unrelated_file") << "x";
+        JobCache cache(cache_dir, 50);
+        if (1 != cache.count() || 40 != cache.size()) {
+            std::cerr << "restored " << cache.count() << " jobs with " << cache.size() << " bytes\n";
+            ret = FAIL;
+        }
+        if (!std::filesystem::exists(cache_dir / "unrelated_file")) {
+            ret = FAIL;
+        }
+    }
+
+    // a queued job is pinned, before a restart shrinks the full cache
+    {
+        const Sha256::Digest hash_queued = write_job(base / "queued", std::string(40, 'q'));
+        const Sha256::Digest hash_e = write_job(base / "e", std::string(40, 'e'));
+        {
+            JobCache cache(cache_dir, 100);
+            cache.insert(hash_queued, base / "queued");
+            cache.insert(hash_e, base / "e");
+        }
+        JobCache cache(cache_dir, 50, { hash_queued });
+        if (   1 != cache.count()
+            || !std::filesystem::exists(cache_dir / Sha256::to_hex(hash_queued))
+            || std::filesystem::exists(cache_dir / Sha256::to_hex(hash_e))) {
+            ret = FAIL;
+        }
+        cache.unpin(hash_queued);
+    }
+
+    std::filesystem::remove_all(base);
+    return ret;
+}
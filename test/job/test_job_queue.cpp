@@ -0,0 +1,93 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <filesystem>
+#include <vector>
+#include <cstdlib>
+#include <job/JobQueue.hh>
+
+static std::vector<uint64_t> ids(JobQueue &queue, const std::string &device)
+{
+    std::vector<uint64_t> result;
+    for (const auto &entry: queue.jobs(device)) {
+        result.push_back(entry.id);
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    char tmp[] = "/tmp/test_job_queue_XXXXXX";
+    if (!mkdtemp(tmp)) {
+        return FAIL;
+    }
+    const std::filesystem::path base(tmp);
+    const std::filesystem::path file = base / "state" / "queue";
+    int ret = SUCCESS;
+
+    Sha256::Digest hash_a;
+    Sha256::Digest hash_b;
+    Sha256::Digest hash_c;
+    hash_a.fill(0xaa);
+    hash_b.fill(0xbb);
+    hash_c.fill(0xcc);
+
+    uint64_t id_a, id_b, id_c, id_other;
+    {
+        JobQueue queue(file);
+        id_a = queue.enqueue("printer_1", hash_a);
+        id_b = queue.enqueue("printer_1", hash_b);
+        id_other = queue.enqueue("printer_2", hash_a);
+        id_c = queue.enqueue("printer_1", hash_c);
+
+        const std::vector<JobQueue::Entry> jobs = queue.jobs("printer_1");
+        if (   3 != jobs.size()
+            || id_a != jobs[0].id || hash_a != jobs[0].job_hash
+            || id_b != jobs[1].id || hash_b != jobs[1].job_hash
+            || id_c != jobs[2].id || hash_c != jobs[2].job_hash
+            || std::vector<uint64_t>({ id_other }) != ids(queue, "printer_2")
+            || 4 != queue.all_jobs().size()) {
+            ret = FAIL;
+        }
+
+        // reordering
+        if (   !queue.move("printer_1", id_c, 0)
+            || std::vector<uint64_t>({ id_c, id_a, id_b }) != ids(queue, "printer_1")) {
+            ret = FAIL;
+        }
+        if (   !queue.move("printer_1", id_c, 100)
+            || std::vector<uint64_t>({ id_a, id_b, id_c }) != ids(queue, "printer_1")) {
+            ret = FAIL;
+        }
+        // jobs of other devices can't be touched
+        if (   queue.move("printer_1", id_other, 0)
+            || queue.remove("printer_1", id_other)
+            || 1 != ids(queue, "printer_2").size()) {
+            ret = FAIL;
+        }
+
+        if (   !queue.remove("printer_1", id_a)
+            || queue.remove("printer_1", id_a)
+            || std::vector<uint64_t>({ id_b, id_c }) != ids(queue, "printer_1")) {
+            ret = FAIL;
+        }
+    }
+
+    // the queues survive a restart and ids are not reused
+    {
+        JobQueue queue(file);
+        if (std::vector<uint64_t>({ id_b, id_c }) != ids(queue, "printer_1")) {
+            ret = FAIL;
+        }
+        queue.remove("printer_1", id_c);
+        const uint64_t id_d = queue.enqueue("printer_1", hash_a);
+        if (id_d <= id_c || std::vector<uint64_t>({ id_b, id_d }) != ids(queue, "printer_1")) {
+            ret = FAIL;
+        }
+        if (!queue.jobs("printer_3").empty()) {
+            ret = FAIL;
+        }
+    }
+
+    std::filesystem::remove_all(base);
+    return ret;
+}
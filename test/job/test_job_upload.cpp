@@ -0,0 +1,139 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <stdexcept>
+#include <job/JobUpload.hh>
+#include <job/GcodeJob.hh>
+
+int main(int argc, char **argv)
+{
+    const std::string gcode = "G28\nG1 X10 Y10\nG1 X20 Y20\n";
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+
+    {
+        std::string file_path;
+        std::shared_ptr<const GcodeJob> job;
+        {
+            JobUpload upload(dir, gcode.size());
+            file_path = upload.file_path();
+            if (!std::filesystem::exists(file_path)) {
+                return FAIL;
+            }
+
+            if (!upload.append(0, std::string_view(gcode).substr(0, 10))) {
+                return FAIL;
+            }
+            // duplicates and chunks after a lost one are dropped
+            if (upload.append(0, std::string_view(gcode).substr(0, 10))
+                || upload.append(2, std::string_view(gcode).substr(20))) {
+                return FAIL;
+            }
+            if (1 != upload.next_sequence() || 10 != upload.received() || upload.complete(1, gcode.size())) {
+                return FAIL;
+            }
+            upload.append(1, std::string_view(gcode).substr(10, 10));
+            upload.append(2, std::string_view(gcode).substr(20));
+            if (!upload.complete(3, gcode.size()) || upload.complete(4, gcode.size())) {
+                return FAIL;
+            }
+
+            std::ifstream file(file_path);
+            std::stringstream content;
+            content << file.rdbuf();
+            if (gcode != content.str()) {
+                return FAIL;
+            }
+
+            job = GcodeJob::from_file(upload.file_path());
+            // the upload is identified by the same hash as the job of the client
+            if (job->content_hash() != upload.content_hash()) {
+                return FAIL;
+            }
+        }
+        // the spool file is removed, but a loaded job stays valid
+        if (std::filesystem::exists(file_path) || 3 != job->size() || "G1 X20 Y20" != job->line(2)) {
+            return FAIL;
+        }
+    }
+
+    // the announced size must not be exceeded
+    {
+        JobUpload upload(dir, 4);
+        bool got_exception = false;
+        try {
+            upload.append(0, gcode);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+
+    // compressed chunks are written decompressed, a corrupted chunk is dropped completely
+    {
+        JobUpload upload(dir, gcode.size(), std::nullopt, Compression::Type::DEFLATE);
+        if (Compression::Type::DEFLATE != upload.compression()) {
+            return FAIL;
+        }
+        std::string first;
+        std::string second;
+        Compression::compress(Compression::Type::DEFLATE, std::string_view(gcode).substr(0, 10), first);
+        Compression::compress(Compression::Type::DEFLATE, std::string_view(gcode).substr(10), second);
+        if (!upload.append(0, first, Compression::Type::DEFLATE)) {
+            return FAIL;
+        }
+
+        bool got_exception = false;
+        try {
+            upload.append(1, second.substr(0, second.size() - 2), Compression::Type::DEFLATE);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception || 1 != upload.next_sequence() || 10 != upload.received()) {
+            return FAIL;
+        }
+
+        upload.append(1, second, Compression::Type::DEFLATE);
+        std::ifstream file(upload.file_path());
+        std::stringstream content;
+        content << file.rdbuf();
+        Sha256 sha;
+        sha.update(gcode);
+        if (!upload.complete(2, gcode.size()) || gcode != content.str() || sha.digest() != upload.content_hash()) {
+            return FAIL;
+        }
+    }
+
+    // the announced size applies to the decompressed data
+    {
+        JobUpload upload(dir, 4, std::nullopt, Compression::Type::DEFLATE);
+        std::string compressed;
+        Compression::compress(Compression::Type::DEFLATE, gcode, compressed);
+        bool got_exception = false;
+        try {
+            upload.append(0, compressed, Compression::Type::DEFLATE);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception || 0 != upload.received()) {
+            return FAIL;
+        }
+    }
+
+    {
+        bool got_exception = false;
+        try {
+            JobUpload upload(dir / "does_not_exist", 4);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <job/PrintCheckpoint.hh>
+#include <job/GcodeJob.hh>
+
+int main(int argc, char **argv)
+{
+    // the latest valid slot is loaded
+    {
+        char path[] = "/tmp/test_print_checkpoint_XXXXXX";
+        const int fd = mkstemp(path);
+        if (0 > fd) {
+            return FAIL;
+        }
+        PrintCheckpoint checkpoint;
+        checkpoint.job_hash.fill(0x42);
+        checkpoint.line = 1000;
+        checkpoint.store(fd, 1);
+        checkpoint.line = 2000;
+        checkpoint.has_position = true;
+        checkpoint.position[2] = 0.4f;
+        checkpoint.temp_extruder = 215.0f;
+        checkpoint.temp_bed = 60.0f;
+        checkpoint.store(fd, 2);
+
+        std::optional<PrintCheckpoint> loaded = PrintCheckpoint::load(path);
+        if (   !loaded
+            || checkpoint.job_hash != loaded->job_hash
+            || 2000 != loaded->line
+            || !loaded->has_position
+            || 0.4f != loaded->position[2]
+            || 215.0f != loaded->temp_extruder
+            || 60.0f != loaded->temp_bed) {
+            return FAIL;
+        }
+
+        // a torn write of the second checkpoint falls back to the first one
+        const char garbage[] = "torn";
+        if (sizeof(garbage) != pwrite(fd, garbage, sizeof(garbage), 40)) {
+            return FAIL;
+        }
+        loaded = PrintCheckpoint::load(path);
+        if (!loaded || 1000 != loaded->line || loaded->has_position) {
+            return FAIL;
+        }
+        close(fd);
+        unlink(path);
+        if (PrintCheckpoint::load(path)) {
+            return FAIL;
+        }
+    }
+
+    if ("/var/lib/gcoded/checkpoints/prusa-1.checkpoint" != PrintCheckpoint::path("/var/lib/gcoded/checkpoints", "prusa-1")) {
+        return FAIL;
+    }
+
+    // the state of the printer is restored from the job
+    {
+        auto job = GcodeJob::from_string("M140 S60\n"
+                                         "M104 S215\n"
+                                         "G28\n"
+                                         "G90\n"
+                                         "M82\n"
+                                         "G92 E0\n"
+                                         "G1 Z0.2 F600\n"
+                                         "M106 S128\n"
+                                         "G1 X10 Y20 E1 F1800\n"
+                                         "G1 X30 Y20 E2\n");
+        PrintCheckpoint checkpoint;
+        checkpoint.line = 9;
+        const std::string expected = "M140 S60\n"
+                                     "M104 S215\n"
+                                     "G92 Z0.200\n"
+                                     "G91\n"
+                                     "G1 Z2.000 F600\n"
+                                     "G90\n"
+                                     "G28 X Y\n"
+                                     "M190 S60\n"
+                                     "M109 S215\n"
+                                     "G1 X10.000 Y20.000 F3000\n"
+                                     "G1 Z0.200 F600\n"
+                                     "G92 E1.00000\n"
+                                     "M82\n"
+                                     "M106 S128\n"
+                                     "G1 F1800\n";
+        if (expected != checkpoint.resume_gcode(*job)) {
+            std::cerr << checkpoint.resume_gcode(*job);
+            return FAIL;
+        }
+
+        // the reported set points override the ones of the job
+        checkpoint.temp_extruder = 220.0f;
+        const std::string gcode = checkpoint.resume_gcode(*job);
+        if (   std::string::npos == gcode.find("M109 S220\n")
+            || std::string::npos != gcode.find("S215")) {
+            return FAIL;
+        }
+
+        checkpoint.line = job->size() + 1;
+        try {
+            checkpoint.resume_gcode(*job);
+            return FAIL;
+        } catch (const std::runtime_error &) {
+        }
+    }
+
+    // the reported position is used, if the job doesn't tell it
+    {
+        auto job = GcodeJob::from_string("M83\nG1 X5 E1\n");
+        PrintCheckpoint checkpoint;
+        checkpoint.has_position = true;
+        checkpoint.position[0] = 1.0f;
+        checkpoint.position[1] = 2.0f;
+        checkpoint.position[2] = 3.0f;
+        checkpoint.position[3] = 4.0f;
+        const std::string expected = "G92 Z3.000\n"
+                                     "G91\n"
+                                     "G1 Z2.000 F600\n"
+                                     "G90\n"
+                                     "G28 X Y\n"
+                                     "G1 X1.000 Y2.000 F3000\n"
+                                     "G1 Z3.000 F600\n"
+                                     "G92 E4.00000\n"
+                                     "M82\n";
+        if (expected != checkpoint.resume_gcode(*job)) {
+            std::cerr << checkpoint.resume_gcode(*job);
+            return FAIL;
+        }
+        // relative extrusion after the first command
+        checkpoint.line = 1;
+        if (std::string::npos == checkpoint.resume_gcode(*job).find("M83\n")) {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
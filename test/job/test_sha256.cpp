@@ -0,0 +1,65 @@
+#include "../mqtt_messages/test_header.hh"
+#include <iostream>
+#include <string>
+#include <job/Sha256.hh>
+
+static bool check(const std::string &data, const std::string &expected)
+{
+    Sha256 sha;
+    sha.update(data);
+    if (expected != Sha256::to_hex(sha.digest())) {
+        std::cerr << "wrong hash for '" << data.substr(0, 64) << "': " << Sha256::to_hex(sha.digest()) << "\n";
+        return false;
+    }
+
+    // the result must not depend on how the data is split
+    for (size_t piece: { 1, 3, 63, 64, 65 }) {
+        Sha256 pieces;
+        for (size_t pos = 0; pos < data.size(); pos += piece) {
+            pieces.update(std::string_view(data).substr(pos, piece));
+        }
+        if (sha.digest() != pieces.digest()) {
+            std::cerr << "wrong hash for pieces of " << piece << " bytes\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // test vectors of FIPS 180-4
+    if (   !check("", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855")
+        || !check("abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad")
+        || !check("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1")
+        || !check(std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0")) {
+        return FAIL;
+    }
+
+    // the digest can be taken in between
+    {
+        Sha256 sha;
+        sha.update("ab");
+        sha.digest();
+        sha.update("c");
+        if ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" != Sha256::to_hex(sha.digest())) {
+            return FAIL;
+        }
+    }
+
+    {
+        Sha256::Digest digest;
+        const std::string hex = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+        if (!Sha256::from_hex(hex, digest) || hex != Sha256::to_hex(digest)) {
+            return FAIL;
+        }
+        if (   Sha256::from_hex(hex.substr(1), digest)
+            || Sha256::from_hex("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD", digest)
+            || Sha256::from_hex("xa7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", digest)) {
+            return FAIL;
+        }
+    }
+
+    return SUCCESS;
+}
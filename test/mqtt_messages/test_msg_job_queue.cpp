@@ -0,0 +1,57 @@
+#include "test_header.hh"
+#include <iostream>
+#include <mqtt_messages/MsgJobQueue.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        Sha256::Digest hash_a;
+        Sha256::Digest hash_b;
+        hash_a.fill(0xaa);
+        hash_b.fill(0xbb);
+        MsgJobQueue orig;
+        orig.add_job(7, hash_a);
+        orig.add_job(3, hash_b);
+        std::vector<char> msg;
+        orig.encode(msg);
+        if (MsgType::Type::JOB_QUEUE != (MsgType::Type)msg[0]) {
+            return FAIL;
+        }
+        MsgJobQueue copy;
+        copy.decode(msg);
+
+        if (   orig != copy
+            || 2 != copy.jobs().size()
+            || 7 != copy.jobs()[0].id
+            || hash_a != copy.jobs()[0].job_hash
+            || 3 != copy.jobs()[1].id
+            || hash_b != copy.jobs()[1].job_hash) {
+            return FAIL;
+        }
+
+        // the count has to match the jobs
+        MsgJobQueue::header_msg *msg_view = (MsgJobQueue::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->job_count = 3;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    // an empty queue
+    {
+        MsgJobQueue orig;
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgJobQueue copy;
+        copy.decode(msg);
+        if (orig != copy || !copy.jobs().empty()) {
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,43 @@
+#include "test_header.hh"
+#include <iostream>
+#include <mqtt_messages/MsgJobQueueRequest.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        MsgJobQueueRequest orig(MsgJobQueueRequest::Action::MOVE, 42, 1);
+        std::vector<char> msg;
+        orig.encode(msg);
+        if (MsgType::Type::JOB_QUEUE_REQUEST != (MsgType::Type)msg[0]) {
+            return FAIL;
+        }
+        MsgJobQueueRequest copy;
+        copy.decode(msg);
+
+        if (   orig != copy
+            || MsgJobQueueRequest::Action::MOVE != copy.action()
+            || 42 != copy.job_id()
+            || 1 != copy.position()) {
+            return FAIL;
+        }
+    }
+
+    {
+        MsgJobQueueRequest orig(MsgJobQueueRequest::Action::CANCEL, 42);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgJobQueueRequest::header_msg *msg_view = (MsgJobQueueRequest::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->action = 0;
+        MsgJobQueueRequest copy;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}
@@ -41,5 +41,170 @@ int main(int argc, char **argv)
             return FAIL;
         }
     }
+    // a job referenced by its hash
+    {
+        Sha256::Digest hash;
+        hash.fill(0xab);
+        MsgPrint orig(hash);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgPrint copy;
+        copy.decode(msg);
+        if (orig != copy || !copy.job_hash() || hash != *copy.job_hash() || !copy.gcode().empty()) {
+            return FAIL;
+        }
+        MsgPrint repeated(orig.request_code_part1(), orig.request_code_part2(), hash);
+        if (orig != repeated) {
+            return FAIL;
+        }
+
+        PrintTargets targets;
+        targets.add(3, 4, "printer_2");
+        repeated.set_targets(targets);
+        std::vector<char> targets_msg;
+        repeated.encode(targets_msg);
+        MsgPrint targets_copy;
+        targets_copy.decode(targets_msg);
+        if (   repeated != targets_copy
+            || 1 != targets_copy.targets().size()
+            || "printer_2" != targets_copy.targets().targets()[0].device) {
+            return FAIL;
+        }
+        if (MsgPrint("G28").job_hash()) {
+            return FAIL;
+        }
+
+        // a hash and gcode are exclusive
+        MsgPrint::header_msg *msg_view = (MsgPrint::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->gcode_len = 3;
+        msg.insert(msg.end(), { 'G', '2', '8' });
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    // a resumed print
+    {
+        MsgPrint orig;
+        orig.set_resume(true);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgPrint copy;
+        copy.decode(msg);
+        if (orig != copy || !copy.resume() || copy.job_hash() || MsgPrint("G28").resume()) {
+            return FAIL;
+        }
+
+        // a resumed print has no job
+        MsgPrint::header_msg *msg_view = (MsgPrint::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->has_job_hash = 1;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    // a queued job
+    {
+        Sha256::Digest hash;
+        hash.fill(0xcd);
+        MsgPrint orig(hash);
+        orig.set_enqueue(true);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgPrint copy;
+        copy.decode(msg);
+        if (orig != copy || !copy.enqueue() || !copy.job_hash() || MsgPrint(hash).enqueue()) {
+            return FAIL;
+        }
+
+        // a queued job is referenced by its hash
+        MsgPrint::header_msg *msg_view = (MsgPrint::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->has_job_hash = 0;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    // compressed gcode
+    {
+        std::string gcode;
+        for (int i = 0; i < 1000; ++i) {
+            gcode += "G1 X" + std::to_string(i % 100) + " Y10 E0.5\n";
+        }
+        MsgPrint orig(gcode, Compression::Type::DEFLATE);
+        std::vector<char> msg;
+        orig.encode(msg);
+        if (msg.size() >= gcode.size()) {
+            std::cerr << "compressed message has " << msg.size() << " bytes for " << gcode.size() << " bytes of gcode\n";
+            return FAIL;
+        }
+        MsgPrint copy;
+        copy.decode(msg);
+        if (orig != copy || gcode != copy.gcode() || Compression::Type::DEFLATE != copy.compression()) {
+            return FAIL;
+        }
+
+        // corrupted data is detected
+        msg[msg.size() / 2] ^= 0x55;
+        msg[msg.size() / 2 + 1] ^= 0x55;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+
+        // the decompressed gcode is limited
+        msg.clear();
+        orig.encode(msg);
+        copy.set_max_gcode_size(gcode.size() - 1);
+        got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception || copy.gcode().size() >= gcode.size()) {
+            return FAIL;
+        }
+        copy.set_max_gcode_size(gcode.size());
+        copy.decode(msg);
+        if (gcode != copy.gcode()) {
+            return FAIL;
+        }
+
+        // the limit applies to uncompressed gcode as well
+        MsgPrint plain(gcode);
+        msg.clear();
+        plain.encode(msg);
+        copy.set_max_gcode_size(gcode.size() - 1);
+        got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
     return SUCCESS;
 }
@@ -58,6 +58,24 @@ int main(int argc, char **argv)
         }
     }
 
+    // a snapshot of a device is decoded to the same readings
+    {
+        SensorTable::Snapshot snapshot;
+        for (const auto &value: readings) {
+            SensorTable::Reading &reading = snapshot.readings[snapshot.count++];
+            reading.name = value.first.c_str();
+            reading.unit = (value.second.unit) ? (value.second.unit->c_str()) : (nullptr);
+            reading.current_value = value.second.current_value;
+            reading.set_point = value.second.set_point;
+        }
+        std::vector<char> msg;
+        MsgSensorReadings::encode(snapshot, msg);
+        MsgSensorReadings copy;
+        if (msg.size() != copy.decode(msg) || readings != copy.sensor_readings()) {
+            return FAIL;
+        }
+    }
+
     {
         MsgSensorReadings orig;
         std::vector<char> msg;
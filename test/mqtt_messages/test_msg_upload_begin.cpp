@@ -0,0 +1,80 @@
+#include "test_header.hh"
+#include <iostream>
+#include <mqtt_messages/MsgUploadBegin.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        MsgUploadBegin orig(123456789, 65536);
+        std::vector<char> msg;
+        orig.encode(msg);
+        if (MsgType::Type::UPLOAD_BEGIN != (MsgType::Type)msg[0]) {
+            return FAIL;
+        }
+        MsgUploadBegin copy;
+        copy.decode(msg);
+
+        if (orig != copy) {
+            return FAIL;
+        }
+        if (123456789 != copy.total_size() || 65536 != copy.chunk_size()) {
+            return FAIL;
+        }
+        MsgUploadBegin again(orig.request_code_part1(), orig.request_code_part2(), 123456789, 65536);
+        if (orig != again) {
+            return FAIL;
+        }
+        if (copy.job_hash()) {
+            return FAIL;
+        }
+        // every upload gets its own request code
+        MsgUploadBegin other(123456789, 65536);
+        if (   orig.request_code_part1() == other.request_code_part1()
+            && orig.request_code_part2() == other.request_code_part2()) {
+            return FAIL;
+        }
+    }
+
+    {
+        MsgUploadBegin orig(123456789, 65536);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadBegin::header_msg *msg_view = (MsgUploadBegin::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->chunk_size = 0;
+        MsgUploadBegin copy;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    {
+        Sha256::Digest hash;
+        hash.fill(0x5a);
+        MsgUploadBegin orig(1, 2, 123456789, 65536);
+        orig.set_job_hash(hash);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadBegin copy;
+        copy.decode(msg);
+        if (orig != copy || !copy.job_hash() || hash != *copy.job_hash()) {
+            return FAIL;
+        }
+    }
+    {
+        MsgUploadBegin orig(1, 2, 123456789, 65536);
+        orig.set_compression(Compression::Type::DEFLATE);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadBegin copy;
+        copy.decode(msg);
+        if (orig != copy || static_cast<uint8_t>(Compression::Type::DEFLATE) != copy.compression()) {
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,66 @@
+#include "test_header.hh"
+#include <iostream>
+#include <mqtt_messages/MsgUploadChunk.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        MsgUploadChunk orig(1, 2, 42, "G1 X10 Y10\nG1 X20 Y20\n");
+        std::vector<char> msg;
+        orig.encode(msg);
+        if (MsgType::Type::UPLOAD_CHUNK != (MsgType::Type)msg[0]) {
+            return FAIL;
+        }
+        MsgUploadChunk copy;
+        copy.decode(msg);
+
+        if (orig != copy) {
+            return FAIL;
+        }
+        if (1 != copy.request_code_part1() || 2 != copy.request_code_part2() || 42 != copy.sequence()) {
+            return FAIL;
+        }
+        std::cout << "Data: " << copy.data() << "\n";
+    }
+
+    {
+        MsgUploadChunk orig(1, 2, 42, "G1 X10 Y10\n");
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadChunk::header_msg *msg_view = (MsgUploadChunk::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->data_len = 255;
+        MsgUploadChunk copy;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    {
+        MsgUploadChunk orig(1, 2, 42, "compressed data", Compression::Type::DEFLATE);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadChunk copy;
+        copy.decode(msg);
+        if (orig != copy || Compression::Type::DEFLATE != copy.compression() || "compressed data" != copy.data()) {
+            return FAIL;
+        }
+
+        MsgUploadChunk::header_msg *msg_view = (MsgUploadChunk::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->compression = 0xff;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,72 @@
+#include "test_header.hh"
+#include <iostream>
+#include <mqtt_messages/MsgUploadCommit.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        MsgUploadCommit orig(1, 2, 1600, 104857600);
+        std::vector<char> msg;
+        orig.encode(msg);
+        if (MsgType::Type::UPLOAD_COMMIT != (MsgType::Type)msg[0]) {
+            return FAIL;
+        }
+        MsgUploadCommit copy;
+        copy.decode(msg);
+
+        if (orig != copy) {
+            return FAIL;
+        }
+        if (1600 != copy.chunk_count() || 104857600 != copy.total_size()) {
+            return FAIL;
+        }
+    }
+
+    {
+        MsgUploadCommit orig(1, 2, 1600, 104857600);
+        std::vector<char> msg;
+        orig.encode(msg);
+        msg.resize(msg.size() - 1);
+        MsgUploadCommit copy;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    // further devices, which print the same job
+    {
+        PrintTargets targets;
+        targets.add(3, 4, "printer_2");
+        targets.add(5, 6, "printer_3");
+        MsgUploadCommit orig(1, 2, 1600, 104857600);
+        orig.set_targets(targets);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadCommit copy;
+        copy.decode(msg);
+        if (orig != copy || 2 != copy.targets().size()) {
+            return FAIL;
+        }
+        const PrintTargets::Target &target = copy.targets().targets()[1];
+        if (5 != target.request_code_part1 || 6 != target.request_code_part2 || "printer_3" != target.device) {
+            return FAIL;
+        }
+
+        msg.resize(msg.size() - 1);
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,66 @@
+#include "test_header.hh"
+#include <iostream>
+#include <mqtt_messages/MsgUploadCredit.hh>
+
+int main(int argc, char **argv)
+{
+    {
+        MsgUploadCredit orig(1, 2, 12, 20);
+        std::vector<char> msg;
+        orig.encode(msg);
+        if (MsgType::Type::UPLOAD_CREDIT != (MsgType::Type)msg[0]) {
+            return FAIL;
+        }
+        MsgUploadCredit copy;
+        copy.decode(msg);
+
+        if (orig != copy) {
+            return FAIL;
+        }
+        if (12 != copy.acknowledged() || 20 != copy.credit()) {
+            return FAIL;
+        }
+    }
+
+    {
+        MsgUploadCredit orig(1, 2, 12, 20);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadCredit::header_msg *msg_view = (MsgUploadCredit::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->acknowledged = 21;
+        MsgUploadCredit copy;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    {
+        MsgUploadCredit orig(1, 2, 12, 20, Compression::Type::DEFLATE);
+        std::vector<char> msg;
+        orig.encode(msg);
+        MsgUploadCredit copy;
+        copy.decode(msg);
+        if (orig != copy || Compression::Type::DEFLATE != copy.compression()) {
+            return FAIL;
+        }
+
+        // the daemon must not confirm an unknown compression
+        MsgUploadCredit::header_msg *msg_view = (MsgUploadCredit::header_msg *)(msg.data() + sizeof(MsgType::header_msg));
+        msg_view->compression = 0xff;
+        bool got_exception = false;
+        try {
+            copy.decode(msg);
+        } catch (const std::runtime_error &e) {
+            got_exception = true;
+        }
+        if (!got_exception) {
+            return FAIL;
+        }
+    }
+    return SUCCESS;
+}